@@ -47,6 +47,7 @@ from gvtest import (  # pylint: disable=wrong-import-position
         "graphml2gv",
         "gv2gml",
         "gv2gxl",
+        "gvbin",
         "gvcolor",
         "gvedit",
         "gvgen",
@@ -50,6 +50,7 @@ endif()
 set(HAVE_LASI       ${LASI_FOUND}      )
 set(HAVE_PANGOCAIRO ${PANGOCAIRO_FOUND})
 set(HAVE_POPPLER    ${POPPLER_FOUND}   )
+set(HAVE_PTHREAD    ${CMAKE_USE_PTHREADS_INIT})
 set(HAVE_WEBP       ${WEBP_FOUND}      )
 
 # Values
@@ -16,6 +16,7 @@
 #include <sparse/general.h>
 #include <limits.h>
 #include <math.h>
+#include <sparse/FlatQuadTree.h>
 #include <sparse/QuadTree.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -31,6 +32,7 @@
 #include <util/debug.h>
 #include <util/list.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 
 #include <edgepaint/lab.h>
 #include <edgepaint/node_distinct_coloring.h>
@@ -953,7 +955,7 @@ static int make_map_internal(bool include_OK_points, int n, int dim, double *x0,
 
   double xmax[2], xmin[2], area, *x = x0;
   int i, j;
-  QuadTree qt = NULL;
+  FlatQuadTree qt = NULL;
   int dim2 = 2, nn = 0;
   int max_qtree_level = 10;
   double ymin[2], min;
@@ -1034,9 +1036,9 @@ static int make_map_internal(bool include_OK_points, int n, int dim, double *x0,
       fprintf(stderr, "after adding edge points, n:%d->%d\n",n, nz);
       n = nz;
       x = y;
-      qt = QuadTree_new_from_point_list(dim, nz, max_qtree_level, y);
+      qt = FlatQuadTree_new(dim, nz, max_qtree_level, y, NULL);
     } else {
-      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x);
+      qt = FlatQuadTree_new(dim, n, max_qtree_level, x, NULL);
     }
   }
 
@@ -1070,7 +1072,7 @@ static int make_map_internal(bool include_OK_points, int n, int dim, double *x0,
       const double n2 = n * floor(area2 / area);
       nrandom = fmax(n1, n2);
     }
-    srand(123);
+    gv_srand(123);
     xran = gv_calloc((nrandom + 4) * dim2, sizeof(double));
     int nz = 0;
     if (INCLUDE_OK_POINTS){
@@ -1091,7 +1093,7 @@ static int make_map_internal(bool include_OK_points, int n, int dim, double *x0,
 	point[j] = xmin[j] + (xmax[j] - xmin[j])*drand();
       }
       
-      QuadTree_get_nearest(qt, point, ymin, &imin, &min);
+      FlatQuadTree_get_nearest(qt, point, ymin, &imin, &min);
 
       if (min > shore_depth_tol){/* point not too close, accepted */
 	for (j = 0; j < dim2; j++){
@@ -1199,7 +1201,7 @@ done:
   free(xcombined);
   free(xran);
   if (grouping != grouping0) free(grouping);
-  QuadTree_delete(qt);
+  FlatQuadTree_delete(qt);
   if (x != x0) free(x);
   return rc;
 }
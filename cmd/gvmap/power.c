@@ -11,6 +11,7 @@
 #include "config.h"
 
 #include <util/alloc.h>
+#include <util/random.h>
 #include "power.h"
 #include <sparse/SparseMatrix.h>
 
@@ -57,7 +58,7 @@ double *power_method(void *A, int n, int random_seed) {
   vv = gv_calloc(n, sizeof(double));
   u = gv_calloc(n, sizeof(double));
 
-  srand((unsigned)random_seed);
+  gv_srand((unsigned)random_seed);
 
   v = eigv;
   for (i = 0; i < n; i++) u[i] = drand();
@@ -370,7 +370,7 @@ void makeBall(unsigned w, unsigned h, edgefn ef) {
  */
 void makeRandom(unsigned h, unsigned w, edgefn ef) {
     assert(h > 0);
-    const int type = rand() % 2;
+    const int type = gv_rand() % 2;
 
     unsigned size = 0;
     unsigned depth = 0;
@@ -391,7 +391,7 @@ void makeRandom(unsigned h, unsigned w, edgefn ef) {
 
     for (unsigned i = 3; i <= size; i++) {
 	for (unsigned j = 1; j + 1 < i; j++) {
-	    const unsigned th = (unsigned)rand() % (size * size);
+	    const unsigned th = (unsigned)gv_rand() % (size * size);
 	    if ((th <= w * w && (i < 5 || (i + 4 > h && j + 4 > h))) || th <= w)
 		ef(j,i);
 	}
@@ -505,6 +505,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
     Agattr_t *data = agattrrec(obj);
     if (data) {
 	for (Agsym_t *sym = dtfirst(defdict); sym; sym = dtnext(defdict, sym)) {
+	    char *const value = agxget(obj, sym);
 	    if (!isGxlGrammar(sym->name)) {
 		if (AGTYPE(obj) == AGINEDGE || AGTYPE(obj) == AGOUTEDGE) {
 		    if (Tailport && sym->id == Tailport->id)
@@ -512,13 +513,13 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 		    if (Headport && sym->id == Headport->id)
 			continue;
 		}
-		if (data->str[sym->id] != sym->defval) {
+		if (value != sym->defval) {
 
-		    if (strcmp(data->str[sym->id], "") == 0)
+		    if (strcmp(value, "") == 0)
 			continue;
 
-		    if (isLocatorType(data->str[sym->id])) {
-			char *locatorVal = data->str[sym->id] + strlen(GXL_LOC);
+		    if (isLocatorType(value)) {
+			char *locatorVal = value + strlen(GXL_LOC);
 
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t<attr name=\"");
@@ -535,14 +536,14 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 			fprintf(gxlFile, "\t<attr name=\"");
 			xml_puts(gxlFile, sym->name);
 			fprintf(gxlFile, "\"");
-			if (aghtmlstr(data->str[sym->id])) {
+			if (aghtmlstr(value)) {
 			  // This is a <…> string. Note this in the kind.
 			  fprintf(gxlFile, " kind=\"HTML-like string\"");
 			}
 			fprintf(gxlFile, ">\n");
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t\t<string>");
-			xml_puts(gxlFile, data->str[sym->id]);
+			xml_puts(gxlFile, value);
 			fprintf(gxlFile, "</string>\n");
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t</attr>\n");
@@ -551,7 +552,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 	    } else {
 		/* gxl attr; check for special cases like composites */
 		if (startswith(sym->name, GXL_COMP)) {
-		    if (data->str[sym->id] != sym->defval) {
+		    if (value != sym->defval) {
 
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t<attr name=\"");
@@ -559,7 +560,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 			fprintf(gxlFile, "\">\n");
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t\t");
-			xml_puts(gxlFile, data->str[sym->id]);
+			xml_puts(gxlFile, value);
 			fprintf(gxlFile, "\n");
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t</attr>\n");
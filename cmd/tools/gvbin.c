@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief convert graphs between DOT and the binary graph format
+ */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * which accompanies this distribution, and is available at
+ * https://www.eclipse.org/org/documents/epl-2.0/EPL-2.0.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include "config.h"
+
+#include "openFile.h"
+#include <cgraph/cgraph.h>
+#include <cgraph/ingraphs.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/exit.h>
+#include <util/unreachable.h>
+
+/// output format
+typedef enum {
+  TO_OTHER, ///< whichever format each graph was not read in
+  TO_BINARY,
+  TO_DOT,
+} output_t;
+
+static char **Files;
+static output_t Output = TO_OTHER;
+static FILE *OutFile;
+static char *CmdName;
+
+/// was the graph last read in the binary format?
+static bool ReadBinary;
+
+static const char useString[] = "Usage: %s [-bd?] [-o outfile] <files>\n\
+  -b - write the binary format\n\
+  -d - write DOT\n\
+  -o <file> - put output in <file>\n\
+  -? - print usage\n\
+By default, DOT input is written in the binary format and binary input\n\
+as DOT. If no files are specified, stdin is used\n";
+
+static void usage(int v) {
+  fprintf(v ? stderr : stdout, useString, CmdName);
+  graphviz_exit(v);
+}
+
+static void init(int argc, char *argv[]) {
+  int c;
+
+  CmdName = argv[0];
+  opterr = 0;
+  while ((c = getopt(argc, argv, ":bdo:?")) != -1) {
+    switch (c) {
+    case 'b':
+      Output = TO_BINARY;
+      break;
+    case 'd':
+      Output = TO_DOT;
+      break;
+    case 'o':
+      if (OutFile != NULL)
+        fclose(OutFile);
+      OutFile = openFile(CmdName, optarg, "wb");
+      break;
+    case ':':
+      fprintf(stderr, "%s: option -%c missing argument\n", CmdName, optopt);
+      usage(EXIT_FAILURE);
+      break;
+    case '?':
+      if (optopt == '\0' || optopt == '?')
+        usage(EXIT_SUCCESS);
+      fprintf(stderr, "%s: option -%c unrecognized\n", CmdName, optopt);
+      usage(EXIT_FAILURE);
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+  argv += optind;
+  argc -= optind;
+
+  if (argc)
+    Files = argv;
+  if (OutFile == NULL)
+    OutFile = stdout;
+}
+
+/// read a graph in either format
+static Agraph_t *readGraph(const char *filename, void *fp) {
+  const int c = getc(fp);
+  if (c != EOF)
+    ungetc(c, fp);
+  ReadBinary = c == AGBIN_LEAD;
+  if (ReadBinary)
+    return agreadbin(fp, NULL, NULL);
+  return agconcat(NULL, filename, fp, NULL);
+}
+
+int main(int argc, char **argv) {
+  Agraph_t *g;
+  ingraph_state ig;
+  int rc = EXIT_SUCCESS;
+
+  init(argc, argv);
+  newIng(&ig, Files, readGraph);
+
+  while ((g = nextGraph(&ig)) != 0) {
+    const bool binary =
+        Output == TO_BINARY || (Output == TO_OTHER && !ReadBinary);
+    if ((binary ? agwritebin(g, OutFile, NULL) : agwrite(g, OutFile)) == EOF) {
+      fprintf(stderr, "%s: could not write graph %s\n", CmdName, agnameof(g));
+      rc = EXIT_FAILURE;
+    }
+    agclose(g);
+  }
+  if (fflush(OutFile) != 0)
+    rc = EXIT_FAILURE;
+
+  if (ig.errors != 0 || agerrors() != 0)
+    rc = EXIT_FAILURE;
+  graphviz_exit(rc);
+}
@@ -30,6 +30,7 @@
 #include "openFile.h"
 #include <util/exit.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 
 typedef enum { unknown, grid, circle, complete, completeb, 
     path, tree, torus, cylinder, mobius, randomg, randomt, ball,
@@ -457,7 +458,7 @@ int main(int argc, char *argv[])
     }
 
     // seed the random number generator
-    srand(opts.seed);
+    gv_srand(opts.seed);
 
     switch (graphType) {
     case grid:
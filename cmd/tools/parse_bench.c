@@ -0,0 +1,227 @@
+/// @file
+/// @brief benchmark of DOT parsing throughput
+///
+/// This times reading every graph in a file through stdio with `agread`, in
+/// place from a mapping with `agmapread`, from the same mapping with the
+/// `AG_PARALLEL_READ` option of `agmapread_flags`, and from a copy of the
+/// graphs in the binary format with `agreadbin`, and reports each in MB of the
+/// original file per second. It is not installed. Build it on demand with `make parse_bench`.
+
+#include "config.h"
+
+#include <cgraph/cgraph.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <util/exit.h>
+#include <util/gv_fopen.h>
+#include <util/unreachable.h>
+
+static char *cmd;
+
+static const char useString[] =
+    "Usage: %s [-r repeats] file.gv\n\
+  Measure how fast the graphs in a DOT file are parsed.\n\
+  -r <r> - number of times to read the file each way (default 3)\n";
+
+static void usage(int eval) {
+  fprintf(stderr, useString, cmd);
+  graphviz_exit(eval);
+}
+
+typedef struct {
+  int repeats;
+  const char *infile;
+} parms_t;
+
+static void init(int argc, char **argv, parms_t *p) {
+  int c;
+
+  cmd = argv[0];
+  opterr = 0;
+  while ((c = getopt(argc, argv, ":r:?")) != -1) {
+    switch (c) {
+    case 'r': {
+      char *end;
+      const long v = strtol(optarg, &end, 10);
+      if (end == optarg || *end != '\0' || v < 1 || v > INT_MAX) {
+        usage(1);
+      }
+      p->repeats = (int)v;
+      break;
+    }
+    case ':':
+      fprintf(stderr, "%s: option -%c missing argument\n", cmd, optopt);
+      usage(1);
+      break;
+    case '?':
+      if (optopt == '\0' || optopt == '?')
+        usage(0);
+      fprintf(stderr, "%s: option -%c unrecognized\n", cmd, optopt);
+      usage(1);
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+  argv += optind;
+  argc -= optind;
+
+  if (argc != 1) {
+    usage(1);
+  }
+  p->infile = argv[0];
+}
+
+/// wall clock time in seconds
+static double now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// read every graph in a file through stdio
+///
+/// @return Seconds taken, or a negative number on failure
+static double read_stdio(const char *path, int *graphs) {
+  const double start = now();
+  FILE *f = gv_fopen(path, "r");
+  if (f == NULL) {
+    return -1;
+  }
+  *graphs = 0;
+  for (Agraph_t *g; (g = agconcat(NULL, path, f, NULL)) != NULL; ++*graphs) {
+    agclose(g);
+  }
+  fclose(f);
+  return now() - start;
+}
+
+/// read every graph in a file from a mapping
+///
+/// @param flags Options to pass to `agmapread_flags`
+/// @return Seconds taken, or a negative number on failure
+static double read_mapping(const char *path, int *graphs, unsigned flags) {
+  const double start = now();
+  struct graphviz_mapped_input *input = agmapopen(path);
+  if (input == NULL) {
+    return -1;
+  }
+  *graphs = 0;
+  for (Agraph_t *g; (g = agmapread_flags(input, NULL, flags)) != NULL;
+       ++*graphs) {
+    agclose(g);
+  }
+  agmapclose(input);
+  return now() - start;
+}
+
+static double read_mapped(const char *path, int *graphs) {
+  return read_mapping(path, graphs, 0);
+}
+
+static double read_parallel(const char *path, int *graphs) {
+  return read_mapping(path, graphs, AG_PARALLEL_READ);
+}
+
+/// the graphs of the input file in the binary format
+static FILE *binary;
+
+/// write every graph in a file to `binary`
+///
+/// @return Whether this succeeded
+static bool convert(const char *path) {
+  binary = tmpfile();
+  if (binary == NULL) {
+    return false;
+  }
+  struct graphviz_mapped_input *input = agmapopen(path);
+  if (input == NULL) {
+    return false;
+  }
+  bool ok = true;
+  for (Agraph_t *g; (g = agmapread(input, NULL)) != NULL;) {
+    ok &= agwritebin(g, binary, NULL) == 0;
+    agclose(g);
+  }
+  agmapclose(input);
+  return ok;
+}
+
+/// read every graph from their copy in the binary format
+///
+/// @return Seconds taken, or a negative number on failure
+static double read_binary(const char *path, int *graphs) {
+  (void)path;
+  if (binary == NULL) {
+    return -1;
+  }
+  const double start = now();
+  rewind(binary);
+  *graphs = 0;
+  for (Agraph_t *g; (g = agreadbin(binary, NULL, NULL)) != NULL; ++*graphs) {
+    agclose(g);
+  }
+  return now() - start;
+}
+
+int main(int argc, char **argv) {
+  parms_t p = {.repeats = 3};
+  init(argc, argv, &p);
+
+  struct stat st;
+  if (stat(p.infile, &st) != 0) {
+    fprintf(stderr, "%s: %s: %s\n", cmd, p.infile, strerror(errno));
+    graphviz_exit(EXIT_FAILURE);
+  }
+  const double mb = (double)st.st_size / 1e6;
+  if (!convert(p.infile) && binary != NULL) {
+    fclose(binary);
+    binary = NULL;
+  }
+
+  static const struct {
+    const char *name;
+    double (*read)(const char *path, int *graphs);
+  } readers[] = {
+      {"stdio", read_stdio},
+      {"mapped", read_mapped},
+      {"parallel", read_parallel},
+      {"binary", read_binary}};
+
+  printf("%s: %.1f MB\n", p.infile, mb);
+  printf("%-8s %8s %12s %10s\n", "reader", "graphs", "best (s)", "MB/s");
+
+  int rc = EXIT_SUCCESS;
+  for (size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); ++i) {
+    double best = -1;
+    int graphs = 0;
+    for (int r = 0; r < p.repeats; ++r) {
+      const double t = readers[i].read(p.infile, &graphs);
+      if (t < 0) {
+        break;
+      }
+      if (best < 0 || t < best) {
+        best = t;
+      }
+    }
+    if (best < 0) {
+      printf("%-8s %8s %12s %10s\n", readers[i].name, "-", "-", "failed");
+      rc = EXIT_FAILURE;
+      continue;
+    }
+    printf("%-8s %8d %12.4f %10.1f\n", readers[i].name, graphs, best,
+           best > 0 ? mb / best : 0);
+  }
+
+  if (binary != NULL) {
+    fclose(binary);
+  }
+  graphviz_exit(rc);
+}
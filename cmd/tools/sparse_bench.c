@@ -0,0 +1,298 @@
+/// @file
+/// @brief benchmark of the single and multithreaded SparseMatrix kernels
+///
+/// This times each kernel in lib/sparse that has a `_parallel` variant against
+/// its single threaded namesake, and checks the two produce identical results.
+/// It is not installed. Build it on demand with `make sparse_bench`.
+
+#include "config.h"
+
+#include "matrix_market.h"
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sparse/SparseMatrix.h>
+#include <time.h>
+#include <util/alloc.h>
+#include <util/exit.h>
+#include <util/parallel.h>
+#include <util/prisize_t.h>
+#include <util/unreachable.h>
+
+static char *cmd;
+
+static const char useString[] =
+    "Usage: %s [-t threads] [-r repeats] [-n nodes] [-d degree] [file.mtx]\n\
+  Compare single and multithreaded sparse matrix kernels.\n\
+  -t <t> - number of threads, 0 for one per processor (default 0)\n\
+  -r <r> - number of times to run each kernel (default 5)\n\
+  -n <n> - number of rows of a random matrix (default 1000000)\n\
+  -d <d> - entries per row of a random matrix (default 8)\n\
+  If a Matrix Market file is given, it is used instead of a random matrix.\n";
+
+static void usage(int eval) {
+  fprintf(stderr, useString, cmd);
+  graphviz_exit(eval);
+}
+
+typedef struct {
+  int threads;
+  int repeats;
+  int nodes;
+  int degree;
+  const char *infile;
+} parms_t;
+
+static int int_arg(const char *arg, int min) {
+  char *end;
+  const long v = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || v < min || v > INT_MAX) {
+    usage(1);
+  }
+  return (int)v;
+}
+
+static void init(int argc, char **argv, parms_t *p) {
+  int c;
+
+  cmd = argv[0];
+  opterr = 0;
+  while ((c = getopt(argc, argv, ":t:r:n:d:?")) != -1) {
+    switch (c) {
+    case 't':
+      p->threads = int_arg(optarg, 0);
+      break;
+    case 'r':
+      p->repeats = int_arg(optarg, 1);
+      break;
+    case 'n':
+      p->nodes = int_arg(optarg, 1);
+      break;
+    case 'd':
+      p->degree = int_arg(optarg, 1);
+      break;
+    case ':':
+      fprintf(stderr, "%s: option -%c missing argument\n", cmd, optopt);
+      usage(1);
+      break;
+    case '?':
+      if (optopt == '\0' || optopt == '?')
+        usage(0);
+      fprintf(stderr, "%s: option -%c unrecognized\n", cmd, optopt);
+      usage(1);
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+  argv += optind;
+  argc -= optind;
+
+  if (argc > 0) {
+    p->infile = argv[0];
+  }
+}
+
+/// a square real matrix with `degree` random entries in each row
+static SparseMatrix random_matrix(int n, int degree) {
+  const size_t nz = (size_t)n * (size_t)degree;
+  int *irn = gv_calloc(nz, sizeof(int));
+  int *jcn = gv_calloc(nz, sizeof(int));
+  double *val = gv_calloc(nz, sizeof(double));
+  srand(1);
+  for (size_t k = 0; k < nz; k++) {
+    irn[k] = (int)(k / (size_t)degree);
+    // keep most entries near the diagonal, like a graph with locality
+    const int offset = k % 2 == 0 ? rand() % 64 - 32 : rand();
+    jcn[k] = (int)(((long long)irn[k] + offset % n + n) % n);
+    val[k] = 1. + rand() % 8;
+  }
+  SparseMatrix A = SparseMatrix_from_coordinate_arrays(
+      nz, n, n, irn, jcn, val, MATRIX_TYPE_REAL, sizeof(double));
+  free(val);
+  free(jcn);
+  free(irn);
+  return A;
+}
+
+/// a square real matrix read from a Matrix Market file
+static SparseMatrix read_matrix(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "%s: could not open %s\n", cmd, path);
+    graphviz_exit(1);
+  }
+  SparseMatrix A = SparseMatrix_import_matrix_market(f);
+  fclose(f);
+  if (A == NULL) {
+    fprintf(stderr, "%s: could not read %s\n", cmd, path);
+    graphviz_exit(1);
+  }
+  SparseMatrix B = SparseMatrix_to_square_matrix(A, BIPARTITE_RECT);
+  if (B != A) {
+    SparseMatrix_delete(A);
+  }
+  if (B->type != MATRIX_TYPE_REAL) {
+    B = SparseMatrix_set_entries_to_real_one(B);
+  }
+  return B;
+}
+
+/// the prolongation from aggregating consecutive pairs of nodes
+static SparseMatrix pairwise_prolongation(int n) {
+  int *irn = gv_calloc((size_t)n, sizeof(int));
+  int *jcn = gv_calloc((size_t)n, sizeof(int));
+  double *val = gv_calloc((size_t)n, sizeof(double));
+  for (int i = 0; i < n; i++) {
+    irn[i] = i;
+    jcn[i] = i / 2;
+    val[i] = 1;
+  }
+  SparseMatrix P = SparseMatrix_from_coordinate_arrays(
+      (size_t)n, n, (n + 1) / 2, irn, jcn, val, MATRIX_TYPE_REAL,
+      sizeof(double));
+  free(val);
+  free(jcn);
+  free(irn);
+  return P;
+}
+
+static bool same_matrix(SparseMatrix A, SparseMatrix B) {
+  if (A == NULL || B == NULL) {
+    return A == B;
+  }
+  if (A->m != B->m || A->n != B->n || A->nz != B->nz || A->type != B->type) {
+    return false;
+  }
+  if (memcmp(A->ia, B->ia, sizeof(int) * ((size_t)A->m + 1)) != 0) {
+    return false;
+  }
+  if (A->nz > 0 && memcmp(A->ja, B->ja, sizeof(int) * A->nz) != 0) {
+    return false;
+  }
+  return A->nz == 0 || A->size == 0 ||
+         memcmp(A->a, B->a, A->size * A->nz) == 0;
+}
+
+/// wall clock time in seconds
+static double now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+enum { TRANSPOSE, MULTIPLY_VECTOR, MULTIPLY_DENSE, MULTIPLY, MULTIPLY3,
+       KERNELS };
+
+static const char *const names[] = {
+    [TRANSPOSE] = "transpose",
+    [MULTIPLY_VECTOR] = "multiply_vector",
+    [MULTIPLY_DENSE] = "multiply_dense",
+    [MULTIPLY] = "multiply",
+    [MULTIPLY3] = "multiply3",
+};
+
+/// operands and results of one kernel run
+typedef struct {
+  SparseMatrix A, R, P;
+  const double *v;
+  double *res; ///< vector result
+  SparseMatrix M; ///< matrix result
+} operands_t;
+
+/// run a kernel, single threaded if `pool` is `NULL`
+static void run(int kernel, operands_t *o, gv_pool_t *pool) {
+  switch (kernel) {
+  case TRANSPOSE:
+    o->M = SparseMatrix_transpose_parallel(o->A, pool);
+    break;
+  case MULTIPLY_VECTOR:
+    SparseMatrix_multiply_vector_parallel(o->A, (double *)o->v, &o->res, pool);
+    break;
+  case MULTIPLY_DENSE:
+    SparseMatrix_multiply_dense_parallel(o->A, o->v, o->res, 2, pool);
+    break;
+  case MULTIPLY:
+    o->M = SparseMatrix_multiply_parallel(o->A, o->A, pool);
+    break;
+  case MULTIPLY3:
+    o->M = SparseMatrix_multiply3_parallel(o->R, o->A, o->P, pool);
+    break;
+  default:
+    UNREACHABLE();
+  }
+}
+
+/// time a kernel, returning the best of `repeats` runs
+static double best_time(int kernel, operands_t *o, gv_pool_t *pool,
+                        int repeats) {
+  double best = 0;
+  for (int r = 0; r < repeats; r++) {
+    SparseMatrix_delete(o->M);
+    o->M = NULL;
+    const double start = now();
+    run(kernel, o, pool);
+    const double t = now() - start;
+    if (r == 0 || t < best) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  parms_t p = {.repeats = 5, .nodes = 1000000, .degree = 8};
+  init(argc, argv, &p);
+
+  SparseMatrix A = p.infile != NULL ? read_matrix(p.infile)
+                                    : random_matrix(p.nodes, p.degree);
+  const int n = A->m;
+  SparseMatrix P = pairwise_prolongation(n);
+  SparseMatrix R = SparseMatrix_transpose(P);
+
+  double *v = gv_calloc(2 * (size_t)n, sizeof(double));
+  for (int i = 0; i < 2 * n; i++) {
+    v[i] = (double)(i % 17) - 8;
+  }
+
+  gv_pool_t *pool = gv_pool_new((size_t)p.threads);
+  printf("%d × %d matrix with %" PRISIZE_T " entries, %" PRISIZE_T
+         " threads\n", A->m, A->n, A->nz, gv_pool_size(pool));
+  printf("%-16s %12s %12s %8s\n", "kernel", "serial (s)", "parallel (s)",
+         "speedup");
+
+  int rc = EXIT_SUCCESS;
+  for (int k = 0; k < KERNELS; k++) {
+    operands_t serial = {.A = A, .R = R, .P = P, .v = v};
+    operands_t parallel = serial;
+    serial.res = gv_calloc(2 * (size_t)n, sizeof(double));
+    parallel.res = gv_calloc(2 * (size_t)n, sizeof(double));
+
+    const double ts = best_time(k, &serial, NULL, p.repeats);
+    const double tp = best_time(k, &parallel, pool, p.repeats);
+
+    const bool same =
+        same_matrix(serial.M, parallel.M) &&
+        memcmp(serial.res, parallel.res, 2 * (size_t)n * sizeof(double)) == 0;
+    printf("%-16s %12.4f %12.4f %7.2fx%s\n", names[k], ts, tp,
+           tp > 0 ? ts / tp : 0, same ? "" : "  results differ!");
+    if (!same) {
+      rc = EXIT_FAILURE;
+    }
+
+    SparseMatrix_delete(parallel.M);
+    SparseMatrix_delete(serial.M);
+    free(parallel.res);
+    free(serial.res);
+  }
+
+  gv_pool_free(pool);
+  free(v);
+  SparseMatrix_delete(R);
+  SparseMatrix_delete(P);
+  SparseMatrix_delete(A);
+  graphviz_exit(rc);
+}
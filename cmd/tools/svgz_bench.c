@@ -0,0 +1,196 @@
+/// @file
+/// @brief benchmark of compressed output
+///
+/// This lays out the first graph in a file, then times rendering it as SVGZ
+/// into memory at several compression levels, through the single deflate
+/// stream used with `threads=1` and through the block-parallel writer used
+/// with more threads. Each is reported with its compressed size, its
+/// throughput in MB of uncompressed SVG per second and its speedup over the
+/// single stream at the same level. It is not installed. Build it on demand
+/// with `make svgz_bench`.
+
+#include "config.h"
+
+#include <cgraph/cgraph.h>
+#include <getopt.h>
+#include <gvc/gvc.h>
+#include <gvc/gvplugin.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <util/exit.h>
+#include <util/gv_fopen.h>
+#include <util/parallel.h>
+#include <util/unreachable.h>
+
+extern gvplugin_library_t gvplugin_core_LTX_library;
+extern gvplugin_library_t gvplugin_dot_layout_LTX_library;
+extern gvplugin_library_t gvplugin_neato_layout_LTX_library;
+
+static char *cmd;
+
+static const char useString[] = "Usage: %s [-K engine] [-r repeats] file.gv\n\
+  Measure how fast a laid out graph is rendered as compressed SVG.\n\
+  -K <e> - layout engine to use (default dot)\n\
+  -r <r> - number of times to render each way (default 3)\n";
+
+static void usage(int eval) {
+  fprintf(stderr, useString, cmd);
+  graphviz_exit(eval);
+}
+
+typedef struct {
+  const char *engine;
+  int repeats;
+  const char *infile;
+} parms_t;
+
+static void init(int argc, char **argv, parms_t *p) {
+  int c;
+
+  cmd = argv[0];
+  opterr = 0;
+  while ((c = getopt(argc, argv, ":K:r:?")) != -1) {
+    switch (c) {
+    case 'K':
+      p->engine = optarg;
+      break;
+    case 'r': {
+      char *end;
+      const long v = strtol(optarg, &end, 10);
+      if (end == optarg || *end != '\0' || v < 1 || v > INT_MAX) {
+        usage(1);
+      }
+      p->repeats = (int)v;
+      break;
+    }
+    case ':':
+      fprintf(stderr, "%s: option -%c missing argument\n", cmd, optopt);
+      usage(1);
+      break;
+    case '?':
+      if (optopt == '\0' || optopt == '?')
+        usage(0);
+      fprintf(stderr, "%s: option -%c unrecognized\n", cmd, optopt);
+      usage(1);
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+  argv += optind;
+  argc -= optind;
+
+  if (argc != 1) {
+    usage(1);
+  }
+  p->infile = argv[0];
+}
+
+/// wall clock time in seconds
+static double now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// render a graph in a format, keeping the fastest of several runs
+///
+/// @return Best time in seconds, or a negative value on failure
+static double render(GVC_t *gvc, Agraph_t *g, const char *format, int repeats,
+                     size_t *length) {
+  double best = -1;
+  for (int r = 0; r < repeats; ++r) {
+    char *result = NULL;
+    size_t len = 0;
+    const double start = now();
+    const int rc = gvRenderData(gvc, g, format, &result, &len);
+    const double t = now() - start;
+    gvFreeRenderData(result);
+    if (rc != 0) {
+      return -1;
+    }
+    *length = len;
+    if (best < 0 || t < best) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  parms_t p = {.engine = "dot", .repeats = 3};
+  init(argc, argv, &p);
+
+  // link the plugins in, so this runs without an installed Graphviz
+  lt_symlist_t builtins[] = {
+      {"gvplugin_core_LTX_library", &gvplugin_core_LTX_library},
+      {"gvplugin_dot_layout_LTX_library", &gvplugin_dot_layout_LTX_library},
+      {"gvplugin_neato_layout_LTX_library",
+       &gvplugin_neato_layout_LTX_library},
+      {0}};
+  GVC_t *const gvc = gvContextPlugins(builtins, 0);
+
+  FILE *const in = gv_fopen(p.infile, "r");
+  if (in == NULL) {
+    fprintf(stderr, "%s: could not open %s\n", cmd, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+  Agraph_t *const g = agread(in, NULL);
+  fclose(in);
+  if (g == NULL) {
+    fprintf(stderr, "%s: no graph in %s\n", cmd, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+  if (gvLayout(gvc, g, p.engine) != 0) {
+    fprintf(stderr, "%s: %s layout of %s failed\n", cmd, p.engine, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+
+  size_t svg = 0;
+  const double plain = render(gvc, g, "svg", p.repeats, &svg);
+  if (plain < 0) {
+    fprintf(stderr, "%s: rendering %s failed\n", cmd, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+  const double mb = (double)svg / 1e6;
+
+  printf("%s: %.1f MB of SVG, %zu processors\n", p.infile, mb,
+         gv_processors());
+  printf("%-8s %7s %6s %10s %12s %10s %8s\n", "format", "threads", "level",
+         "bytes", "best (s)", "MB/s", "speedup");
+  printf("%-8s %7s %6s %10zu %12.4f %10.1f %8s\n", "svg", "-", "-", svg,
+         plain, plain > 0 ? mb / plain : 0, "-");
+
+  // the first entry is the single stream the others are compared against
+  const char *const threads[] = {"1", "2", "0"};
+  const char *const levels[] = {"1", "6", "9"};
+  double serial[sizeof(levels) / sizeof(levels[0])] = {0};
+  int rc = EXIT_SUCCESS;
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+    agattr_text(g, AGRAPH, "threads", threads[t]);
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+      agattr_text(g, AGRAPH, "compresslevel", levels[l]);
+      size_t bytes = 0;
+      const double best = render(gvc, g, "svgz", p.repeats, &bytes);
+      if (best < 0) {
+        printf("%-8s %7s %6s %10s %12s %10s %8s\n", "svgz", threads[t],
+               levels[l], "-", "-", "failed", "-");
+        rc = EXIT_FAILURE;
+        continue;
+      }
+      if (t == 0) {
+        serial[l] = best;
+      }
+      printf("%-8s %7s %6s %10zu %12.4f %10.1f %8.2f\n", "svgz", threads[t],
+             levels[l], bytes, best, best > 0 ? mb / best : 0,
+             serial[l] > 0 && best > 0 ? serial[l] / best : 0);
+    }
+  }
+
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  gvFreeContext(gvc);
+  graphviz_exit(rc);
+}
@@ -0,0 +1,215 @@
+/// @file
+/// @brief benchmark of DOT writing throughput
+///
+/// This reads every graph in a file, then times writing them with `agwrite`
+/// to a sink that only counts the output, to a temporary file through stdio,
+/// and in the binary format with `agwritebin`. Each is reported in MB of
+/// output per second. It is not installed. Build it on demand with
+/// `make write_bench`.
+
+#include "config.h"
+
+#include <cgraph/cgraph.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <util/exit.h>
+#include <util/gv_fopen.h>
+#include <util/list.h>
+#include <util/unreachable.h>
+
+static char *cmd;
+
+static const char useString[] = "Usage: %s [-r repeats] file.gv\n\
+  Measure how fast the graphs in a DOT file are written.\n\
+  -r <r> - number of times to write the graphs each way (default 3)\n";
+
+static void usage(int eval) {
+  fprintf(stderr, useString, cmd);
+  graphviz_exit(eval);
+}
+
+typedef struct {
+  int repeats;
+  const char *infile;
+} parms_t;
+
+static void init(int argc, char **argv, parms_t *p) {
+  int c;
+
+  cmd = argv[0];
+  opterr = 0;
+  while ((c = getopt(argc, argv, ":r:?")) != -1) {
+    switch (c) {
+    case 'r': {
+      char *end;
+      const long v = strtol(optarg, &end, 10);
+      if (end == optarg || *end != '\0' || v < 1 || v > INT_MAX) {
+        usage(1);
+      }
+      p->repeats = (int)v;
+      break;
+    }
+    case ':':
+      fprintf(stderr, "%s: option -%c missing argument\n", cmd, optopt);
+      usage(1);
+      break;
+    case '?':
+      if (optopt == '\0' || optopt == '?')
+        usage(0);
+      fprintf(stderr, "%s: option -%c unrecognized\n", cmd, optopt);
+      usage(1);
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+  argv += optind;
+  argc -= optind;
+
+  if (argc != 1) {
+    usage(1);
+  }
+  p->infile = argv[0];
+}
+
+/// wall clock time in seconds
+static double now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// where graphs are written
+typedef struct {
+  FILE *file;   ///< file to write to, or NULL to discard the output
+  size_t bytes; ///< bytes written
+} sink_t;
+
+static int sink_putstr(void *chan, const char *str) {
+  sink_t *const sink = chan;
+  const size_t len = strlen(str);
+  sink->bytes += len;
+  if (sink->file != NULL && fwrite(str, 1, len, sink->file) < len) {
+    return EOF;
+  }
+  return 0;
+}
+
+static int sink_flush(void *chan) {
+  const sink_t *const sink = chan;
+  if (sink->file != NULL) {
+    return fflush(sink->file);
+  }
+  return 0;
+}
+
+static size_t sink_write(void *chan, const void *buf, size_t len) {
+  sink_t *const sink = chan;
+  sink->bytes += len;
+  if (sink->file != NULL) {
+    return fwrite(buf, 1, len, sink->file);
+  }
+  return len;
+}
+
+typedef LIST(Agraph_t *) graphs_t;
+
+/// write every graph with `agwrite`
+static bool write_dot(const graphs_t *graphs, sink_t *sink) {
+  for (size_t i = 0; i < LIST_SIZE(graphs); ++i) {
+    if (agwrite(LIST_GET(graphs, i), sink) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// write every graph with `agwritebin`
+static bool write_binary(const graphs_t *graphs, sink_t *sink) {
+  for (size_t i = 0; i < LIST_SIZE(graphs); ++i) {
+    if (agwritebin(LIST_GET(graphs, i), sink, sink_write) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  parms_t p = {.repeats = 3};
+  init(argc, argv, &p);
+
+  // read the graphs with a discipline that writes to a `sink_t`
+  Agiodisc_t io = {
+      .afread = AgIoDisc.afread, .putstr = sink_putstr, .flush = sink_flush};
+  Agdisc_t disc = {.io = &io};
+
+  FILE *const in = gv_fopen(p.infile, "r");
+  if (in == NULL) {
+    fprintf(stderr, "%s: could not open %s\n", cmd, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+  graphs_t graphs = {0};
+  for (Agraph_t *g; (g = agread(in, &disc)) != NULL;) {
+    LIST_APPEND(&graphs, g);
+  }
+  fclose(in);
+  if (LIST_IS_EMPTY(&graphs)) {
+    fprintf(stderr, "%s: no graphs in %s\n", cmd, p.infile);
+    graphviz_exit(EXIT_FAILURE);
+  }
+
+  const struct {
+    const char *name;
+    bool (*write)(const graphs_t *graphs, sink_t *sink);
+    bool to_file;
+  } writers[] = {{"memory", write_dot, false},
+                 {"file", write_dot, true},
+                 {"binary", write_binary, false}};
+
+  printf("%s: %zu graphs\n", p.infile, LIST_SIZE(&graphs));
+  printf("%-8s %10s %12s %10s\n", "writer", "MB", "best (s)", "MB/s");
+
+  int rc = EXIT_SUCCESS;
+  for (size_t i = 0; i < sizeof(writers) / sizeof(writers[0]); ++i) {
+    double best = -1;
+    sink_t sink = {0};
+    for (int r = 0; r < p.repeats; ++r) {
+      sink = (sink_t){0};
+      if (writers[i].to_file && (sink.file = tmpfile()) == NULL) {
+        break;
+      }
+      const double start = now();
+      const bool ok = writers[i].write(&graphs, &sink);
+      const double t = now() - start;
+      if (sink.file != NULL) {
+        fclose(sink.file);
+      }
+      if (!ok) {
+        best = -1;
+        break;
+      }
+      if (best < 0 || t < best) {
+        best = t;
+      }
+    }
+    if (best < 0) {
+      printf("%-8s %10s %12s %10s\n", writers[i].name, "-", "-", "failed");
+      rc = EXIT_FAILURE;
+      continue;
+    }
+    const double mb = (double)sink.bytes / 1e6;
+    printf("%-8s %10.1f %12.4f %10.1f\n", writers[i].name, mb, best,
+           best > 0 ? mb / best : 0);
+  }
+
+  for (size_t i = 0; i < LIST_SIZE(&graphs); ++i) {
+    agclose(LIST_GET(&graphs, i));
+  }
+  LIST_FREE(&graphs);
+  graphviz_exit(rc);
+}
@@ -150,6 +150,8 @@ CDT_API Dtmethod_t *dtmethod(Dt_t *, Dtmethod_t *);
 CDT_API Dtlink_t *dtflatten(Dt_t *);
 CDT_API Dtlink_t *dtextract(Dt_t *);
 CDT_API int dtrestore(Dt_t *, Dtlink_t *);
+CDT_API int dtfreeze(Dt_t *, int);
+CDT_API void *dtextracted(Dt_t *, Dtlink_t *, void *, int);
 
 CDT_API int dtwalk(Dt_t *, int (*)(void *, void *), void *);
 
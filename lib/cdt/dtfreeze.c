@@ -0,0 +1,111 @@
+#include "config.h"
+
+#include	<cdt/dthdr.h>
+#include	<stddef.h>
+
+/*	Freeze an ordered set so that searches leave it unchanged.
+**	Searching a tree normally splays the object found to the root, so even
+**	lookups modify the dictionary. A frozen dictionary is balanced once and
+**	then searched in place, letting several threads look up or walk it at
+**	the same time. Objects can still be inserted or deleted, but not while
+**	another thread is using the dictionary.
+*/
+
+/* make a balanced tree of the first n objects of a flattened list */
+static Dtlink_t* balance(Dtlink_t** list, size_t n)
+{
+	Dtlink_t	*root, *l;
+
+	if(n == 0)
+		return NULL;
+	l = balance(list, n / 2);
+	root = *list;
+	*list = root->right;
+	root->left = l;
+	root->right = balance(list, n - n / 2 - 1);
+	return root;
+}
+
+int dtfreeze(Dt_t* dt, int freeze)
+{
+	Dtlink_t	*list, *t;
+	size_t		n = 0;
+
+	if(!(dt->data.type & DT_OSET))
+		return -1;
+
+	if(!freeze)
+	{	dt->data.type &= ~DT_FROZEN;
+		return 0;
+	}
+
+	list = dtflatten(dt);
+	for(t = list; t; t = t->right)
+		++n;
+	dt->data.here = balance(&list, n);
+	dt->data.type &= ~DT_FLATTEN;
+	dt->data.type |= DT_FROZEN;
+	dt->data.size = (int)n;
+	return 0;
+}
+
+/* search a tree without changing it */
+void* _dtfrozen(Dt_t* dt, Dtlink_t* root, void* obj, int type)
+{
+	Dtlink_t	*t, *found = NULL;
+	int		cmp, lk, sz, ky;
+	void		*k, *key;
+	Dtcompar_f	cmpf;
+	Dtdisc_t*	disc = dt->disc;
+
+	_DTDSC(disc,ky,sz,lk,cmpf);
+
+	if(!root)
+		return NULL;
+	if(type&(DT_FIRST|DT_LAST))
+	{	if(type&DT_FIRST)
+		{	while((t = root->left) )
+				root = t;
+		}
+		else
+		{	while((t = root->right) )
+				root = t;
+		}
+		return _DTOBJ(root,lk);
+	}
+	if(!obj)
+		return NULL;
+
+	key = (type&DT_MATCH) ? obj : _DTKEY(obj,ky,sz);
+	while(root)
+	{	k = _DTOBJ(root,lk); k = _DTKEY(k,ky,sz);
+		cmp = _DTCMP(key, k, cmpf, sz);
+		if(type&DT_NEXT) /* smallest object after key */
+		{	if(cmp < 0)
+			{	found = root;
+				root = root->left;
+			}
+			else	root = root->right;
+		}
+		else if(type&DT_PREV) /* largest object before key */
+		{	if(cmp > 0)
+			{	found = root;
+				root = root->right;
+			}
+			else	root = root->left;
+		}
+		else if(cmp == 0)
+		{	found = root;
+			break;
+		}
+		else	root = cmp < 0 ? root->left : root->right;
+	}
+	return found ? _DTOBJ(found,lk) : NULL;
+}
+
+void* dtextracted(Dt_t* dt, Dtlink_t* list, void* obj, int type)
+{
+	if(!(dt->data.type & DT_FROZEN))
+		return NULL;
+	return _dtfrozen(dt, list, obj, type);
+}
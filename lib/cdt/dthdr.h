@@ -17,6 +17,7 @@
 /* this must be disjoint from DT_METHODS */
 #define DT_FLATTEN	010000	/* dictionary already flattened	*/
 #define DT_WALK		020000	/* hash table being walked	*/
+#define DT_FROZEN	040000	/* searches leave the tree as is	*/
 
 /* hash start size and load factor */
 #define HSLOT		(256)
@@ -24,6 +25,9 @@
 #define HLOAD(s)	((s) << 1)
 #define HINDEX(n,h)	((h)&((n)-1))
 
+/* search a frozen tree, see dtfreeze.c */
+void* _dtfrozen(Dt_t* dt, Dtlink_t* root, void* obj, int type);
+
 #define UNFLATTEN(dt) ((dt->data.type & DT_FLATTEN) ? dtrestore(dt, NULL) : 0)
 
 /* tree rotation/linking functions */
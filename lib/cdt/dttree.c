@@ -21,6 +21,9 @@ static void* dttree(Dt_t* dt, void* obj, int type)
 	Dtdisc_t*	disc;
 
 	UNFLATTEN(dt);
+	if((dt->data.type&DT_FROZEN) &&
+	   (type&(DT_SEARCH|DT_MATCH|DT_NEXT|DT_PREV|DT_FIRST|DT_LAST)) )
+		return _dtfrozen(dt, dt->data.here, obj, type);
 	disc = dt->disc; _DTDSC(disc,ky,sz,lk,cmpf);
 
 	root = dt->data.here;
@@ -25,7 +25,8 @@ static void* dtvsearch(Dt_t* dt, void* obj, int type)
 	{	for(d = dt; d; d = d->view)
 			if ((o = d->meth->searchf(d, obj, type)))
 				break;
-		dt->walk = d;
+		if(!(dt->data.type & DT_FROZEN)) /* others may be searching */
+			dt->walk = d;
 		return o;
 	}
 
@@ -53,7 +54,8 @@ static void* dtvsearch(Dt_t* dt, void* obj, int type)
 			}
 		}
 
-		dt->walk = p;
+		if(!(dt->data.type & DT_FROZEN))
+			dt->walk = p;
 		return n;
 	}
 
@@ -24,11 +24,11 @@
 #include <util/gv_math.h>
 #include <util/streq.h>
 
-static agerrlevel_t agerrno;             /* Last error level */
+static _Thread_local agerrlevel_t agerrno;             /* Last error level */
 static agerrlevel_t agerrlevel = AGWARN; /* Report errors >= agerrlevel */
-static int agmaxerr;
+static _Thread_local int agmaxerr;
 
-static agxbuf last;         ///< last message
+static _Thread_local agxbuf last;       ///< last message
 static agusererrf usererrf; /* User-set error function */
 
 agusererrf agseterrf(agusererrf newf) {
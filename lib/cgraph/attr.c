@@ -20,6 +20,9 @@
 #include	<stdbool.h>
 #include	<stdlib.h>
 #include	<util/alloc.h>
+#ifdef HAVE_PTHREAD
+#include	<pthread.h>
+#endif
 #include	<util/streq.h>
 #include	<util/unreachable.h>
 
@@ -46,6 +49,45 @@ static Agdesc_t ProtoDesc = {.directed = true, .no_loop = true,
                              .no_write = true};
 static Agraph_t *ProtoGraph;
 
+#ifdef HAVE_PTHREAD
+/// serializes use of `ProtoGraph`, which all threads share
+///
+/// Lookups splay its dictionaries, so even reading them needs this. It is
+/// recursive because opening `ProtoGraph` makes its dictionaries in turn.
+static pthread_mutex_t ProtoLock;
+static pthread_once_t ProtoLockOnce = PTHREAD_ONCE_INIT;
+
+static void protolock_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&ProtoLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+#endif
+
+static void protolock(void) {
+#ifdef HAVE_PTHREAD
+    pthread_once(&ProtoLockOnce, protolock_init);
+    pthread_mutex_lock(&ProtoLock);
+#endif
+}
+
+static void protounlock(void) {
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&ProtoLock);
+#endif
+}
+
+/// get the graph holding default attributes, creating it if necessary
+///
+/// The caller must hold `ProtoLock`.
+static Agraph_t *protograph(void) {
+    if (ProtoGraph == NULL)
+	ProtoGraph = agopen(NULL, ProtoDesc, NULL);
+    return ProtoGraph;
+}
+
 Agdatadict_t *agdatadict(Agraph_t *g, bool cflag) {
     Agdatadict_t *rv = (Agdatadict_t *) aggetrec(g, DataDictName, 0);
     if (rv || !cflag)
@@ -74,6 +116,75 @@ static Dict_t *agdictof(Agraph_t * g, int kind)
     return NULL;
 }
 
+/* the attribute columns of a kind of object, if the graph stores them */
+static agcolumns_t *agcolumnsof(Agraph_t * g, int kind)
+{
+    struct graphviz_attr_columns *const columns = g->clos->columns;
+    if (columns == NULL)
+	return NULL;
+    switch (kind) {
+    case AGNODE:
+	return &columns->node;
+    case AGINEDGE:
+    case AGOUTEDGE:
+	return &columns->edge;
+    default:
+	return NULL;
+    }
+}
+
+/* start a column for a new root graph declaration */
+static void agcolumnadd(Agraph_t * root, Agsym_t * sym)
+{
+    agcolumns_t *const cols = agcolumnsof(root, sym->kind);
+    if (cols == NULL)
+	return;
+    const size_t id = (size_t)sym->id;
+    if (id >= cols->size) {
+	cols->base = gv_recalloc(cols->base, cols->size, id + 1,
+	                         sizeof(agcolumn_t));
+	cols->size = id + 1;
+    }
+    assert(cols->base[id].sym == NULL && "attribute declared twice");
+    cols->base[id].sym = sym;
+}
+
+/* where the value of an attribute of an object is stored, growing the column
+ * to hold it if `create` */
+static char **agcolumnslot(Agraph_t * g, agcolumns_t * cols, Agobj_t * obj,
+                           int id, bool create)
+{
+    assert(id >= 0 && (size_t)id < cols->size);
+    agcolumn_t *const col = &cols->base[id];
+    const size_t seq = AGSEQ(obj);
+    if (seq >= col->size) {
+	if (!create)
+	    return NULL;
+	/* make room for every object created so far, and then some */
+	size_t size = g->clos->seq[AGTYPE(obj) == AGNODE ? AGNODE : AGEDGE] + 1;
+	if (size < 2 * col->size)
+	    size = 2 * col->size;
+	col->values = gv_recalloc(col->values, col->size, size, sizeof(char *));
+	col->size = size;
+    }
+    return &col->values[seq];
+}
+
+void agcolumnsclose(Agraph_t * g)
+{
+    struct graphviz_attr_columns *const columns = g->clos->columns;
+    if (columns == NULL)
+	return;
+    agcolumns_t *const kinds[] = {&columns->node, &columns->edge};
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+	for (size_t j = 0; j < kinds[i]->size; j++)
+	    free(kinds[i]->base[j].values);
+	free(kinds[i]->base);
+    }
+    free(columns);
+    g->clos->columns = NULL;
+}
+
 /// @param is_html Is `value` an HTML-like string?
 static Agsym_t *agnewsym(Agraph_t * g, const char *name, const char *value,
                          bool is_html, int id, int kind) {
@@ -96,6 +207,7 @@ static void agcopydict(Dict_t * src, Dict_t * dest, Agraph_t * g, int kind)
 	newsym->print = sym->print;
 	newsym->fixed = sym->fixed;
 	dtinsert(dest, newsym);
+	agcolumnadd(g, newsym);
     }
 }
 
@@ -115,6 +227,7 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	dtview(dd->dict.e, parent_dd->dict.e);
 	dtview(dd->dict.g, parent_dd->dict.g);
     } else {
+	protolock();
 	if (ProtoGraph && g != ProtoGraph) {
 	    /* it's not ok to dtview here for several reasons. the proto
 	       graph could change, and the sym indices don't match */
@@ -123,6 +236,7 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	    agcopydict(parent_dd->dict.e, dd->dict.e, g, AGEDGE);
 	    agcopydict(parent_dd->dict.g, dd->dict.g, g, AGRAPH);
 	}
+	protounlock();
     }
     return dd;
 }
@@ -161,6 +275,35 @@ static int topdictsize(Agobj_t * obj)
     return d ? dtsize(d) : 0;
 }
 
+/* give a new object the defaults of the subgraph it is created in, and those of
+ * the subgraphs enclosing it, where they differ from those of the root graph */
+static void agcolumninit(agcolumns_t *cols, Agraph_t *g, Agobj_t *obj)
+{
+    Agraph_t *const par = agparent(g);
+    if (par == NULL)
+	return;
+    agcolumninit(cols, par, obj);
+
+    Agraph_t *const root = agraphof(obj);
+    Dict_t *const dict = agdictof(g, AGTYPE(obj));
+    Dict_t *const view = dtview(dict, NULL);
+    for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym)) {
+	const bool is_default = sym->defval == cols->base[sym->id].sym->defval;
+	char **const slot = agcolumnslot(root, cols, obj, sym->id, !is_default);
+	if (slot == NULL)
+	    continue;
+	agstrfree(root, *slot, aghtmlstr(*slot));
+	if (is_default) {
+	    *slot = NULL;
+	} else if (aghtmlstr(sym->defval)) {
+	    *slot = agstrdup_html(root, sym->defval);
+	} else {
+	    *slot = agstrdup(root, sym->defval);
+	}
+    }
+    dtview(dict, view);
+}
+
 /* g can be either the enclosing graph, or ProtoGraph */
 static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 {
@@ -170,8 +313,13 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
     assert(datadict);
     if (rec->dict == NULL) {
 	rec->dict = agdictof(agroot(context), AGTYPE(obj));
+	agcolumns_t *const cols = agcolumnsof(agraphof(obj), AGTYPE(obj));
+	if (cols) {
+	    agcolumninit(cols, context, obj);
+	    return &rec->h;
+	}
 	const int sz = topdictsize(obj);
-	rec->str = gv_calloc((size_t)sz, sizeof(char *));
+	rec->str = agalloc(agraphof(obj), (size_t)sz * sizeof(char *));
 	/* doesn't call agxset() so no obj-modified callbacks occur */
 	for (Agsym_t *sym = dtfirst(datadict); sym; sym = dtnext(datadict, sym)) {
 	    if (aghtmlstr(sym->defval)) {
@@ -189,10 +337,21 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 static void freeattr(Agobj_t * obj, Agattr_t * attr)
 {
     Agraph_t *const g = agraphof(obj);
+    agcolumns_t *const cols = agcolumnsof(g, AGTYPE(obj));
+    if (cols) {
+	for (size_t i = 0; i < cols->size; i++) {
+	    char **const slot = agcolumnslot(g, cols, obj, (int)i, false);
+	    if (slot && *slot) {
+		agstrfree(g, *slot, aghtmlstr(*slot));
+		*slot = NULL;
+	    }
+	}
+	return;
+    }
     const int sz = topdictsize(obj);
     for (int i = 0; i < sz; i++)
 	agstrfree(g, attr->str[i], aghtmlstr(attr->str[i]));
-    free(attr->str);
+    agfree(g, attr->str, (size_t)sz * sizeof(char *));
 }
 
 static void freesym(void *obj) {
@@ -211,8 +370,9 @@ static void addattr(Agraph_t *g, Agobj_t *obj, void *symbol) {
     Agsym_t *const sym = symbol;
     Agattr_t *attr = agattrrec(obj);
     assert(attr != NULL);
-    attr->str = gv_recalloc(attr->str, (size_t)sym->id, (size_t)sym->id + 1,
-                            sizeof(char *));
+    attr->str = agrealloc(agraphof(obj), attr->str,
+                          (size_t)sym->id * sizeof(char *),
+                          ((size_t)sym->id + 1) * sizeof(char *));
     if (aghtmlstr(sym->defval)) {
 	attr->str[sym->id] = agstrdup_html(g, sym->defval);
     } else {
@@ -251,6 +411,37 @@ static void unviewsubgraphsattr(Agraph_t *parent, char *name) {
   }
 }
 
+/* store the root graph default of an attribute in an object left at it */
+static void agcolumnkeep(Agraph_t * root, agcolumns_t * cols, Agobj_t * obj,
+                         Agsym_t * sym)
+{
+    char **const slot = agcolumnslot(root, cols, obj, sym->id, true);
+    if (*slot)
+	return;
+    if (aghtmlstr(sym->defval)) {
+	*slot = agstrdup_html(root, sym->defval);
+    } else {
+	*slot = agstrdup(root, sym->defval);
+    }
+}
+
+/* store the root graph default of an attribute in all objects left at it,
+ * before it changes, so they keep their value */
+static void agcolumnfill(Agraph_t * root, int kind, Agsym_t * sym)
+{
+    agcolumns_t *const cols = agcolumnsof(root, kind);
+    if (cols == NULL)
+	return;
+    for (Agnode_t *n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	if (kind == AGNODE) {
+	    agcolumnkeep(root, cols, &n->base, sym);
+	    continue;
+	}
+	for (Agedge_t *e = agfstout(root, n); e; e = agnxtout(root, e))
+	    agcolumnkeep(root, cols, &e->base, sym);
+    }
+}
+
 static int agxset_(void *obj, Agsym_t *sym, const char *value, bool is_html);
 
 /// @param is_html Is `value` an HTML-like string?
@@ -269,6 +460,8 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value,
         if (kind == AGRAPH) {
 	    unviewsubgraphsattr(g,name);
         }
+	if (g == root)
+	    agcolumnfill(root, kind, lsym);
 	agstrfree(g, lsym->defval, aghtmlstr(lsym->defval));
 	lsym->defval = is_html ? agstrdup_html(g, value) : agstrdup(g, value);
 	rv = lsym;
@@ -282,16 +475,24 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, const char *value,
 	    Dict_t *rdict = agdictof(root, kind);
 	    Agsym_t *rsym = agnewsym(root, name, value, is_html, dtsize(rdict), kind);
 	    dtinsert(rdict, rsym);
+	    agcolumnadd(root, rsym);
+	    /* objects whose values are stored by column take the new default
+	     * without being visited */
+	    const bool bycolumn = agcolumnsof(root, kind) != NULL;
 	    switch (kind) {
 	    case AGRAPH:
 		agapply(root, &root->base, addattr, rsym, true);
 		break;
 	    case AGNODE:
+		if (bycolumn)
+		    break;
 		for (Agnode_t *n = agfstnode(root); n; n = agnxtnode(root, n))
 		    addattr(g, &n->base, rsym);
 		break;
 	    case AGINEDGE:
 	    case AGOUTEDGE:
+		if (bycolumn)
+		    break;
 		for (Agnode_t *n = agfstnode(root); n; n = agnxtnode(root, n))
 		    for (Agedge_t *e = agfstout(root, n); e; e = agnxtout(root, e))
 			addattr(g, &e->base, rsym);
@@ -319,9 +520,10 @@ static Agsym_t *agattr_(Agraph_t *g, int kind, char *name, const char *value,
     Agsym_t *rv;
 
     if (g == NULL) {
-	if (ProtoGraph == NULL)
-	    ProtoGraph = agopen(NULL, ProtoDesc, NULL);
-	g = ProtoGraph;
+	protolock();
+	rv = agattr_(protograph(), kind, name, value, is_html);
+	protounlock();
+	return rv;
     }
     if (value)
 	rv = setattr(g, kind, name, value, is_html);
@@ -340,10 +542,10 @@ Agsym_t *agattr_html(Agraph_t *g, int kind, char *name, const char *value) {
 
 Agsym_t *agattr(Agraph_t *g, int kind, char *name, const char *value) {
   if (g == NULL) {
-    if (ProtoGraph == NULL) {
-      ProtoGraph = agopen(NULL, ProtoDesc, NULL);
-    }
-    g = ProtoGraph;
+    protolock();
+    Agsym_t *const rv = agattr(protograph(), kind, name, value);
+    protounlock();
+    return rv;
   }
 
   // Is the value we were passed a previously created HTML-like string? We
@@ -450,14 +652,19 @@ char *agget(void *obj, char *name)
     if (sym == NULL) {
 	return NULL; // note was "", but this provides more info
     }
-    Agattr_t *const data = agattrrec(obj);
-    return data->str[sym->id];
+    return agxget(obj, sym);
 }
 
 char *agxget(void *obj, Agsym_t * sym)
 {
-    Agattr_t *const data = agattrrec(obj);
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
+    Agraph_t *const g = agraphof(obj);
+    agcolumns_t *const cols = agcolumnsof(g, AGTYPE(obj));
+    if (cols) {
+	char **const slot = agcolumnslot(g, cols, obj, sym->id, false);
+	return slot && *slot ? *slot : cols->base[sym->id].sym->defval;
+    }
+    Agattr_t *const data = agattrrec(obj);
     return data->str[sym->id];
 }
 
@@ -499,10 +706,12 @@ static int agxset_(void *obj, Agsym_t *sym, const char *value, bool is_html) {
 
     Agraph_t *g = agraphof(obj);
     Agobj_t *hdr = obj;
-    Agattr_t *data = agattrrec(hdr);
     assert(sym->id >= 0 && sym->id < topdictsize(obj));
-    agstrfree(g, data->str[sym->id], aghtmlstr(data->str[sym->id]));
-    data->str[sym->id] = is_html ? agstrdup_html(g, value) : agstrdup(g, value);
+    agcolumns_t *const cols = agcolumnsof(g, AGTYPE(hdr));
+    char **const slot = cols ? agcolumnslot(g, cols, hdr, sym->id, true)
+                             : &agattrrec(hdr)->str[sym->id];
+    agstrfree(g, *slot, aghtmlstr(*slot));
+    *slot = is_html ? agstrdup_html(g, value) : agstrdup(g, value);
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict = agdatadict(g, false)->dict.g;
@@ -0,0 +1,858 @@
+/// @file
+/// @brief a compact binary serialization of graphs
+/// @ingroup cgraph_graph
+///
+/// A graph is written as its attribute declarations, a node table, an edge
+/// table whose entries refer to their endpoints by node index, the values of
+/// each node and edge attribute as a sparse column, and the subgraph tree with
+/// the members of each subgraph as a bitmap or a list of index gaps, whichever
+/// is smaller. A string is written once, where it is first used, and referred
+/// to by index after that, so the reader interns each distinct string once.
+/// Nothing is quoted or escaped, so neither side scans strings byte by byte.
+///
+/// All integers are unsigned LEB128 varints. The layout is:
+///
+///   magic         "\x89GVB\r\n\x1a\n"
+///   version       1
+///   flags         1 directed, 2 strict, 4 no loops
+///   name          name of the root graph
+///   declarations  for graph, node, then edge attributes: a count, then the
+///                 name, default and flags of each
+///   nodes         a count, then the name of each in sequence order
+///   edges         a count, then the tail index, head index and key of each
+///                 in sequence order
+///   columns       for each declared node attribute, then each edge attribute:
+///                 a count of values differing from the default, then for each
+///                 the gap in index since the previous one and the value
+///   subgraphs     a count, then for each its name; its local declarations
+///                 for graph, node and edge attributes as a count, then the
+///                 number of the declaration, default and flags of each; its
+///                 nodes; its edges; and its subgraphs
+///
+/// A string is 0 for none, 2 + `i` for the `i`th string seen so far, or 1
+/// followed by a new string: its length shifted left one bit, with the low bit
+/// set if it is HTML-like, then its bytes. The flags of a declaration are 1 if
+/// it is always written as DOT, even when empty, and 2 if it is fixed. A set of members is its size
+/// shifted left one bit, with the low bit set if a bitmap over all indices
+/// follows, then either the bitmap or the gap before each member.
+///
+/// Graph attribute values are not written separately, as setting one also
+/// sets the graph's local default.
+
+#include "config.h"
+
+#include <assert.h>
+#include <cgraph/cghdr.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/agxbuf.h>
+#include <util/alloc.h>
+#include <util/list.h>
+
+static const unsigned char MAGIC[] = {0x89, 'G', 'V', 'B', '\r', '\n', 0x1a,
+                                      '\n'};
+static_assert(AGBIN_LEAD == 0x89,
+              "AGBIN_LEAD does not match the binary graph magic");
+
+enum { VERSION = 1 };
+
+enum { FLAG_DIRECTED = 1, FLAG_STRICT = 2, FLAG_NO_LOOP = 4 };
+
+enum { SYM_PRINT = 1, SYM_FIXED = 2 };
+
+/// attribute kinds, in the order their declarations are written
+static const int KINDS[] = {AGRAPH, AGNODE, AGEDGE};
+enum { NKINDS = sizeof(KINDS) / sizeof(KINDS[0]) };
+
+bool agisbin(const char *data, size_t size) {
+  return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/******************************* writing *******************************/
+
+/// a string already written, and its index
+typedef struct {
+  const char *s;
+  size_t index;
+  bool is_html;
+} strtab_entry_t;
+
+/// strings written so far, by content
+typedef struct {
+  strtab_entry_t *slots;
+  size_t capacity; ///< a power of 2
+  size_t size;
+} strtab_t;
+
+enum { WRITE_BUFFER = 64 * 1024 };
+
+typedef struct {
+  void *chan;
+  size_t (*write)(void *chan, const void *buf, size_t len);
+  bool error;
+  size_t len;
+  unsigned char buf[WRITE_BUFFER];
+  strtab_t strings;
+  /// declared attributes of each kind, in the order they were written
+  Agsym_t **syms[NKINDS];
+  size_t nsyms[NKINDS];
+  /// the number under which each root attribute was declared, by ID
+  size_t *numbers[NKINDS];
+  /// node and edge indices, by sequence number
+  size_t *node_index;
+  size_t *edge_index;
+  size_t nnodes;
+  size_t nedges;
+} writer_t;
+
+static size_t stdio_write(void *chan, const void *buf, size_t len) {
+  return fwrite(buf, 1, len, chan);
+}
+
+static void flush(writer_t *w) {
+  if (w->len > 0 && !w->error && w->write(w->chan, w->buf, w->len) != w->len)
+    w->error = true;
+  w->len = 0;
+}
+
+static void put_bytes(writer_t *w, const void *data, size_t len) {
+  if (w->len + len > sizeof(w->buf)) {
+    flush(w);
+    if (len > sizeof(w->buf)) {
+      if (!w->error && w->write(w->chan, data, len) != len)
+        w->error = true;
+      return;
+    }
+  }
+  memcpy(w->buf + w->len, data, len);
+  w->len += len;
+}
+
+static void put_varint(writer_t *w, uint64_t v) {
+  if (w->len + 10 > sizeof(w->buf))
+    flush(w);
+  do {
+    unsigned char b = v & 0x7f;
+    v >>= 7;
+    if (v != 0)
+      b |= 0x80;
+    w->buf[w->len++] = b;
+  } while (v != 0);
+}
+
+static size_t varint_size(uint64_t v) {
+  size_t n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+static size_t hash_str(const char *s, bool is_html) {
+  // FNV-1a
+  uint64_t h = 0xcbf29ce484222325ull ^ (uint64_t)is_html;
+  for (; *s != '\0'; ++s) {
+    h ^= (unsigned char)*s;
+    h *= 0x100000001b3ull;
+  }
+  return (size_t)h;
+}
+
+/// find a string in the table, or the slot it would go in
+static strtab_entry_t *strtab_find(const strtab_t *t, const char *s,
+                                   bool is_html) {
+  const size_t mask = t->capacity - 1;
+  for (size_t i = hash_str(s, is_html) & mask;; i = (i + 1) & mask) {
+    strtab_entry_t *const e = &t->slots[i];
+    if (e->s == NULL ||
+        (e->is_html == is_html && (e->s == s || strcmp(e->s, s) == 0)))
+      return e;
+  }
+}
+
+static void strtab_grow(strtab_t *t) {
+  strtab_t bigger = {.capacity = t->capacity == 0 ? 1024 : t->capacity * 2};
+  bigger.slots = gv_calloc(bigger.capacity, sizeof(bigger.slots[0]));
+  for (size_t i = 0; i < t->capacity; ++i) {
+    if (t->slots[i].s != NULL)
+      *strtab_find(&bigger, t->slots[i].s, t->slots[i].is_html) = t->slots[i];
+  }
+  bigger.size = t->size;
+  free(t->slots);
+  *t = bigger;
+}
+
+/// write a string, or a reference to it if it has been written before
+static void put_str(writer_t *w, const char *s, bool is_html) {
+  if (s == NULL) {
+    put_varint(w, 0);
+    return;
+  }
+  if (2 * (w->strings.size + 1) > w->strings.capacity)
+    strtab_grow(&w->strings);
+  strtab_entry_t *const e = strtab_find(&w->strings, s, is_html);
+  if (e->s != NULL) {
+    put_varint(w, (uint64_t)e->index + 2);
+    return;
+  }
+  *e = (strtab_entry_t){.s = s, .index = w->strings.size++, .is_html = is_html};
+  const size_t len = strlen(s);
+  put_varint(w, 1);
+  put_varint(w, (uint64_t)len << 1 | is_html);
+  put_bytes(w, s, len);
+}
+
+/// write a string obtained from `agstrdup` or an attribute lookup
+static void put_refstr(writer_t *w, const char *s) {
+  put_str(w, s, s != NULL && aghtmlstr(s));
+}
+
+/// write the name of a graph, node or edge, or none if it is anonymous
+///
+/// Unlike `agnameof`, this does not make up a name for anonymous objects.
+static void put_name(writer_t *w, void *obj) {
+  Agraph_t *const g = agraphof(obj);
+  char *name = aginternalmapprint(g, AGTYPE(obj), AGID(obj));
+  if (name == NULL && AGDISC(g, id)->print != NULL)
+    name = AGDISC(g, id)->print(AGCLOS(g, id), AGTYPE(obj), AGID(obj));
+  if (name == NULL || (AGTYPE(obj) == AGEDGE && name[0] == '\0')) {
+    put_varint(w, 0);
+    return;
+  }
+  put_refstr(w, name);
+}
+
+static void put_sym_flags(writer_t *w, const Agsym_t *sym) {
+  put_varint(w, (sym->print ? SYM_PRINT : 0) | (sym->fixed ? SYM_FIXED : 0));
+}
+
+static void put_declarations(writer_t *w, Agraph_t *g) {
+  for (size_t k = 0; k < NKINDS; ++k) {
+    size_t n = 0;
+    for (Agsym_t *sym = agnxtattr(g, KINDS[k], NULL); sym != NULL;
+         sym = agnxtattr(g, KINDS[k], sym))
+      ++n;
+    w->syms[k] = gv_calloc(n, sizeof(Agsym_t *));
+    w->numbers[k] = gv_calloc(n, sizeof(size_t));
+    w->nsyms[k] = n;
+    put_varint(w, n);
+    size_t i = 0;
+    for (Agsym_t *sym = agnxtattr(g, KINDS[k], NULL); sym != NULL;
+         sym = agnxtattr(g, KINDS[k], sym), ++i) {
+      assert(sym->id >= 0 && (size_t)sym->id < n);
+      w->syms[k][i] = sym;
+      w->numbers[k][sym->id] = i;
+      put_refstr(w, sym->name);
+      put_refstr(w, sym->defval);
+      put_sym_flags(w, sym);
+    }
+  }
+}
+
+static void put_local_declarations(writer_t *w, Agraph_t *subg) {
+  Agdatadict_t *const dd = agdatadict(subg, false);
+  Dict_t *const dicts[] = {dd ? dd->dict.g : NULL, dd ? dd->dict.n : NULL,
+                           dd ? dd->dict.e : NULL};
+  for (size_t k = 0; k < NKINDS; ++k) {
+    Dict_t *const dict = dicts[k];
+    if (dict == NULL) {
+      put_varint(w, 0);
+      continue;
+    }
+    // only this subgraph's own declarations, not those it inherits
+    Dict_t *const view = dtview(dict, NULL);
+    size_t n = 0;
+    for (Agsym_t *sym = dtfirst(dict); sym != NULL; sym = dtnext(dict, sym)) {
+      if (sym->id >= 0 && (size_t)sym->id < w->nsyms[k])
+        ++n;
+    }
+    put_varint(w, n);
+    for (Agsym_t *sym = dtfirst(dict); sym != NULL; sym = dtnext(dict, sym)) {
+      if (sym->id >= 0 && (size_t)sym->id < w->nsyms[k]) {
+        put_varint(w, w->numbers[k][sym->id]);
+        put_refstr(w, sym->defval);
+        put_sym_flags(w, sym);
+      }
+    }
+    dtview(dict, view);
+  }
+}
+
+/// write a set of indices, sorted ascending, from `0, …, universe - 1`
+static void put_set(writer_t *w, const size_t *members, size_t n,
+                    size_t universe) {
+  size_t gaps = 0;
+  for (size_t i = 0, next = 0; i < n; next = members[i++] + 1)
+    gaps += varint_size(members[i] - next);
+  const size_t bitmap = (universe + 7) / 8;
+  if (bitmap < gaps) {
+    unsigned char *const bits = gv_calloc(bitmap, sizeof(bits[0]));
+    for (size_t i = 0; i < n; ++i)
+      bits[members[i] / 8] |= (unsigned char)(1u << (members[i] % 8));
+    put_varint(w, (uint64_t)n << 1 | 1);
+    put_bytes(w, bits, bitmap);
+    free(bits);
+    return;
+  }
+  put_varint(w, (uint64_t)n << 1);
+  for (size_t i = 0, next = 0; i < n; next = members[i++] + 1)
+    put_varint(w, members[i] - next);
+}
+
+static int cmp_size(const void *a, const void *b) {
+  const size_t *x = a;
+  const size_t *y = b;
+  return *x < *y ? -1 : *x > *y;
+}
+
+static void put_subgraphs(writer_t *w, Agraph_t *g) {
+  size_t n = 0;
+  for (Agraph_t *subg = agfstsubg(g); subg != NULL; subg = agnxtsubg(subg))
+    ++n;
+  put_varint(w, n);
+
+  LIST(size_t) members = {0};
+  for (Agraph_t *subg = agfstsubg(g); subg != NULL; subg = agnxtsubg(subg)) {
+    put_name(w, subg);
+    put_local_declarations(w, subg);
+
+    for (Agnode_t *v = agfstnode(subg); v != NULL; v = agnxtnode(subg, v))
+      LIST_APPEND(&members, w->node_index[AGSEQ(v)]);
+    put_set(w, members.base, LIST_SIZE(&members), w->nnodes);
+    LIST_CLEAR(&members);
+
+    for (Agnode_t *v = agfstnode(subg); v != NULL; v = agnxtnode(subg, v)) {
+      for (Agedge_t *e = agfstout(subg, v); e != NULL; e = agnxtout(subg, e))
+        LIST_APPEND(&members, w->edge_index[AGSEQ(e)]);
+    }
+    LIST_SORT(&members, cmp_size);
+    put_set(w, members.base, LIST_SIZE(&members), w->nedges);
+    LIST_CLEAR(&members);
+
+    put_subgraphs(w, subg);
+  }
+  LIST_FREE(&members);
+}
+
+static int cmp_edge_seq(const void *a, const void *b) {
+  Agedge_t *const *x = a;
+  Agedge_t *const *y = b;
+  return AGSEQ(*x) < AGSEQ(*y) ? -1 : AGSEQ(*x) > AGSEQ(*y);
+}
+
+/// write the value of each attribute where it differs from the default
+static void put_columns(writer_t *w, size_t k, void **objs, size_t n) {
+  for (size_t i = 0; i < w->nsyms[k]; ++i) {
+    Agsym_t *const sym = w->syms[k][i];
+    size_t count = 0;
+    for (size_t j = 0; j < n; ++j) {
+      if (agxget(objs[j], sym) != sym->defval)
+        ++count;
+    }
+    put_varint(w, count);
+    for (size_t j = 0, next = 0; j < n; ++j) {
+      char *const value = agxget(objs[j], sym);
+      if (value != sym->defval) {
+        put_varint(w, j - next);
+        put_refstr(w, value);
+        next = j + 1;
+      }
+    }
+  }
+}
+
+int agwritebin(Agraph_t *g, void *chan,
+               size_t (*write)(void *chan, const void *buf, size_t len)) {
+  assert(g != NULL);
+  g = agroot(g);
+
+  writer_t *const w = gv_alloc(sizeof(*w));
+  w->chan = chan;
+  w->write = write != NULL ? write : stdio_write;
+
+  put_bytes(w, MAGIC, sizeof(MAGIC));
+  put_varint(w, VERSION);
+  put_varint(w, (g->desc.directed ? FLAG_DIRECTED : 0) |
+                    (g->desc.strict ? FLAG_STRICT : 0) |
+                    (g->desc.no_loop ? FLAG_NO_LOOP : 0));
+  put_name(w, g);
+  put_declarations(w, g);
+
+  w->nnodes = (size_t)agnnodes(g);
+  void **const nodes = gv_calloc(w->nnodes, sizeof(nodes[0]));
+  w->node_index = gv_calloc(g->clos->seq[AGNODE] + 1, sizeof(size_t));
+  put_varint(w, w->nnodes);
+  {
+    size_t i = 0;
+    for (Agnode_t *v = agfstnode(g); v != NULL; v = agnxtnode(g, v), ++i) {
+      nodes[i] = v;
+      w->node_index[AGSEQ(v)] = i;
+      put_name(w, v);
+    }
+  }
+
+  w->nedges = (size_t)agnedges(g);
+  void **const edges = gv_calloc(w->nedges, sizeof(edges[0]));
+  w->edge_index = gv_calloc(g->clos->seq[AGEDGE] + 1, sizeof(size_t));
+  {
+    size_t i = 0;
+    for (Agnode_t *v = agfstnode(g); v != NULL; v = agnxtnode(g, v)) {
+      for (Agedge_t *e = agfstout(g, v); e != NULL; e = agnxtout(g, e))
+        edges[i++] = e;
+    }
+    assert(i == w->nedges);
+  }
+  qsort(edges, w->nedges, sizeof(edges[0]), cmp_edge_seq);
+  put_varint(w, w->nedges);
+  for (size_t i = 0; i < w->nedges; ++i) {
+    Agedge_t *const e = edges[i];
+    w->edge_index[AGSEQ(e)] = i;
+    put_varint(w, w->node_index[AGSEQ(agtail(e))]);
+    put_varint(w, w->node_index[AGSEQ(aghead(e))]);
+    put_name(w, e);
+  }
+
+  put_columns(w, 1, nodes, w->nnodes);
+  put_columns(w, 2, edges, w->nedges);
+  put_subgraphs(w, g);
+  flush(w);
+
+  const int rc = w->error ? EOF : 0;
+  free(edges);
+  free(nodes);
+  free(w->edge_index);
+  free(w->node_index);
+  for (size_t k = 0; k < NKINDS; ++k) {
+    free(w->numbers[k]);
+    free(w->syms[k]);
+  }
+  free(w->strings.slots);
+  free(w);
+  return rc;
+}
+
+/******************************* reading *******************************/
+
+typedef struct {
+  /// input in memory, if `end` is non-NULL
+  const unsigned char *cur;
+  const unsigned char *end;
+  /// otherwise, a stream and how to read from it
+  void *chan;
+  size_t (*read)(void *chan, void *buf, size_t len);
+  bool error; ///< was the input malformed or truncated?
+  Agraph_t *g;
+  LIST(char *) strings; ///< strings seen so far, each holding a reference
+  agxbuf scratch;
+  Agsym_t **syms[NKINDS]; ///< declared attributes of each kind
+  size_t nsyms[NKINDS];
+  Agnode_t **nodes;
+  size_t nnodes;
+  Agedge_t **edges;
+  size_t nedges;
+} reader_t;
+
+static size_t stdio_read(void *chan, void *buf, size_t len) {
+  return fread(buf, 1, len, chan);
+}
+
+static void get_bytes(reader_t *r, void *dst, size_t len) {
+  if (r->error)
+    return;
+  if (r->end != NULL) {
+    if ((size_t)(r->end - r->cur) < len) {
+      r->error = true;
+      return;
+    }
+    memcpy(dst, r->cur, len);
+    r->cur += len;
+    return;
+  }
+  if (r->read(r->chan, dst, len) != len)
+    r->error = true;
+}
+
+static unsigned get_byte(reader_t *r) {
+  if (r->end != NULL) {
+    if (r->cur == r->end) {
+      r->error = true;
+      return 0;
+    }
+    return *r->cur++;
+  }
+  if (r->read == stdio_read) {
+    const int c = getc(r->chan);
+    if (c == EOF) {
+      r->error = true;
+      return 0;
+    }
+    return (unsigned)c;
+  }
+  unsigned char c = 0;
+  get_bytes(r, &c, 1);
+  return c;
+}
+
+static uint64_t get_varint(reader_t *r) {
+  uint64_t v = 0;
+  for (unsigned shift = 0; !r->error; shift += 7) {
+    if (shift >= 64) {
+      r->error = true;
+      break;
+    }
+    const unsigned b = get_byte(r);
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return v;
+  }
+  return 0;
+}
+
+/// read a count or index, which must be less than `limit`
+static size_t get_size(reader_t *r, size_t limit) {
+  const uint64_t v = get_varint(r);
+  if (v >= limit) {
+    r->error = true;
+    return 0;
+  }
+  return (size_t)v;
+}
+
+/// read the number of entries in a table, each taking at least `min_bytes`
+///
+/// In memory, the count is checked against the bytes left. The length of a
+/// stream is not known, so tables are grown as their entries are read rather
+/// than allocated up front for the count.
+static size_t get_count(reader_t *r, size_t min_bytes) {
+  const size_t n = get_size(r, INT_MAX);
+  if (r->end != NULL && n > (size_t)(r->end - r->cur) / min_bytes) {
+    r->error = true;
+    return 0;
+  }
+  return n;
+}
+
+/// make room for entry `i` of a table filled in order
+///
+/// @param table Table of `*capacity` entries of `size` bytes
+/// @return The table, possibly moved
+static void *grow(void *table, size_t *capacity, size_t i, size_t size) {
+  if (i < *capacity)
+    return table;
+  const size_t bigger = *capacity == 0 ? 64 : *capacity * 2;
+  table = gv_recalloc(table, *capacity, bigger, size);
+  *capacity = bigger;
+  return table;
+}
+
+/// read the bytes of a new string into the scratch buffer
+///
+/// @return Whether the string is HTML-like
+static bool get_new_str(reader_t *r) {
+  const uint64_t v = get_varint(r);
+  uint64_t len = v >> 1;
+  agxbclear(&r->scratch);
+  // read in pieces, so a bad length in a stream fails before exhausting memory
+  char piece[4096];
+  while (len > 0 && !r->error) {
+    const size_t n = len < sizeof(piece) ? (size_t)len : sizeof(piece);
+    get_bytes(r, piece, n);
+    agxbput_n(&r->scratch, piece, n);
+    len -= n;
+  }
+  if (!r->error && memchr(agxbstart(&r->scratch), '\0',
+                          agxblen(&r->scratch)) != NULL)
+    r->error = true;
+  return v & 1;
+}
+
+/// read a string reference
+///
+/// @return The string, interned in the graph, or NULL for none or on error
+static char *get_str(reader_t *r) {
+  const uint64_t v = get_varint(r);
+  if (r->error || v == 0)
+    return NULL;
+  if (v == 1) {
+    const bool is_html = get_new_str(r);
+    if (r->error)
+      return NULL;
+    char *const s = agxbuse(&r->scratch);
+    char *const interned =
+        is_html ? agstrdup_html(r->g, s) : agstrdup_text(r->g, s);
+    LIST_APPEND(&r->strings, interned);
+    return interned;
+  }
+  if (v - 2 >= LIST_SIZE(&r->strings)) {
+    r->error = true;
+    return NULL;
+  }
+  return LIST_GET(&r->strings, (size_t)(v - 2));
+}
+
+/// read a string reference that must not be none
+static char *get_some_str(reader_t *r) {
+  char *const s = get_str(r);
+  if (s == NULL)
+    r->error = true;
+  return s;
+}
+
+static void set_sym_flags(Agsym_t *sym, uint64_t flags) {
+  if (sym == NULL)
+    return;
+  sym->print = (flags & SYM_PRINT) != 0;
+  sym->fixed = (flags & SYM_FIXED) != 0;
+}
+
+static void get_declarations(reader_t *r) {
+  for (size_t k = 0; k < NKINDS && !r->error; ++k) {
+    // a name, a default and flags
+    const size_t n = get_count(r, 3);
+    size_t capacity = 0;
+    for (size_t i = 0; i < n && !r->error; ++i, ++r->nsyms[k]) {
+      char *const name = get_some_str(r);
+      char *const def = get_some_str(r);
+      const uint64_t flags = get_varint(r);
+      if (r->error)
+        break;
+      r->syms[k] = grow(r->syms[k], &capacity, i, sizeof(Agsym_t *));
+      r->syms[k][i] = aghtmlstr(def) ? agattr_html(r->g, KINDS[k], name, def)
+                                     : agattr_text(r->g, KINDS[k], name, def);
+      set_sym_flags(r->syms[k][i], flags);
+    }
+  }
+}
+
+static void get_local_declarations(reader_t *r, Agraph_t *subg) {
+  for (size_t k = 0; k < NKINDS && !r->error; ++k) {
+    const size_t n = get_size(r, r->nsyms[k] + 1);
+    for (size_t i = 0; i < n && !r->error; ++i) {
+      const size_t number = get_size(r, r->nsyms[k]);
+      char *const def = get_some_str(r);
+      const uint64_t flags = get_varint(r);
+      if (r->error)
+        break;
+      char *const name = r->syms[k][number]->name;
+      set_sym_flags(aghtmlstr(def) ? agattr_html(subg, KINDS[k], name, def)
+                                   : agattr_text(subg, KINDS[k], name, def),
+                    flags);
+    }
+  }
+}
+
+static void set_value(void *obj, Agsym_t *sym, char *value) {
+  if (aghtmlstr(value)) {
+    agxset_html(obj, sym, value);
+  } else {
+    agxset_text(obj, sym, value);
+  }
+}
+
+/// read the values of node (`k` = 1) or edge (`k` = 2) attributes
+static void get_columns(reader_t *r, size_t k) {
+  const size_t n = k == 1 ? r->nnodes : r->nedges;
+  for (size_t i = 0; i < r->nsyms[k] && !r->error; ++i) {
+    const size_t count = get_size(r, n + 1);
+    for (size_t j = 0, next = 0; j < count && !r->error; ++j) {
+      const size_t index = next + get_size(r, n - next);
+      char *const value = get_some_str(r);
+      if (r->error)
+        break;
+      void *const obj =
+          k == 1 ? (void *)r->nodes[index] : (void *)r->edges[index];
+      set_value(obj, r->syms[k][i], value);
+      next = index + 1;
+    }
+  }
+}
+
+/// read a set of indices from `0, …, universe - 1`, calling `add` for each
+static void get_set(reader_t *r, size_t universe,
+                    void (*add)(reader_t *r, Agraph_t *subg, size_t index),
+                    Agraph_t *subg) {
+  const uint64_t v = get_varint(r);
+  const uint64_t n = v >> 1;
+  if (n > universe) {
+    r->error = true;
+    return;
+  }
+  if (v & 1) {
+    const size_t size = (universe + 7) / 8;
+    unsigned char *const bits = gv_alloc(size);
+    get_bytes(r, bits, size);
+    for (size_t i = 0; i < universe && !r->error; ++i) {
+      if (bits[i / 8] & (1u << (i % 8)))
+        add(r, subg, i);
+    }
+    free(bits);
+    return;
+  }
+  for (size_t i = 0, next = 0; i < n && !r->error; ++i) {
+    const size_t index = next + get_size(r, universe - next);
+    if (!r->error)
+      add(r, subg, index);
+    next = index + 1;
+  }
+}
+
+static void add_node(reader_t *r, Agraph_t *subg, size_t index) {
+  agsubnode(subg, r->nodes[index], 1);
+}
+
+static void add_edge(reader_t *r, Agraph_t *subg, size_t index) {
+  agsubedge(subg, r->edges[index], 1);
+}
+
+/// how deeply subgraphs may be nested, bounding the recursion of reading them
+enum { MAX_SUBGRAPH_DEPTH = 1000 };
+
+static void get_subgraphs(reader_t *r, Agraph_t *g, int depth) {
+  const size_t n = get_size(r, SIZE_MAX);
+  if (n > 0 && depth == MAX_SUBGRAPH_DEPTH) {
+    agerrorf("binary graph has subgraphs nested more than %d deep\n",
+             MAX_SUBGRAPH_DEPTH);
+    r->error = true;
+    return;
+  }
+  for (size_t i = 0; i < n && !r->error; ++i) {
+    char *const name = get_str(r);
+    if (r->error)
+      break;
+    Agraph_t *const subg = agsubg(g, name, 1);
+    get_local_declarations(r, subg);
+    get_set(r, r->nnodes, add_node, subg);
+    get_set(r, r->nedges, add_edge, subg);
+    get_subgraphs(r, subg, depth + 1);
+  }
+}
+
+static Agraph_t *read_graph(reader_t *r, Agdisc_t *disc, unsigned options) {
+  unsigned char magic[sizeof(MAGIC)];
+  get_bytes(r, magic, sizeof(magic));
+  if (r->error)
+    return NULL;
+  if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    agerrorf("not a binary graph\n");
+    return NULL;
+  }
+  const uint64_t version = get_varint(r);
+  if (!r->error && version != VERSION) {
+    agerrorf("unsupported binary graph version %" PRIu64 "\n", version);
+    return NULL;
+  }
+  const uint64_t flags = get_varint(r);
+
+  // the graph's name is the first string, and read before there is a graph
+  // to intern it in
+  const uint64_t name_ref = get_varint(r);
+  bool name_html = false;
+  if (name_ref == 1) {
+    name_html = get_new_str(r);
+  } else if (name_ref != 0) {
+    r->error = true;
+  }
+  if (r->error) {
+    agerrorf("truncated or malformed binary graph\n");
+    return NULL;
+  }
+  const Agdesc_t desc = {.directed = (flags & FLAG_DIRECTED) != 0,
+                         .strict = (flags & FLAG_STRICT) != 0,
+                         .no_loop = (flags & FLAG_NO_LOOP) != 0,
+                         .maingraph = true};
+  Agraph_t *const g = agopen_flags(
+      name_ref == 1 ? agxbuse(&r->scratch) : NULL, desc, disc, options);
+  if (g == NULL)
+    return NULL;
+  r->g = g;
+  if (name_ref == 1) {
+    char *const name = agnameof(g);
+    LIST_APPEND(&r->strings, name_html ? agstrdup_html(g, name)
+                                       : agstrdup_text(g, name));
+  }
+
+  get_declarations(r);
+
+  // a name for each node
+  const size_t nnodes = get_count(r, 1);
+  size_t capacity = 0;
+  for (size_t i = 0; i < nnodes && !r->error; ++i) {
+    char *const name = get_str(r);
+    if (r->error)
+      break;
+    r->nodes = grow(r->nodes, &capacity, i, sizeof(r->nodes[0]));
+    r->nodes[i] = agnode(g, name, 1);
+    ++r->nnodes;
+  }
+
+  // a tail, a head and a key for each edge
+  const size_t nedges = get_count(r, 3);
+  capacity = 0;
+  for (size_t i = 0; i < nedges && !r->error; ++i) {
+    const size_t tail = get_size(r, r->nnodes);
+    const size_t head = get_size(r, r->nnodes);
+    char *const key = get_str(r);
+    if (r->error)
+      break;
+    r->edges = grow(r->edges, &capacity, i, sizeof(r->edges[0]));
+    r->edges[i] = agedge(g, r->nodes[tail], r->nodes[head], key, 1);
+    if (r->edges[i] == NULL) {
+      r->error = true;
+      break;
+    }
+    ++r->nedges;
+  }
+
+  get_columns(r, 1);
+  get_columns(r, 2);
+  get_subgraphs(r, g, 0);
+
+  if (r->error) {
+    agerrorf("truncated or malformed binary graph\n");
+    agclose(g);
+    r->g = NULL;
+    return NULL;
+  }
+  return g;
+}
+
+static void reader_free(reader_t *r) {
+  if (r->g != NULL) {
+    for (size_t i = 0; i < LIST_SIZE(&r->strings); ++i) {
+      char *const s = LIST_GET(&r->strings, i);
+      agstrfree(r->g, s, aghtmlstr(s));
+    }
+  }
+  LIST_FREE(&r->strings);
+  agxbfree(&r->scratch);
+  for (size_t k = 0; k < NKINDS; ++k)
+    free(r->syms[k]);
+  free(r->nodes);
+  free(r->edges);
+}
+
+Agraph_t *agreadbin(void *chan,
+                    size_t (*read)(void *chan, void *buf, size_t len),
+                    Agdisc_t *disc) {
+  reader_t r = {.chan = chan, .read = read != NULL ? read : stdio_read};
+  Agraph_t *const g = read_graph(&r, disc, 0);
+  reader_free(&r);
+  return g;
+}
+
+Agraph_t *agreadbinbuf(const char *data, size_t size, size_t *used,
+                       Agdisc_t *disc, unsigned flags) {
+  reader_t r = {.cur = (const unsigned char *)data,
+                .end = (const unsigned char *)data + size};
+  Agraph_t *const g = read_graph(&r, disc, flags);
+  *used = (size_t)((const char *)r.cur - data);
+  reader_free(&r);
+  return g;
+}
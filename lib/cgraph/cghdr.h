@@ -69,9 +69,25 @@ extern Dtdisc_t Ag_subgraph_seq_disc;
 Agraph_t *agopen1(Agraph_t * g);
 int agstrclose(Agraph_t * g);
 
+/// how a reference-counted string is written in DOT, as remembered by
+/// @ref agwrite
+typedef enum {
+  STRCANON_UNKNOWN = 0, ///< not yet determined
+  STRCANON_PLAIN,       ///< written as is, without quotes
+  STRCANON_QUOTED,      ///< needs quoting or escaping
+} strcanon_t;
+
+/// what is known about how a string from @ref agstrdup is written
+strcanon_t agstrcanonstate(const char *s);
+/// remember how a string from @ref agstrdup is written
+void agsetstrcanonstate(const char *s, strcanon_t state);
+
 /// Mask of `Agtag_s.seq` width
 enum { SEQ_MASK = (1 << (sizeof(unsigned) * 8 - 4)) - 1 };
 
+/// are these options of agopen_flags known? Reports an error if not.
+bool agflagsknown(unsigned flags);
+
 	/* object set management */
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id);
 uint64_t agnextseq(Agraph_t * g, int objtype);
@@ -95,6 +111,31 @@ void agnodeattr_init(Agraph_t *g, Agnode_t * n);
 void agnodeattr_delete(Agnode_t * n);
 void agedgeattr_init(Agraph_t *g, Agedge_t * e);
 void agedgeattr_delete(Agedge_t * e);
+
+/// values of a node or edge attribute, indexed by object sequence number
+typedef struct {
+  Agsym_t *sym;  ///< root graph declaration, giving the value of unset entries
+  char **values; ///< values set, NULL for objects left at `sym->defval`
+  size_t size;   ///< number of entries in `values`
+} agcolumn_t;
+
+/// values of all node or all edge attributes, indexed by `Agsym_t.id`
+typedef struct {
+  agcolumn_t *base;
+  size_t size;
+} agcolumns_t;
+
+/// attribute values of the nodes and edges of a root graph
+struct graphviz_attr_columns {
+  agcolumns_t node;
+  agcolumns_t edge;
+};
+
+/// release the attribute columns of a root graph
+///
+/// Any values still in them are assumed to be released with the string
+/// dictionary.
+void agcolumnsclose(Agraph_t *g);
 /// @}
 
 	/* parsing and lexing graph files
@@ -114,6 +155,31 @@ void aagset_in(FILE *, aagscan_t);
 int aagparse(aagscan_t scanner);
 void aglexeof(aagscan_t yyscanner);
 void aglexbad(aagscan_t yyscanner);
+void aglexbuffer(aagscan_t yyscanner, const char *data, size_t size);
+size_t aglexoffset(aagscan_t yyscanner);
+
+/// parse a graph from a buffer, as @ref agconcat would from a channel
+///
+/// @param data Input
+/// @param size Number of bytes of input
+/// @param [out] used Number of bytes consumed, to resume from for the next graph
+/// @param flags Options of a new graph, as for @ref agopen_flags
+Agraph_t *agconcatbuf(Agraph_t *g, const char *filename, const char *data,
+                      size_t size, size_t *used, Agdisc_t *disc,
+                      unsigned flags);
+
+/// parse a new graph from a buffer as @ref agconcatbuf would, tokenizing it
+/// on several threads if its body is a flat list of statements
+Agraph_t *agreadparallelbuf(const char *filename, const char *data,
+                            size_t size, size_t *used, Agdisc_t *disc,
+                            unsigned flags);
+
+/// read a graph in the binary format from a buffer, as @ref agreadbin would
+///
+/// @param [out] used Number of bytes consumed, to resume from for the next graph
+/// @param flags Options of the new graph, as for @ref agopen_flags
+Agraph_t *agreadbinbuf(const char *data, size_t size, size_t *used,
+                       Agdisc_t *disc, unsigned flags);
 
 	/* ID management */
 int agmapnametoid(Agraph_t *g, int objtype, char *str, IDTYPE *result,
@@ -154,4 +220,26 @@ void agdelcb(Agraph_t * g, void *obj, Agcbstack_t * disc);
 /// @defgroup cgmem memory
 /// @{
 void aginternalmapclearlocalnames(Agraph_t *g);
+
+/// allocate zeroed memory for an object of a graph
+///
+/// This comes from the region of the root graph if its discipline asked for
+/// one, and from the heap otherwise.
+///
+/// @param g Graph or subgraph the object belongs to
+/// @param size Number of bytes to allocate
+/// @return Pointer to allocated memory
+void *agalloc(Agraph_t *g, size_t size);
+
+/// resize memory from `agalloc`, zeroing any added bytes
+void *agrealloc(Agraph_t *g, void *ptr, size_t old_size, size_t size);
+
+/// release memory from `agalloc`
+///
+/// Memory from a region is only reclaimed when the root graph is closed.
+///
+/// @param g Graph or subgraph the object belongs to
+/// @param ptr Memory to release
+/// @param size Number of bytes originally allocated, or 0 if not known
+void agfree(Agraph_t *g, void *ptr, size_t size);
 /// @}
@@ -403,6 +403,15 @@ CGRAPH_API int agpopdisc(Agraph_t *g, Agcbdisc_t *disc);
 
 /// @}
 
+/// opaque type; the definition of this is internal to Graphviz
+struct graphviz_arena;
+
+/// opaque type; the definition of this is internal to Graphviz
+struct graphviz_attr_columns;
+
+/// opaque type; the definition of this is internal to Graphviz
+struct graphviz_edge_index;
+
 /// shared resources for Agraph_s
 struct Agclos_s {
   Agdisc_t disc;    /* resource discipline functions */
@@ -412,11 +421,22 @@ struct Agclos_s {
   Agcbstack_t *cb;  /* user and system callback function stacks */
   Dict_t *lookup_by_name[3];
   Dict_t *lookup_by_id[3];
+  unsigned flags;   ///< options given to @ref agopen_flags
+  struct graphviz_arena *arena; ///< source of objects, if @ref AG_ARENA
+  struct graphviz_attr_columns *columns; ///< values, if @ref AG_COLUMNAR
+  struct graphviz_edge_index *edge_index; ///< edges, if @ref AG_EDGE_INDEX
+  /// nodes by sequence number, if @ref AG_SUBGRAPH_BITSETS
+  Agnode_t **node_table;
+  size_t node_table_size; ///< number of entries in `node_table`
+  bool frozen;            ///< searches leave the graph unchanged, see @ref agfreeze
 };
 
 /// opaque type; the definition of this is internal to Graphviz
 struct graphviz_node_set;
 
+/// opaque type; the definition of this is internal to Graphviz
+struct graphviz_seq_set;
+
 /// graph or subgraph
 struct Agraph_s {
   Agobj_t base;
@@ -429,6 +449,11 @@ struct Agraph_s {
   Dict_t *g_seq, *g_id;           ///< subgraphs - descendants
   Agraph_t *parent, *root;        ///< subgraphs - ancestors
   Agclos_t *clos;                 ///< shared resources
+  /// the node set of a subgraph, in place of `n_seq` and `n_id`, if
+  /// @ref AG_SUBGRAPH_BITSETS
+  struct graphviz_seq_set *n_bits;
+  /// the edge set of a subgraph, in place of `e_seq` and `e_id`, likewise
+  struct graphviz_seq_set *e_bits;
 };
 
 /* graphs */
@@ -445,16 +470,127 @@ CGRAPH_API Agraph_t *agopen(char *name, Agdesc_t desc, Agdisc_t *disc);
  * value will be used to indicate the default discipline @ref AgDefaultDisc.
  */
 
+/// options of a root graph, for @ref agopen_flags and @ref agread_flags
+enum {
+  /// @brief allocate the objects of the graph from a region
+  ///
+  /// The nodes, edges, subgraphs, records and attribute value arrays of the
+  /// root graph and its subgraphs are carved out of large blocks, all released
+  /// at once by @ref agclose of the root graph. This makes building and
+  /// discarding large graphs cheaper, but memory of objects deleted before
+  /// then is not reused.
+  AG_ARENA = 1 << 0,
+  /// @brief store node and edge attribute values by attribute
+  ///
+  /// The values of each node or edge attribute are kept in an array indexed
+  /// by object sequence number, allocated once the attribute is first set,
+  /// instead of each object holding a value for every declared attribute.
+  /// Objects left at the default of the root graph share it. Memory then
+  /// scales with the attributes actually set, and declaring an attribute does
+  /// not touch every existing object. @ref Agattr_s.str is NULL for nodes and
+  /// edges of such graphs, so their values must be read through @ref agxget.
+  AG_COLUMNAR = 1 << 1,
+  /// @brief index edges by their endpoints
+  ///
+  /// The root graph keeps a hash table of its edges by tail, head and key.
+  /// Finding an edge between two nodes, as @ref agedge does before creating
+  /// one and as strict graphs do to reject duplicates, then takes constant
+  /// time rather than time logarithmic in the degree of the head, which helps
+  /// graphs with nodes of very high degree. Lookups in subgraphs use it to
+  /// rule out edges missing from the root graph.
+  AG_EDGE_INDEX = 1 << 2,
+  /// @brief record subgraph membership as bitsets
+  ///
+  /// Each subgraph keeps its nodes and edges as sparse bitsets over their
+  /// sequence numbers, rather than as a record per node and dictionaries of
+  /// nodes and edges. Adding a node to a deeply nested subgraph then sets a
+  /// bit in each ancestor instead of allocating and inserting a record in
+  /// each, and subgraphs take much less memory. Iterating the nodes of a
+  /// subgraph walks its bitset in sequence order. Iterating the edges of a node
+  /// in a subgraph walks the node's edges in the root graph and skips those
+  /// not in the subgraph, so it is slower for nodes with many edges outside
+  /// the subgraph. @ref agsubrep returns NULL for the nodes of such subgraphs.
+  AG_SUBGRAPH_BITSETS = 1 << 3,
+  /// @brief tokenize DOT input on several threads
+  ///
+  /// An option of @ref agmapread_flags, ignored when opening a graph. The rest
+  /// of the mapped file is cut into chunks that are tokenized at the same time,
+  /// with one thread per processor, and the nodes, edges and attributes are
+  /// then created in the order they appear, so the graph is the same as one
+  /// read without this option. This applies to graphs whose body is a flat list
+  /// of node, edge and attribute statements. Graphs with subgraphs, ports,
+  /// concatenated strings or syntax errors are read again from their start by
+  /// the serial parser once these are reached.
+  AG_PARALLEL_READ = 1 << 4,
+};
+
+CGRAPH_API Agraph_t *agopen_flags(char *name, Agdesc_t desc, Agdisc_t *disc,
+                                  unsigned flags);
+/**<
+ * @brief creates a new graph, like @ref agopen, with the given options
+ *
+ * @param flags - bitwise OR of options such as @ref AG_ARENA, or 0 for none.
+ * Bits not known to this version of the library are rejected, so a program
+ * asking for an option the library lacks gets NULL rather than a graph
+ * without it.
+ */
+
 CGRAPH_API int agclose(Agraph_t *g);
 ///< deletes a graph, freeing its associated storage
 CGRAPH_API Agraph_t *agread(void *chan, Agdisc_t *disc);
 ///< constructs a new graph
+CGRAPH_API Agraph_t *agread_flags(void *chan, Agdisc_t *disc, unsigned flags);
+///< constructs a new graph, opened as by @ref agopen_flags
 
 CGRAPH_API Agraph_t *agmemread(const char *cp);
 ///< reads a graph from the input string
 
 CGRAPH_API Agraph_t *agmemconcat(Agraph_t *g, const char *cp);
 
+/// a file mapped into memory, from which graphs can be read
+struct graphviz_mapped_input;
+
+CGRAPH_API struct graphviz_mapped_input *agmapopen(const char *filename);
+/**< @brief maps a regular file into memory for reading with @ref agmapread
+ *
+ * The scanner is fed the mapped bytes in large blocks, so reading a large file
+ * this way avoids the per-line reads of @ref agread on a stdio stream.
+ *
+ * The file must not be truncated while it is mapped. Reading a page beyond
+ * its new end raises `SIGBUS` rather than reporting an error.
+ *
+ * @param filename Path of the file to map
+ * @return The mapped file or NULL, with `errno` set, if it could not be opened
+ *   or is not a regular file with a non-zero size. An empty file or one whose
+ *   size is not known in advance, like those under /proc, fails with `errno`
+ *   set to `EINVAL` and can be read through stdio instead. Mapping is
+ *   unavailable on platforms without `mmap`, where this always fails with
+ *   `errno` set to `ENOTSUP`.
+ */
+
+CGRAPH_API Agraph_t *agmapread(struct graphviz_mapped_input *input,
+                               Agdisc_t *disc);
+/**< @brief reads the next graph from a mapped file
+ *
+ * Unlike @ref agread on a stdio stream, graphs that share a line are all read.
+ *
+ * @param disc Discipline for the new graph. Its I/O methods are not used.
+ * @return The graph, or NULL at the end of the file or after a syntax error
+ */
+
+CGRAPH_API Agraph_t *agmapread_flags(struct graphviz_mapped_input *input,
+                                     Agdisc_t *disc, unsigned flags);
+/**< @brief reads the next graph from a mapped file, with the given options
+ *
+ * @param flags Bitwise OR of options for the new graph, as for
+ *   @ref agopen_flags, and of @ref AG_PARALLEL_READ
+ * @return As for @ref agmapread, and also NULL if given an option this
+ *   version of the library does not know
+ */
+
+CGRAPH_API void agmapclose(struct graphviz_mapped_input *input);
+///< unmaps a file mapped by @ref agmapopen
+
 CGRAPH_API Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
                               Agdisc_t *disc);
 /**< @brief merges the file contents with a pre-existing graph
@@ -468,6 +604,48 @@ CGRAPH_API Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
  */
 
 CGRAPH_API int agwrite(Agraph_t *g, void *chan);
+
+/// the first byte of a graph in the binary format, which never begins DOT
+#define AGBIN_LEAD 0x89
+
+CGRAPH_API int agwritebin(Agraph_t *g, void *chan,
+                          size_t (*write)(void *chan, const void *buf,
+                                          size_t len));
+/**< @brief writes a graph in a compact binary format
+ *
+ * The format holds a table of nodes, a table of edges by endpoint index, the
+ * attribute values of nodes and edges by column, and the members of each
+ * subgraph. Each distinct string is written once. Reading it back with
+ * @ref agreadbin needs no quoting or parsing, and gives a graph with the same
+ * nodes, edges, subgraphs and attributes, created in the same order.
+ *
+ * @param chan Where to write
+ * @param write How to write to `chan`, like `fwrite`, or NULL if `chan` is a
+ *   stdio `FILE` pointer
+ * @return 0 on success, `EOF` on failure
+ */
+
+CGRAPH_API Agraph_t *agreadbin(void *chan,
+                               size_t (*read)(void *chan, void *buf,
+                                              size_t len),
+                               Agdisc_t *disc);
+/**< @brief reads a graph written by @ref agwritebin
+ *
+ * Exactly the bytes of one graph are consumed, so several graphs written to
+ * the same channel can be read in turn. @ref agmapread also reads graphs in
+ * this format.
+ *
+ * @param chan Where to read from
+ * @param read How to read from `chan`, like `fread`, or NULL if `chan` is a
+ *   stdio `FILE` pointer
+ * @return The graph, or NULL at the end of input or if the input is not a
+ *   valid binary graph. Subgraphs nested more than 1000 deep are rejected as
+ *   invalid.
+ */
+
+CGRAPH_API bool agisbin(const char *data, size_t size);
+///< does the data start with a graph in the binary format?
+
 CGRAPH_API int agisdirected(Agraph_t *g);
 CGRAPH_API int agisundirected(Agraph_t *g);
 CGRAPH_API int agisstrict(Agraph_t *g);
@@ -586,6 +764,24 @@ CGRAPH_API char *agstrdup_html(Agraph_t *, const char *);
 CGRAPH_API int aghtmlstr(const char *);
 ///< query if a string is an ordinary string or an HTML-like string
 ///
+CGRAPH_API bool agstrtod(const char *s, double *value);
+///< @brief parses a reference-counted string as `strtod` would
+///
+/// The result is remembered in the string, so repeated queries of an attribute
+/// value shared by many objects parse it only once. Several threads may query
+/// the same string at once.
+///
+/// @param s A string obtained from @ref agstrdup or an attribute lookup
+/// @param [out] value The parsed number on success
+/// @return True if `s` begins with a number
+CGRAPH_API bool agstrtol(const char *s, long *value);
+///< @brief parses a reference-counted string as `strtol` in base 10 would
+///
+/// Like @ref agstrtod, the result is remembered in the string.
+///
+/// @param s A string obtained from @ref agstrdup or an attribute lookup
+/// @param [out] value The parsed number on success
+/// @return True if `s` begins with a number
 CGRAPH_API char *agstrbind(Agraph_t *g, const char *);
 ///< returns a pointer to a reference-counted string if it exists, or NULL if
 ///< not
@@ -629,7 +825,8 @@ CGRAPH_API char *agstrcanon(char *, char *);
 struct Agattr_s { /* dynamic string attributes */
   Agrec_t h;      /* common data header */
   Dict_t *dict;   ///< shared dict of Agsym_s to interpret Agattr_s.str
-  char **str;     ///< the attribute string values indexed by Agsym_s.id
+  char **str;     ///< the attribute string values indexed by Agsym_s.id,
+                  ///< NULL for nodes and edges if @ref AG_COLUMNAR
 };
 
 /// @brief string attribute descriptor
@@ -889,6 +1086,86 @@ CGRAPH_API int agdegree(Agraph_t *g, Agnode_t *n, int in, int out);
 CGRAPH_API int agcountuniqedges(Agraph_t *g, Agnode_t *n, int in, int out);
 /// @}
 
+/** @defgroup cgraph_csr adjacency snapshots
+ *
+ * @ref agcsropen copies the nodes and edges of a graph into flat arrays in
+ * compressed sparse row form. Code that walks every edge of a graph many
+ * times, or builds its own adjacency arrays, can read these instead of
+ * iterating the graph’s dictionaries. The snapshot is not updated when the
+ * graph changes, and must be released with @ref agcsrclose.
+ *
+ * Nodes are numbered by their position in @ref agfstnode / @ref agnxtnode
+ * order. Edges are numbered by their position in the out-edge lists, which
+ * hold each node’s out-edges in @ref agfstout / @ref agnxtout order, one node
+ * after another. The in-edge lists hold the numbers of each node’s in-edges
+ * in @ref agfstin / @ref agnxtin order. A loop appears in both lists of its
+ * node.
+ *
+ * @{
+ */
+
+/// a read-only snapshot of the adjacency of a graph
+typedef struct {
+  size_t n_nodes;   ///< number of nodes
+  size_t n_edges;   ///< number of edges
+  Agnode_t **nodes; ///< the nodes, by number
+  /// out-edges of node `i` are numbered `out[i]` to `out[i + 1] - 1`, `n_nodes
+  /// + 1` entries
+  size_t *out;
+  Agedge_t **edges; ///< the edges, as out-edges, by number
+  size_t *tails;    ///< number of the tail of each edge
+  size_t *heads;    ///< number of the head of each edge
+  /// the numbers of in-edges of node `i` are `in_edges[in[i]]` to
+  /// `in_edges[in[i + 1] - 1]`, `n_nodes + 1` entries
+  size_t *in;
+  size_t *in_edges; ///< edge numbers of each node’s in-edges
+  double *weights;  ///< weight of each edge, or NULL if none was requested
+  size_t n_seq;     ///< entries in `seq_index`
+  size_t *seq_index; ///< node number by @ref AGSEQ, see @ref agcsrindex
+} Agcsr_t;
+
+CGRAPH_API Agcsr_t *agcsropen(Agraph_t *g, Agsym_t *weight, double dflt);
+///< @brief takes a snapshot of the nodes and edges of a graph
+///
+/// @param g Graph or subgraph to describe
+/// @param weight An edge attribute to read into `weights` as numbers, or NULL
+///   to leave `weights` NULL
+/// @param dflt Weight of edges whose `weight` attribute is not a number
+/// @return A snapshot to be released with @ref agcsrclose
+
+CGRAPH_API size_t agcsrindex(const Agcsr_t *csr, Agnode_t *n);
+///< @brief gets the number of a node in a snapshot
+///
+/// @return The node’s number, or `SIZE_MAX` if it was not in the snapshot
+
+CGRAPH_API void agcsrclose(Agcsr_t *csr);
+///< @brief releases a snapshot from @ref agcsropen
+/// @}
+
+/** @defgroup cgraph_freeze concurrent reading
+ *
+ * Walking or searching a graph normally rearranges its dictionaries, so even
+ * code that only reads a graph cannot share it with other threads.
+ * @ref agfreeze balances the dictionaries of a whole graph once and makes
+ * later reads leave them as they are. While frozen, a graph can be read from
+ * several threads at the same time, provided none of them changes it.
+ *
+ * @{
+ */
+
+CGRAPH_API void agfreeze(Agraph_t *g, bool freeze);
+///< @brief makes reads of a graph safe to do concurrently, or undoes this
+///
+/// This applies to the root graph of `g` and all its subgraphs. Objects,
+/// attributes and records must not be added, deleted or changed while the
+/// graph is frozen, though attribute values can still be read. Attribute values
+/// can also be parsed with @ref agstrtod and @ref agstrtol or written with
+/// @ref agwrite, whose caches in the strings are updated atomically.
+///
+/// @param g Graph or subgraph to freeze
+/// @param freeze Whether to freeze or to thaw the graph
+/// @}
+
 /// @cond
 
 /* support for extra API misuse warnings if available */
@@ -0,0 +1,126 @@
+/// @file
+/// @brief implements @ref agcsropen, @ref agcsrindex and @ref agcsrclose
+/// @ingroup cgraph_csr
+
+#include "config.h"
+
+#include <assert.h>
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+#include <util/list.h>
+
+Agcsr_t *agcsropen(Agraph_t *g, Agsym_t *weight, double dflt) {
+  assert(g != NULL);
+
+  Agcsr_t *const csr = gv_alloc(sizeof(Agcsr_t));
+
+  // number the nodes
+  const size_t n_nodes = (size_t)agnnodes(g);
+  csr->n_nodes = n_nodes;
+  csr->nodes = gv_calloc(n_nodes, sizeof(Agnode_t *));
+  uint64_t max_seq = 0;
+  {
+    size_t i = 0;
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      assert(i < n_nodes);
+      csr->nodes[i++] = n;
+      if (AGSEQ(n) > max_seq) {
+        max_seq = AGSEQ(n);
+      }
+    }
+    assert(i == n_nodes);
+  }
+  csr->n_seq = (size_t)max_seq + 1;
+  csr->seq_index = gv_calloc(csr->n_seq, sizeof(size_t));
+  for (size_t i = 0; i < csr->n_seq; ++i) {
+    csr->seq_index[i] = SIZE_MAX;
+  }
+  for (size_t i = 0; i < n_nodes; ++i) {
+    csr->seq_index[AGSEQ(csr->nodes[i])] = i;
+  }
+
+  // gather the out-edges, the only walk of the graph’s edge dictionaries
+  csr->out = gv_calloc(n_nodes + 1, sizeof(size_t));
+  LIST(Agedge_t *) edges = {0};
+  for (size_t i = 0; i < n_nodes; ++i) {
+    csr->out[i] = LIST_SIZE(&edges);
+    for (Agedge_t *e = agfstout(g, csr->nodes[i]); e != NULL;
+         e = agnxtout(g, e)) {
+      LIST_APPEND(&edges, e);
+    }
+  }
+  csr->out[n_nodes] = LIST_SIZE(&edges);
+  LIST_DETACH(&edges, &csr->edges, &csr->n_edges);
+  const size_t n_edges = csr->n_edges;
+
+  csr->tails = gv_calloc(n_edges, sizeof(size_t));
+  csr->heads = gv_calloc(n_edges, sizeof(size_t));
+  for (size_t i = 0; i < n_nodes; ++i) {
+    for (size_t x = csr->out[i]; x < csr->out[i + 1]; ++x) {
+      csr->tails[x] = i;
+      csr->heads[x] = agcsrindex(csr, aghead(csr->edges[x]));
+      assert(csr->heads[x] != SIZE_MAX);
+    }
+  }
+
+  // Derive the in-edges by counting them per head. Out-edges are visited by
+  // tail and then in their own order, which is the order of each head’s
+  // in-edge dictionary.
+  csr->in = gv_calloc(n_nodes + 1, sizeof(size_t));
+  for (size_t x = 0; x < n_edges; ++x) {
+    ++csr->in[csr->heads[x] + 1];
+  }
+  for (size_t i = 0; i < n_nodes; ++i) {
+    csr->in[i + 1] += csr->in[i];
+  }
+  csr->in_edges = gv_calloc(n_edges, sizeof(size_t));
+  size_t *const next = gv_calloc(n_nodes, sizeof(size_t));
+  for (size_t x = 0; x < n_edges; ++x) {
+    const size_t h = csr->heads[x];
+    csr->in_edges[csr->in[h] + next[h]++] = x;
+  }
+  free(next);
+
+  if (weight != NULL) {
+    csr->weights = gv_calloc(n_edges, sizeof(double));
+    for (size_t x = 0; x < n_edges; ++x) {
+      double w;
+      csr->weights[x] = agstrtod(agxget(csr->edges[x], weight), &w) ? w : dflt;
+    }
+  }
+
+  return csr;
+}
+
+size_t agcsrindex(const Agcsr_t *csr, Agnode_t *n) {
+  assert(csr != NULL);
+  assert(n != NULL);
+
+  if (AGSEQ(n) >= csr->n_seq) {
+    return SIZE_MAX;
+  }
+  const size_t i = csr->seq_index[AGSEQ(n)];
+  if (i == SIZE_MAX || csr->nodes[i] != n) {
+    return SIZE_MAX;
+  }
+  return i;
+}
+
+void agcsrclose(Agcsr_t *csr) {
+  if (csr == NULL) {
+    return;
+  }
+  free(csr->nodes);
+  free(csr->out);
+  free(csr->edges);
+  free(csr->tails);
+  free(csr->heads);
+  free(csr->in);
+  free(csr->in_edges);
+  free(csr->weights);
+  free(csr->seq_index);
+  free(csr);
+}
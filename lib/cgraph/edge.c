@@ -17,25 +17,55 @@
 
 #include <assert.h>
 #include <cgraph/cghdr.h>
+#include <cgraph/edge_index.h>
 #include <cgraph/node_set.h>
+#include <cgraph/seq_set.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <util/alloc.h>
+#include <util/unreachable.h>
 #include <util/unused.h>
 
+/* skip the edges of the root graph that are not in the subgraph <g> */
+static Agedge_t *agmemberedge(Agraph_t * g, Agedge_t * e, bool out)
+{
+    Agraph_t *root = agroot(g);
+
+    while (e && !seq_set_contains(g->e_bits, AGSEQ(e)))
+	e = out ? agnxtout(root, e) : agnxtin(root, e);
+    return e;
+}
+
+/* search an edge set <*set> of a subnode, held extracted from <d> */
+static Agedge_t *edgesearch(Agraph_t * g, Dict_t * d, Dtlink_t ** set,
+			    void *obj, int type)
+{
+    Agedge_t *e;
+
+    if (g->clos->frozen)	/* others may be searching the same set */
+	return dtextracted(d, *set, obj, type);
+    dtrestore(d, *set);
+    e = d->searchf(d, obj, type);
+    *set = dtextract(d);
+    return e;
+}
+
 /* return first outedge of <n> */
 Agedge_t *agfstout(Agraph_t * g, Agnode_t * n)
 {
     Agsubnode_t *sn;
     Agedge_t *e = NULL;
 
+    if (g->e_bits) {
+	if (!seq_set_contains(g->n_bits, AGSEQ(n)))
+	    return NULL;
+	return agmemberedge(g, agfstout(agroot(g), n), true);
+    }
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		e = dtfirst(g->e_seq);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = edgesearch(g, g->e_seq, &sn->out_seq, NULL, DT_FIRST);
     return e;
 }
 
@@ -46,13 +76,12 @@ Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e)
     Agsubnode_t *sn;
     Agedge_t *f = NULL;
 
+    if (g->e_bits)
+	return agmemberedge(g, agnxtout(agroot(g), e), true);
     n = AGTAIL(e);
     sn = agsubrep(g, n);
-    if (sn) {
-		dtrestore(g->e_seq, sn->out_seq);
-		f = dtnext(g->e_seq, e);
-		sn->out_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	f = edgesearch(g, g->e_seq, &sn->out_seq, e, DT_NEXT);
     return f;
 }
 
@@ -61,12 +90,14 @@ Agedge_t *agfstin(Agraph_t * g, Agnode_t * n)
     Agsubnode_t *sn;
     Agedge_t *e = NULL;
 
+    if (g->e_bits) {
+	if (!seq_set_contains(g->n_bits, AGSEQ(n)))
+	    return NULL;
+	return agmemberedge(g, agfstin(agroot(g), n), false);
+    }
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		e = dtfirst(g->e_seq);
-		sn->in_seq = dtextract(g->e_seq);
-	}
+    if (sn)
+	e = edgesearch(g, g->e_seq, &sn->in_seq, NULL, DT_FIRST);
     return e;
 }
 
@@ -76,14 +107,13 @@ Agedge_t *agnxtin(Agraph_t * g, Agedge_t * e)
     Agsubnode_t *sn;
     Agedge_t *f = NULL;
 
+    if (g->e_bits)
+	return agmemberedge(g, agnxtin(agroot(g), e), false);
     n = AGHEAD(e);
     sn = agsubrep(g, n);
-	if (sn) {
-		dtrestore(g->e_seq, sn->in_seq);
-		f = dtnext(g->e_seq, e);
-		sn->in_seq = dtextract(g->e_seq);
-	}
-	return f;
+    if (sn)
+	f = edgesearch(g, g->e_seq, &sn->in_seq, e, DT_NEXT);
+    return f;
 }
 
 Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n)
@@ -115,6 +145,25 @@ Agedge_t *agnxtedge(Agraph_t * g, Agedge_t * e, Agnode_t * n)
     return rv;
 }
 
+/* find an edge from <t> to <h> of the root graph that is in the subgraph <g> */
+static Agedge_t *agfindmemberedge(Agraph_t * g, Agnode_t * t, Agnode_t * h)
+{
+    Agraph_t *root = agroot(g);
+    Agsubnode_t *sn = agsubrep(root, h);
+    Agedge_t *e, *prev, template;
+
+    /* the in-edges of <h> from <t> are adjacent in its ID set */
+    template.base.tag = (Agtag_t){0};
+    template.node = t;
+    e = edgesearch(root, root->e_id, &sn->in_id, &template, DT_SEARCH);
+    while (e && (prev = edgesearch(root, root->e_id, &sn->in_id, e, DT_PREV))
+	   && prev->node == t)
+	e = prev;
+    while (e && e->node == t && !seq_set_contains(g->e_bits, AGSEQ(e)))
+	e = edgesearch(root, root->e_id, &sn->in_id, e, DT_NEXT);
+    return e && e->node == t ? e : NULL;
+}
+
 /* internal edge set lookup */
 static Agedge_t *agfindedge_by_key(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 			    Agtag_t key)
@@ -124,15 +173,32 @@ static Agedge_t *agfindedge_by_key(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 
     if (t == NULL || h == NULL)
 	return NULL;
+
+    /* a subgraph with bitsets holds the edges of the root graph it marks */
+    if (g->e_bits) {
+	if (!seq_set_contains(g->n_bits, AGSEQ(t)) ||
+	    !seq_set_contains(g->n_bits, AGSEQ(h)))
+	    return NULL;
+	if (key.objtype == 0)
+	    return agfindmemberedge(g, t, h);
+	e = agfindedge_by_key(agroot(g), t, h, key);
+	return e && seq_set_contains(g->e_bits, AGSEQ(e)) ? e : NULL;
+    }
+
+    /* consult the index of the root graph, if there is one */
+    if (g->clos->edge_index) {
+	e = edge_index_find(g->clos->edge_index, t, h, key);
+	/* an edge missing from the root graph is missing from its subgraphs */
+	if (e == NULL || agparent(g) == NULL)
+	    return e;
+    }
+
     template.base.tag = key;
     template.node = t;		/* guess that fan-in < fan-out */
     sn = agsubrep(g, h);
     if (!sn) e = 0;
-    else {
-	    dtrestore(g->e_id, sn->in_id);
-	    e = dtsearch(g->e_id, &template);
-	    sn->in_id = dtextract(g->e_id);
-    }
+    else
+	e = edgesearch(g, g->e_id, &sn->in_id, &template, DT_SEARCH);
     return e;
 }
 
@@ -145,6 +211,8 @@ static Agedge_t *agfindedge_by_id(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 
 Agsubnode_t *agsubrep(Agraph_t * g, Agnode_t * n)
 {
+  if (g->n_bits)
+    return NULL;
   return g == n->root ? &n->mainsub : node_set_find(g->n_id, n->base.tag.id);
 }
 
@@ -174,6 +242,11 @@ static void installedge(Agraph_t * g, Agedge_t * e)
     t = agtail(e);
     h = aghead(e);
     while (g) {
+	if (g->e_bits) {
+	    if (!seq_set_add(g->e_bits, AGSEQ(e))) break;
+	    g = agparent(g);
+	    continue;
+	}
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
 	sn = agsubrep(g, t);
 	ins(g->e_seq, &sn->out_seq, out);
@@ -181,6 +254,8 @@ static void installedge(Agraph_t * g, Agedge_t * e)
 	sn = agsubrep(g, h);
 	ins(g->e_seq, &sn->in_seq, in);
 	ins(g->e_id, &sn->in_id, in);
+	if (agparent(g) == NULL && g->clos->edge_index)
+	    edge_index_add(g->clos->edge_index, in);
 	g = agparent(g);
     }
 }
@@ -198,7 +273,7 @@ static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 
     (void)agsubnode(g, t, 1);
     (void)agsubnode(g, h, 1);
-    Agedgepair_t *e2 = gv_alloc(sizeof(Agedgepair_t));
+    Agedgepair_t *e2 = agalloc(g, sizeof(Agedgepair_t));
     in = &e2->in;
     out = &e2->out;
     uint64_t seq = agnextseq(g, AGEDGE);
@@ -312,12 +387,19 @@ void agdeledgeimage(Agraph_t *g, Agobj_t *edge, void *ignored) {
     }
     t = in->node;
     h = out->node;
+    if (g->e_bits) {
+	bool removed UNUSED = seq_set_remove(g->e_bits, AGSEQ(e));
+	assert(removed);
+	return;
+    }
     sn = agsubrep(g, t);
     del(g->e_seq, &sn->out_seq, out);
     del(g->e_id, &sn->out_id, out);
     sn = agsubrep(g, h);
     del(g->e_seq, &sn->in_seq, in);
     del(g->e_id, &sn->in_id, in);
+    if (agparent(g) == NULL && g->clos->edge_index)
+	edge_index_remove(g->clos->edge_index, in);
 #ifdef DEBUG
     for (e = agfstin(g,h); e; e = agnxtin(g,e))
 	assert(e != in);
@@ -341,7 +423,7 @@ int agdeledge(Agraph_t * g, Agedge_t * e)
     }
     if (agapply(g, &e->base, agdeledgeimage, NULL, false) == SUCCESS) {
 	if (g == agroot(g))
-		free(e);
+		agfree(g, e, sizeof(Agedgepair_t));
 	return SUCCESS;
     } else
 	return FAILURE;
@@ -423,6 +505,214 @@ Dtdisc_t Ag_subedge_id_disc = {
     .comparf = agedgeidcmpf,
 };
 
+/// an edge in an index
+typedef struct {
+  const Agnode_t *tail; ///< tail of `edge`
+  const Agnode_t *head; ///< head of `edge`
+  Agedge_t *edge;       ///< in-edge half of the edge, or an empty slot marker
+} edge_slot_t;
+
+struct graphviz_edge_index {
+  edge_slot_t *slots;  ///< backing store for elements
+  size_t size;         ///< number of elements in the index
+  size_t deleted;      ///< number of slots from which an element was removed
+  size_t capacity_exp; ///< log₂ size of `slots`
+};
+
+/// a sentinel, marking a slot from which an element has been deleted
+static Agedge_t *const TOMBSTONE = (Agedge_t *)-1;
+
+/// get the allocated size of the backing storage of an edge index
+///
+/// @param self Index to inspect
+/// @return Capacity of the given index
+static size_t edge_index_get_capacity(const edge_index_t *self) {
+  assert(self != NULL);
+  return self->slots == NULL ? 0 : (size_t)1 << self->capacity_exp;
+}
+
+edge_index_t *edge_index_new(void) { return gv_alloc(sizeof(edge_index_t)); }
+
+/// compute a hash of the endpoints of an edge
+///
+/// Edges between the same nodes hash the same way, whatever their key, so that
+/// any of them can be found without knowing its key. Node identifiers and
+/// sequence numbers can change under an edge, so the nodes’ addresses are
+/// hashed instead.
+///
+/// @param t Tail of the edge
+/// @param h Head of the edge
+/// @return Hash digest of the endpoints
+static size_t edge_index_hash(const Agnode_t *t, const Agnode_t *h) {
+  uint64_t x = (uint64_t)(uintptr_t)t * 0x9e3779b97f4a7c15ull;
+  x ^= (uint64_t)(uintptr_t)h;
+  x ^= x >> 31;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 29;
+  return (size_t)x;
+}
+
+/// place an edge in a slot of an index known to have room for it
+///
+/// @param self Index to add to
+/// @param slot Description of the edge to add
+static void edge_index_place(edge_index_t *self, edge_slot_t slot) {
+  const size_t capacity = edge_index_get_capacity(self);
+  assert(capacity > self->size + self->deleted);
+
+  const size_t hash = edge_index_hash(slot.tail, slot.head);
+
+  for (size_t i = 0; i < capacity; ++i) {
+    const size_t candidate = (hash + i) & (capacity - 1);
+
+    // if we found an empty slot or a previously deleted slot, we can insert
+    if (self->slots[candidate].edge == NULL) {
+      self->slots[candidate] = slot;
+      ++self->size;
+      return;
+    }
+    if (self->slots[candidate].edge == TOMBSTONE) {
+      self->slots[candidate] = slot;
+      ++self->size;
+      --self->deleted;
+      return;
+    }
+  }
+
+  UNREACHABLE();
+}
+
+void edge_index_add(edge_index_t *self, Agedge_t *e) {
+  assert(self != NULL);
+  assert(e != NULL);
+
+  // a watermark ratio at which the index should be rebuilt
+  static const size_t OCCUPANCY_THRESHOLD_PERCENT = 50;
+
+  // do we need to rebuild the backing store? Deleted slots count against the
+  // capacity, as they lengthen searches as much as live ones.
+  const size_t capacity = edge_index_get_capacity(self);
+  const size_t used = self->size + self->deleted;
+  if (100 * used >= OCCUPANCY_THRESHOLD_PERCENT * capacity) {
+    // grow, unless discarding the deleted slots makes enough room
+    size_t new_c = self->capacity_exp;
+    if (capacity == 0) {
+      new_c = 10;
+    } else if (200 * self->size >= OCCUPANCY_THRESHOLD_PERCENT * capacity) {
+      ++new_c;
+    }
+    edge_slot_t *new_slots = gv_calloc((size_t)1 << new_c,
+                                       sizeof(edge_slot_t));
+
+    // Construct a new index and copy everything into it. Note we need to
+    // rehash because capacity (and hence modulo wraparound behavior) may have
+    // changed. This flushes out the tombstones too.
+    edge_index_t new_self = {.slots = new_slots, .capacity_exp = new_c};
+    for (size_t i = 0; i < capacity; ++i) {
+      // skip empty and deleted slots
+      if (self->slots[i].edge == NULL || self->slots[i].edge == TOMBSTONE) {
+        continue;
+      }
+      edge_index_place(&new_self, self->slots[i]);
+    }
+
+    // replace ourselves with this new index
+    free(self->slots);
+    *self = new_self;
+  }
+
+  Agedge_t *const in = AGMKIN(e);
+  edge_index_place(self,
+                   (edge_slot_t){.tail = AGTAIL(in), .head = AGHEAD(in),
+                                 .edge = in});
+}
+
+Agedge_t *edge_index_find(const edge_index_t *self, const Agnode_t *t,
+                          const Agnode_t *h, Agtag_t key) {
+  assert(self != NULL);
+
+  const size_t hash = edge_index_hash(t, h);
+  const size_t capacity = edge_index_get_capacity(self);
+  Agedge_t *found = NULL;
+
+  for (size_t i = 0; i < capacity; ++i) {
+    const edge_slot_t *const slot = &self->slots[(hash + i) & (capacity - 1)];
+
+    // if we found an empty slot, there are no more candidates
+    if (slot->edge == NULL) {
+      break;
+    }
+
+    // if we found a previously deleted slot, skip over it
+    if (slot->edge == TOMBSTONE) {
+      continue;
+    }
+
+    if (slot->tail != t || slot->head != h) {
+      continue;
+    }
+
+    // a specific edge?
+    if (key.objtype != 0) {
+      if (AGID(slot->edge) == key.id) {
+        return slot->edge;
+      }
+      continue;
+    }
+
+    // Otherwise, return the oldest edge between these nodes. The order of
+    // slots depends on where nodes were allocated, so this keeps the answer
+    // the same from one run to the next.
+    if (found == NULL || AGSEQ(slot->edge) < AGSEQ(found)) {
+      found = slot->edge;
+    }
+  }
+
+  return found;
+}
+
+void edge_index_remove(edge_index_t *self, Agedge_t *e) {
+  assert(self != NULL);
+  assert(e != NULL);
+
+  Agedge_t *const in = AGMKIN(e);
+  const size_t hash = edge_index_hash(AGTAIL(in), AGHEAD(in));
+  const size_t capacity = edge_index_get_capacity(self);
+
+  for (size_t i = 0; i < capacity; ++i) {
+    edge_slot_t *const slot = &self->slots[(hash + i) & (capacity - 1)];
+
+    // if we found an empty slot, the sought edge does not exist
+    if (slot->edge == NULL) {
+      return;
+    }
+
+    if (slot->edge == in) {
+      assert(self->size > 0);
+      slot->edge = TOMBSTONE;
+      --self->size;
+      ++self->deleted;
+      return;
+    }
+  }
+}
+
+size_t edge_index_size(const edge_index_t *self) {
+  assert(self != NULL);
+  return self->size;
+}
+
+void edge_index_free(edge_index_t **self) {
+  assert(self != NULL);
+
+  if (*self != NULL) {
+    free((*self)->slots);
+  }
+
+  free(*self);
+  *self = NULL;
+}
+
 /* expose macros as functions for ease of debugging
 and to expose them to foreign languages without C preprocessor. */
 #ifdef ageqedge
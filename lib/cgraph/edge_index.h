@@ -0,0 +1,58 @@
+/// @file
+/// @brief hash index of the edges of a root graph by endpoints and key
+
+#pragma once
+
+#include <cgraph/cgraph.h>
+#include <stddef.h>
+
+/// an unordered index of edges, looked up by (tail, head, key)
+typedef struct graphviz_edge_index edge_index_t;
+
+/// construct a new index
+///
+/// Calls `exit` on failure (out-of-memory).
+///
+/// @return A constructed index
+edge_index_t *edge_index_new(void);
+
+/// add an edge to the index
+///
+/// If the backing store is not large enough, it is expanded on demand. On
+/// allocation failure, `exit` is called.
+///
+/// @param self Index to add to
+/// @param e Edge to add, either half of the pair
+void edge_index_add(edge_index_t *self, Agedge_t *e);
+
+/// lookup an edge in the index
+///
+/// @param self Index to search
+/// @param t Tail of the sought edge
+/// @param h Head of the sought edge
+/// @param key Tag of the sought edge, or a tag with `objtype` 0 to find any
+///   edge from `t` to `h`
+/// @return The in-edge half of the found edge or `NULL` if there is none
+Agedge_t *edge_index_find(const edge_index_t *self, const Agnode_t *t,
+                          const Agnode_t *h, Agtag_t key);
+
+/// remove an edge from the index
+///
+/// If the given edge was not in the index, this is a no-op.
+///
+/// @param self Index to remove from
+/// @param e Edge to remove, either half of the pair
+void edge_index_remove(edge_index_t *self, Agedge_t *e);
+
+/// get the number of edges in an index
+///
+/// @param self Index to query
+/// @return Number of edges in the index
+size_t edge_index_size(const edge_index_t *self);
+
+/// destruct an index
+///
+/// `*self` is `NULL` on return.
+///
+/// @param self Index to destroy
+void edge_index_free(edge_index_t **self);
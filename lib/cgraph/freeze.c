@@ -0,0 +1,80 @@
+/// @file
+/// @brief implements @ref agfreeze
+/// @ingroup cgraph_freeze
+
+#include "config.h"
+
+#include <assert.h>
+#include <cdt/cdt.h>
+#include <cgraph/cghdr.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+static void freeze_dict(Dict_t *d, bool freeze) {
+  if (d != NULL) {
+    (void)dtfreeze(d, freeze);
+  }
+}
+
+/// balance an edge set extracted from `d`
+///
+/// Thawing `d` itself is enough to thaw its extracted sets.
+static void freeze_set(Dict_t *d, Dtlink_t **set) {
+  if (*set == NULL) {
+    return;
+  }
+  dtrestore(d, *set);
+  (void)dtfreeze(d, 1);
+  *set = dtextract(d);
+}
+
+static void freeze_graph(Agraph_t *g, bool freeze) {
+  if (g->n_seq != NULL) {
+    for (Agsubnode_t *sn = dtfirst(g->n_seq); freeze && sn != NULL;
+         sn = dtnext(g->n_seq, sn)) {
+      freeze_set(g->e_seq, &sn->out_seq);
+      freeze_set(g->e_seq, &sn->in_seq);
+      freeze_set(g->e_id, &sn->out_id);
+      freeze_set(g->e_id, &sn->in_id);
+    }
+    freeze_dict(g->n_seq, freeze);
+    freeze_dict(g->e_seq, freeze);
+    freeze_dict(g->e_id, freeze);
+  }
+
+  if (g->desc.has_attrs) {
+    Agdatadict_t *const dd = agdatadict(g, false);
+    if (dd != NULL) {
+      freeze_dict(dd->dict.n, freeze);
+      freeze_dict(dd->dict.e, freeze);
+      freeze_dict(dd->dict.g, freeze);
+    }
+  }
+
+  for (Agraph_t *sg = dtfirst(g->g_seq); sg != NULL;
+       sg = dtnext(g->g_seq, sg)) {
+    freeze_graph(sg, freeze);
+  }
+  freeze_dict(g->g_seq, freeze);
+  freeze_dict(g->g_id, freeze);
+}
+
+void agfreeze(Agraph_t *g, bool freeze) {
+  assert(g != NULL);
+
+  Agraph_t *const root = agroot(g);
+  if (root->clos->frozen == freeze) {
+    return;
+  }
+
+  // thaw first, so the walk over the graph can use the usual searches
+  root->clos->frozen = false;
+  freeze_graph(root, freeze);
+  for (size_t i = 0; i < sizeof(root->clos->lookup_by_name) /
+                              sizeof(root->clos->lookup_by_name[0]);
+       ++i) {
+    freeze_dict(root->clos->lookup_by_name[i], freeze);
+    freeze_dict(root->clos->lookup_by_id[i], freeze);
+  }
+  root->clos->frozen = freeze;
+}
@@ -35,6 +35,7 @@ struct gstack_s;
 struct aagextra_s {
 	/* Common */
 	Agdisc_t *Disc;		/* discipline passed to agread or agconcat */
+	unsigned Flags;		/* options passed to agread_flags */
 	void *Ifile;
 	Agraph_t *G;		/* top level graph */
 	/* Parser */
@@ -46,8 +47,13 @@ struct aagextra_s {
 	const char *InputFile;
 	agxbuf InputFileBuffer;
 	int graphType;
+	bool eof;	/* end of graph reached, see aglexeof */
 	/* buffer for arbitrary length strings */
 	agxbuf Sbuf;
+	/* input read from a buffer, see aglexbuffer */
+	const char *Idata;	/* the rest of the buffer to read, or NULL */
+	size_t Isize;	/* number of bytes at Idata */
+	size_t Iused;	/* number of bytes matched by the scanner */
 };
 
 }
@@ -60,7 +66,9 @@ struct aagextra_s {
 
 %{
 
+#include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <cghdr.h>
 #include <stdlib.h>
@@ -571,7 +579,7 @@ static void startgraph(aagscan_t scanner, char *name, bool directed, bool strict
 	if (ctx->G == NULL) {
 		ctx->SubgraphDepth = 0;
 		Agdesc_t req = {.directed = directed, .strict = strict, .maingraph = true};
-		ctx->G = agopen(name,req,ctx->Disc);
+		ctx->G = agopen_flags(name,req,ctx->Disc,ctx->Flags);
 	}
 	ctx->S = push(ctx->S,ctx->G);
 	agstrfree(NULL, name, false);
@@ -627,11 +635,17 @@ static void graph_error(aagscan_t scanner)
 	}
 }
 
-Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
-                   Agdisc_t *disc) {
+/* parse:
+ * Parse a graph from chan or, if data is non-NULL, from the size
+ * bytes at data, storing in *used how many of these were consumed.
+ */
+static Agraph_t *parse(Agraph_t *g, const char *filename, void *chan,
+                       const char *data, size_t size, size_t *used,
+                       Agdisc_t *disc, unsigned flags) {
 	aagscan_t scanner = NULL;
 	aagextra_t extra = {
 		.Disc = disc ? disc : &AgDefaultDisc,
+		.Flags = flags,
 		.Ifile = chan,
 		.G = g,
 		.line_num = 1,
@@ -640,8 +654,16 @@ Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
 	if (aaglex_init_extra(&extra, &scanner)) {
 		return NULL;
 	}
-	aagset_in(chan, scanner);
+	if (data != NULL) {
+		aglexbuffer(scanner, data, size);
+	} else {
+		aagset_in(chan, scanner);
+	}
 	aagparse(scanner);
+	if (data != NULL) {
+		// after an error, give up on the rest of the input
+		*used = extra.G == NULL ? size : aglexoffset(scanner);
+	}
 	if (extra.G == NULL) aglexbad(scanner);
 	aaglex_destroy(scanner);
 	agxbfree(&extra.InputFileBuffer);
@@ -649,7 +671,27 @@ Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
 	return extra.G;
 }
 
+Agraph_t *agconcat(Agraph_t *g, const char *filename, void *chan,
+                   Agdisc_t *disc) {
+	return parse(g, filename, chan, NULL, 0, NULL, disc, 0);
+}
+
+Agraph_t *agconcatbuf(Agraph_t *g, const char *filename, const char *data,
+                      size_t size, size_t *used, Agdisc_t *disc,
+                      unsigned flags) {
+	assert(data != NULL);
+	assert(used != NULL);
+	return parse(g, filename, NULL, data, size, used, disc, flags);
+}
+
 Agraph_t *agread(void *fp, Agdisc_t *disc) {
   return agconcat(NULL, NULL, fp, disc);
 }
 
+Agraph_t *agread_flags(void *fp, Agdisc_t *disc, unsigned flags) {
+  if (!agflagsknown(flags)) {
+    return NULL;
+  }
+  return parse(NULL, NULL, fp, NULL, 0, NULL, disc, flags);
+}
+
@@ -17,38 +17,108 @@
 
 #include <assert.h>
 #include <cgraph/cghdr.h>
+#include <cgraph/edge_index.h>
 #include <cgraph/node_set.h>
+#include <cgraph/seq_set.h>
 #include <limits.h>
+#include <stdalign.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <util/alloc.h>
+#include <util/arena.h>
 
 /*
  * this code sets up the resource management discipline
  * and returns a new main graph struct.
  */
-static Agclos_t *agclos(Agdisc_t * proto)
+static Agclos_t *agclos(Agdisc_t * proto, unsigned flags)
 {
     Agclos_t *rv;
 
-    /* establish an allocation arena */
     rv = gv_calloc(1, sizeof(Agclos_t));
     rv->disc.id = ((proto && proto->id) ? proto->id : &AgIdDisc);
     rv->disc.io = ((proto && proto->io) ? proto->io : &AgIoDisc);
+    rv->flags = flags;
+
+    /* establish an allocation arena, if requested */
+    if (flags & AG_ARENA)
+	rv->arena = gv_alloc(sizeof(arena_t));
+
+    /* store node and edge attributes by column, if requested */
+    if (flags & AG_COLUMNAR)
+	rv->columns = gv_alloc(sizeof(struct graphviz_attr_columns));
+
+    /* index edges by their endpoints, if requested */
+    if (flags & AG_EDGE_INDEX)
+	rv->edge_index = edge_index_new();
     return rv;
 }
 
+void *agalloc(Agraph_t *g, size_t size)
+{
+    if (g->clos->arena)
+	return gv_arena_alloc(g->clos->arena, alignof(max_align_t), size);
+    return gv_alloc(size);
+}
+
+void *agrealloc(Agraph_t *g, void *ptr, size_t old_size, size_t size)
+{
+    if (g->clos->arena) {
+	void *const rv = agalloc(g, size);
+	if (ptr)
+	    memcpy(rv, ptr, old_size < size ? old_size : size);
+	agfree(g, ptr, old_size);
+	return rv;
+    }
+    return gv_recalloc(ptr, old_size, size, sizeof(char));
+}
+
+void agfree(Agraph_t *g, void *ptr, size_t size)
+{
+    if (g->clos->arena)
+	gv_arena_free(g->clos->arena, ptr, size);
+    else
+	free(ptr);
+}
+
 /*
  * Open a new main graph with the given descriptor (directed, strict, etc.)
  */
 Agraph_t *agopen(char *name, Agdesc_t desc, Agdisc_t * arg_disc)
+{
+    return agopen_flags(name, desc, arg_disc, 0);
+}
+
+bool agflagsknown(unsigned flags)
+{
+    /* options this version of the library knows */
+    const unsigned known = AG_ARENA | AG_COLUMNAR | AG_EDGE_INDEX |
+			   AG_SUBGRAPH_BITSETS | AG_PARALLEL_READ;
+
+    if (flags & ~known) {
+	agerrorf("unknown graph options 0x%x\n", flags & ~known);
+	return false;
+    }
+    return true;
+}
+
+Agraph_t *agopen_flags(char *name, Agdesc_t desc, Agdisc_t * arg_disc,
+                       unsigned flags)
 {
     Agraph_t *g;
     Agclos_t *clos;
     IDTYPE gid;
 
-    clos = agclos(arg_disc);
-    g = gv_calloc(1, sizeof(Agraph_t));
+    if (!agflagsknown(flags))
+	return NULL;
+
+    clos = agclos(arg_disc, flags);
+    if (clos->arena)
+	g = ARENA_NEW(clos->arena, Agraph_t);
+    else
+	g = gv_calloc(1, sizeof(Agraph_t));
     AGTYPE(g) = AGRAPH;
     g->clos = clos;
     g->desc = desc;
@@ -69,10 +139,15 @@ Agraph_t *agopen1(Agraph_t * g)
 {
     Agraph_t *par;
 
-    g->n_seq = agdtopen(&Ag_subnode_seq_disc, Dttree);
-    g->n_id = node_set_new();
-    g->e_seq = agdtopen(g == agroot(g)? &Ag_mainedge_seq_disc : &Ag_subedge_seq_disc, Dttree);
-    g->e_id = agdtopen(g == agroot(g)? &Ag_mainedge_id_disc : &Ag_subedge_id_disc, Dttree);
+    if (g != agroot(g) && (g->clos->flags & AG_SUBGRAPH_BITSETS)) {
+	g->n_bits = seq_set_new();
+	g->e_bits = seq_set_new();
+    } else {
+	g->n_seq = agdtopen(&Ag_subnode_seq_disc, Dttree);
+	g->n_id = node_set_new();
+	g->e_seq = agdtopen(g == agroot(g)? &Ag_mainedge_seq_disc : &Ag_subedge_seq_disc, Dttree);
+	g->e_id = agdtopen(g == agroot(g)? &Ag_mainedge_id_disc : &Ag_subedge_id_disc, Dttree);
+    }
     g->g_seq = agdtopen(&Ag_subgraph_seq_disc, Dttree);
 
     g->g_id = agdtopen(&Ag_subgraph_id_disc, Dttree);
@@ -91,6 +166,36 @@ Agraph_t *agopen1(Agraph_t * g)
     return g;
 }
 
+/*
+ * Close the dictionaries of a graph and its subgraphs, leaving the objects in
+ * them to be released in bulk.
+ */
+static int agclosedicts(Agraph_t * g)
+{
+    Agraph_t *subg, *next_subg;
+
+    for (subg = agfstsubg(g); subg; subg = next_subg) {
+	next_subg = agnxtsubg(subg);
+	if (agclosedicts(subg)) return FAILURE;
+    }
+
+    if (g->n_bits) {
+	seq_set_free(&g->n_bits);
+	seq_set_free(&g->e_bits);
+    } else {
+	node_set_free(&g->n_id);
+	if (agdtclose(g, g->n_seq)) return FAILURE;
+	if (agdtclose(g, g->e_id)) return FAILURE;
+	if (agdtclose(g, g->e_seq)) return FAILURE;
+    }
+    if (agdtclose(g, g->g_seq)) return FAILURE;
+    if (agdtclose(g, g->g_id)) return FAILURE;
+
+    if (g->desc.has_attrs)
+	if (agraphattr_delete(g)) return FAILURE;
+    return SUCCESS;
+}
+
 /*
  * Close a graph or subgraph, freeing its storage.
  */
@@ -101,6 +206,26 @@ int agclose(Agraph_t * g)
 
     par = agparent(g);
 
+    /* When the objects of a root graph come from a region and there is no one
+     * to tell about their deletion, there is no need to take them apart one by
+     * one. Their memory goes with the region, their names and attribute values
+     * with the string dictionary.
+     */
+    if (!par && g->clos->arena && !g->clos->cb && AGDISC(g, id) == &AgIdDisc) {
+	aginternalmapclose(g);
+	if (agclosedicts(g)) return FAILURE;
+	agcolumnsclose(g);
+	edge_index_free(&g->clos->edge_index);
+	free(g->clos->node_table);
+	AGDISC(g, id)->close(AGCLOS(g, id));
+	if (agstrclose(g)) return FAILURE;
+	Agclos_t *const clos = g->clos;
+	gv_arena_reset(clos->arena);
+	free(clos->arena);
+	free(clos);
+	return SUCCESS;
+    }
+
     for (subg = agfstsubg(g); subg; subg = next_subg) {
 	next_subg = agnxtsubg(subg);
 	agclose(subg);
@@ -114,15 +239,22 @@ int agclose(Agraph_t * g)
     aginternalmapclose(g);
     agmethod_delete(g, g);
 
-    assert(node_set_is_empty(g->n_id));
-    node_set_free(&g->n_id);
-    assert(dtsize(g->n_seq) == 0);
-    if (agdtclose(g, g->n_seq)) return FAILURE;
-
-    assert(dtsize(g->e_id) == 0);
-    if (agdtclose(g, g->e_id)) return FAILURE;
-    assert(dtsize(g->e_seq) == 0);
-    if (agdtclose(g, g->e_seq)) return FAILURE;
+    if (g->n_bits) {
+	assert(seq_set_size(g->n_bits) == 0);
+	seq_set_free(&g->n_bits);
+	assert(seq_set_size(g->e_bits) == 0);
+	seq_set_free(&g->e_bits);
+    } else {
+	assert(node_set_is_empty(g->n_id));
+	node_set_free(&g->n_id);
+	assert(dtsize(g->n_seq) == 0);
+	if (agdtclose(g, g->n_seq)) return FAILURE;
+
+	assert(dtsize(g->e_id) == 0);
+	if (agdtclose(g, g->e_id)) return FAILURE;
+	assert(dtsize(g->e_seq) == 0);
+	if (agdtclose(g, g->e_seq)) return FAILURE;
+    }
 
     assert(dtsize(g->g_seq) == 0);
     if (agdtclose(g, g->g_seq)) return FAILURE;
@@ -137,14 +269,24 @@ int agclose(Agraph_t * g)
 
     if (par) {
 	agdelsubg(par, g);
-	free(g);
+	agfree(g, g, sizeof(Agraph_t));
     } else {
 	while (g->clos->cb)
 	    agpopdisc(g, g->clos->cb->f);
+	agcolumnsclose(g);
+	assert(g->clos->edge_index == NULL ||
+	       edge_index_size(g->clos->edge_index) == 0);
+	edge_index_free(&g->clos->edge_index);
+	free(g->clos->node_table);
 	AGDISC(g, id)->close(AGCLOS(g, id));
 	if (agstrclose(g)) return FAILURE;
-	free(g->clos);
-	free(g);
+	Agclos_t *const clos = g->clos;
+	agfree(g, g, sizeof(Agraph_t));
+	if (clos->arena) {
+	    gv_arena_reset(clos->arena);
+	    free(clos->arena);
+	}
+	free(clos);
     }
     return SUCCESS;
 }
@@ -156,8 +298,10 @@ uint64_t agnextseq(Agraph_t * g, int objtype)
 
 int agnnodes(Agraph_t * g)
 {
-  assert(node_set_size(g->n_id) <= INT_MAX);
-  return (int)node_set_size(g->n_id);
+  const size_t size =
+      g->n_bits ? seq_set_size(g->n_bits) : node_set_size(g->n_id);
+  assert(size <= INT_MAX);
+  return (int)size;
 }
 
 int agnedges(Agraph_t * g)
@@ -165,6 +309,11 @@ int agnedges(Agraph_t * g)
     Agnode_t *n;
     int rv = 0;
 
+    if (g->e_bits) {
+	assert(seq_set_size(g->e_bits) <= INT_MAX);
+	return (int)seq_set_size(g->e_bits);
+    }
+
     for (n = agfstnode(g); n; n = agnxtnode(g, n))
 	rv += agdegree(g, n, 0, 1);	/* must use OUT to get self-arcs */
     return rv;
@@ -204,16 +353,38 @@ static int cnt(Dict_t * d, Dtlink_t ** set)
 	return rv;
 }
 
-int agcountuniqedges(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
+/* count the out- or in-edges of a node */
+static int cntedges(Agraph_t * g, Agnode_t * n, bool out)
 {
-    Agedge_t *e;
     Agsubnode_t *sn;
+    Agedge_t *e;
     int rv = 0;
 
+    /* no per-node sets to take the size of, or none to restore safely */
+    if (g->e_bits || g->clos->frozen) {
+	if (out) {
+	    for (e = agfstout(g, n); e; e = agnxtout(g, e))
+		rv++;
+	} else {
+	    for (e = agfstin(g, n); e; e = agnxtin(g, e))
+		rv++;
+	}
+	return rv;
+    }
     sn = agsubrep(g, n);
-    if (want_out) rv = cnt(g->e_seq,&(sn->out_seq));
+    if (sn)
+	rv = cnt(g->e_seq, out ? &sn->out_seq : &sn->in_seq);
+    return rv;
+}
+
+int agcountuniqedges(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
+{
+    Agedge_t *e;
+    int rv = 0;
+
+    if (want_out) rv = cntedges(g, n, true);
     if (want_in) {
-		if (!want_out) rv += cnt(g->e_seq,&(sn->in_seq));	/* cheap */
+		if (!want_out) rv += cntedges(g, n, false);	/* cheap */
 		else {	/* less cheap */
 			for (e = agfstin(g, n); e; e = agnxtin(g, e))
 				if (e->node != n) rv++;  /* don't double count loops */
@@ -224,14 +395,10 @@ int agcountuniqedges(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
 
 int agdegree(Agraph_t * g, Agnode_t * n, int want_in, int want_out)
 {
-    Agsubnode_t *sn;
     int rv = 0;
 
-    sn = agsubrep(g, n);
-    if (sn) {
-	if (want_out) rv += cnt(g->e_seq,&(sn->out_seq));
-	if (want_in) rv += cnt(g->e_seq,&(sn->in_seq));
-    }
+    if (want_out) rv += cntedges(g, n, true);
+    if (want_in) rv += cntedges(g, n, false);
 	return rv;
 }
 
@@ -274,7 +441,7 @@ Agdesc_t Agstrictdirected = {.directed = true, .strict = true, .maingraph = true
 Agdesc_t Agundirected = {.maingraph = true};
 Agdesc_t Agstrictundirected = {.strict = true, .maingraph = true};
 
-Agdisc_t AgDefaultDisc = { &AgIdDisc, &AgIoDisc };
+Agdisc_t AgDefaultDisc = {.id = &AgIdDisc, .io = &AgIoDisc};
 
 /**
  * @dir lib/cgraph
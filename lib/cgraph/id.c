@@ -159,7 +159,7 @@ char *agnameof(void *obj)
 	    return rv;
     }
     if (AGTYPE(obj) != AGEDGE) {
-	static char buf[32];
+	static _Thread_local char buf[32];
 	snprintf(buf, sizeof(buf), "%c%" PRIu64, LOCALNAMEPREFIX, AGID(obj));
 	rv = buf;
     }
@@ -14,10 +14,19 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <cgraph/cghdr.h>
 #include <cgraph/rdr.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <util/alloc.h>
+#include <util/gv_ctype.h>
 
 static int iofread(void *chan, char *buf, int bufsize)
 {
@@ -70,15 +79,19 @@ memiofread(void *chan, char *buf, int bufsize)
     return l;
 }
 
-static Agiodisc_t memIoDisc = {memiofread, 0, 0};
+static Agiodisc_t memIoDisc = {memiofread, ioputstr, ioflush};
 
 static Agraph_t *agmemread0(Agraph_t *arg_g, const char *cp)
 {
     rdr_t rdr;
-    Agdisc_t disc;
+    Agdisc_t disc = {0};
 
-    memIoDisc.putstr = AgIoDisc.putstr;
-    memIoDisc.flush = AgIoDisc.flush;
+    // follow any change to the default discipline, but without writing when
+    // there is none, so reading graphs from several threads does not race
+    if (memIoDisc.putstr != AgIoDisc.putstr)
+	memIoDisc.putstr = AgIoDisc.putstr;
+    if (memIoDisc.flush != AgIoDisc.flush)
+	memIoDisc.flush = AgIoDisc.flush;
     rdr.data = cp;
     rdr.len = strlen(cp);
     rdr.cur = 0;
@@ -98,3 +111,108 @@ Agraph_t *agmemconcat(Agraph_t *g, const char *cp)
 {
     return agmemread0(g, cp);
 }
+
+struct graphviz_mapped_input {
+    char *data;		///< file contents
+    size_t size;	///< size of the file
+    size_t cur;		///< offset at which to read the next graph
+    char *filename;	///< path of the file, for diagnostics
+};
+
+struct graphviz_mapped_input *agmapopen(const char *filename)
+{
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+	return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+	const int err = errno;
+	close(fd);
+	errno = err;
+	return NULL;
+    }
+    // files such as those under /proc report a size of 0 but have contents
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+	close(fd);
+	errno = EINVAL;
+	return NULL;
+    }
+
+    const size_t size = (size_t)st.st_size;
+    char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int err = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+	errno = err;
+	return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+    struct graphviz_mapped_input *input = gv_alloc(sizeof(*input));
+    input->data = data;
+    input->size = size;
+    input->filename = gv_strdup(filename);
+    return input;
+#else
+    (void)filename;
+    errno = ENOTSUP;
+    return NULL;
+#endif
+}
+
+Agraph_t *agmapread(struct graphviz_mapped_input *input, Agdisc_t *disc)
+{
+    return agmapread_flags(input, disc, 0);
+}
+
+Agraph_t *agmapread_flags(struct graphviz_mapped_input *input, Agdisc_t *disc,
+                          unsigned flags)
+{
+    assert(input != NULL);
+
+    if (!agflagsknown(flags))
+	return NULL;
+    if (input->cur >= input->size)
+	return NULL;
+
+    // the options of the new graph, without those of reading it
+    const unsigned options = flags & ~(unsigned)AG_PARALLEL_READ;
+
+    // a graph in the binary format, possibly after whitespace ending DOT
+    size_t start = input->cur;
+    while (start < input->size && gv_isspace(input->data[start]))
+	++start;
+    if (agisbin(input->data + start, input->size - start)) {
+	size_t used = 0;
+	Agraph_t *g = agreadbinbuf(input->data + start, input->size - start,
+	                           &used, disc, options);
+	input->cur = g == NULL ? input->size : start + used;
+	return g;
+    }
+
+    size_t used = 0;
+    Agraph_t *g;
+    if (flags & AG_PARALLEL_READ)
+	g = agreadparallelbuf(input->filename, input->data + input->cur,
+	                      input->size - input->cur, &used, disc, options);
+    else
+	g = agconcatbuf(NULL, input->filename, input->data + input->cur,
+	                input->size - input->cur, &used, disc, options);
+    input->cur += used;
+    return g;
+}
+
+void agmapclose(struct graphviz_mapped_input *input)
+{
+    if (input == NULL)
+	return;
+#ifdef HAVE_SYS_MMAN_H
+    munmap(input->data, input->size);
+#endif
+    free(input->filename);
+    free(input);
+}
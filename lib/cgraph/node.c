@@ -16,16 +16,50 @@
 #include <assert.h>
 #include <cgraph/cghdr.h>
 #include <cgraph/node_set.h>
+#include <cgraph/seq_set.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <util/alloc.h>
+#include <util/list.h>
 #include <util/unreachable.h>
+#include <util/unused.h>
+
+/* record the node with a given sequence number, for subgraph bitsets */
+static void node_table_set(Agraph_t * g, uint64_t seq, Agnode_t * n)
+{
+    Agclos_t *clos = g->clos;
+
+    if (seq >= clos->node_table_size) {
+	size_t size = clos->node_table_size ? clos->node_table_size : 64;
+	while (size <= seq)
+	    size *= 2;
+	clos->node_table = gv_recalloc(clos->node_table, clos->node_table_size,
+				       size, sizeof(Agnode_t *));
+	clos->node_table_size = size;
+    }
+    clos->node_table[seq] = n;
+}
+
+/* the node with a sequence number found in a subgraph bitset */
+static Agnode_t *node_of_seq(Agraph_t * g, uint64_t seq)
+{
+    if (seq == SEQ_SET_NONE)
+	return NULL;
+    assert(seq < g->clos->node_table_size && g->clos->node_table[seq]);
+    return g->clos->node_table[seq];
+}
 
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id)
 {
     Agsubnode_t *sn;
+    Agnode_t *n;
 
+    if (g->n_bits) {
+	n = agfindnode_by_id(agroot(g), id);
+	return n && seq_set_contains(g->n_bits, AGSEQ(n)) ? n : NULL;
+    }
     sn = node_set_find(g->n_id, id);
     return sn ? sn->node : NULL;
 }
@@ -43,6 +77,8 @@ static Agnode_t *agfindnode_by_name(Agraph_t * g, char *name)
 Agnode_t *agfstnode(Agraph_t * g)
 {
     Agsubnode_t *sn;
+    if (g->n_bits)
+	return node_of_seq(g, seq_set_next(g->n_bits, 0));
     sn = dtfirst(g->n_seq);
     return sn ? sn->node : NULL;
 }
@@ -50,6 +86,11 @@ Agnode_t *agfstnode(Agraph_t * g)
 Agnode_t *agnxtnode(Agraph_t * g, Agnode_t * n)
 {
     Agsubnode_t *sn;
+    if (g->n_bits) {
+	if (!seq_set_contains(g->n_bits, AGSEQ(n)))
+	    return NULL;
+	return node_of_seq(g, seq_set_next(g->n_bits, AGSEQ(n) + 1));
+    }
     sn = agsubrep(g, n);
     if (sn) sn = dtnext(g->n_seq, sn);
     return sn ? sn->node : NULL;
@@ -58,6 +99,8 @@ Agnode_t *agnxtnode(Agraph_t * g, Agnode_t * n)
 Agnode_t *aglstnode(Agraph_t * g)
 {
     Agsubnode_t *sn;
+    if (g->n_bits)
+	return node_of_seq(g, seq_set_prev(g->n_bits, UINT64_MAX));
     sn = dtlast(g->n_seq);
     return sn ? sn->node : NULL;
 }
@@ -65,6 +108,11 @@ Agnode_t *aglstnode(Agraph_t * g)
 Agnode_t *agprvnode(Agraph_t * g, Agnode_t * n)
 {
     Agsubnode_t *sn;
+    if (g->n_bits) {
+	if (AGSEQ(n) == 0 || !seq_set_contains(g->n_bits, AGSEQ(n)))
+	    return NULL;
+	return node_of_seq(g, seq_set_prev(g->n_bits, AGSEQ(n) - 1));
+    }
     sn = agsubrep(g, n);
     if (sn) sn = dtprev(g->n_seq, sn);
     return sn ? sn->node : NULL;
@@ -76,7 +124,7 @@ static Agnode_t *newnode(Agraph_t * g, IDTYPE id, uint64_t seq)
 {
     assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
 
-    Agnode_t *n = gv_alloc(sizeof(Agnode_t));
+    Agnode_t *n = agalloc(g, sizeof(Agnode_t));
     AGTYPE(n) = AGNODE;
     AGID(n) = id;
     AGSEQ(n) = seq & SEQ_MASK;
@@ -95,10 +143,18 @@ static void installnode(Agraph_t * g, Agnode_t * n)
     size_t osize;
     (void)osize;
 
+    if (g->n_bits) {
+	bool added UNUSED = seq_set_add(g->n_bits, AGSEQ(n));
+	assert(added);
+	return;
+    }
+    if (g == agroot(g) && (g->clos->flags & AG_SUBGRAPH_BITSETS))
+	node_table_set(g, AGSEQ(n), n);
+
     assert(node_set_size(g->n_id) == (size_t)dtsize(g->n_seq));
     osize = node_set_size(g->n_id);
     if (g == agroot(g)) sn = &(n->mainsub);
-    else sn = gv_alloc(sizeof(Agsubnode_t));
+    else sn = agalloc(g, sizeof(Agsubnode_t));
     sn->node = n;
     node_set_add(g->n_id, sn);
     dtinsert(g->n_seq, sn);
@@ -162,7 +218,7 @@ Agnode_t *agnode(Agraph_t * g, char *name, int cflag)
 	n = newnode(g, id, agnextseq(g, AGNODE));
 	installnodetoroot(g, n);
 	initnode(g, n);
-	assert(agsubrep(g,n));
+	assert(agsubnode(g, n, 0) == n);
 	agregister(g, AGNODE, n); /* register in external namespace */
 	return n;
     }
@@ -182,6 +238,13 @@ void agdelnodeimage(Agraph_t *g, Agobj_t *node, void *ignored) {
 	f = agnxtedge(g, e, n);
 	agdeledgeimage(g, &e->base, 0);
     }
+    if (g->n_bits) {
+	bool removed UNUSED = seq_set_remove(g->n_bits, AGSEQ(n));
+	assert(removed);
+	return;
+    }
+    if (g == agroot(g) && (g->clos->flags & AG_SUBGRAPH_BITSETS))
+	node_table_set(g, AGSEQ(n), NULL);
     /* If the following lines are switched, switch the discipline using
      * free_subnode below.
      */ 
@@ -208,7 +271,7 @@ int agdelnode(Agraph_t * g, Agnode_t * n)
     }
     if (agapply(g, &n->base, agdelnodeimage, NULL, false) == SUCCESS) {
 	if (g == agroot(g))
-	    free(n);
+	    agfree(g, n, sizeof(Agnode_t));
 	return SUCCESS;
     } else
 	return FAILURE;
@@ -258,6 +321,15 @@ Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n0, int cflag)
 
     if (agroot(g) != n0->root)
 	return NULL;
+    if (g->n_bits) {	/* <n0> itself, if its bit is set */
+	if (!seq_set_contains(g->n_bits, AGSEQ(n0))) {
+	    if (!cflag)
+		return NULL;
+	    (void)agsubnode(agparent(g), n0, cflag);
+	    installnode(g, n0);
+	}
+	return n0;
+    }
     n = agfindnode_by_id(g, AGID(n0));
     if (n == NULL && cflag) {
 	if ((par = agparent(g))) {
@@ -300,7 +372,7 @@ static int agsubnodeseqcmpf(void *arg0, void *arg1) {
 static void free_subnode(void *subnode) {
    Agsubnode_t *sn = subnode;
    if (!AGSNMAIN(sn)) 
-	free(sn);
+	agfree(sn->node->root, sn, sizeof(Agsubnode_t));
 }
 
 Dtdisc_t Ag_subnode_seq_disc = {
@@ -309,17 +381,50 @@ Dtdisc_t Ag_subnode_seq_disc = {
     .comparf = agsubnodeseqcmpf,
 };
 
-static void agnodesetfinger(Agraph_t *g, Agobj_t *node, void *ignored) {
+typedef LIST(Agraph_t *) graphs_t;
+
+static void agnodesetfinger(Agraph_t *g, Agobj_t *node, void *arg) {
     Agnode_t *const n = (Agnode_t *)((char *)node - offsetof(Agnode_t, base));
+    if (g->n_bits) {	/* take the node out, to be put back by its new number */
+	seq_set_remove(g->n_bits, AGSEQ(n));
+	LIST_APPEND((graphs_t *)arg, g);
+	return;
+    }
     Agsubnode_t template = {.node = n};
 	dtsearch(g->n_seq,&template);
-    (void)ignored;
 }
 
 static void agnoderenew(Agraph_t *g, Agobj_t *n, void *ignored) {
-    dtrenew(g->n_seq, dtfinger(g->n_seq));
     (void)n;
     (void)ignored;
+    if (g->n_bits)
+	return;
+    dtrenew(g->n_seq, dtfinger(g->n_seq));
+}
+
+/* give <n> a new sequence number, keeping the graphs containing it ordered */
+static int agnodereseq(Agnode_t *n, uint64_t seq)
+{
+	Agraph_t *g = agroot(n);
+	graphs_t moved = {0};
+	int rc = FAILURE;
+
+	if (agapply(g, &n->base, agnodesetfinger, &moved, false) != SUCCESS)
+		goto done;
+	assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
+	if ((g->clos->flags & AG_SUBGRAPH_BITSETS))
+		node_table_set(g, AGSEQ(n), NULL);
+	AGSEQ(n) = seq & SEQ_MASK;
+	if ((g->clos->flags & AG_SUBGRAPH_BITSETS))
+		node_table_set(g, AGSEQ(n), n);
+	for (size_t i = 0; i < LIST_SIZE(&moved); ++i)
+		seq_set_add(LIST_GET(&moved, i)->n_bits, AGSEQ(n));
+	if (agapply(g, &n->base, agnoderenew, NULL, false) != SUCCESS)
+		goto done;
+	rc = SUCCESS;
+done:
+	LIST_FREE(&moved);
+	return rc;
 }
 
 int agnodebefore(Agnode_t *fst, Agnode_t *snd)
@@ -332,39 +437,20 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 	if (AGSEQ(fst) > AGSEQ(snd)) return SUCCESS;
 
 	/* move snd out of the way somewhere */
-	n = snd;
-	if (agapply(g, &n->base, agnodesetfinger, n, false) != SUCCESS) {
-		return FAILURE;
-	}
-	{
-		uint64_t seq = g->clos->seq[AGNODE] + 2;
-		assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
-		AGSEQ(snd) = seq & SEQ_MASK;
-	}
-	if (agapply(g, &n->base, agnoderenew, n, false) != SUCCESS) {
+	if (agnodereseq(snd, g->clos->seq[AGNODE] + 2) != SUCCESS) {
 		return FAILURE;
 	}
 	n = agprvnode(g,snd);
 	do {
 		nxt = agprvnode(g,n);
-		if (agapply(g, &n->base, agnodesetfinger, n, false) != SUCCESS) {
-		  return FAILURE;
-		}
-		uint64_t seq = AGSEQ(n) + 1;
-		assert((seq & SEQ_MASK) == seq && "sequence ID overflow");
-		AGSEQ(n) = seq & SEQ_MASK;
-		if (agapply(g, &n->base, agnoderenew, n, false) != SUCCESS) {
+		if (agnodereseq(n, AGSEQ(n) + 1) != SUCCESS) {
 		  return FAILURE;
 		}
 		if (n == fst) break;
 		n = nxt;
 	} while (n);
-	if (agapply(g, &snd->base, agnodesetfinger, n, false) != SUCCESS) {
-		return FAILURE;
-	}
 	assert(AGSEQ(fst) != 0 && "sequence ID overflow");
-	AGSEQ(snd) = (AGSEQ(fst) - 1) & SEQ_MASK;
-	if (agapply(g, &snd->base, agnoderenew, snd, false) != SUCCESS) {
+	if (agnodereseq(snd, AGSEQ(fst) - 1) != SUCCESS) {
 		return FAILURE;
 	}
 	return SUCCESS;
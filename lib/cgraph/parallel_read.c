@@ -0,0 +1,836 @@
+/// @file
+/// @brief implements the @ref AG_PARALLEL_READ option of @ref agmapread_flags
+/// @ingroup cgraph_core
+///
+/// The input is cut into chunks that are tokenized on several threads. Each
+/// chunk collects its distinct strings, already unquoted, in a table of its
+/// own. The tokens are then replayed in input order on the calling thread,
+/// which makes the same calls to create nodes, edges and attributes as the
+/// actions of grammar.y. The graph is therefore the same as one read by the
+/// serial parser.
+///
+/// Chunk boundaries are placed after a newline and assumed to fall between
+/// tokens. When the token before a boundary turns out to run past it, such as
+/// a string or comment spanning several lines, the next chunk is tokenized
+/// again from where that token ends.
+///
+/// Only graphs whose body is a flat list of node, edge and attribute
+/// statements are replayed. Anything else, such as a subgraph, a port, a
+/// concatenated string or a syntax error, is left to the serial parser. The
+/// partly built graph is then discarded and the serial parser reads the whole
+/// graph again.
+
+#include "config.h"
+
+#include <assert.h>
+#include <cgraph/cghdr.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/agxbuf.h>
+#include <util/alloc.h>
+#include <util/gv_ctype.h>
+#include <util/list.h>
+#include <util/parallel.h>
+#include <util/strcasecmp.h>
+#include <util/streq.h>
+
+/// bytes of input per chunk, before moving its end to the next line start
+enum { CHUNK_SIZE = 256 * 1024 };
+
+/// chunks tokenized at once, per worker
+enum { CHUNKS_PER_WORKER = 8 };
+
+/// bytes tokenized by the first batch
+///
+/// Batches double in size from this, so reading a small graph from the front
+/// of a large file does not tokenize much of what follows it.
+enum { FIRST_BATCH = 16 * 1024 };
+
+/// kinds of token other than single characters, which stand for themselves
+enum {
+  TOK_END = -1,        ///< end of the input
+  TOK_ATOM = 256,      ///< name, number, or quoted or HTML-like string
+  TOK_DIRECTED_OP,     ///< `->`
+  TOK_UNDIRECTED_OP,   ///< `--`
+  TOK_GRAPH,
+  TOK_DIGRAPH,
+  TOK_NODE,
+  TOK_EDGE,
+  TOK_STRICT,
+  TOK_SUBGRAPH,
+  /// input only the serial parser handles in the same way, such as a badly
+  /// delimited number it warns about or an unterminated string
+  TOK_UNSUPPORTED,
+};
+
+typedef struct {
+  int kind;
+  /// for @ref TOK_ATOM, the index of its string in the chunk, and for `}`,
+  /// the offset of the input following it
+  size_t value;
+} token_t;
+
+/// a distinct string of a chunk
+typedef struct {
+  size_t offset; ///< start of its NUL terminated contents in `chunk_t.text`
+  size_t length;
+  bool html;
+} string_t;
+
+/// a run of input tokenized by one worker
+typedef struct {
+  size_t begin; ///< offset of the first token
+  size_t limit; ///< offset from which tokens belong to the next chunk
+  size_t end;   ///< offset after the last token, at or past `limit`
+  LIST(token_t) tokens;
+  LIST(string_t) strings;
+  agxbuf text;    ///< contents of the strings
+  size_t *slots;  ///< hash table of string indices plus one, or 0 if free
+  size_t n_slots; ///< size of `slots`, a power of 2
+  agxbuf scratch; ///< a quoted string being unescaped
+  char **interned; ///< the strings, as interned in the graph once used
+} chunk_t;
+
+static const char Key[] = "key";
+
+static size_t hash(const char *s, size_t length, bool html) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ull ^ (uint64_t)html;
+  for (size_t i = 0; i < length; ++i) {
+    h ^= (unsigned char)s[i];
+    h *= 1099511628211ull;
+  }
+  return (size_t)h;
+}
+
+/// find or add a string in the table of a chunk
+///
+/// @return Index of the string
+static size_t intern(chunk_t *c, const char *s, size_t length, bool html) {
+  if (2 * (LIST_SIZE(&c->strings) + 1) > c->n_slots) {
+    const size_t n_slots = c->n_slots == 0 ? 256 : 2 * c->n_slots;
+    size_t *const slots = gv_calloc(n_slots, sizeof(size_t));
+    for (size_t i = 0; i < LIST_SIZE(&c->strings); ++i) {
+      const string_t *const str = LIST_AT(&c->strings, i);
+      size_t j = hash(agxbstart(&c->text) + str->offset, str->length,
+                      str->html) &
+                 (n_slots - 1);
+      while (slots[j] != 0) {
+        j = (j + 1) & (n_slots - 1);
+      }
+      slots[j] = i + 1;
+    }
+    free(c->slots);
+    c->slots = slots;
+    c->n_slots = n_slots;
+  }
+
+  size_t j = hash(s, length, html) & (c->n_slots - 1);
+  for (; c->slots[j] != 0; j = (j + 1) & (c->n_slots - 1)) {
+    const string_t *const str = LIST_AT(&c->strings, c->slots[j] - 1);
+    if (str->length == length && str->html == html &&
+        memcmp(agxbstart(&c->text) + str->offset, s, length) == 0) {
+      return c->slots[j] - 1;
+    }
+  }
+
+  const string_t str = {
+      .offset = agxblen(&c->text), .length = length, .html = html};
+  agxbput_n(&c->text, s, length);
+  agxbputc(&c->text, '\0');
+  LIST_APPEND(&c->strings, str);
+  c->slots[j] = LIST_SIZE(&c->strings);
+  return LIST_SIZE(&c->strings) - 1;
+}
+
+static void push(chunk_t *c, int kind, size_t value) {
+  LIST_APPEND(&c->tokens, ((token_t){.kind = kind, .value = value}));
+}
+
+/// the LETTER class of scan.l
+static bool is_letter(unsigned char c) {
+  return gv_isalpha(c) || c == '_' || c >= 0200;
+}
+
+/// length of the NUMBER of scan.l at the start of `s`, or 0 if there is none
+static size_t number_length(const char *s, size_t size) {
+  size_t i = 0;
+  if (i < size && s[i] == '-') {
+    ++i;
+  }
+  if (i < size && gv_isdigit(s[i])) {
+    while (i < size && gv_isdigit(s[i])) {
+      ++i;
+    }
+    if (i < size && s[i] == '.') {
+      ++i;
+      while (i < size && gv_isdigit(s[i])) {
+        ++i;
+      }
+    }
+  } else if (i + 1 < size && s[i] == '.' && gv_isdigit(s[i + 1])) {
+    i += 2;
+    while (i < size && gv_isdigit(s[i])) {
+      ++i;
+    }
+  } else {
+    return 0;
+  }
+  if (i < size && (s[i] == '.' || is_letter((unsigned char)s[i]))) {
+    ++i;
+  }
+  return i;
+}
+
+/// would the scanner warn about this number and split it, as in chkNum?
+static bool bad_number(const char *s, size_t length) {
+  const char last = s[length - 1];
+  if (last == '.') {
+    const char *const dot = memchr(s, '.', length);
+    return dot != &s[length - 1];
+  }
+  return !gv_isdigit(last);
+}
+
+static int keyword(const char *s, size_t length) {
+  static const struct {
+    const char *word;
+    int kind;
+  } keywords[] = {{"node", TOK_NODE},         {"edge", TOK_EDGE},
+                  {"graph", TOK_GRAPH},       {"digraph", TOK_DIGRAPH},
+                  {"strict", TOK_STRICT},     {"subgraph", TOK_SUBGRAPH}};
+  // scan.l is generated case-insensitive
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i) {
+    if (strlen(keywords[i].word) == length &&
+        strncasecmp(s, keywords[i].word, length) == 0) {
+      return keywords[i].kind;
+    }
+  }
+  return TOK_ATOM;
+}
+
+/// tokenize a chunk, following the rules of scan.l
+///
+/// Tokens starting before the chunk’s limit are read, to their end.
+static void scan(chunk_t *c, const char *data, size_t size) {
+  size_t pos = c->begin;
+  while (pos < c->limit) {
+    const unsigned char ch = (unsigned char)data[pos];
+
+    if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+      ++pos;
+      continue;
+    }
+
+    if (ch == '/' && pos + 1 < size && data[pos + 1] == '*') {
+      size_t i = pos + 2;
+      while (i + 1 < size && !(data[i] == '*' && data[i + 1] == '/')) {
+        ++i;
+      }
+      if (i + 1 >= size) {
+        push(c, TOK_UNSUPPORTED, 0);
+        pos = size;
+        break;
+      }
+      pos = i + 2;
+      continue;
+    }
+
+    if (ch == '#' || (ch == '/' && pos + 1 < size && data[pos + 1] == '/')) {
+      const char *const eol = memchr(data + pos, '\n', size - pos);
+      pos = eol == NULL ? size : (size_t)(eol - data);
+      continue;
+    }
+
+    if (ch == '-' && pos + 1 < size && data[pos + 1] == '>') {
+      push(c, TOK_DIRECTED_OP, 0);
+      pos += 2;
+      continue;
+    }
+    if (ch == '-' && pos + 1 < size && data[pos + 1] == '-') {
+      push(c, TOK_UNDIRECTED_OP, 0);
+      pos += 2;
+      continue;
+    }
+
+    if (ch == '-' || ch == '.' || gv_isdigit(ch)) {
+      const size_t length = number_length(data + pos, size - pos);
+      if (length > 0) {
+        if (bad_number(data + pos, length)) {
+          push(c, TOK_UNSUPPORTED, 0);
+          pos += length - 1;
+        } else {
+          push(c, TOK_ATOM, intern(c, data + pos, length, false));
+          pos += length;
+        }
+        continue;
+      }
+    }
+
+    if (is_letter(ch)) {
+      size_t length = 1;
+      while (pos + length < size &&
+             (is_letter((unsigned char)data[pos + length]) ||
+              gv_isdigit(data[pos + length]))) {
+        ++length;
+      }
+      if (length == 3 && memcmp(data + pos, "\xEF\xBB\xBF", 3) == 0) {
+        // a byte order mark
+      } else {
+        const int kind = keyword(data + pos, length);
+        push(c, kind,
+             kind == TOK_ATOM ? intern(c, data + pos, length, false) : 0);
+      }
+      pos += length;
+      continue;
+    }
+
+    if (ch == '"') {
+      agxbclear(&c->scratch);
+      bool nul = false;
+      size_t i = pos + 1;
+      while (i < size && data[i] != '"') {
+        if (data[i] == '\\' && i + 1 < size && data[i + 1] == '"') {
+          agxbputc(&c->scratch, '"');
+          i += 2;
+        } else if (data[i] == '\\' && i + 1 < size && data[i + 1] == '\\') {
+          agxbput(&c->scratch, "\\\\");
+          i += 2;
+        } else if (data[i] == '\\' && i + 1 < size && data[i + 1] == '\n') {
+          i += 2;
+        } else {
+          nul |= data[i] == '\0';
+          agxbputc(&c->scratch, data[i]);
+          ++i;
+        }
+      }
+      if (i >= size || nul) {
+        push(c, TOK_UNSUPPORTED, 0);
+      } else {
+        const size_t length = agxblen(&c->scratch);
+        push(c, TOK_ATOM, intern(c, agxbstart(&c->scratch), length, false));
+      }
+      pos = i < size ? i + 1 : size;
+      continue;
+    }
+
+    if (ch == '<') {
+      agxbclear(&c->scratch);
+      bool nul = false;
+      int nest = 1;
+      size_t i = pos + 1;
+      for (; i < size; ++i) {
+        if (data[i] == '>' && --nest == 0) {
+          break;
+        }
+        if (data[i] == '<') {
+          ++nest;
+        }
+        nul |= data[i] == '\0';
+        agxbputc(&c->scratch, data[i]);
+      }
+      if (i >= size || nul) {
+        push(c, TOK_UNSUPPORTED, 0);
+      } else {
+        const size_t length = agxblen(&c->scratch);
+        push(c, TOK_ATOM, intern(c, agxbstart(&c->scratch), length, true));
+      }
+      pos = i < size ? i + 1 : size;
+      continue;
+    }
+
+    if (ch == '\0' || ch == '@') {
+      // '@' ends the input, like `GRAPH_EOF_TOKEN`
+      push(c, TOK_UNSUPPORTED, 0);
+    } else {
+      push(c, ch, pos + 1);
+    }
+    ++pos;
+  }
+  c->end = pos;
+}
+
+/// what the workers tokenizing a batch of chunks share
+typedef struct {
+  chunk_t **chunks;
+  const char *data;
+  size_t size;
+} batch_t;
+
+static void scan_chunks(void *context, size_t start, size_t end,
+                        size_t worker) {
+  (void)worker;
+  const batch_t *const batch = context;
+  for (size_t i = start; i < end; ++i) {
+    scan(batch->chunks[i], batch->data, batch->size);
+  }
+}
+
+/// release a chunk and the references it holds to strings of a graph
+///
+/// @param g Graph its strings were interned in, or NULL if it was closed
+static void chunk_free(chunk_t *c, Agraph_t *g) {
+  if (c->interned != NULL && g != NULL) {
+    for (size_t i = 0; i < LIST_SIZE(&c->strings); ++i) {
+      if (c->interned[i] != NULL) {
+        agstrfree(g, c->interned[i], LIST_AT(&c->strings, i)->html);
+      }
+    }
+  }
+  free(c->interned);
+  LIST_FREE(&c->tokens);
+  LIST_FREE(&c->strings);
+  agxbfree(&c->text);
+  agxbfree(&c->scratch);
+  free(c->slots);
+  free(c);
+}
+
+/// an attribute setting of the statement being replayed
+typedef struct {
+  char *name;
+  char *value;
+  Agsym_t *sym; ///< the attribute, once declared, or NULL for an edge key
+} attr_t;
+
+typedef struct {
+  const char *data;
+  size_t size;
+  gv_pool_t *pool;
+  size_t batch;   ///< bytes to tokenize in the next batch
+  size_t next;    ///< offset at which to tokenize the next batch
+  LIST(chunk_t *) chunks; ///< chunks not yet released, in input order
+  size_t current; ///< index in `chunks` of the chunk being replayed
+  size_t token;   ///< index in that chunk of the next token
+  Agraph_t *g;
+  bool directed;
+  // the statement being replayed
+  LIST(Agnode_t *) nodes;
+  LIST(size_t) groups; ///< index in `nodes` of each node list of an edge
+  LIST(attr_t) attrs;
+} ingest_t;
+
+/// tokenize the next batch of input
+static void tokenize(ingest_t *r) {
+  const size_t first = LIST_SIZE(&r->chunks);
+  size_t budget = r->batch;
+  for (size_t start = r->next; budget > 0 && start < r->size;) {
+    size_t limit;
+    const size_t chunk_size = budget < CHUNK_SIZE ? budget : CHUNK_SIZE;
+    if (r->size - start <= chunk_size) {
+      limit = r->size;
+    } else {
+      // end after a newline, where a token is likely to start
+      limit = start + chunk_size;
+      const size_t window =
+          r->size - limit < CHUNK_SIZE ? r->size - limit : CHUNK_SIZE;
+      const char *const eol = memchr(r->data + limit, '\n', window);
+      if (eol != NULL) {
+        limit = (size_t)(eol - r->data) + 1;
+      }
+    }
+    chunk_t *const c = gv_alloc(sizeof(chunk_t));
+    c->begin = start;
+    c->limit = limit;
+    LIST_APPEND(&r->chunks, c);
+    budget -= chunk_size;
+    start = limit;
+  }
+  const size_t n = LIST_SIZE(&r->chunks) - first;
+  assert(n > 0);
+
+  if (n > 1 && r->pool == NULL) {
+    r->pool = gv_pool_new(0);
+  }
+  batch_t batch = {.chunks = gv_calloc(n, sizeof(chunk_t *)),
+                   .data = r->data,
+                   .size = r->size};
+  for (size_t i = 0; i < n; ++i) {
+    batch.chunks[i] = LIST_GET(&r->chunks, first + i);
+  }
+  gv_pool_for(n > 1 ? r->pool : NULL, n, 1, scan_chunks, &batch);
+  free(batch.chunks);
+
+  // tokenize again any chunk that did not start where the one before ended
+  for (size_t i = first + 1; i < first + n; ++i) {
+    const chunk_t *const prev = LIST_GET(&r->chunks, i - 1);
+    chunk_t *const c = LIST_GET(&r->chunks, i);
+    if (prev->end != c->begin) {
+      LIST_CLEAR(&c->tokens);
+      LIST_CLEAR(&c->strings);
+      agxbclear(&c->text);
+      if (c->slots != NULL) {
+        memset(c->slots, 0, c->n_slots * sizeof(c->slots[0]));
+      }
+      c->begin = prev->end;
+      scan(c, r->data, r->size);
+    }
+  }
+  r->next = LIST_GET(&r->chunks, first + n - 1)->end;
+
+  const size_t most =
+      (size_t)CHUNKS_PER_WORKER * gv_pool_size(r->pool) * CHUNK_SIZE;
+  r->batch = r->batch < most / 2 ? 2 * r->batch : most;
+}
+
+/// the next token, without moving past it
+static const token_t *peek(ingest_t *r) {
+  static const token_t end = {.kind = TOK_END};
+  for (;;) {
+    if (r->current < LIST_SIZE(&r->chunks)) {
+      const chunk_t *const c = LIST_GET(&r->chunks, r->current);
+      if (r->token < LIST_SIZE(&c->tokens)) {
+        return LIST_AT(&c->tokens, r->token);
+      }
+      if (r->current + 1 < LIST_SIZE(&r->chunks)) {
+        ++r->current;
+        r->token = 0;
+        continue;
+      }
+    }
+    if (r->next >= r->size) {
+      return &end;
+    }
+    tokenize(r);
+  }
+}
+
+static void advance(ingest_t *r) {
+  assert(r->current < LIST_SIZE(&r->chunks));
+  ++r->token;
+}
+
+/// the contents of the string of the current token
+static const string_t *text_of(ingest_t *r, const char **text) {
+  chunk_t *const c = LIST_GET(&r->chunks, r->current);
+  const token_t *const t = LIST_AT(&c->tokens, r->token);
+  assert(t->kind == TOK_ATOM);
+  const string_t *const str = LIST_AT(&c->strings, t->value);
+  *text = agxbstart(&c->text) + str->offset;
+  return str;
+}
+
+/// intern the string of the current token in the graph and move past it
+///
+/// @return The string, or NULL if it is concatenated with the next one
+static char *atom(ingest_t *r) {
+  chunk_t *const c = LIST_GET(&r->chunks, r->current);
+  const token_t *const t = LIST_AT(&c->tokens, r->token);
+  assert(t->kind == TOK_ATOM);
+  if (c->interned == NULL) {
+    c->interned = gv_calloc(LIST_SIZE(&c->strings), sizeof(char *));
+  }
+  char *s = c->interned[t->value];
+  if (s == NULL) {
+    const char *text;
+    const bool html = text_of(r, &text)->html;
+    s = html ? agstrdup_html(r->g, text) : agstrdup(r->g, text);
+    c->interned[t->value] = s;
+  }
+  advance(r);
+  return peek(r)->kind == '+' ? NULL : s;
+}
+
+/// release the chunks before the current one
+static void release(ingest_t *r) {
+  for (; r->current > 0; --r->current) {
+    chunk_free(LIST_POP_FRONT(&r->chunks), r->g);
+  }
+}
+
+/// declare the attributes of the statement, as bindattrs in grammar.y
+static void bind(ingest_t *r, int kind) {
+  for (size_t i = 0; i < LIST_SIZE(&r->attrs); ++i) {
+    attr_t *const a = LIST_AT(&r->attrs, i);
+    if (kind == AGEDGE && streq(a->name, Key)) {
+      continue;
+    }
+    a->sym = agattr_text(r->g, kind, a->name, NULL);
+    if (a->sym == NULL) {
+      a->sym = agattr_text(r->g, kind, a->name, "");
+    }
+  }
+}
+
+/// set the attributes of the statement on an object, as applyattrs does
+static void apply(ingest_t *r, void *obj) {
+  for (size_t i = 0; i < LIST_SIZE(&r->attrs); ++i) {
+    const attr_t *const a = LIST_AT(&r->attrs, i);
+    if (a->sym == NULL) {
+      continue;
+    }
+    if (aghtmlstr(a->value)) {
+      agxset_html(obj, a->sym, a->value);
+    } else {
+      agxset(obj, a->sym, a->value);
+    }
+  }
+}
+
+/// set defaults, as attrstmt does for the root graph
+static void attrstmt(ingest_t *r, int kind) {
+  bind(r, kind);
+  for (size_t i = 0; i < LIST_SIZE(&r->attrs); ++i) {
+    const attr_t *const a = LIST_AT(&r->attrs, i);
+    if (a->sym == NULL) {
+      continue;
+    }
+    Agsym_t *sym = a->sym;
+    if (!sym->fixed) {
+      sym = aghtmlstr(a->value)
+                ? agattr_html(r->g, kind, a->sym->name, a->value)
+                : agattr_text(r->g, kind, a->sym->name, a->value);
+    }
+    sym->print = true;
+  }
+}
+
+/// read the bracketed lists of attribute settings that follow
+static bool attrlist(ingest_t *r) {
+  while (peek(r)->kind == '[') {
+    advance(r);
+    for (;;) {
+      const int kind = peek(r)->kind;
+      if (kind == ']') {
+        advance(r);
+        break;
+      }
+      if (kind != TOK_ATOM) {
+        return false;
+      }
+      attr_t a = {.name = atom(r)};
+      if (a.name == NULL || peek(r)->kind != '=') {
+        return false;
+      }
+      advance(r);
+      if (peek(r)->kind != TOK_ATOM || (a.value = atom(r)) == NULL) {
+        return false;
+      }
+      LIST_APPEND(&r->attrs, a);
+      if (peek(r)->kind == ';' || peek(r)->kind == ',') {
+        advance(r);
+      }
+    }
+  }
+  return true;
+}
+
+/// create the node named by the current token, as appendnode does
+static bool node(ingest_t *r) {
+  if (peek(r)->kind != TOK_ATOM) {
+    return false;
+  }
+  char *const name = atom(r);
+  if (name == NULL || peek(r)->kind == ':') {
+    return false;
+  }
+  LIST_APPEND(&r->nodes, agnode(r->g, name, 1));
+  return true;
+}
+
+/// replay a node or edge statement
+static bool compound(ingest_t *r) {
+  const int edgeop = r->directed ? TOK_DIRECTED_OP : TOK_UNDIRECTED_OP;
+  LIST_APPEND(&r->groups, 0);
+  if (!node(r)) {
+    return false;
+  }
+  for (;;) {
+    const int kind = peek(r)->kind;
+    if (kind == ',') {
+      advance(r);
+    } else if (kind == edgeop) {
+      advance(r);
+      LIST_APPEND(&r->groups, LIST_SIZE(&r->nodes));
+    } else {
+      break;
+    }
+    if (!node(r)) {
+      return false;
+    }
+  }
+  if (!attrlist(r)) {
+    return false;
+  }
+
+  if (LIST_SIZE(&r->groups) == 1) {
+    // endnode
+    bind(r, AGNODE);
+    for (size_t i = 0; i < LIST_SIZE(&r->nodes); ++i) {
+      apply(r, LIST_GET(&r->nodes, i));
+    }
+    return true;
+  }
+
+  // endedge
+  bind(r, AGEDGE);
+  char *key = NULL;
+  for (size_t i = 0; i < LIST_SIZE(&r->attrs); ++i) {
+    const attr_t *const a = LIST_AT(&r->attrs, i);
+    if (a->sym == NULL && streq(a->name, Key)) {
+      key = a->value;
+    }
+  }
+  LIST_APPEND(&r->groups, LIST_SIZE(&r->nodes));
+  for (size_t i = 0; i + 2 < LIST_SIZE(&r->groups); ++i) {
+    const size_t tails = LIST_GET(&r->groups, i);
+    const size_t heads = LIST_GET(&r->groups, i + 1);
+    const size_t heads_end = LIST_GET(&r->groups, i + 2);
+    for (size_t t = tails; t < heads; ++t) {
+      for (size_t h = heads; h < heads_end; ++h) {
+        Agedge_t *const e = agedge(r->g, LIST_GET(&r->nodes, t),
+                                   LIST_GET(&r->nodes, h), key, 1);
+        if (e != NULL) { // can fail if graph is strict and t==h
+          apply(r, e);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/// replay a statement
+static bool statement(ingest_t *r) {
+  LIST_CLEAR(&r->nodes);
+  LIST_CLEAR(&r->groups);
+  LIST_CLEAR(&r->attrs);
+
+  switch (peek(r)->kind) {
+  case TOK_GRAPH:
+  case TOK_NODE:
+  case TOK_EDGE: {
+    const int kind = peek(r)->kind == TOK_GRAPH  ? AGRAPH
+                     : peek(r)->kind == TOK_NODE ? AGNODE
+                                                 : AGEDGE;
+    advance(r);
+    // the serial parser warns about attribute macros, `node x = [...]`
+    if (peek(r)->kind != '[' || !attrlist(r)) {
+      return false;
+    }
+    attrstmt(r, kind);
+    break;
+  }
+  case TOK_ATOM: {
+    // look past the name for the `=` of a graph attribute setting
+    const size_t current = r->current;
+    const size_t token = r->token;
+    char *const name = atom(r);
+    if (name == NULL) {
+      return false;
+    }
+    if (peek(r)->kind == '=') {
+      advance(r);
+      attr_t a = {.name = name};
+      if (peek(r)->kind != TOK_ATOM || (a.value = atom(r)) == NULL) {
+        return false;
+      }
+      LIST_APPEND(&r->attrs, a);
+      attrstmt(r, AGRAPH);
+    } else {
+      r->current = current;
+      r->token = token;
+      if (!compound(r)) {
+        return false;
+      }
+    }
+    break;
+  }
+  default:
+    return false;
+  }
+
+  if (peek(r)->kind == ';') {
+    advance(r);
+  }
+  return true;
+}
+
+/// replay a graph
+///
+/// @param [out] used Number of bytes of input consumed
+/// @return Whether the graph was read, or the serial parser has to read it
+static bool replay(ingest_t *r, Agdisc_t *disc, unsigned flags, size_t *used) {
+  bool strict = false;
+  if (peek(r)->kind == TOK_STRICT) {
+    strict = true;
+    advance(r);
+  }
+  const int type = peek(r)->kind;
+  if (type != TOK_GRAPH && type != TOK_DIGRAPH) {
+    return false;
+  }
+  r->directed = type == TOK_DIGRAPH;
+  advance(r);
+
+  // the name is interned before there is a graph, as startgraph expects
+  char *name = NULL;
+  bool html = false;
+  if (peek(r)->kind == TOK_ATOM) {
+    const char *text;
+    html = text_of(r, &text)->html;
+    name = html ? agstrdup_html(NULL, text) : agstrdup(NULL, text);
+    advance(r);
+  }
+  if (peek(r)->kind != '{') {
+    agstrfree(NULL, name, html);
+    return false;
+  }
+  advance(r);
+
+  const Agdesc_t req = {
+      .directed = r->directed, .strict = strict, .maingraph = true};
+  r->g = agopen_flags(name, req, disc, flags);
+  agstrfree(NULL, name, html);
+  if (r->g == NULL) {
+    return false;
+  }
+
+  for (;;) {
+    const token_t *const t = peek(r);
+    if (t->kind == '}') {
+      *used = t->value;
+      advance(r);
+      break;
+    }
+    if (!statement(r)) {
+      return false;
+    }
+    release(r);
+  }
+
+  aginternalmapclearlocalnames(r->g);
+  return true;
+}
+
+Agraph_t *agreadparallelbuf(const char *filename, const char *data,
+                            size_t size, size_t *used, Agdisc_t *disc,
+                            unsigned flags) {
+  assert(data != NULL);
+  assert(used != NULL);
+
+  ingest_t r = {.data = data, .size = size, .batch = FIRST_BATCH};
+  const bool ok = replay(&r, disc != NULL ? disc : &AgDefaultDisc, flags, used);
+
+  // a graph left to the serial parser has its strings freed with it
+  Agraph_t *const g = r.g;
+  if (!ok && g != NULL) {
+    r.g = NULL;
+    agclose(g);
+  }
+  while (!LIST_IS_EMPTY(&r.chunks)) {
+    chunk_free(LIST_POP_FRONT(&r.chunks), r.g);
+  }
+  LIST_FREE(&r.chunks);
+  LIST_FREE(&r.nodes);
+  LIST_FREE(&r.groups);
+  LIST_FREE(&r.attrs);
+  gv_pool_free(r.pool);
+
+  if (!ok) {
+    return agconcatbuf(NULL, filename, data, size, used, disc, flags);
+  }
+  return g;
+}
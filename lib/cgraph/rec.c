@@ -19,7 +19,6 @@
 #include	<stdbool.h>
 #include	<stdlib.h>
 #include	<util/streq.h>
-#include	<util/alloc.h>
 #include	<util/unreachable.h>
 
 /*
@@ -58,8 +57,8 @@ Agrec_t *aggetrec(void *obj, const char *name, int mtf)
     if (hdr->tag.mtflock) {
 	if (mtf && hdr->data != d)
 	    agerrorf("move to front lock inconsistency");
-    } else if (d != first || mtf != 0) {
-	set_data(hdr, d, mtf != 0);	/* Always optimize */
+    } else if (mtf != 0 || (d != first && !agraphof(obj)->clos->frozen)) {
+	set_data(hdr, d, mtf != 0);	/* optimize unless others may be reading */
     }
     return d;
 }
@@ -98,7 +97,7 @@ void *agbindrec(void *arg_obj, const char *recname, unsigned int recsize,
     g = agraphof(obj);
     Agrec_t *rec = aggetrec(obj, recname, 0);
     if (rec == NULL && recsize > 0) {
-	rec = gv_calloc(recsize, sizeof(char));
+	rec = agalloc(g, recsize);
 	rec->name = agstrdup(g, recname);
 	objputrec(obj, rec);
     }
@@ -158,7 +157,7 @@ int agdelrec(void *arg_obj, const char *name)
 	UNREACHABLE();
     }
     agstrfree(g, rec->name, false);
-    free(rec);
+    agfree(g, rec, 0);
 
     return SUCCESS;
 }
@@ -236,7 +235,7 @@ void agrecclose(Agobj_t * obj)
 	do {
 	    nrec = rec->next;
 	    agstrfree(g, rec->name, false);
-	    free(rec);
+	    agfree(g, rec, 0);
 	    rec = nrec;
 	} while (rec != obj->data);
     }
@@ -17,21 +17,48 @@
 
 #include <assert.h>
 #include <cgraph/cghdr.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <util/alloc.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include <util/unreachable.h>
 
 /*
  * reference counted strings.
  */
 
+/// what is known about the content of a reference-counted string
+///
+/// These are bits of `refstr_t.known`. A string may be read from several
+/// threads at once, for example while its graph is frozen for concurrent
+/// rendering. So each fact is published by setting its bits atomically, and a
+/// cached number is written only by the thread that claimed its slot, before
+/// marking it done.
+enum {
+  DOUBLE_CLAIMED = 1 << 0, ///< a thread is parsing with `strtod`
+  DOUBLE_DONE = 1 << 1,    ///< `strtod` has been tried
+  DOUBLE_OK = 1 << 2,      ///< `strtod` succeeded, result in `d`
+  LONG_CLAIMED = 1 << 3,   ///< a thread is parsing with `strtol`
+  LONG_DONE = 1 << 4,      ///< `strtol` has been tried
+  LONG_OK = 1 << 5,        ///< `strtol` succeeded, result in `l`
+  CANON_PLAIN = 1 << 6,    ///< the string is written as is, without quotes
+  CANON_QUOTED = 1 << 7,   ///< the string needs quoting or escaping
+};
+
 typedef struct {
     uint64_t refcnt: sizeof(uint64_t) * 8 - 1;
     uint64_t is_html: 1;
+    atomic_uint known; ///< a bit mask of the flags above
+    /// Results of numeric parses of `s`. Strings are immutable and interned,
+    /// so these never need invalidating.
+    double d;
+    long l;
     char s[];
 } refstr_t;
 
@@ -61,6 +88,33 @@ typedef struct {
 
 static strdict_t *Refdict_default;
 
+#ifdef HAVE_PTHREAD
+/// serializes use of `Refdict_default`, which all threads share
+static pthread_mutex_t Refdict_default_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/// take the lock guarding the dictionary of `g`, if it needs one
+static void refdict_lock(const Agraph_t *g) {
+#ifdef HAVE_PTHREAD
+  if (g == NULL) {
+    pthread_mutex_lock(&Refdict_default_lock);
+  }
+#else
+  (void)g;
+#endif
+}
+
+/// release the lock taken by `refdict_lock`
+static void refdict_unlock(const Agraph_t *g) {
+#ifdef HAVE_PTHREAD
+  if (g == NULL) {
+    pthread_mutex_unlock(&Refdict_default_lock);
+  }
+#else
+  (void)g;
+#endif
+}
+
 /// derive a hash value from the given data
 ///
 /// @param key Start of data to read
@@ -325,7 +379,9 @@ static strdict_t **refdict(Agraph_t *g) {
 
 int agstrclose(Agraph_t * g)
 {
+    refdict_lock(g);
     strdict_free(refdict(g));
+    refdict_unlock(g);
     return 0;
 }
 
@@ -339,27 +395,35 @@ static char *refstrbind(strdict_t *strdict, const char *s, bool is_html) {
 }
 
 char *agstrbind(Agraph_t *g, const char *s) {
+  refdict_lock(g);
+  strdict_t *const strdict = *refdict(g);
 
   // did this string originate from `agstrdup_html(g, …)`?
+  bool is_html = false;
   if (s != NULL) {
-    strdict_t *const strdict = *refdict(g);
     refstr_t *const ref = strdict_find(strdict, s, true);
-    if (ref != NULL && ref->s == s) {
-      // create this copy as HTML-like
-      return agstrbind_html(g, s);
-    }
+    // if so, create this copy as HTML-like
+    is_html = ref != NULL && ref->s == s;
   }
 
-  return agstrbind_text(g, s);
+  char *const bound = refstrbind(strdict, s, is_html);
+  refdict_unlock(g);
+  return bound;
 }
 
 char *agstrbind_html(Agraph_t *g, const char *s) {
-  return refstrbind(*refdict(g), s, true);
+  refdict_lock(g);
+  char *const bound = refstrbind(*refdict(g), s, true);
+  refdict_unlock(g);
+  return bound;
 }
 
 char *agstrbind_text(Agraph_t * g, const char *s)
 {
-    return refstrbind(*refdict(g), s, false);
+    refdict_lock(g);
+    char *const bound = refstrbind(*refdict(g), s, false);
+    refdict_unlock(g);
+    return bound;
 }
 
 static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
@@ -384,6 +448,7 @@ static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
 	}
 	r->refcnt = 1;
 	r->is_html = is_html;
+	atomic_init(&r->known, 0);
 	memcpy(r->s, s, s_size);
 	strdict_add(strdict, r);
     }
@@ -391,27 +456,34 @@ static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
 }
 
 char *agstrdup_text(Agraph_t *g, const char *s) {
-  return agstrdup_internal(g, s, false);
+  refdict_lock(g);
+  char *const copy = agstrdup_internal(g, s, false);
+  refdict_unlock(g);
+  return copy;
 }
 
 char *agstrdup_html(Agraph_t *g, const char *s) {
-  return agstrdup_internal(g, s, true);
+  refdict_lock(g);
+  char *const copy = agstrdup_internal(g, s, true);
+  refdict_unlock(g);
+  return copy;
 }
 
 char *agstrdup(Agraph_t *g, const char *s) {
+  refdict_lock(g);
 
-  // did this string originate from `agstrdup_html(g, …)`?
+  // did this string originate from `agstrdup_html(g, …)`? If so, create this
+  // copy as HTML-like, otherwise as regular text.
+  bool is_html = false;
   if (s != NULL) {
     strdict_t *const strdict = *refdict(g);
     refstr_t *const ref = strdict_find(strdict, s, true);
-    if (ref != NULL && ref->s == s) {
-      // create this copy as HTML-like
-      return agstrdup_html(g, s);
-    }
+    is_html = ref != NULL && ref->s == s;
   }
 
-  // otherwise, create the copy as regular text
-  return agstrdup_text(g, s);
+  char *const copy = agstrdup_internal(g, s, is_html);
+  refdict_unlock(g);
+  return copy;
 }
 
 int agstrfree(Agraph_t *g, const char *s, bool is_html) {
@@ -420,6 +492,7 @@ int agstrfree(Agraph_t *g, const char *s, bool is_html) {
     if (s == NULL)
 	 return FAILURE;
 
+    refdict_lock(g);
     strdict_t *strdict = *refdict(g);
     r = strdict_find(strdict, s, is_html);
     if (r && r->s == s) {
@@ -428,6 +501,7 @@ int agstrfree(Agraph_t *g, const char *s, bool is_html) {
 	    strdict_remove(strdict, r);
 	}
     }
+    refdict_unlock(g);
     if (r == NULL)
 	return FAILURE;
     return SUCCESS;
@@ -447,6 +521,95 @@ int aghtmlstr(const char *s)
     return key->is_html != 0;
 }
 
+/// recover the reference-counted string containing the given content
+static refstr_t *refstrof(const char *s) {
+  return (refstr_t *)(s - offsetof(refstr_t, s));
+}
+
+bool agstrtod(const char *s, double *value) {
+  assert(s != NULL);
+  assert(value != NULL);
+
+  refstr_t *const r = refstrof(s);
+  const unsigned known = atomic_load_explicit(&r->known, memory_order_acquire);
+  if (known & DOUBLE_DONE) {
+    if (!(known & DOUBLE_OK)) {
+      return false;
+    }
+    *value = r->d;
+    return true;
+  }
+
+  char *end;
+  const double d = strtod(s, &end);
+  const bool ok = end != s;
+  if (!(atomic_fetch_or_explicit(&r->known, DOUBLE_CLAIMED,
+                                 memory_order_relaxed) & DOUBLE_CLAIMED)) {
+    r->d = d;
+    atomic_fetch_or_explicit(&r->known, DOUBLE_DONE | (ok ? DOUBLE_OK : 0),
+                             memory_order_release);
+  }
+
+  if (!ok) {
+    return false;
+  }
+  *value = d;
+  return true;
+}
+
+bool agstrtol(const char *s, long *value) {
+  assert(s != NULL);
+  assert(value != NULL);
+
+  refstr_t *const r = refstrof(s);
+  const unsigned known = atomic_load_explicit(&r->known, memory_order_acquire);
+  if (known & LONG_DONE) {
+    if (!(known & LONG_OK)) {
+      return false;
+    }
+    *value = r->l;
+    return true;
+  }
+
+  char *end;
+  const long l = strtol(s, &end, 10);
+  const bool ok = end != s;
+  if (!(atomic_fetch_or_explicit(&r->known, LONG_CLAIMED,
+                                 memory_order_relaxed) & LONG_CLAIMED)) {
+    r->l = l;
+    atomic_fetch_or_explicit(&r->known, LONG_DONE | (ok ? LONG_OK : 0),
+                             memory_order_release);
+  }
+
+  if (!ok) {
+    return false;
+  }
+  *value = l;
+  return true;
+}
+
+strcanon_t agstrcanonstate(const char *s) {
+  assert(s != NULL);
+  const unsigned known =
+      atomic_load_explicit(&refstrof(s)->known, memory_order_relaxed);
+  if (known & CANON_QUOTED) {
+    return STRCANON_QUOTED;
+  }
+  if (known & CANON_PLAIN) {
+    return STRCANON_PLAIN;
+  }
+  return STRCANON_UNKNOWN;
+}
+
+void agsetstrcanonstate(const char *s, strcanon_t state) {
+  assert(s != NULL);
+  assert(state != STRCANON_UNKNOWN);
+  atomic_fetch_or_explicit(&refstrof(s)->known,
+                           state == STRCANON_QUOTED ? CANON_QUOTED
+                                                    : CANON_PLAIN,
+                           memory_order_relaxed);
+}
+
 #ifdef DEBUG
 static int refstrprint(const refstr_t *r) {
     fprintf(stderr, "%s\n", r->s);
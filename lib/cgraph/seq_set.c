@@ -0,0 +1,213 @@
+/// @file
+/// @brief implementation of @ref seq_set_t
+
+#include "config.h"
+
+#include <assert.h>
+#include <cgraph/seq_set.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+
+enum { WORD_BITS = 64, BLOCK_WORDS = 4, BLOCK_BITS = BLOCK_WORDS * WORD_BITS };
+
+/// a run of `BLOCK_BITS` consecutive sequence numbers
+typedef struct {
+  uint64_t index;              ///< first sequence number held, / `BLOCK_BITS`
+  uint64_t words[BLOCK_WORDS]; ///< one bit per sequence number
+} block_t;
+
+struct graphviz_seq_set {
+  block_t *blocks;    ///< blocks with at least one member, by ascending index
+  size_t n_blocks;    ///< number of used entries in `blocks`
+  size_t capacity;    ///< number of allocated entries in `blocks`
+  size_t size;        ///< number of members
+};
+
+seq_set_t *seq_set_new(void) { return gv_alloc(sizeof(seq_set_t)); }
+
+/// find the position of the first block with an index not less than `index`
+static size_t lower_bound(const seq_set_t *self, uint64_t index) {
+  // members are mostly added in ascending order, so try the end first
+  if (self->n_blocks == 0 || self->blocks[self->n_blocks - 1].index < index) {
+    return self->n_blocks;
+  }
+  size_t lo = 0;
+  size_t hi = self->n_blocks;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (self->blocks[mid].index < index) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/// find the block holding a sequence number, if there is one
+static block_t *find(const seq_set_t *self, uint64_t seq) {
+  const uint64_t index = seq / BLOCK_BITS;
+  const size_t pos = lower_bound(self, index);
+  if (pos == self->n_blocks || self->blocks[pos].index != index) {
+    return NULL;
+  }
+  return &self->blocks[pos];
+}
+
+bool seq_set_add(seq_set_t *self, uint64_t seq) {
+  assert(self != NULL);
+
+  const uint64_t index = seq / BLOCK_BITS;
+  const size_t pos = lower_bound(self, index);
+  if (pos == self->n_blocks || self->blocks[pos].index != index) {
+    if (self->n_blocks == self->capacity) {
+      const size_t c = self->capacity == 0 ? 1 : 2 * self->capacity;
+      self->blocks =
+          gv_recalloc(self->blocks, self->capacity, c, sizeof(block_t));
+      self->capacity = c;
+    }
+    memmove(&self->blocks[pos + 1], &self->blocks[pos],
+            (self->n_blocks - pos) * sizeof(block_t));
+    self->blocks[pos] = (block_t){.index = index};
+    ++self->n_blocks;
+  }
+
+  uint64_t *const word = &self->blocks[pos].words[seq % BLOCK_BITS / WORD_BITS];
+  const uint64_t bit = UINT64_C(1) << (seq % WORD_BITS);
+  if (*word & bit) {
+    return false;
+  }
+  *word |= bit;
+  ++self->size;
+  return true;
+}
+
+bool seq_set_remove(seq_set_t *self, uint64_t seq) {
+  assert(self != NULL);
+
+  block_t *const block = find(self, seq);
+  if (block == NULL) {
+    return false;
+  }
+  uint64_t *const word = &block->words[seq % BLOCK_BITS / WORD_BITS];
+  const uint64_t bit = UINT64_C(1) << (seq % WORD_BITS);
+  if (!(*word & bit)) {
+    return false;
+  }
+  *word &= ~bit;
+  assert(self->size > 0);
+  --self->size;
+
+  // drop the block if this was its last member
+  for (size_t i = 0; i < BLOCK_WORDS; ++i) {
+    if (block->words[i] != 0) {
+      return true;
+    }
+  }
+  const size_t pos = (size_t)(block - self->blocks);
+  memmove(&self->blocks[pos], &self->blocks[pos + 1],
+          (self->n_blocks - pos - 1) * sizeof(block_t));
+  --self->n_blocks;
+  return true;
+}
+
+bool seq_set_contains(const seq_set_t *self, uint64_t seq) {
+  assert(self != NULL);
+
+  const block_t *const block = find(self, seq);
+  if (block == NULL) {
+    return false;
+  }
+  return (block->words[seq % BLOCK_BITS / WORD_BITS] >> (seq % WORD_BITS)) & 1;
+}
+
+/// find the lowest member of a block at or after the given bit
+static uint64_t block_next(const block_t *block, size_t from) {
+  for (size_t i = from / WORD_BITS; i < BLOCK_WORDS; ++i) {
+    uint64_t word = block->words[i];
+    size_t bit = 0;
+    if (i == from / WORD_BITS) {
+      bit = from % WORD_BITS;
+      word >>= bit;
+    }
+    for (; word != 0; word >>= 1, ++bit) {
+      if (word & 1) {
+        return block->index * BLOCK_BITS + i * WORD_BITS + bit;
+      }
+    }
+  }
+  return SEQ_SET_NONE;
+}
+
+/// find the highest member of a block at or before the given bit
+static uint64_t block_prev(const block_t *block, size_t from) {
+  for (size_t i = from / WORD_BITS + 1; i-- > 0;) {
+    uint64_t word = block->words[i];
+    size_t bit = WORD_BITS - 1;
+    if (i == from / WORD_BITS) {
+      bit = from % WORD_BITS;
+      word <<= WORD_BITS - 1 - bit;
+    }
+    for (; word != 0; word <<= 1, --bit) {
+      if (word >> (WORD_BITS - 1)) {
+        return block->index * BLOCK_BITS + i * WORD_BITS + bit;
+      }
+    }
+  }
+  return SEQ_SET_NONE;
+}
+
+uint64_t seq_set_next(const seq_set_t *self, uint64_t seq) {
+  assert(self != NULL);
+
+  const uint64_t index = seq / BLOCK_BITS;
+  size_t pos = lower_bound(self, index);
+  if (pos < self->n_blocks && self->blocks[pos].index == index) {
+    const uint64_t found = block_next(&self->blocks[pos], seq % BLOCK_BITS);
+    if (found != SEQ_SET_NONE) {
+      return found;
+    }
+    ++pos;
+  }
+  // every stored block has a member
+  if (pos < self->n_blocks) {
+    return block_next(&self->blocks[pos], 0);
+  }
+  return SEQ_SET_NONE;
+}
+
+uint64_t seq_set_prev(const seq_set_t *self, uint64_t seq) {
+  assert(self != NULL);
+
+  const uint64_t index = seq / BLOCK_BITS;
+  const size_t pos = lower_bound(self, index);
+  if (pos < self->n_blocks && self->blocks[pos].index == index) {
+    const uint64_t found = block_prev(&self->blocks[pos], seq % BLOCK_BITS);
+    if (found != SEQ_SET_NONE) {
+      return found;
+    }
+  }
+  // every stored block has a member
+  if (pos > 0) {
+    return block_prev(&self->blocks[pos - 1], BLOCK_BITS - 1);
+  }
+  return SEQ_SET_NONE;
+}
+
+size_t seq_set_size(const seq_set_t *self) {
+  assert(self != NULL);
+  return self->size;
+}
+
+void seq_set_free(seq_set_t **self) {
+  assert(self != NULL);
+  if (*self != NULL) {
+    free((*self)->blocks);
+  }
+  free(*self);
+  *self = NULL;
+}
@@ -0,0 +1,76 @@
+/// @file
+/// @brief ordered set of object sequence numbers, stored as a sparse bitmap
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// an ordered set of sequence numbers
+///
+/// Members are stored as bits in small fixed size blocks, and only blocks that
+/// hold at least one member are allocated. Sequence numbers in a subgraph tend
+/// to come in runs, so this is compact while still answering membership and
+/// successor queries in time logarithmic in the number of blocks.
+typedef struct graphviz_seq_set seq_set_t;
+
+/// result of @ref seq_set_next and @ref seq_set_prev when there is no member
+#define SEQ_SET_NONE UINT64_MAX
+
+/// construct a new set
+///
+/// Calls `exit` on failure (out-of-memory).
+///
+/// @return A constructed set
+seq_set_t *seq_set_new(void);
+
+/// add a sequence number to the set
+///
+/// On allocation failure, `exit` is called.
+///
+/// @param self Set to add to
+/// @param seq Sequence number to add
+/// @return True if `seq` was not already in the set
+bool seq_set_add(seq_set_t *self, uint64_t seq);
+
+/// remove a sequence number from the set
+///
+/// @param self Set to remove from
+/// @param seq Sequence number to remove
+/// @return True if `seq` was in the set
+bool seq_set_remove(seq_set_t *self, uint64_t seq);
+
+/// is this sequence number in the set?
+///
+/// @param self Set to query
+/// @param seq Sequence number to look for
+/// @return True if `seq` is in the set
+bool seq_set_contains(const seq_set_t *self, uint64_t seq);
+
+/// find the smallest member not less than a given sequence number
+///
+/// @param self Set to query
+/// @param seq Sequence number to start from
+/// @return The found member or @ref SEQ_SET_NONE
+uint64_t seq_set_next(const seq_set_t *self, uint64_t seq);
+
+/// find the largest member not greater than a given sequence number
+///
+/// @param self Set to query
+/// @param seq Sequence number to start from
+/// @return The found member or @ref SEQ_SET_NONE
+uint64_t seq_set_prev(const seq_set_t *self, uint64_t seq);
+
+/// get the number of members of a set
+///
+/// @param self Set to query
+/// @return Number of sequence numbers in the set
+size_t seq_set_size(const seq_set_t *self);
+
+/// destruct a set
+///
+/// `*self` is `NULL` on return.
+///
+/// @param self Set to destroy
+void seq_set_free(seq_set_t **self);
@@ -18,7 +18,7 @@
 #include <cgraph/cghdr.h>
 #include <stdlib.h>
 
-static Agraph_t *Ag_dictop_G;
+static _Thread_local Agraph_t *Ag_dictop_G;
 
 Dict_t *agdtopen(Dtdisc_t *disc, Dtmethod_t *method) {
     return dtopen(disc, method);
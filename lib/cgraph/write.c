@@ -23,6 +23,7 @@
 #include <stdbool.h>
 #include <stdio.h>		/* need sprintf() */
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include <cgraph/agstrcanon.h>
 #include <cgraph/cghdr.h>
@@ -33,18 +34,48 @@
 #define EMPTY(s)		(((s) == 0) || (s)[0] == '\0')
 #define CHKRV(v)     {if ((v) == EOF) return EOF;}
 
-typedef void iochan_t;
+/// bytes of output gathered before they are passed to the I/O discipline
+enum { WRITE_BUFFER_SIZE = 64 * 1024 };
 
-static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
+/// output channel of @ref agwrite
+///
+/// Output is gathered here and handed to the discipline's `putstr` in large
+/// pieces, rather than one token at a time.
+typedef struct {
+    void *chan;		///< channel given to @ref agwrite
+    size_t len;		///< bytes pending in `buf`
+    char *scratch;	///< space for canonicalizing strings
+    size_t scratch_size;	///< bytes allocated in `scratch`
+    char buf[WRITE_BUFFER_SIZE + 1];	///< pending output, and room for a NUL
+} iochan_t;
+
+/// pass any pending output on to the I/O discipline
+static int ioflush(Agraph_t *g, iochan_t *ofile)
 {
-    return AGDISC(g, io)->putstr(ofile, str);
+    if (ofile->len == 0)
+	return 0;
+    ofile->buf[ofile->len] = '\0';
+    ofile->len = 0;
+    return AGDISC(g, io)->putstr(ofile->chan, ofile->buf);
+}
 
+static int ioput(Agraph_t * g, iochan_t * ofile, const char *str)
+{
+    const size_t len = strlen(str);
+    if (len > WRITE_BUFFER_SIZE - ofile->len) {
+	CHKRV(ioflush(g, ofile));
+	if (len > WRITE_BUFFER_SIZE)
+	    return AGDISC(g, io)->putstr(ofile->chan, str);
+    }
+    memcpy(ofile->buf + ofile->len, str, len);
+    ofile->len += len;
+    return 0;
 }
 
 #define MAX_OUTPUTLINE		128
 #define MIN_OUTPUTLINE		 60
-static int Max_outputline = MAX_OUTPUTLINE;
-static Agsym_t *Tailport, *Headport;
+static _Thread_local int Max_outputline = MAX_OUTPUTLINE;
+static _Thread_local Agsym_t *Tailport, *Headport;
 
 typedef struct {
 	uint64_t *preorder_number;	// of a graph or subgraph
@@ -224,38 +255,86 @@ char *agstrcanon(char *arg, char *buf)
 	return _agstrcanon(arg, buf);
 }
 
-static int _write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool chk) {
-
-    // maximum bytes required for canonicalized string
+/// get space to stage the canonicalized form of a string
+///
+/// @return Space for at least `agstrcanon_bytes(str)` bytes, or NULL on failure
+static char *scratch_for(iochan_t *ofile, const char *str) {
     const size_t required = agstrcanon_bytes(str);
+    if (required > ofile->scratch_size) {
+	char *const scratch = realloc(ofile->scratch, required);
+	if (scratch == NULL) {
+	    return NULL;
+	}
+	ofile->scratch = scratch;
+	ofile->scratch_size = required;
+    }
+    return ofile->scratch;
+}
+
+static int _write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool chk) {
 
-    // allocate space to stage the canonicalized string
-    char *const scratch = malloc(required);
+    char *const scratch = scratch_for(ofile, str);
     if (scratch == NULL) {
 	return EOF;
     }
 
     char *const canonicalized =
       chk ? agstrcanon(str, scratch) : _agstrcanon(str, scratch);
-    const int rc = ioput(g, ofile, canonicalized);
-    free(scratch);
-    return rc;
+    return ioput(g, ofile, canonicalized);
+}
+
+/// write a string from @ref agstrdup
+///
+/// Whether a string needs quoting is remembered in the string itself, so
+/// strings written repeatedly, like attribute names and values, are scanned
+/// only once.
+static int write_refstr(Agraph_t *g, iochan_t *ofile, char *str) {
+    if (aghtmlstr(str)) {
+	CHKRV(ioput(g, ofile, "<"));
+	CHKRV(ioput(g, ofile, str));
+	return ioput(g, ofile, ">");
+    }
+
+    switch (agstrcanonstate(str)) {
+    case STRCANON_PLAIN:
+	return ioput(g, ofile, str);
+    case STRCANON_QUOTED:
+	return _write_canonstr(g, ofile, str, false);
+    default:
+	break;
+    }
+
+    // Longer strings may be split differently depending on the line length,
+    // so the decision is only remembered for strings that are never split.
+    if (strlen(str) >= MIN_OUTPUTLINE)
+	return _write_canonstr(g, ofile, str, false);
+
+    char *const scratch = scratch_for(ofile, str);
+    if (scratch == NULL) {
+	return EOF;
+    }
+    char *const canonicalized = _agstrcanon(str, scratch);
+    agsetstrcanonstate(str, canonicalized == str ? STRCANON_PLAIN
+                                                 : STRCANON_QUOTED);
+    return ioput(g, ofile, canonicalized);
 }
 
 /// @param known Is `str` already known to be a reference-counted string?
 static int write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool known) {
     char *s;
 
+    if (known) {
+	return write_refstr(g, ofile, str);
+    }
+
     /* str may not have been allocated by agstrdup, so we first need to turn it
      * into a valid refstr
      */
-    s = known ? str : agstrdup(g, str);
+    s = agstrdup(g, str);
 
-    int r = _write_canonstr(g, ofile, s, true);
+    int r = write_refstr(g, ofile, s);
 
-    if (!known) {
-	agstrfree(g, s, false);
-    }
+    agstrfree(g, s, false);
     return r;
 }
 
@@ -424,7 +503,7 @@ static bool not_default_attrs(Agraph_t * g, Agnode_t * n)
     (void)g;
     if ((data = agattrrec(n))) {
 	for (sym = dtfirst(data->dict); sym; sym = dtnext(data->dict, sym)) {
-	    if (data->str[sym->id] != sym->defval)
+	    if (agxget(n, sym) != sym->defval)
 		return true;
 	}
     }
@@ -447,19 +526,40 @@ static int write_subgs(Agraph_t *g, iochan_t *ofile, write_info_t *wr_info) {
     return 0;
 }
 
+/// get the name of an object, as @ref agnameof does
+///
+/// @param known [out] Whether the name is known to be a reference-counted
+///   string
+/// @return The object's name
+static char *nameof(void *obj, bool *known) {
+  assert(known != NULL);
+
+  // handle the common case inline for performance
+  const Agraph_t *const g = agraphof(obj);
+  if (AGDISC(g, id) == &AgIdDisc && AGID(obj) % 2 == 0) {
+    // replicate `idprint`, whose names come from `agstrdup`
+    *known = true;
+    return (char *)(uintptr_t)AGID(obj);
+  }
+
+  *known = false;
+  return agnameof(obj);
+}
+
 static int write_edge_name(Agedge_t *e, iochan_t *ofile, bool terminate,
                            write_info_t *wr_info) {
     char *p;
     Agraph_t *g;
+    bool known;
 
-    p = agnameof(e);
+    p = nameof(e, &known);
     g = agraphof(e);
     if (!EMPTY(p)) {
 	if (!terminate) {
 	    wr_info->level++;
 	}
 	CHKRV(ioput(g, ofile, "\t[key="));
-	CHKRV(write_canonstr(g, ofile, p, false));
+	CHKRV(write_canonstr(g, ofile, p, known));
 	if (terminate)
 	    CHKRV(ioput(g, ofile, "]"));
 	return 1;
@@ -491,7 +591,8 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		if (Headport && sym->id == Headport->id)
 		    continue;
 	    }
-	    if (data->str[sym->id] != sym->defval) {
+	    char *const value = agxget(obj, sym);
+	    if (value != sym->defval) {
 		if (cnt++ == 0) {
 		    CHKRV(ioput(g, ofile, "\t["));
 		    wr_info->level++;
@@ -501,7 +602,7 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		}
 		CHKRV(write_canonstr(g, ofile, sym->name, true));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id], true));
+		CHKRV(write_canonstr(g, ofile, value, true));
 	    }
 	}
     if (cnt > 0) {
@@ -516,11 +617,12 @@ static int write_nodename(Agnode_t * n, iochan_t * ofile)
 {
     char *name;
     Agraph_t *g;
+    bool known;
 
-    name = agnameof(n);
+    name = nameof(n, &known);
     g = agraphof(n);
     if (name) {
-	CHKRV(write_canonstr(g, ofile, name, false));
+	CHKRV(write_canonstr(g, ofile, name, known));
     } else {
 	char buf[sizeof("__SUSPECT") + 20];
 	snprintf(buf, sizeof(buf), "_%" PRIu64 "_SUSPECT", AGID(n));	/* could be deadly wrong */
@@ -666,7 +768,7 @@ static void set_attrwf(Agraph_t * g, bool toplevel, bool value)
 }
 
 /// Return 0 on success, EOF on failure
-int agwrite(Agraph_t * g, void *ofile)
+int agwrite(Agraph_t * g, void *chan)
 {
     char* s;
     s = agget(g, "linelength");
@@ -675,22 +777,23 @@ int agwrite(Agraph_t * g, void *ofile)
 	if ((len == 0 || len >= MIN_OUTPUTLINE) && len <= INT_MAX)
 	    Max_outputline = (int)len;
     }
+    iochan_t *const ofile = gv_alloc(sizeof(iochan_t));
+    ofile->chan = chan;
     write_info_t wr_info = before_write(g);
-    if (write_hdr(g, ofile, true, &wr_info) == EOF) {
-	after_write(wr_info);
-	return EOF;
-    }
-    if (write_body(g, ofile, &wr_info) == EOF) {
-	after_write(wr_info);
-	return EOF;
-    }
-    if (write_trl(g, ofile, &wr_info) == EOF) {
-	after_write(wr_info);
-	return EOF;
-    }
+    int rc = write_hdr(g, ofile, true, &wr_info);
+    if (rc != EOF)
+	rc = write_body(g, ofile, &wr_info);
+    if (rc != EOF)
+	rc = write_trl(g, ofile, &wr_info);
+    if (rc != EOF)
+	rc = ioflush(g, ofile);
     after_write(wr_info);
+    free(ofile->scratch);
+    free(ofile);
+    if (rc == EOF)
+	return EOF;
     Max_outputline = MAX_OUTPUTLINE;
-    return AGDISC(g, io)->flush(ofile);
+    return AGDISC(g, io)->flush(chan);
 }
 
 static uint64_t subgdfs(Agraph_t *g, uint64_t ix, write_info_t *wr_info) {
@@ -39,6 +39,7 @@
 #include <util/gv_math.h>
 #include <util/list.h>
 #include <util/lockfile.h>
+#include <util/parallel.h>
 #include <util/streq.h>
 #include <util/strview.h>
 #include <util/tokenize.h>
@@ -1637,7 +1638,7 @@ static bool node_in_box(node_t *n, boxf b)
   return boxf_overlap(ND_bb(n), b);
 }
 
-static char *saved_color_scheme;
+static _Thread_local char *saved_color_scheme;
 
 static void emit_begin_node(GVJ_t * job, node_t * n)
 {
@@ -1795,7 +1796,6 @@ static void emit_end_node(GVJ_t * job)
 
 static void emit_node(GVJ_t * job, node_t * n)
 {
-    GVC_t *gvc = job->gvc;
     char *s;
     char *style;
     char **styles = NULL;
@@ -1805,9 +1805,9 @@ static void emit_node(GVJ_t * job, node_t * n)
     if (ND_shape(n) 				     /* node has a shape */
 	    && node_in_layer(job, agraphof(n), n)    /* and is in layer */
 	    && node_in_box(n, job->clip)             /* and is in page/view */
-	    && ND_state(n) != gvc->common.viewNum) /* and not already drawn */
+	    && job->drawn[AGSEQ(n)] != job->common->viewNum) /* and not already drawn */
     {
-	ND_state(n) = gvc->common.viewNum; 	     /* mark node as drawn */
+	job->drawn[AGSEQ(n)] = job->common->viewNum; /* mark node as drawn */
 
         gvrender_comment(job, agnameof(n));
 	s = late_string(n, N_comment, "");
@@ -3504,11 +3504,10 @@ static void emit_colors(GVJ_t * job, graph_t * g)
 
 static void emit_view(GVJ_t * job, graph_t * g, int flags)
 {
-    GVC_t * gvc = job->gvc;
     node_t *n;
     edge_t *e;
 
-    gvc->common.viewNum++;
+    job->common->viewNum++;
     /* when drawing, lay clusters down before nodes and edges */
     if (!(flags & EMIT_CLUSTERS_LAST))
 	emit_clusters(job, g, flags);
@@ -3668,7 +3667,6 @@ static void emit_page(GVJ_t * job, graph_t * g)
 
 void emit_graph(GVJ_t * job, graph_t * g)
 {
-    node_t *n;
     char *s;
     int flags = job->flags;
     int* lp;
@@ -3701,9 +3699,9 @@ void emit_graph(GVJ_t * job, graph_t * g)
     if (flags & EMIT_COLORS)
 	emit_colors(job,g);
 
-    /* reset node state */
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	ND_state(n) = 0;
+    /* reset node state, kept by the job so jobs can be emitted at once */
+    job->drawn = gv_calloc((size_t)agroot(g)->clos->seq[AGNODE] + 1,
+                           sizeof(int));
     /* iterate layers */
     for (firstlayer(job,&lp); validlayer(job); nextlayer(job,&lp)) {
 	if (numPhysicalLayers (job) > 1)
@@ -3717,6 +3715,8 @@ void emit_graph(GVJ_t * job, graph_t * g)
 	    gvrender_end_layer(job);
     } 
     emit_end_graph(job);
+    free(job->drawn);
+    job->drawn = NULL;
 }
 
 static Dict_t *strings;
@@ -4006,12 +4006,12 @@ static token_t style_token(char **s) {
  */
 char **parse_style(char *s)
 {
-    static char *parse[FUNLIMIT];
+    static _Thread_local char *parse[FUNLIMIT];
     size_t parse_offsets[sizeof(parse) / sizeof(parse[0])];
     size_t fun = 0;
     bool in_parens = false;
     char *p;
-    static agxbuf ps_xb;
+    static _Thread_local agxbuf ps_xb;
 
     p = s;
     while (true) {
@@ -4173,6 +4173,37 @@ extern gvdevice_callbacks_t gvdevice_callbacks;
  */
 void gv_fixLocale (int set)
 {
+#ifdef LC_NUMERIC_MASK
+    // switch only this thread’s locale, so other threads rendering with their
+    // own contexts are unaffected
+    static _Thread_local locale_t save_locale;
+    static _Thread_local locale_t c_locale;
+    static _Thread_local int cnt;
+
+    if (set) {
+	cnt++;
+	if (cnt == 1) {
+	    // a copy of the current locale with C number formatting
+	    locale_t base = duplocale(uselocale((locale_t)0));
+	    if (base == (locale_t)0)
+		return;
+	    c_locale = newlocale(LC_NUMERIC_MASK, "C", base);
+	    if (c_locale == (locale_t)0) {
+		freelocale(base);
+		return;
+	    }
+	    save_locale = uselocale(c_locale);
+	}
+    }
+    else if (cnt > 0) {
+	cnt--;
+	if (cnt == 0 && c_locale != (locale_t)0) {
+	    uselocale(save_locale);
+	    freelocale(c_locale);
+	    c_locale = (locale_t)0;
+	}
+    }
+#else
     static char* save_locale;
     static int cnt;
 
@@ -4190,16 +4221,147 @@ void gv_fixLocale (int set)
 	    free (save_locale);
 	}
     }
+#endif
+}
+
+
+/// a job whose emission is deferred, to emit it alongside others
+typedef struct {
+    GVJ_t *job;
+    GVCOMMON_t common; ///< the job’s own copy of the shared state
+} deferred_job_t;
+
+typedef LIST(deferred_job_t) deferred_jobs_t;
+
+/// can `job` be emitted alongside other jobs for the same graph?
+///
+/// Its renderer must keep no state across jobs, and its output must go
+/// somewhere of its own rather than to a shared stream or callback.
+static bool can_defer(const GVC_t *gvc, const GVJ_t *job)
+{
+    if (!(job->flags & GVRENDER_CONCURRENT) || (job->flags & GVDEVICE_EVENTS)
+      || debug || gvc->write_fn || job->device.engine || job->external_context)
+	return false;
+    if (job->output_data)
+	return true;
+    return !job->output_file
+      && (job->output_filename || gvc->common.auto_outfile_names);
 }
 
+/// would `job` and the deferred `other` write to the same place?
+static bool same_output(const GVC_t *gvc, const GVJ_t *job,
+                        const GVJ_t *other)
+{
+    if (job->output_data || other->output_data)
+	return false;
+    // automatic names differ only by format, see auto_output_filename
+    if (gvc->common.auto_outfile_names)
+	return streq(job->output_langname, other->output_langname);
+    return streq(job->output_filename, other->output_filename);
+}
+
+static bool is_deferred(const deferred_jobs_t *deferred, const GVJ_t *job)
+{
+    for (size_t i = 0; i < LIST_SIZE(deferred); ++i) {
+	if (LIST_GET(deferred, i).job == job)
+	    return true;
+    }
+    return false;
+}
+
+/// what the threads emitting deferred jobs share
+typedef struct {
+    graph_t *g;
+    deferred_jobs_t *jobs;
+    gv_globals_t *globals; ///< per-thread state of the calling thread
+    Dict_t *images;        ///< images loaded by the calling thread
+} emit_jobs_t;
+
+static void emit_jobs(void *context, size_t start, size_t end, size_t worker)
+{
+    emit_jobs_t *const ctx = context;
+    gv_globals_t *own = NULL;
+    Dict_t *own_images = NULL;
+
+    // helpers take on the calling thread’s state, and then restore their own
+    if (worker != 0) {
+	gv_fixLocale(1);
+	own = gv_globals_save();
+	gv_globals_load(ctx->globals);
+	own_images = gvusershape_adopt_images(ctx->images);
+    }
+    for (size_t i = start; i < end; ++i)
+	emit_graph(LIST_AT(ctx->jobs, i)->job, ctx->g);
+    if (worker != 0) {
+	(void)gvusershape_adopt_images(own_images);
+	gv_globals_load(own);
+	free(own);
+	gv_fixLocale(0);
+    }
+}
+
+/* emit_deferred:
+ * Emit the deferred jobs, each from its own thread when there are several.
+ * The graph and the images are frozen meanwhile, so searching them does not
+ * rearrange them. Afterwards, end the jobs that later jobs would have ended
+ * had they been emitted one at a time.
+ */
+static void emit_deferred(GVC_t *gvc, graph_t *g, deferred_jobs_t *deferred,
+                          int threads)
+{
+    const size_t n = LIST_SIZE(deferred);
+
+    if (n == 0)
+	return;
+    for (size_t i = 0; i < n; ++i) {
+	deferred_job_t *const d = LIST_AT(deferred, i);
+	d->job->common = &d->common;
+    }
+
+    if (n == 1) {
+	emit_graph(LIST_FRONT(deferred)->job, g);
+    } else {
+	emit_jobs_t ctx = {.g = g, .jobs = deferred,
+	                   .globals = gv_globals_save(),
+	                   .images = gvusershape_images()};
+	size_t workers = threads > 0 ? (size_t)threads : gv_processors();
+	if (workers > n)
+	    workers = n;
+
+	agfreeze(g, true);
+	if (ctx.images)
+	    (void)dtfreeze(ctx.images, 1);
+	gv_pool_t *const pool = gv_pool_new(workers);
+	gv_pool_for(pool, n, 1, emit_jobs, &ctx);
+	gv_pool_free(pool);
+	if (ctx.images)
+	    (void)dtfreeze(ctx.images, 0);
+	agfreeze(g, false);
+	free(ctx.globals);
+    }
+
+    gvc->common.viewNum = LIST_BACK(deferred)->common.viewNum;
+    for (size_t i = 0; i < n; ++i) {
+	GVJ_t *const job = LIST_GET(deferred, i).job;
+	job->common = &gvc->common;
+	if (job != gvc->active_jobs)
+	    gvrender_end_job(job);
+    }
+    LIST_CLEAR(deferred);
+}
 
 #define FINISH()                                                               \
   GV_DEBUG("gvRenderJobs %s: %.2f secs.", agnameof(g), elapsed_sec())
 
+/* gvRenderJobs:
+ * Emit the graph for every job. If the graph's "threads" attribute asks for
+ * more than one thread, consecutive jobs that can be are emitted at once.
+ */
 int gvRenderJobs (GVC_t * gvc, graph_t * g)
 {
-    static GVJ_t *prevjob;
+    static _Thread_local GVJ_t *prevjob;
     GVJ_t *job, *firstjob;
+    deferred_jobs_t deferred = {0};
 
     if (Verbose)
 	start_timer();
@@ -4213,6 +4375,7 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
     init_bb(g);
     init_gvc(gvc, g);
     init_layering(gvc, g);
+    const int threads = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
 
     gv_fixLocale (1);
     for (job = gvjobs_first(gvc); job; job = gvjobs_next(gvc)) {
@@ -4230,6 +4393,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	job->numkeys = gvevent_key_binding_size;
 	if (!GD_drawing(g)) {
 	    agerrorf("layout was not done\n");
+	    emit_deferred(gvc, g, &deferred, threads);
+	    LIST_FREE(&deferred);
 	    gv_fixLocale (0);
 	    FINISH();
 	    return -1;
@@ -4238,6 +4403,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
         job->output_lang = gvrender_select(job, job->output_langname);
         if (job->output_lang == NO_SUPPORT) {
             agerrorf("renderer for %s is unavailable\n", job->output_langname);
+	    emit_deferred(gvc, g, &deferred, threads);
+	    LIST_FREE(&deferred);
 	    gv_fixLocale (0);
 	    FINISH();
             return -1;
@@ -4257,11 +4424,25 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	// multiple output files, or we are about to write to a different output
 	// device
         firstjob = gvc->active_jobs;
+	const bool chained = firstjob && prevjob
+	  && (firstjob->flags & GVDEVICE_DOES_PAGES)
+	  && streq(job->output_langname, firstjob->output_langname);
+
+	// emit the deferred jobs before one that cannot join them
+	bool defer = threads != 1 && !chained && can_defer(gvc, job);
+	for (size_t i = 0; defer && i < LIST_SIZE(&deferred); ++i)
+	    defer = !same_output(gvc, job, LIST_GET(&deferred, i).job);
+	if (!defer)
+	    emit_deferred(gvc, g, &deferred, threads);
+
         if (firstjob) {
 	    if (! (firstjob->flags & GVDEVICE_DOES_PAGES)
 	      || strcmp(job->output_langname, firstjob->output_langname)) {
 
-	        gvrender_end_job(firstjob);
+		if (is_deferred(&deferred, firstjob))
+		    gvc->common.lib = NULL;	/* ended by emit_deferred */
+		else
+		    gvrender_end_job(firstjob);
 	    
             	gvc->active_jobs = NULL; /* clear active list */
 	    	gvc->common.viewNum = 0;
@@ -4306,7 +4487,11 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 #pragma GCC diagnostic pop
 #endif
 	    }
-	    emit_graph(job, g);
+	    if (defer)
+		LIST_APPEND(&deferred, ((deferred_job_t){.job = job,
+		                                         .common = *job->common}));
+	    else
+		emit_graph(job, g);
 	}
 
         /* the last job, after all input graphs are processed,
@@ -4314,6 +4499,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
          */
 	prevjob = job;
     }
+    emit_deferred(gvc, g, &deferred, threads);
+    LIST_FREE(&deferred);
     gv_fixLocale (0);
     FINISH();
     return 0;
@@ -1,5 +1,5 @@
 /// @file
-/// @brief @ref fdp_parms
+/// @brief @ref fdp_parms, @ref gv_globals_save and @ref gv_globals_load
 /// @ingroup common_render
 /*************************************************************************
  * Copyright (c) 2011 AT&T Intellectual Property 
@@ -17,9 +17,10 @@
 #include <common/types.h>
 #include <common/globals.h>
 #include <fdpgen/fdp.h>
+#include <util/alloc.h>
 #include <util/list.h>
 
-show_boxes_t Show_boxes = {.dtor = LIST_DTOR_FREE};
+GLOBALS_TLS show_boxes_t Show_boxes = {.dtor = LIST_DTOR_FREE};
 
 /* Default layout values, possibly set via command line; -1 indicates unset */
 static fdpParms_t fdpParms = {
@@ -29,8 +30,131 @@ static fdpParms_t fdpParms = {
     50,                         /* unscaled */
     0.0,                        /* C */
     1.0,                        /* Tfact */
-    -1.0,                       /* K - set in initParams; used in init_edge */
+    -1.0,                       /* K - unused; see fdp_initParams */
     -1.0,                       /* T0 */
 };
 
 struct fdpParms_s* fdp_parms = &fdpParms;
+
+struct gv_globals_s {
+  char *Gvimagepath;
+  int Nop;
+  double PSinputscale;
+  int CL_type;
+  bool Concentrate;
+  double Epsilon;
+  int MaxIter;
+  unsigned short Ndim;
+  int State;
+  int EdgeLabelsDone;
+  double Initial_dist;
+  double Damping;
+  Agsym_t *G_ordering, *G_peripheries, *G_penwidth, *G_gradientangle,
+      *G_margin;
+  Agsym_t *N_height, *N_width, *N_shape, *N_color, *N_fillcolor, *N_fontsize,
+      *N_fontname, *N_fontcolor, *N_label, *N_xlabel, *N_nojustify, *N_style,
+      *N_showboxes, *N_sides, *N_peripheries, *N_ordering, *N_orientation,
+      *N_skew, *N_distortion, *N_fixed, *N_imagescale, *N_imagepos, *N_layer,
+      *N_group, *N_comment, *N_vertices, *N_z, *N_penwidth, *N_gradientangle;
+  Agsym_t *E_weight, *E_minlen, *E_color, *E_fillcolor, *E_fontsize,
+      *E_fontname, *E_fontcolor, *E_label, *E_xlabel, *E_dir, *E_style,
+      *E_decorate, *E_showboxes, *E_arrowsz, *E_constr, *E_layer, *E_comment,
+      *E_label_float, *E_samehead, *E_sametail, *E_headlabel, *E_taillabel,
+      *E_labelfontsize, *E_labelfontname, *E_labelfontcolor,
+      *E_labeldistance, *E_labelangle, *E_tailclip, *E_headclip, *E_penwidth;
+};
+
+/// apply `COPY` to every member of `gv_globals_t`
+#define COPY_ALL()                                                             \
+  do {                                                                         \
+    COPY(Gvimagepath);                                                         \
+    COPY(Nop);                                                                 \
+    COPY(PSinputscale);                                                        \
+    COPY(CL_type);                                                             \
+    COPY(Concentrate);                                                         \
+    COPY(Epsilon);                                                             \
+    COPY(MaxIter);                                                             \
+    COPY(Ndim);                                                                \
+    COPY(State);                                                               \
+    COPY(EdgeLabelsDone);                                                      \
+    COPY(Initial_dist);                                                        \
+    COPY(Damping);                                                             \
+    COPY(G_ordering);                                                          \
+    COPY(G_peripheries);                                                       \
+    COPY(G_penwidth);                                                          \
+    COPY(G_gradientangle);                                                     \
+    COPY(G_margin);                                                            \
+    COPY(N_height);                                                            \
+    COPY(N_width);                                                             \
+    COPY(N_shape);                                                             \
+    COPY(N_color);                                                             \
+    COPY(N_fillcolor);                                                         \
+    COPY(N_fontsize);                                                          \
+    COPY(N_fontname);                                                          \
+    COPY(N_fontcolor);                                                         \
+    COPY(N_label);                                                             \
+    COPY(N_xlabel);                                                            \
+    COPY(N_nojustify);                                                         \
+    COPY(N_style);                                                             \
+    COPY(N_showboxes);                                                         \
+    COPY(N_sides);                                                             \
+    COPY(N_peripheries);                                                       \
+    COPY(N_ordering);                                                          \
+    COPY(N_orientation);                                                       \
+    COPY(N_skew);                                                              \
+    COPY(N_distortion);                                                        \
+    COPY(N_fixed);                                                             \
+    COPY(N_imagescale);                                                        \
+    COPY(N_imagepos);                                                          \
+    COPY(N_layer);                                                             \
+    COPY(N_group);                                                             \
+    COPY(N_comment);                                                           \
+    COPY(N_vertices);                                                          \
+    COPY(N_z);                                                                 \
+    COPY(N_penwidth);                                                          \
+    COPY(N_gradientangle);                                                     \
+    COPY(E_weight);                                                            \
+    COPY(E_minlen);                                                            \
+    COPY(E_color);                                                             \
+    COPY(E_fillcolor);                                                         \
+    COPY(E_fontsize);                                                          \
+    COPY(E_fontname);                                                          \
+    COPY(E_fontcolor);                                                         \
+    COPY(E_label);                                                             \
+    COPY(E_xlabel);                                                            \
+    COPY(E_dir);                                                               \
+    COPY(E_style);                                                             \
+    COPY(E_decorate);                                                          \
+    COPY(E_showboxes);                                                         \
+    COPY(E_arrowsz);                                                           \
+    COPY(E_constr);                                                            \
+    COPY(E_layer);                                                             \
+    COPY(E_comment);                                                           \
+    COPY(E_label_float);                                                       \
+    COPY(E_samehead);                                                          \
+    COPY(E_sametail);                                                          \
+    COPY(E_headlabel);                                                         \
+    COPY(E_taillabel);                                                         \
+    COPY(E_labelfontsize);                                                     \
+    COPY(E_labelfontname);                                                     \
+    COPY(E_labelfontcolor);                                                    \
+    COPY(E_labeldistance);                                                     \
+    COPY(E_labelangle);                                                        \
+    COPY(E_tailclip);                                                          \
+    COPY(E_headclip);                                                          \
+    COPY(E_penwidth);                                                          \
+  } while (0)
+
+gv_globals_t *gv_globals_save(void) {
+  gv_globals_t *const state = gv_alloc(sizeof(gv_globals_t));
+#define COPY(name) (state->name = name)
+  COPY_ALL();
+#undef COPY
+  return state;
+}
+
+void gv_globals_load(const gv_globals_t *state) {
+#define COPY(name) (name = state->name)
+  COPY_ALL();
+#undef COPY
+}
@@ -40,37 +40,49 @@ extern "C" {
 #ifndef EXTERN
 #define EXTERN extern
 #endif
+
+/* State describing the graph being laid out or rendered is kept per thread,
+ * so separate threads can lay out and render separate graphs. Windows DLLs
+ * cannot export thread-local data, so there it stays shared.
+ */
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define GLOBALS_TLS /* nothing */
+#elif defined(__cplusplus)
+#define GLOBALS_TLS thread_local
+#else
+#define GLOBALS_TLS _Thread_local
+#endif
 /// @endcond
 
 typedef LIST(char *) show_boxes_t;
 
     GLOBALS_API EXTERN const char **Lib;		/* from command line */
     GLOBALS_API EXTERN char *Gvfilepath;  /* Per-process path of files allowed in image attributes (also ps libs) */
-    GLOBALS_API EXTERN char *Gvimagepath; /* Per-graph path of files allowed in image attributes  (also ps libs) */
+    GLOBALS_API EXTERN GLOBALS_TLS char *Gvimagepath; /* Per-graph path of files allowed in image attributes  (also ps libs) */
 
     GLOBALS_API EXTERN unsigned char Verbose;
     GLOBALS_API EXTERN bool Reduce;
     GLOBALS_API EXTERN char *HTTPServerEnVar;
     GLOBALS_API EXTERN int graphviz_errors;
-    GLOBALS_API EXTERN int Nop;
-    GLOBALS_API EXTERN double PSinputscale;
-    GLOBALS_API extern show_boxes_t Show_boxes; // emit code for correct box coordinates
-    GLOBALS_API EXTERN int CL_type;		/* NONE, LOCAL, GLOBAL */
-    GLOBALS_API EXTERN bool Concentrate; /// if parallel edges should be merged
-    GLOBALS_API EXTERN double Epsilon;	/* defined in input_graph */
-    GLOBALS_API EXTERN int MaxIter;
-    GLOBALS_API EXTERN unsigned short Ndim;
-    GLOBALS_API EXTERN int State;		/* last finished phase */
-    GLOBALS_API EXTERN int EdgeLabelsDone;	/* true if edge labels have been positioned */
-    GLOBALS_API EXTERN double Initial_dist;
-    GLOBALS_API EXTERN double Damping;
+    GLOBALS_API EXTERN GLOBALS_TLS int Nop;
+    GLOBALS_API EXTERN GLOBALS_TLS double PSinputscale;
+    GLOBALS_API extern GLOBALS_TLS show_boxes_t Show_boxes; // emit code for correct box coordinates
+    GLOBALS_API EXTERN GLOBALS_TLS int CL_type;		/* NONE, LOCAL, GLOBAL */
+    GLOBALS_API EXTERN GLOBALS_TLS bool Concentrate; /// if parallel edges should be merged
+    GLOBALS_API EXTERN GLOBALS_TLS double Epsilon;	/* defined in input_graph */
+    GLOBALS_API EXTERN GLOBALS_TLS int MaxIter;
+    GLOBALS_API EXTERN GLOBALS_TLS unsigned short Ndim;
+    GLOBALS_API EXTERN GLOBALS_TLS int State;		/* last finished phase */
+    GLOBALS_API EXTERN GLOBALS_TLS int EdgeLabelsDone;	/* true if edge labels have been positioned */
+    GLOBALS_API EXTERN GLOBALS_TLS double Initial_dist;
+    GLOBALS_API EXTERN GLOBALS_TLS double Damping;
     GLOBALS_API EXTERN bool Y_invert; ///< invert y in dot & plain output
     GLOBALS_API EXTERN int GvExitOnUsage;   /* gvParseArgs() should exit on usage or error */
 
-    GLOBALS_API EXTERN Agsym_t
+    GLOBALS_API EXTERN GLOBALS_TLS Agsym_t
 	*G_ordering, *G_peripheries, *G_penwidth,
 	*G_gradientangle, *G_margin;
-    GLOBALS_API EXTERN Agsym_t
+    GLOBALS_API EXTERN GLOBALS_TLS Agsym_t
 	*N_height, *N_width, *N_shape, *N_color, *N_fillcolor,
 	*N_fontsize, *N_fontname, *N_fontcolor,
 	*N_label, *N_xlabel, *N_nojustify, *N_style, *N_showboxes,
@@ -78,7 +90,7 @@ typedef LIST(char *) show_boxes_t;
 	*N_skew, *N_distortion, *N_fixed, *N_imagescale, *N_imagepos, *N_layer,
 	*N_group, *N_comment, *N_vertices, *N_z,
 	*N_penwidth, *N_gradientangle;
-    GLOBALS_API EXTERN Agsym_t
+    GLOBALS_API EXTERN GLOBALS_TLS Agsym_t
 	*E_weight, *E_minlen, *E_color, *E_fillcolor,
 	*E_fontsize, *E_fontname, *E_fontcolor,
 	*E_label, *E_xlabel, *E_dir, *E_style, *E_decorate,
@@ -93,6 +105,17 @@ typedef LIST(char *) show_boxes_t;
 
     GLOBALS_API extern struct fdpParms_s* fdp_parms;
 
+    /// a copy of the per-thread state above, except `Show_boxes`
+    typedef struct gv_globals_s gv_globals_t;
+
+    /// copy this thread’s state, for another thread to take on
+    ///
+    /// @return A copy the caller should later `free`
+    GLOBALS_API gv_globals_t *gv_globals_save(void);
+
+    /// take on state copied from this or another thread
+    GLOBALS_API void gv_globals_load(const gv_globals_t *state);
+
 #undef EXTERN
 #undef GLOBALS_API
 
@@ -516,6 +516,8 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
     static char *fn;
     static FILE *fp;
     static int gidx;
+    // was the last graph read from `fp` in the binary format?
+    static bool after_binary;
 
     while (!g) {
 	if (!fp) {
@@ -532,7 +534,18 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	}
 	if (fp == NULL)
 	    break;
-	g = agconcat(NULL, fn ? fn : "<stdin>", fp, NULL);
+	// a binary graph ends exactly at its last byte, so skip any line break
+	// separating it from the next graph
+	int c = getc(fp);
+	while (after_binary && c != EOF && gv_isspace(c))
+	    c = getc(fp);
+	if (c != EOF)
+	    ungetc(c, fp);
+	after_binary = c == AGBIN_LEAD;
+	if (c == AGBIN_LEAD)
+	    g = agreadbin(fp, NULL, NULL);
+	else
+	    g = agconcat(NULL, fn ? fn : "<stdin>", fp, NULL);
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
@@ -540,6 +553,7 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	if (fp != stdin)
 	    fclose (fp);
 	fp = NULL;
+	after_binary = false;
 	gidx = 0;
     }
     return g;
@@ -27,7 +27,7 @@ static void storeline(GVC_t *gvc, textlabel_t *lp, char *line,
                       char terminator) {
     pointf size;
     textspan_t *span;
-    size_t oldsz = lp->u.txt.nspans + 1;
+    size_t oldsz = lp->u.txt.nspans;
 
     lp->u.txt.span = gv_recalloc(lp->u.txt.span, oldsz, oldsz + 1,
                                  sizeof(textspan_t));
@@ -22,8 +22,8 @@
 #include <util/gv_fopen.h>
 #include <util/strcasecmp.h>
 
-static int N_EPSF_files;
-static Dict_t *EPSF_contents;
+static _Thread_local int N_EPSF_files;
+static _Thread_local Dict_t *EPSF_contents;
 
 static void ps_image_free(void *shape) {
     usershape_t *p = shape;
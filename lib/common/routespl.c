@@ -29,10 +29,10 @@
 #include <util/list.h>
 #include <util/prisize_t.h>
 
-static int nedges; ///< total no. of edges used in routing
-static size_t nboxes; ///< total no. of boxes used in routing
+static _Thread_local int nedges; ///< total no. of edges used in routing
+static _Thread_local size_t nboxes; ///< total no. of boxes used in routing
 
-static int routeinit;
+static _Thread_local int routeinit;
 
 static int checkpath(size_t, boxf *, path *);
 static void printpath(path * pp);
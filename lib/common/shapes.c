@@ -2944,8 +2944,10 @@ static void poly_gencode(GVJ_t * job, node_t * n)
     size_t peripheries = poly->peripheries;
     pointf *AF = gv_calloc(sides + 5, sizeof(pointf));
 
-    /* nominal label position in the center of the node */
-    ND_label(n)->pos = ND_coord(n);
+    /* nominal label position in the center of the node, drawn from a copy so
+     * jobs emitting the same graph at once do not write to it */
+    textlabel_t label = *ND_label(n);
+    label.pos = ND_coord(n);
 
     xsize = (ND_lw(n) + ND_rw(n)) / INCH2PS(ND_width(n));
     ysize = ND_ht(n) / INCH2PS(ND_height(n));
@@ -3107,7 +3109,7 @@ static void poly_gencode(GVJ_t * job, node_t * n)
     free (clrs[0]);
     free (clrs[1]);
 
-    emit_label(job, EMIT_NLABEL, ND_label(n));
+    emit_label(job, EMIT_NLABEL, &label);
     if (doMap) {
 	if (job->flags & EMIT_CLUSTERS_LAST)
 	    gvrender_begin_anchor(job,
@@ -3354,7 +3356,7 @@ static bool ISCTRL(int c) {
   return c == '{' || c == '}' || c == '|' || c == '<' || c == '>';
 }
 
-static char *reclblp;
+static _Thread_local char *reclblp;
 
 static void free_field(field_t * f)
 {
@@ -3858,8 +3860,9 @@ static void gen_fields(GVJ_t * job, node_t * n, field_t * f)
     pointf AF[2], coord;
 
     if (f->lp) {
-	f->lp->pos = add_pointf(mid_pointf(f->b.LL, f->b.UR), ND_coord(n));
-	emit_label(job, EMIT_NLABEL, f->lp);
+	textlabel_t label = *f->lp;
+	label.pos = add_pointf(mid_pointf(f->b.LL, f->b.UR), ND_coord(n));
+	emit_label(job, EMIT_NLABEL, &label);
 	penColor(job, n);
     }
 
@@ -3956,8 +3959,8 @@ static void record_gencode(GVJ_t * job, node_t * n)
     }
 }
 
-static shape_desc **UserShape;
-static size_t N_UserShape;
+static _Thread_local shape_desc **UserShape;
+static _Thread_local size_t N_UserShape;
 
 shape_desc *find_user_shape(const char *name)
 {
@@ -4043,9 +4046,10 @@ static void epsf_gencode(GVJ_t * job, node_t * n)
 		"%.5g %.5g translate newpath user_shape_%d\n",
 		ND_coord(n).x + desc->offset.x,
 		ND_coord(n).y + desc->offset.y, desc->macro_id);
-    ND_label(n)->pos = ND_coord(n);
+    textlabel_t label = *ND_label(n);
+    label.pos = ND_coord(n);
 
-    emit_label(job, EMIT_NLABEL, ND_label(n));
+    emit_label(job, EMIT_NLABEL, &label);
     if (doMap) {
 	if (job->flags & EMIT_CLUSTERS_LAST)
 	    gvrender_begin_anchor(job,
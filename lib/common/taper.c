@@ -45,7 +45,7 @@ enum { debug = 0 };
 #define D2R(d)    (M_PI*(d)/180.0)
 #define R2D(r)    (180.0*(r)/M_PI)
 
-static double currentmiterlimit = 10.0;
+static _Thread_local double currentmiterlimit = 10.0;
 
 #define moveto(p,x,y) addto(p,x,y)
 #define lineto(p,x,y) addto(p,x,y)
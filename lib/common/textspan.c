@@ -16,13 +16,23 @@
 
 #include "config.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 #include <cdt/cdt.h>
 #include <common/render.h>
 #include <common/textspan_lut.h>
+#include <gvc/gvcint.h>
+#include <util/agxbuf.h>
 #include <util/alloc.h>
+#include <util/gv_fopen.h>
 #include <util/strcasecmp.h>
 
 /* estimate_textspan_size:
@@ -70,6 +80,290 @@ static PostscriptAlias* translate_postscript_fontname(char* fontname)
                    sizeof(PostscriptAlias), fontcmpf);
 }
 
+/* The measurement of a span depends only on its font name, size, flags and
+ * string, and the same few labels tend to be measured over and over, so
+ * measurements are remembered for the life of the GVC_t. If $GV_TEXT_CACHE
+ * names a file, they are also read from it when first needed and written back
+ * to it by textfont_dict_close, so they outlive the process.
+ *
+ * A long running program can measure an unbounded variety of labels, so the
+ * measurements are bounded in size. When adding one would exceed the bound, all
+ * are forgotten and collecting starts again.
+ */
+
+/// most memory the remembered measurements of a GVC_t may use, in bytes
+enum { TEXTSPAN_CACHE_MAX_BYTES = 8 << 20 };
+
+/// a remembered text span measurement
+typedef struct {
+    /* key */
+    char *fontname;
+    char *str;
+    double fontsize;
+    unsigned flags;
+
+    /* non key */
+    pointf size;
+    double yoffset_layout, yoffset_centerline;
+} textspan_measure_t;
+
+static void *textspan_measure_makef(void *obj, Dtdisc_t *disc) {
+    (void)disc;
+
+    textspan_measure_t *m1 = obj;
+    textspan_measure_t *m2 = gv_alloc(sizeof(textspan_measure_t));
+
+    *m2 = *m1;
+    m2->fontname = gv_strdup(m1->fontname);
+    m2->str = gv_strdup(m1->str);
+    return m2;
+}
+
+static void textspan_measure_freef(void *obj) {
+    textspan_measure_t *m = obj;
+
+    free(m->fontname);
+    free(m->str);
+    free(m);
+}
+
+/// approximate memory used by a remembered measurement
+static size_t textspan_measure_bytes(const textspan_measure_t *m) {
+    return sizeof(*m) + strlen(m->fontname) + 1 + strlen(m->str) + 1;
+}
+
+static int textspan_measure_comparf(void *key1, void *key2) {
+    int rc;
+    textspan_measure_t *m1 = key1, *m2 = key2;
+
+    rc = strcmp(m1->str, m2->str);
+    if (rc) return rc;
+    rc = strcmp(m1->fontname, m2->fontname);
+    if (rc) return rc;
+    if (m1->flags < m2->flags) return -1;
+    if (m1->flags > m2->flags) return 1;
+    if (m1->fontsize < m2->fontsize) return -1;
+    if (m1->fontsize > m2->fontsize) return 1;
+    return 0;
+}
+
+/* The on-disk form is a text line naming the Graphviz version and the
+ * textlayout plugin, a double to catch files written by a machine with
+ * different number representations, then the measurements in binary.
+ * A file that does not match is ignored, and replaced when saving.
+ */
+#define TEXT_CACHE_MAGIC 1.5
+
+static bool read_field(FILE *f, void *dst, size_t size) {
+    return fread(dst, size, 1, f) == 1;
+}
+
+/// read a string of `len` bytes, which must not extend beyond offset `end`
+static char *read_string(FILE *f, uint32_t len, long end) {
+    const long here = ftell(f);
+    if (here < 0 || here > end || len > (uint64_t)(end - here))
+	return NULL;
+    char *s = gv_alloc((size_t)len + 1);
+    if (len > 0 && fread(s, len, 1, f) != 1) {
+	free(s);
+	return NULL;
+    }
+    return s;
+}
+
+/// forget all remembered measurements
+static void textspan_cache_clear(GVC_t *gvc) {
+    dtclear(gvc->textspan_dt);
+    gvc->textspan_bytes = 0;
+}
+
+/// remember a measurement, if it is not already known and there is room
+///
+/// @return False if there was no room
+static bool textspan_cache_insert(GVC_t *gvc, textspan_measure_t *m) {
+    if (dtsearch(gvc->textspan_dt, m))
+	return true;
+    const size_t bytes = textspan_measure_bytes(m);
+    if (gvc->textspan_bytes + bytes > TEXTSPAN_CACHE_MAX_BYTES)
+	return false;
+    dtinsert(gvc->textspan_dt, m);
+    gvc->textspan_bytes += bytes;
+    return true;
+}
+
+static void textspan_cache_load(GVC_t *gvc) {
+    const char *filename = getenv("GV_TEXT_CACHE");
+    if (!filename || !*filename)
+	return;
+    FILE *f = gv_fopen(filename, "rb");
+    if (!f)
+	return;
+
+    const size_t id_len = strlen(gvc->textspan_cache_id);
+    char *id = gv_alloc(id_len + 1);
+    double magic;
+    if (fread(id, 1, id_len, f) != id_len || strcmp(id, gvc->textspan_cache_id)
+	|| !read_field(f, &magic, sizeof(magic))
+	|| memcmp(&magic, &(double){TEXT_CACHE_MAGIC}, sizeof(magic))) {
+	free(id);
+	fclose(f);
+	return;
+    }
+    free(id);
+
+    const long start = ftell(f);
+    if (start < 0 || fseek(f, 0, SEEK_END) != 0) {
+	fclose(f);
+	return;
+    }
+    const long end = ftell(f);
+    if (end < 0 || fseek(f, start, SEEK_SET) != 0) {
+	fclose(f);
+	return;
+    }
+
+    /* stop quietly at the first incomplete record, or when full, but reject
+     * the whole file if a string runs past its end
+     */
+    for (;;) {
+	textspan_measure_t m = {0};
+	uint32_t name_len, str_len;
+	if (!read_field(f, &m.size.x, sizeof(m.size.x))
+	    || !read_field(f, &m.size.y, sizeof(m.size.y))
+	    || !read_field(f, &m.yoffset_layout, sizeof(m.yoffset_layout))
+	    || !read_field(f, &m.yoffset_centerline, sizeof(m.yoffset_centerline))
+	    || !read_field(f, &m.fontsize, sizeof(m.fontsize))
+	    || !read_field(f, &m.flags, sizeof(m.flags))
+	    || !read_field(f, &name_len, sizeof(name_len))
+	    || !read_field(f, &str_len, sizeof(str_len)))
+	    break;
+	m.fontname = read_string(f, name_len, end);
+	m.str = m.fontname ? read_string(f, str_len, end) : NULL;
+	const bool full = m.str && !textspan_cache_insert(gvc, &m);
+	free(m.fontname);
+	free(m.str);
+	if (!m.str) {
+	    textspan_cache_clear(gvc);
+	    break;
+	}
+	if (full)
+	    break;
+    }
+    fclose(f);
+}
+
+static void textspan_cache_save(GVC_t *gvc) {
+    const char *filename = getenv("GV_TEXT_CACHE");
+    if (!filename || !*filename || !gvc->textspan_cache_id || gvc->textspan_misses == 0)
+	return;
+
+    /* write a file alongside and rename it into place, so another process
+     * never reads a partly written cache
+     */
+    agxbuf temp = {0};
+    agxbprint(&temp, "%s.%d.tmp", filename, (int)getpid());
+    const char *const tempname = agxbuse(&temp);
+    FILE *f = gv_fopen(tempname, "wb");
+    if (!f) {
+	agwarningf("failed to open %s for write.\n", tempname);
+	agxbfree(&temp);
+	return;
+    }
+
+    const double magic = TEXT_CACHE_MAGIC;
+    fputs(gvc->textspan_cache_id, f);
+    fwrite(&magic, sizeof(magic), 1, f);
+    for (textspan_measure_t *m = dtfirst(gvc->textspan_dt); m;
+	 m = dtnext(gvc->textspan_dt, m)) {
+	const size_t name_len = strlen(m->fontname);
+	const size_t str_len = strlen(m->str);
+	if (name_len > UINT32_MAX || str_len > UINT32_MAX)
+	    continue;
+	const uint32_t lens[] = {(uint32_t)name_len, (uint32_t)str_len};
+	fwrite(&m->size.x, sizeof(m->size.x), 1, f);
+	fwrite(&m->size.y, sizeof(m->size.y), 1, f);
+	fwrite(&m->yoffset_layout, sizeof(m->yoffset_layout), 1, f);
+	fwrite(&m->yoffset_centerline, sizeof(m->yoffset_centerline), 1, f);
+	fwrite(&m->fontsize, sizeof(m->fontsize), 1, f);
+	fwrite(&m->flags, sizeof(m->flags), 1, f);
+	fwrite(lens, sizeof(lens), 1, f);
+	fwrite(m->fontname, 1, name_len, f);
+	fwrite(m->str, 1, str_len, f);
+    }
+    if (fclose(f) != 0) {
+	agwarningf("failed to write %s.\n", tempname);
+	(void)remove(tempname);
+	agxbfree(&temp);
+	return;
+    }
+#ifdef _WIN32
+    // Windows’ rename does not replace an existing file
+    (void)remove(filename);
+#endif
+    if (rename(tempname, filename) != 0) {
+	agwarningf("failed to replace %s.\n", filename);
+	(void)remove(tempname);
+    }
+    agxbfree(&temp);
+}
+
+/// drop remembered measurements made by a textlayout engine no longer in use
+static void textspan_cache_check(GVC_t *gvc) {
+    if (gvc->textspan_cache_id && gvc->textspan_engine == gvc->textlayout.engine)
+	return;
+
+    textspan_cache_clear(gvc);
+    free(gvc->textspan_cache_id);
+    gvc->textspan_engine = gvc->textlayout.engine;
+
+    gvplugin_available_t *plugin = gvc->api[API_textlayout];
+    agxbuf id = {0};
+    agxbprint(&id, "graphviz %s text measurements from %s\n", PACKAGE_VERSION,
+	      gvc->textspan_engine && plugin ? plugin->package->name : "estimates");
+    gvc->textspan_cache_id = agxbdisown(&id);
+
+    textspan_cache_load(gvc);
+}
+
+static textspan_measure_t textspan_measure_key(textspan_t *span) {
+    return (textspan_measure_t){.fontname = span->font->name, .str = span->str,
+                                .fontsize = span->font->size,
+                                .flags = span->font->flags};
+}
+
+/// fill in a span from a remembered measurement, if there is one
+static bool textspan_cache_find(GVC_t *gvc, textspan_t *span) {
+    textspan_cache_check(gvc);
+
+    textspan_measure_t key = textspan_measure_key(span);
+    textspan_measure_t *m = dtsearch(gvc->textspan_dt, &key);
+    if (!m)
+	return false;
+    gvc->textspan_hits++;
+
+    /* renderers that need a layout make their own when there is none */
+    span->size = m->size;
+    span->yoffset_layout = m->yoffset_layout;
+    span->yoffset_centerline = m->yoffset_centerline;
+    span->layout = NULL;
+    span->free_layout = NULL;
+    return true;
+}
+
+static void textspan_cache_add(GVC_t *gvc, textspan_t *span) {
+    textspan_cache_check(gvc);
+
+    textspan_measure_t m = textspan_measure_key(span);
+    m.size = span->size;
+    m.yoffset_layout = span->yoffset_layout;
+    m.yoffset_centerline = span->yoffset_centerline;
+    if (!textspan_cache_insert(gvc, &m)) {
+	textspan_cache_clear(gvc);
+	(void)textspan_cache_insert(gvc, &m);
+    }
+    gvc->textspan_misses++;
+}
+
 pointf textspan_size(GVC_t *gvc, textspan_t * span)
 /// Estimates size of a textspan, in points.
 {
@@ -88,8 +382,13 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
     if (Verbose && emit_once(font->name))
 	fpp = &fontpath;
 
+    /* a font being reported is measured anyway, to find its path */
+    if (!fpp && textspan_cache_find(gvc, span))
+	return span->size;
+
     if (! gvtextlayout(gvc, span, fpp))
 	estimate_textspan_size(span, fpp);
+    textspan_cache_add(gvc, span);
 
     if (fpp) {
 	if (fontpath)
@@ -154,9 +453,19 @@ static int textfont_comparf(void *key1, void *key2) {
 void textfont_dict_open(GVC_t *gvc) {
     DTDISC(&gvc->textfont_disc, 0, sizeof(textfont_t), -1, textfont_makef, textfont_freef, textfont_comparf);
     gvc->textfont_dt = dtopen(&(gvc->textfont_disc), Dtoset);
+    DTDISC(&gvc->textspan_disc, 0, sizeof(textspan_measure_t), -1, textspan_measure_makef, textspan_measure_freef, textspan_measure_comparf);
+    gvc->textspan_dt = dtopen(&gvc->textspan_disc, Dtoset);
 }
 
 void textfont_dict_close(GVC_t *gvc)
 {
+    const size_t lookups = gvc->textspan_hits + gvc->textspan_misses;
+    if (Verbose && lookups > 0)
+	fprintf(stderr, "text measurement cache: %zu hits, %zu misses (%.1f%% hit rate)\n",
+		gvc->textspan_hits, gvc->textspan_misses,
+		100.0 * (double)gvc->textspan_hits / (double)lookups);
+    textspan_cache_save(gvc);
+    dtclose(gvc->textspan_dt);
+    free(gvc->textspan_cache_id);
     dtclose(gvc->textfont_dt);
 }
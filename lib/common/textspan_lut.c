@@ -10,6 +10,7 @@
 #include <common/utils.h>
 #include <ctype.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -804,9 +805,9 @@ static unsigned short
 estimate_character_width_canonical(const short variant_metrics[128],
                                    unsigned character) {
   if (character >= 128) {
-    static bool warning_already_reported = false;
-    if (!warning_already_reported) { // stderr spam prevention
-      warning_already_reported = true;
+    static atomic_flag warning_already_reported;
+    // stderr spam prevention
+    if (!atomic_flag_test_and_set(&warning_already_reported)) {
       agwarningf(
           "Warning: no value for width of non-ASCII character %u. Falling "
           "back to width of space character\n",
@@ -816,9 +817,9 @@ estimate_character_width_canonical(const short variant_metrics[128],
   }
   short width = variant_metrics[character];
   if (width == -1) {
-    static bool warning_already_reported = false;
-    if (!warning_already_reported) { // stderr spam prevention
-      warning_already_reported = true;
+    static atomic_flag warning_already_reported;
+    // stderr spam prevention
+    if (!atomic_flag_test_and_set(&warning_already_reported)) {
       agwarningf(
           "Warning: no value for width of ASCII character %u. Falling back "
           "to 0\n",
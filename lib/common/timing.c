@@ -16,7 +16,7 @@
 #include <common/utils.h>
 #include <time.h>
 
-static clock_t T;
+static _Thread_local clock_t T;
 
 void start_timer(void) { T = clock(); }
 
@@ -43,9 +43,8 @@ int late_int(void *obj, attrsym_t *attr, int defaultValue, int minimum) {
     char *p = agxget(obj, attr);
     if (!p || p[0] == '\0')
         return defaultValue;
-    char *endp;
-    long rv = strtol(p, &endp, 10);
-    if (p == endp || rv > INT_MAX)
+    long rv;
+    if (!agstrtol(p, &rv) || rv > INT_MAX)
         return defaultValue; /* invalid int format */
     if (rv < minimum)
         return minimum;
@@ -59,9 +58,8 @@ double late_double(void *obj, attrsym_t *attr, double defaultValue,
     char *p = agxget(obj, attr);
     if (!p || p[0] == '\0')
         return defaultValue;
-    char *endp;
-    double rv = strtod(p, &endp);
-    if (p == endp)
+    double rv;
+    if (!agstrtod(p, &rv))
         return defaultValue; /* invalid double format */
     if (rv < minimum)
         return minimum;
@@ -251,7 +249,7 @@ static strviews_t mkDirlist(const char *list) {
 }
 
 static char *findPath(const strviews_t dirs, const char *str) {
-    static agxbuf safefilename;
+    static _Thread_local agxbuf safefilename;
 
     for (size_t i = 0; i < LIST_SIZE(&dirs); ++i) {
 	const strview_t d = LIST_GET(&dirs, i);
@@ -265,9 +263,9 @@ static char *findPath(const strviews_t dirs, const char *str) {
 
 const char *safefile(const char *filename)
 {
-    static bool onetime = true;
-    static char *pathlist = NULL;
-    static strviews_t dirs;
+    static _Thread_local bool onetime = true;
+    static _Thread_local char *pathlist = NULL;
+    static _Thread_local strviews_t dirs;
 
     if (!filename || !filename[0])
 	return NULL;
@@ -731,7 +729,7 @@ static node_t *clustNode(node_t * n, graph_t * cg, agxbuf * xb,
 			 graph_t * clg)
 {
     node_t *cn;
-    static int idx = 0;
+    static _Thread_local int idx = 0;
 
     agxbprint(xb, "__%d:%s", idx++, agnameof(cg));
 
@@ -1182,8 +1180,8 @@ cvtAndAppend (unsigned char c, agxbuf* xb)
  */
 char* htmlEntityUTF8 (char* s, graph_t* g)
 {
-    static graph_t* lastg;
-    static atomic_flag warned;
+    static _Thread_local graph_t* lastg;
+    static _Thread_local atomic_flag warned;
     unsigned char c;
     unsigned int v;
 
@@ -1546,15 +1544,6 @@ void gv_nodesize(node_t *n, bool flip) {
     }
 }
 
-#ifndef HAVE_DRAND48
-double drand48(void)
-{
-    double d;
-    d = rand();
-    d = d / RAND_MAX;
-    return d;
-}
-#endif
 typedef struct {
     Dtlink_t link;
     char* name;
@@ -33,6 +33,7 @@
 #include <util/gv_math.h>
 #include <util/itos.h>
 #include <util/list.h>
+#include <util/parallel.h>
 #include <util/streq.h>
 
 struct adjmatrix_t {
@@ -126,6 +127,7 @@ static void init_mccomp(graph_t *g, size_t c);
 static void cleanup2(graph_t *g, int64_t nc);
 /// @return minimum crossings on success, negative value on failure
 static int64_t mincross_clust(graph_t *g);
+static int64_t mincross_components(graph_t *g);
 /// @return minimum crossings on success, negative value on failure
 static int64_t mincross(graph_t *g, int startpass);
 static void mincross_step(graph_t * g, int pass);
@@ -154,14 +156,39 @@ void node_in_root_vlist(node_t * n);
 
 
 	/* mincross parameters */
-static int MinQuit;
+static _Thread_local int MinQuit;
 static const double Convergence = .995;
 
-static graph_t *Root;
-static int GlobalMinRank, GlobalMaxRank;
-static edge_t **TE_list;
-static int *TI_list;
-static bool ReMincross;
+static _Thread_local graph_t *Root;
+static _Thread_local int GlobalMinRank, GlobalMaxRank;
+static _Thread_local edge_t **TE_list;
+static _Thread_local int *TI_list;
+static _Thread_local bool ReMincross;
+static _Thread_local gv_pool_t *Pool; ///< workers requested by the `threads` attribute
+
+/// a connected component of `Root`, laid out on a worker thread
+///
+/// While the components of the root graph are laid out concurrently, each
+/// thread works on a private copy of the root’s rank array whose node lists are
+/// the component’s slices of the root’s.
+typedef struct {
+    rank_t *rank;  ///< stands in for `GD_rank(Root)`
+    node_t *nlist; ///< stands in for `GD_nlist(Root)`
+    int64_t nc;    ///< crossings of the finished layout, or -1 on failure
+} component_t;
+
+/// component being laid out by the calling thread, if any
+static _Thread_local component_t *Comp;
+
+/// rank array of a graph, as seen by the calling thread
+static rank_t *ranks(graph_t *g) {
+    return Comp != NULL && g == Root ? Comp->rank : GD_rank(g);
+}
+
+/// node list of a graph, as seen by the calling thread
+static node_t *nlist(graph_t *g) {
+    return Comp != NULL && g == Root ? Comp->nlist : GD_nlist(g);
+}
 
 typedef struct {
     Agrec_t h;
@@ -327,7 +354,7 @@ checkLabelOrder (graph_t* g)
  * Note that nodes are not placed into GD_rank(g) until mincross()
  * is called.
  */
-int dot_mincross(graph_t *g) {
+static int mincross_graph(graph_t *g) {
     int64_t nc;
     char *s;
 
@@ -350,14 +377,21 @@ int dot_mincross(graph_t *g) {
 
     init_mincross(g);
 
-    size_t comp;
-    for (nc = 0, comp = 0; comp < GD_comp(g).size; comp++) {
-	init_mccomp(g, comp);
-	const int64_t mc = mincross(g, 0);
-	if (mc < 0) {
+    if (Pool != NULL && GD_comp(g).size > 1 && !GD_has_flat_edges(g)) {
+	nc = mincross_components(g);
+	if (nc < 0) {
 	    return -1;
 	}
-	nc += mc;
+    } else {
+	size_t comp;
+	for (nc = 0, comp = 0; comp < GD_comp(g).size; comp++) {
+	    init_mccomp(g, comp);
+	    const int64_t mc = mincross(g, 0);
+	    if (mc < 0) {
+		return -1;
+	    }
+	    nc += mc;
+	}
     }
 
     merge2(g);
@@ -392,6 +426,15 @@ int dot_mincross(graph_t *g) {
     return 0;
 }
 
+int dot_mincross(graph_t *g) {
+    const int threads = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
+    Pool = threads == 1 ? NULL : gv_pool_new((size_t)threads);
+    const int rc = mincross_graph(g);
+    gv_pool_free(Pool);
+    Pool = NULL;
+    return rc;
+}
+
 static adjmatrix_t *new_matrix(size_t initial_rows, size_t initial_columns) {
     adjmatrix_t *rv = gv_alloc(sizeof(adjmatrix_t));
     const size_t bits = initial_rows * initial_columns;
@@ -421,6 +464,93 @@ static void init_mccomp(graph_t *g, size_t c) {
     }
 }
 
+/// state shared by the workers laying out components
+typedef struct {
+    component_t *comps; ///< one per component of `Root`
+    int **ti_lists;     ///< scratch space for `medians`, one per worker
+
+    // the calling thread’s mincross parameters, for the workers to adopt
+    graph_t *root;
+    int min_quit;
+    int max_iter;
+    bool remincross;
+} components_t;
+
+/// lay out the components `[start, end)`, for `gv_pool_for`
+static void layout_components(void *context, size_t start, size_t end,
+                              size_t worker) {
+    components_t *const cs = context;
+    Root = cs->root;
+    MinQuit = cs->min_quit;
+    MaxIter = cs->max_iter;
+    ReMincross = cs->remincross;
+    int *const ti_list = TI_list;
+    TI_list = cs->ti_lists[worker];
+    for (size_t c = start; c < end; c++) {
+	Comp = &cs->comps[c];
+	Comp->nc = mincross(Root, 0);
+    }
+    Comp = NULL;
+    TI_list = ti_list;
+}
+
+/* Run the initial mincross of each connected component of g concurrently.
+ * Each component is installed into the same slices of the rank lists that
+ * the serial loop over init_mccomp would give it, and the rank array of g is
+ * left as that loop leaves it, so the layout does not depend on the number
+ * of threads. Only called on graphs without flat edges, whose handling
+ * queries the subgraph dictionaries of g and so cannot be done concurrently.
+ */
+static int64_t mincross_components(graph_t *g) {
+    const size_t ncomp = GD_comp(g).size;
+    components_t cs = {.comps = gv_calloc(ncomp, sizeof(component_t)),
+                       .root = Root, .min_quit = MinQuit, .max_iter = MaxIter,
+                       .remincross = ReMincross};
+
+    int *const used = gv_calloc(GD_maxrank(g) + 2, sizeof(int));
+    for (size_t c = 0; c < ncomp; c++) {
+	component_t *const comp = &cs.comps[c];
+	comp->nlist = GD_comp(g).list[c];
+	comp->rank = gv_calloc(GD_maxrank(g) + 2, sizeof(rank_t));
+	for (int r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	    comp->rank[r] = GD_rank(g)[r];
+	    comp->rank[r].v = GD_rank(g)[r].av + used[r];
+	    comp->rank[r].n = 0;
+	}
+	for (node_t *n = comp->nlist; n; n = ND_next(n))
+	    used[ND_rank(n)]++;
+    }
+    free(used);
+
+    const size_t workers = gv_pool_size(Pool);
+    const size_t edges = (size_t)agnedges(dot_root(g)) + 1;
+    cs.ti_lists = gv_calloc(workers, sizeof(int *));
+    for (size_t i = 0; i < workers; i++)
+	cs.ti_lists[i] = gv_calloc(edges, sizeof(int));
+
+    gv_pool_for(Pool, ncomp, 1, layout_components, &cs);
+
+    int64_t nc = 0;
+    for (size_t c = 0; c < ncomp; c++) {
+	if (cs.comps[c].nc < 0 || nc < 0)
+	    nc = -1;
+	else
+	    nc += cs.comps[c].nc;
+    }
+    const component_t *const last = &cs.comps[ncomp - 1];
+    for (int r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	GD_rank(g)[r] = last->rank[r];
+    GD_nlist(g) = last->nlist;
+
+    for (size_t i = 0; i < workers; i++)
+	free(cs.ti_lists[i]);
+    free(cs.ti_lists);
+    for (size_t c = 0; c < ncomp; c++)
+	free(cs.comps[c].rank);
+    free(cs.comps);
+    return nc;
+}
+
 static int betweenclust(edge_t * e)
 {
     while (ED_to_orig(e))
@@ -568,7 +698,7 @@ static bool left2right(graph_t *g, node_t *v, node_t *w) {
 	if (ND_clust(v) != ND_clust(w))
 	    return true;
     }
-    adjmatrix_t *const M = GD_rank(g)[ND_rank(v)].flat;
+    adjmatrix_t *const M = ranks(g)[ND_rank(v)].flat;
     if (M == NULL)
 	return false;
     if (GD_flip(g)) {
@@ -623,9 +753,9 @@ static void exchange(node_t * v, node_t * w)
     vi = ND_order(v);
     wi = ND_order(w);
     ND_order(v) = wi;
-    GD_rank(Root)[r].v[wi] = v;
+    ranks(Root)[r].v[wi] = v;
     ND_order(w) = vi;
-    GD_rank(Root)[r].v[vi] = w;
+    ranks(Root)[r].v[vi] = w;
 }
 
 static int64_t transpose_step(graph_t *g, int r, bool reverse) {
@@ -633,10 +763,10 @@ static int64_t transpose_step(graph_t *g, int r, bool reverse) {
     node_t *v, *w;
 
     int64_t rv = 0;
-    GD_rank(g)[r].candidate = false;
-    for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	v = GD_rank(g)[r].v[i];
-	w = GD_rank(g)[r].v[i + 1];
+    ranks(g)[r].candidate = false;
+    for (i = 0; i < ranks(g)[r].n - 1; i++) {
+	v = ranks(g)[r].v[i];
+	w = ranks(g)[r].v[i + 1];
 	assert(ND_order(v) < ND_order(w));
 	if (left2right(g, v, w))
 	    continue;
@@ -646,23 +776,23 @@ static int64_t transpose_step(graph_t *g, int r, bool reverse) {
 	    c0 += in_cross(v, w);
 	    c1 += in_cross(w, v);
 	}
-	if (GD_rank(g)[r + 1].n > 0) {
+	if (ranks(g)[r + 1].n > 0) {
 	    c0 += out_cross(v, w);
 	    c1 += out_cross(w, v);
 	}
 	if (c1 < c0 || (c0 > 0 && reverse && c1 == c0)) {
 	    exchange(v, w);
 	    rv += c0 - c1;
-	    GD_rank(Root)[r].valid = false;
-	    GD_rank(g)[r].candidate = true;
+	    ranks(Root)[r].valid = false;
+	    ranks(g)[r].candidate = true;
 
 	    if (r > GD_minrank(g)) {
-		GD_rank(Root)[r - 1].valid = false;
-		GD_rank(g)[r - 1].candidate = true;
+		ranks(Root)[r - 1].valid = false;
+		ranks(g)[r - 1].candidate = true;
 	    }
 	    if (r < GD_maxrank(g)) {
-		GD_rank(Root)[r + 1].valid = false;
-		GD_rank(g)[r + 1].candidate = true;
+		ranks(Root)[r + 1].valid = false;
+		ranks(g)[r + 1].candidate = true;
 	    }
 	}
     }
@@ -674,12 +804,12 @@ static void transpose(graph_t * g, bool reverse)
     int r;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
-	GD_rank(g)[r].candidate = true;
+	ranks(g)[r].candidate = true;
     int64_t delta;
     do {
 	delta = 0;
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    if (GD_rank(g)[r].candidate) {
+	    if (ranks(g)[r].candidate) {
 		delta += transpose_step(g, r, reverse);
 	    }
 	}
@@ -755,14 +885,14 @@ static void restore_best(graph_t * g)
     int i, r;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < ranks(g)[r].n; i++) {
+	    n = ranks(g)[r].v[i];
 	    ND_order(n) = saveorder(n);
 	}
     }
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	GD_rank(Root)[r].valid = false;
-	qsort(GD_rank(g)[r].v, GD_rank(g)[r].n, sizeof(GD_rank(g)[0].v[0]),
+	ranks(Root)[r].valid = false;
+	qsort(ranks(g)[r].v, ranks(g)[r].n, sizeof(ranks(g)[0].v[0]),
 	      nodeposcmpf);
     }
 }
@@ -772,8 +902,8 @@ static void save_best(graph_t * g)
     node_t *n;
     int i, r;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < ranks(g)[r].n; i++) {
+	    n = ranks(g)[r].v[i];
 	    saveorder(n) = ND_order(n);
 	}
     }
@@ -1074,7 +1204,7 @@ static void flat_search(graph_t * g, node_t * v)
     int i;
     bool hascl;
     edge_t *e;
-    adjmatrix_t *M = GD_rank(g)[ND_rank(v)].flat;
+    adjmatrix_t *M = ranks(g)[ND_rank(v)].flat;
 
     ND_mark(v) = true;
     ND_onstack(v) = true;
@@ -1108,20 +1238,20 @@ static void flat_breakcycles(graph_t * g)
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	bool flat = false;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < ranks(g)[r].n; i++) {
+	    v = ranks(g)[r].v[i];
 	    ND_mark(v) = false;
 	    ND_onstack(v) = false;
 	    ND_low(v) = i;
 	    if (ND_flat_out(v).size > 0 && !flat) {
-		GD_rank(g)[r].flat =
-		    new_matrix((size_t)GD_rank(g)[r].n, (size_t)GD_rank(g)[r].n);
+		ranks(g)[r].flat =
+		    new_matrix((size_t)ranks(g)[r].n, (size_t)ranks(g)[r].n);
 		flat = true;
 	    }
 	}
 	if (flat) {
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < ranks(g)[r].n; i++) {
+		v = ranks(g)[r].v[i];
 		if (!ND_mark(v))
 		    flat_search(g, v);
 	    }
@@ -1164,30 +1294,30 @@ int install_in_rank(graph_t *g, node_t *n) {
     int i, r;
 
     r = ND_rank(n);
-    i = GD_rank(g)[r].n;
-    if (GD_rank(g)[r].an <= 0) {
+    i = ranks(g)[r].n;
+    if (ranks(g)[r].an <= 0) {
 	agerrorf("install_in_rank, line %d: %s %s rank %d i = %d an = 0\n",
 	      __LINE__, agnameof(g), agnameof(n), r, i);
 	return -1;
     }
 
-    GD_rank(g)[r].v[i] = n;
+    ranks(g)[r].v[i] = n;
     ND_order(n) = i;
-    GD_rank(g)[r].n++;
-    assert(GD_rank(g)[r].n <= GD_rank(g)[r].an);
+    ranks(g)[r].n++;
+    assert(ranks(g)[r].n <= ranks(g)[r].an);
 #ifdef DEBUG
     {
 	node_t *v;
 
-	for (v = GD_nlist(g); v; v = ND_next(v))
+	for (v = nlist(g); v; v = ND_next(v))
 	    if (v == n)
 		break;
 	assert(v != NULL);
     }
 #endif
-    if (ND_order(n) > GD_rank(Root)[r].an) {
+    if (ND_order(n) > ranks(Root)[r].an) {
 	agerrorf("install_in_rank, line %d: ND_order(%s) [%d] > GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, agnameof(n), ND_order(n), r, GD_rank(Root)[r].an);
+	      __LINE__, agnameof(n), ND_order(n), r, ranks(Root)[r].an);
 	return -1;
     }
     if (r < GD_minrank(g) || r > GD_maxrank(g)) {
@@ -1195,10 +1325,10 @@ int install_in_rank(graph_t *g, node_t *n) {
 	      __LINE__, r, GD_minrank(g), GD_maxrank(g));
 	return -1;
     }
-    if (GD_rank(g)[r].v + ND_order(n) >
-	GD_rank(g)[r].av + GD_rank(Root)[r].an) {
+    if (ranks(g)[r].v + ND_order(n) >
+	ranks(g)[r].av + ranks(Root)[r].an) {
 	agerrorf("install_in_rank, line %d: GD_rank(g)[%d].v + ND_order(%s) [%d] > GD_rank(g)[%d].av + GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, r, agnameof(n),ND_order(n), r, r, GD_rank(Root)[r].an);
+	      __LINE__, r, agnameof(n),ND_order(n), r, r, ranks(Root)[r].an);
 	return -1;
     }
     return 0;
@@ -1213,13 +1343,13 @@ int build_ranks(graph_t *g, int pass) {
     node_t *n, *ns;
     edge_t **otheredges;
     node_queue_t q = {0};
-    for (n = GD_nlist(g); n; n = ND_next(n))
+    for (n = nlist(g); n; n = ND_next(n))
 	MARK(n) = false;
 
 #ifdef DEBUG
     {
 	edge_t *e;
-	for (n = GD_nlist(g); n; n = ND_next(n)) {
+	for (n = nlist(g); n; n = ND_next(n)) {
 	    for (i = 0; (e = ND_out(n).list[i]); i++)
 		assert(!MARK(aghead(e)));
 	    for (i = 0; (e = ND_in(n).list[i]); i++)
@@ -1229,17 +1359,17 @@ int build_ranks(graph_t *g, int pass) {
 #endif
 
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
-	GD_rank(g)[i].n = 0;
+	ranks(g)[i].n = 0;
 
     const bool walkbackwards = g != agroot(g); // if this is a cluster, need to
                                                // walk GD_nlist backward to
                                                // preserve input node order
     if (walkbackwards) {
-	for (ns = GD_nlist(g); ND_next(ns); ns = ND_next(ns)) {
+	for (ns = nlist(g); ND_next(ns); ns = ND_next(ns)) {
 	    ;
 	}
     } else {
-	ns = GD_nlist(g);
+	ns = nlist(g);
     }
     for (n = ns; n; n = walkbackwards ? ND_prev(n) : ND_next(n)) {
 	otheredges = pass == 0 ? ND_in(n).list : ND_out(n).list;
@@ -1268,10 +1398,10 @@ int build_ranks(graph_t *g, int pass) {
     }
     assert(LIST_IS_EMPTY(&q));
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++) {
-	GD_rank(Root)[i].valid = false;
-	if (GD_flip(g) && GD_rank(g)[i].n > 0) {
-	    node_t **vlist = GD_rank(g)[i].v;
-	    int num_nodes_1 = GD_rank(g)[i].n - 1;
+	ranks(Root)[i].valid = false;
+	if (GD_flip(g) && ranks(g)[i].n > 0) {
+	    node_t **vlist = ranks(g)[i].v;
+	    int num_nodes_1 = ranks(g)[i].n - 1;
 	    int half_num_nodes_1 = num_nodes_1 / 2;
 	    for (j = 0; j <= half_num_nodes_1; j++)
 		exchange(vlist[j], vlist[num_nodes_1 - j]);
@@ -1345,16 +1475,16 @@ static void flat_reorder(graph_t * g)
     if (!GD_has_flat_edges(g))
 	return;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].n == 0) continue;
-	base_order = ND_order(GD_rank(g)[r].v[0]);
-	for (i = 0; i < GD_rank(g)[r].n; i++)
-	    MARK(GD_rank(g)[r].v[i]) = false;
+	if (ranks(g)[r].n == 0) continue;
+	base_order = ND_order(ranks(g)[r].v[0]);
+	for (i = 0; i < ranks(g)[r].n; i++)
+	    MARK(ranks(g)[r].v[i]) = false;
 	LIST_CLEAR(&temprank);
 
 	/* construct reverse topological sort order in temprank */
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    if (GD_flip(g)) v = GD_rank(g)[r].v[i];
-	    else v = GD_rank(g)[r].v[GD_rank(g)[r].n - i - 1];
+	for (i = 0; i < ranks(g)[r].n; i++) {
+	    if (GD_flip(g)) v = ranks(g)[r].v[i];
+	    else v = ranks(g)[r].v[ranks(g)[r].n - i - 1];
 
 	    local_in_cnt = local_out_cnt = 0;
 	    for (size_t j = 0; j < ND_flat_in(v).size; j++) {
@@ -1378,14 +1508,14 @@ static void flat_reorder(graph_t * g)
 	    if (!GD_flip(g)) {
 		LIST_REVERSE(&temprank);
 	    }
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i] = LIST_GET(&temprank, (size_t)i);
+	    for (i = 0; i < ranks(g)[r].n; i++) {
+		v = ranks(g)[r].v[i] = LIST_GET(&temprank, (size_t)i);
 		ND_order(v) = i + base_order;
 	    }
 
 	    /* nonconstraint flat edges must be made LR */
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < ranks(g)[r].n; i++) {
+		v = ranks(g)[r].v[i];
 		if (ND_flat_out(v).list) {
 		    for (size_t j = 0; (e = ND_flat_out(v).list[j]); j++) {
 			if ((!GD_flip(g) && ND_order(aghead(e)) < ND_order(agtail(e))) ||
@@ -1401,7 +1531,7 @@ static void flat_reorder(graph_t * g)
 	    /* postprocess to restore intended order */
 	}
 	/* else do no harm! */
-	GD_rank(Root)[r].valid = false;
+	ranks(Root)[r].valid = false;
     }
     LIST_FREE(&temprank);
 }
@@ -1409,10 +1539,10 @@ static void flat_reorder(graph_t * g)
 static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
 {
     int changed = 0, nelt;
-    node_t **vlist = GD_rank(g)[r].v;
-    node_t **lp, **rp, **ep = vlist + GD_rank(g)[r].n;
+    node_t **vlist = ranks(g)[r].v;
+    node_t **lp, **rp, **ep = vlist + ranks(g)[r].n;
 
-    for (nelt = GD_rank(g)[r].n - 1; nelt >= 0; nelt--) {
+    for (nelt = ranks(g)[r].n - 1; nelt >= 0; nelt--) {
 	lp = vlist;
 	while (lp < ep) {
 	    /* find leftmost node that can be compared */
@@ -1452,9 +1582,9 @@ static void reorder(graph_t * g, int r, bool reverse, bool hasfixed)
     }
 
     if (changed) {
-	GD_rank(Root)[r].valid = false;
+	ranks(Root)[r].valid = false;
 	if (r > 0)
-	    GD_rank(Root)[r - 1].valid = false;
+	    ranks(Root)[r - 1].valid = false;
     }
 }
 
@@ -1508,57 +1638,124 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
+/// add a weight at a 1-based position of a Fenwick tree of `size` positions
+static void accumulate(int64_t *tree, int size, int pos, int64_t weight) {
+    for (; pos <= size; pos += pos & -pos)
+	tree[pos] += weight;
+}
+
+/// total weight at 1-based positions `[1, pos]` of a Fenwick tree
+static int64_t accumulated(const int64_t *tree, int pos) {
+    int64_t sum = 0;
+    for (; pos > 0; pos -= pos & -pos)
+	sum += tree[pos];
+    return sum;
+}
+
+/* Count the crossings between ranks r and r+1. The top rank is swept left
+ * to right, keeping the penalties of the edges seen so far in an accumulator
+ * tree (Barth, Jünger and Mutzel) indexed by head position. Each edge crosses
+ * the earlier edges whose heads lie to its right, so it costs one query and
+ * one update, making this O(|E| log |V|) rather than O(|E| width). The edges
+ * of a node do not cross each other this way, so they are all queried before
+ * any of them is added.
+ */
 static int64_t rcross(graph_t *g, int r) {
-    int top, bot, max, i, k;
+    int top, bot, i;
     node_t **rtop, *v;
 
     int64_t cross = 0;
-    max = 0;
-    rtop = GD_rank(g)[r].v;
+    rtop = ranks(g)[r].v;
 
-    int *Count = gv_calloc(GD_rank(Root)[r + 1].n + 1, sizeof(int));
+    const int size = ranks(g)[r + 1].n + 1;
+    int64_t *tree = gv_calloc((size_t)size + 1, sizeof(int64_t));
+    int64_t total = 0;
 
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
+    for (top = 0; top < ranks(g)[r].n; top++) {
 	edge_t *e;
-	if (max > 0) {
+	if (total > 0) {
 	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
+		const int64_t right =
+		    total - accumulated(tree, ND_order(aghead(e)) + 1);
+		cross += right * ED_xpenalty(e);
 	    }
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    accumulate(tree, size, ND_order(aghead(e)) + 1, ED_xpenalty(e));
+	    total += ED_xpenalty(e);
 	}
     }
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	v = GD_rank(g)[r].v[top];
+    for (top = 0; top < ranks(g)[r].n; top++) {
+	v = ranks(g)[r].v[top];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_out(v), 1);
     }
-    for (bot = 0; bot < GD_rank(g)[r + 1].n; bot++) {
-	v = GD_rank(g)[r + 1].v[bot];
+    for (bot = 0; bot < ranks(g)[r + 1].n; bot++) {
+	v = ranks(g)[r + 1].v[bot];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_in(v), -1);
     }
-    free(Count);
+    free(tree);
     return cross;
 }
 
+/// ranks of the root graph whose crossings are being recounted
+typedef struct {
+    graph_t *root;
+    int *invalid;
+} recount_t;
+
+/// recount the crossings below the listed ranks `[start, end)`, for
+/// `gv_pool_for`
+static void recount_ranks(void *context, size_t start, size_t end,
+                          size_t worker) {
+    (void)worker;
+    const recount_t *const rc = context;
+    for (size_t i = start; i < end; i++) {
+	const int r = rc->invalid[i];
+	GD_rank(rc->root)[r].cache_nc = rcross(rc->root, r);
+	GD_rank(rc->root)[r].valid = true;
+    }
+}
+
+/* Recount the crossings below each invalid rank of the root concurrently,
+ * when there are enough of them to be worth waking the pool. Each rank's
+ * count only reads the orders of its own nodes and those of the next rank.
+ */
+static void recount_invalid(graph_t *g) {
+    enum { MIN_NODES = 2000 };
+
+    if (Pool == NULL || Comp != NULL)
+	return;
+    int *const invalid = gv_calloc(GD_maxrank(g) - GD_minrank(g) + 1,
+                                   sizeof(int));
+    size_t ninvalid = 0;
+    int nodes = 0;
+    for (int r = GD_minrank(g); r < GD_maxrank(g); r++) {
+	if (!GD_rank(g)[r].valid) {
+	    invalid[ninvalid++] = r;
+	    nodes += GD_rank(g)[r].n + GD_rank(g)[r + 1].n;
+	}
+    }
+    if (ninvalid > 1 && nodes >= MIN_NODES)
+	gv_pool_for(Pool, ninvalid, 1, recount_ranks,
+	            &(recount_t){.root = g, .invalid = invalid});
+    free(invalid);
+}
+
 static int64_t ncross(void) {
     int r;
 
     graph_t *g = Root;
     int64_t count = 0;
+    recount_invalid(g);
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].valid)
-	    count += GD_rank(g)[r].cache_nc;
+	if (ranks(g)[r].valid)
+	    count += ranks(g)[r].cache_nc;
 	else {
-	    const int64_t nc = GD_rank(g)[r].cache_nc = rcross(g, r);
+	    const int64_t nc = ranks(g)[r].cache_nc = rcross(g, r);
 	    count += nc;
-	    GD_rank(g)[r].valid = true;
+	    ranks(g)[r].valid = true;
 	}
     }
     return count;
@@ -1625,8 +1822,8 @@ static bool medians(graph_t * g, int r0, int r1)
     bool hasfixed = false;
 
     list = TI_list;
-    v = GD_rank(g)[r0].v;
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    v = ranks(g)[r0].v;
+    for (i = 0; i < ranks(g)[r0].n; i++) {
 	n = v[i];
 	size_t j = 0;
 	if (r1 > r0)
@@ -1667,7 +1864,7 @@ static bool medians(graph_t * g, int r0, int r1)
 	    }
 	}
     }
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    for (i = 0; i < ranks(g)[r0].n; i++) {
 	n = v[i];
 	if (ND_out(n).size == 0 && ND_in(n).size == 0)
 	    hasfixed |= flat_mval(n);
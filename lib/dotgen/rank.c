@@ -727,7 +727,7 @@ static bool is_internal_to_cluster(edge_t * e)
     return false;
 }
 
-static node_t* Last_node;
+static _Thread_local node_t* Last_node;
 static node_t* makeXnode (graph_t* G, char* name)
 {
     node_t *n = agnode(G, name, 1);
@@ -783,7 +783,7 @@ static void weak(graph_t * g, node_t * t, node_t * h, edge_t * orig)
 {
     node_t *v;
     edge_t *e, *f;
-    static int id;
+    static _Thread_local int id;
     char buf[100];
 
     for (e = agfstin(g, t); e; e = agnxtin(g, e)) {
@@ -105,7 +105,7 @@ struct fdpParms_s {
 typedef struct fdpParms_s fdpParms_t;
 
     extern void fdp_layout(Agraph_t * g);
-    extern void fdp_init_node_edge(Agraph_t * g);
+    extern void fdp_init_node_edge(Agraph_t * g, double K);
     extern void fdp_cleanup(Agraph_t * g);
 
 #ifdef __cplusplus
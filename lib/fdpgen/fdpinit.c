@@ -69,11 +69,11 @@ static void initialPositions(graph_t * g)
 
 /* init_edge:
  */
-static void init_edge(edge_t * e, attrsym_t * E_len)
+static void init_edge(edge_t * e, attrsym_t * E_len, double K)
 {
     agbindrec(e, "Agedgeinfo_t", sizeof(Agedgeinfo_t), true);	//node custom data
     ED_factor(e) = late_double(e, E_weight, 1.0, 0.0);
-    ED_dist(e) = late_double(e, E_len, fdp_parms->K, 0.0);
+    ED_dist(e) = late_double(e, E_len, K, 0.0);
 
     common_init_edge(e);
 }
@@ -85,7 +85,7 @@ static void init_node(node_t * n)
     gv_nodesize(n, GD_flip(agraphof(n)));
 }
 
-void fdp_init_node_edge(graph_t * g)
+void fdp_init_node_edge(graph_t * g, double K)
 {
     attrsym_t *E_len;
     node_t *n;
@@ -111,7 +111,7 @@ void fdp_init_node_edge(graph_t * g)
     E_len = agattr_text(g,AGEDGE, "len", NULL);
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    init_edge(e, E_len);
+	    init_edge(e, E_len, K);
 	}
     }
     initialPositions(g);
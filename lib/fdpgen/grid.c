@@ -106,7 +106,7 @@ static int ijcmpf(void *point1, void *point2) {
     return 0;
 }
 
-static Grid _grid; // hack because can't attach info. to Dt_t
+static _Thread_local Grid _grid; // hack because can't attach info. to Dt_t
 
 /* Allocate a new cell from free store and initialize its indices
  * This is used by the grid discipline to create cells.
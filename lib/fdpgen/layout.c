@@ -463,7 +463,7 @@ static graph_t *deriveGraph(graph_t * g, layout_info * infop)
 	    hd = DNODE(aghead(e));
 	    if (hd == tl)
 		continue;
-	    if (hd > tl)
+	    if (AGSEQ(hd) > AGSEQ(tl))
 		de = agedge(dg, tl, hd, NULL,1);
 	    else
 		de = agedge(dg, hd, tl, NULL,1);
@@ -498,7 +498,7 @@ static graph_t *deriveGraph(graph_t * g, layout_info * infop)
 		dn = mkDeriveNode(dg, portName(g, pp, &portname));
 		sz++;
 		ND_id(dn) = id++;
-		if (dn > m)
+		if (AGSEQ(dn) > AGSEQ(m))
 		    de = agedge(dg, m, dn, NULL,1);
 		else
 		    de = agedge(dg, dn, m, NULL,1);
@@ -606,7 +606,7 @@ static erec *getEdgeList(node_t * n, graph_t * g)
 /* Given list of edges with node n in derived graph, add corresponding
  * ports to port list pp, starting at index idx. Return next index.
  * If an edge in the derived graph corresponds to multiple real edges,
- * add them in order if address of n is smaller than other node address.
+ * add them in order if n was created before the other node.
  * Otherwise, reverse order.
  * Attach angles. The value bnd gives next angle after er->alpha.
  */
@@ -631,7 +631,7 @@ genPorts(node_t * n, erec * er, bport_t * pp, int idx, double bnd)
     delta = fmin((bnd - er->alpha) / cnt, ANG);
     angle = er->alpha;
 
-    if (n < other) {
+    if (AGSEQ(n) < AGSEQ(other)) {
 	i = idx;
 	inc = 1;
     } else {
@@ -1007,8 +1007,8 @@ static void fdp_init_graph(Agraph_t * g)
     Ndim = GD_ndim(agroot(g)) = MIN(GD_ndim(agroot(g)), MAXDIM);
 
     mkClusters (g, NULL, g);
-    fdp_initParams(g);
-    fdp_init_node_edge(g);
+    const double K = fdp_initParams(g);
+    fdp_init_node_edge(g, K);
 }
 
 static int fdpLayout(graph_t * g)
@@ -36,12 +36,10 @@
 #include <sys/types.h>
 #include <time.h>
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
 
 #include <common/globals.h>
 #include <fdpgen/tlayout.h>
+#include <util/random.h>
 
 #define D_useGrid (fdp_parms->useGrid)
 #define D_useNew (fdp_parms->useNew)
@@ -49,7 +47,6 @@
 #define D_unscaled (fdp_parms->unscaled)
 #define D_C (fdp_parms->C)
 #define D_Tfact (fdp_parms->Tfact)
-#define D_K (fdp_parms->K)
 #define D_T0 (fdp_parms->T0)
 
 /* Actual parameters used; initialized using fdp_parms, then possibly
@@ -74,7 +71,7 @@ typedef struct {
   int loopcnt;  /* actual iterations in this pass */
 } parms_t;
 
-static parms_t parms;
+static _Thread_local parms_t parms;
 
 #define T_useGrid (parms.useGrid)
 #define T_useNew (parms.useNew)
@@ -150,7 +147,9 @@ static bool init_params(graph_t *g, xparams *xpms) {
 }
 
 /// initialize parameters based on root graph attributes
-void fdp_initParams(graph_t *g) {
+///
+/// @return The spring constant of `g`
+double fdp_initParams(graph_t *g) {
   T_useGrid = D_useGrid;
   T_useNew = D_useNew;
   T_numIters = D_numIters;
@@ -160,7 +159,7 @@ void fdp_initParams(graph_t *g) {
   T_Tfact = D_Tfact;
   T_maxIters =
       late_int(g, agattr_text(g, AGRAPH, "maxiter", NULL), DFLT_maxIters, 0);
-  D_K = T_K = late_double(g, agattr_text(g, AGRAPH, "K", NULL), DFLT_K, 0.0);
+  T_K = late_double(g, agattr_text(g, AGRAPH, "K", NULL), DFLT_K, 0.0);
   if (D_T0 == -1.0) {
     T_T0 = late_double(g, agattr_text(g, AGRAPH, "T0", NULL), -1.0, 0.0);
   } else
@@ -185,6 +184,7 @@ void fdp_initParams(graph_t *g) {
             agnameof(g), T_K, T_T0, T_Tfact, T_maxIters, T_unscaled);
   }
 #endif
+  return T_K;
 }
 
 static void doRep(node_t *p, node_t *q, double xdelta, double ydelta,
@@ -193,8 +193,8 @@ static void doRep(node_t *p, node_t *q, double xdelta, double ydelta,
   double dist;
 
   while (dist2 == 0.0) {
-    xdelta = 5 - rand() % 10;
-    ydelta = 5 - rand() % 10;
+    xdelta = 5 - gv_rand() % 10;
+    ydelta = 5 - gv_rand() % 10;
     dist2 = xdelta * xdelta + ydelta * ydelta;
   }
   if (T_useNew) {
@@ -294,8 +294,8 @@ static void applyAttr(Agnode_t *p, Agnode_t *q, Agedge_t *e) {
   ydelta = ND_pos(q)[1] - ND_pos(p)[1];
   dist2 = xdelta * xdelta + ydelta * ydelta;
   while (dist2 == 0.0) {
-    xdelta = 5 - rand() % 10;
-    ydelta = 5 - rand() % 10;
+    xdelta = 5 - gv_rand() % 10;
+    ydelta = 5 - gv_rand() % 10;
     dist2 = xdelta * xdelta + ydelta * ydelta;
   }
   dist = sqrt(dist2);
@@ -485,7 +485,7 @@ static pointf initPositions(graph_t *g, bport_t *pp) {
   else {
     local_seed = (long)time(NULL);
   }
-  srand48(local_seed);
+  gv_srand48(local_seed);
 
   /* If ports, place ports on and nodes within an ellipse centered at origin
    * with halfwidth Wd and halfheight Ht.
@@ -537,8 +537,8 @@ static pointf initPositions(graph_t *g, bport_t *pp) {
           ND_pos(np)[0] = 0.98 * p.x + 0.1 * ctr.x;
           ND_pos(np)[1] = 0.9 * p.y + 0.1 * ctr.y;
         } else {
-          double angle = PItimes2 * drand48();
-          double radius = 0.9 * drand48();
+          double angle = PItimes2 * gv_drand48();
+          double radius = 0.9 * gv_drand48();
           ND_pos(np)[0] = radius * T_Wd * cos(angle);
           ND_pos(np)[1] = radius * T_Ht * sin(angle);
         }
@@ -552,14 +552,14 @@ static pointf initPositions(graph_t *g, bport_t *pp) {
           ND_pos(np)[0] -= ctr.x;
           ND_pos(np)[1] -= ctr.y;
         } else {
-          ND_pos(np)[0] = T_Wd * (2.0 * drand48() - 1.0);
-          ND_pos(np)[1] = T_Ht * (2.0 * drand48() - 1.0);
+          ND_pos(np)[0] = T_Wd * (2.0 * gv_drand48() - 1.0);
+          ND_pos(np)[1] = T_Ht * (2.0 * gv_drand48() - 1.0);
         }
       }
     } else { /* No ports or positions; place randomly */
       for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
-        ND_pos(np)[0] = T_Wd * (2.0 * drand48() - 1.0);
-        ND_pos(np)[1] = T_Ht * (2.0 * drand48() - 1.0);
+        ND_pos(np)[0] = T_Wd * (2.0 * gv_drand48() - 1.0);
+        ND_pos(np)[1] = T_Ht * (2.0 * gv_drand48() - 1.0);
       }
     }
   }
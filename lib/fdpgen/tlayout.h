@@ -17,7 +17,7 @@ extern "C" {
 #include <fdpgen/fdp.h>
 #include <fdpgen/xlayout.h>
 
-    extern void fdp_initParams(graph_t *);
+    extern double fdp_initParams(graph_t *);
     extern void fdp_tLayout(graph_t *, xparams *);
 
 #ifdef __cplusplus
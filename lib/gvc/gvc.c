@@ -20,12 +20,25 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* default_label:
+ * Make node labels default to the node name.
+ * Graphs being read in other threads copy these defaults, so only change them
+ * when needed.
+ */
+static void default_label(void)
+{
+    Agsym_t *const label = agattr_text(NULL, AGNODE, "label", NULL);
+    if (label == NULL || strcmp(label->defval, NODENAME_ESC) != 0)
+	agattr_text(NULL, AGNODE, "label", NODENAME_ESC);
+}
 
 GVC_t *gvContext(void)
 {
     GVC_t *gvc;
 
-    agattr_text(NULL, AGNODE, "label", NODENAME_ESC);
+    default_label();
     /* default to no builtins, demand loading enabled */
     gvc = gvNEWcontext(NULL, true);
     gvconfig(gvc, false); /* configure for available plugins */
@@ -36,7 +49,7 @@ GVC_t *gvContextPlugins(const lt_symlist_t *builtins, int demand_loading)
 {
     GVC_t *gvc;
 
-    agattr_text(NULL, AGNODE, "label", NODENAME_ESC);
+    default_label();
     gvc = gvNEWcontext(builtins, demand_loading);
     gvconfig(gvc, false); /* configure for available plugins */
     return gvc;
@@ -216,6 +229,110 @@ int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result,
     return rc;
 }
 
+/* Render layout in a specified format, passing the output to a callback in
+ * chunks as it is produced rather than gathering all of it in memory */
+int gvRenderChunks(GVC_t *gvc, graph_t *g, const char *format,
+                   size_t (*chunk)(void *context, const char *data,
+                                   size_t length),
+                   void *context) {
+    int rc;
+    GVJ_t *job;
+
+    if (!chunk) {
+	agerrorf("no callback for output\n");
+	return -1;
+    }
+
+    /* create a job for the required format */
+    bool r = gvjobs_output_langname(gvc, format);
+    job = gvc->job;
+    if (!r) {
+	agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
+                format, gvplugin_list(gvc, API_device, format));
+	return -1;
+    }
+
+    job->output_lang = gvrender_select(job, job->output_langname);
+    if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
+	agerrorf( "Layout was not done\n");
+	return -1;
+    }
+
+    job->output_chunk = chunk;
+    job->output_chunk_context = context;
+
+    rc = gvRenderJobs(gvc, g);
+    gvrender_end_job(job);
+    if (rc == 0 && job->output_chunk_failed)
+	rc = -1;
+    gvjobs_delete(gvc);
+
+    return rc;
+}
+
+/* Render layout in several formats, each to a malloc'ed string */
+int gvRenderDataFormats(GVC_t *gvc, graph_t *g, const char **formats,
+                        size_t n, char **results, size_t *lengths) {
+    int rc;
+    GVJ_t *job;
+
+    if (!results || !lengths) {
+	agerrorf("no place for results\n");
+	return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+	results[i] = NULL;
+	lengths[i] = 0;
+    }
+
+    /* create a job for each required format */
+    for (size_t i = 0; i < n; ++i) {
+	bool r = gvjobs_output_langname(gvc, formats[i]);
+	job = gvc->output_langname_job;
+	if (!r) {
+	    agerrorf("Format: \"%s\" not recognized. Use one of:%s\n",
+                    formats[i], gvplugin_list(gvc, API_device, formats[i]));
+	    gvjobs_delete(gvc);
+	    return -1;
+	}
+
+	job->output_lang = gvrender_select(job, job->output_langname);
+	if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
+	    agerrorf( "Layout was not done\n");
+	    gvjobs_delete(gvc);
+	    return -1;
+	}
+
+	if (!(job->output_data = malloc(OUTPUT_DATA_INITIAL_ALLOCATION))) {
+	    agerrorf("failure malloc'ing for result string");
+	    for (job = gvc->jobs; job; job = job->next)
+		free(job->output_data);
+	    gvjobs_delete(gvc);
+	    return -1;
+	}
+	job->output_data_allocated = OUTPUT_DATA_INITIAL_ALLOCATION;
+	job->output_data_position = 0;
+    }
+
+    /* jobs are ended as the next one starts, except for the last */
+    rc = gvRenderJobs(gvc, g);
+    if (gvc->active_jobs)
+	gvrender_end_job(gvc->active_jobs);
+
+    size_t i = 0;
+    for (job = gvc->jobs; job && i < n; job = job->next, ++i) {
+	if (rc == 0) {
+	    results[i] = job->output_data;
+	    lengths[i] = job->output_data_position;
+	} else {
+	    free(job->output_data);
+	}
+    }
+    gvjobs_delete(gvc);
+
+    return rc;
+}
+
 /* gvFreeRenderData:
  * Utility routine to free memory allocated in gvRenderData, as the application code may use
  * a different runtime library.
@@ -98,6 +98,21 @@ GVC_API int gvRenderContext(GVC_t *gvc, graph_t *g, const char *format, void *co
 GVC_API int gvRenderData(GVC_t *gvc, graph_t *g, const char *format,
                          char **result, size_t *length);
 
+/* Render layout in a specified format, passing the output to chunk as it is
+ * produced instead of holding all of it in memory. SVG output arrives in
+ * large chunks. If chunk consumes less than length, the rest of the output is
+ * dropped and -1 is returned. */
+GVC_API int gvRenderChunks(GVC_t *gvc, graph_t *g, const char *format,
+                           size_t (*chunk)(void *context, const char *data,
+                                           size_t length),
+                           void *context);
+
+/* Render layout in each of n formats to malloc'ed strings, in one pass if
+ * the graph's "threads" attribute allows emitting the formats concurrently.
+ * Free each of results[0..n-1] with gvFreeRenderData. */
+GVC_API int gvRenderDataFormats(GVC_t *gvc, graph_t *g, const char **formats,
+                                size_t n, char **results, size_t *lengths);
+
 /* Free memory allocated and pointed to by *result in gvRenderData */
 GVC_API void gvFreeRenderData (char* data);
 
@@ -106,6 +106,12 @@ extern "C" {
 	/* fonts and textlayout */
 	Dtdisc_t textfont_disc;
 	Dt_t *textfont_dt;
+	Dtdisc_t textspan_disc;
+	Dt_t *textspan_dt;	/* remembered text measurements, by font and string */
+	gvtextlayout_engine_t *textspan_engine; /* engine that made them */
+	char *textspan_cache_id; /* identifies the engine in the on-disk cache */
+	size_t textspan_bytes; /* approximate memory used by textspan_dt */
+	size_t textspan_hits, textspan_misses;
 	gvplugin_active_textlayout_t textlayout; /* always use best avail for all jobs */
 //	void (*free_layout) (void *layout);   /* function for freeing layouts (mostly used by pango) */
 	
@@ -114,6 +120,8 @@ extern "C" {
 	/* gvrender_config() */
 	GVJ_t *jobs;	/* linked list of jobs */
 	GVJ_t *job;	/* current job */
+	GVJ_t *output_filename_job; /* job given the latest -o */
+	GVJ_t *output_langname_job; /* job given the latest -T */
 
 	graph_t *g;      /* current graph */
 
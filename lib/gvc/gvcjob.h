@@ -57,12 +57,15 @@ extern "C" {
  GVDEVICE_BINARY_FORMAT		Suppresses \r\n substitution for linends 
  GVDEVICE_COMPRESSED_FORMAT	controls libz compression		
  GVDEVICE_NO_WRITER		used when gvdevice is not used because device uses its own writer, devil outputs   (FIXME seems to overlap OUTPUT_NOT_REQUIRED)
+ GVDEVICE_BUFFERED		output is gathered in a large buffer and written in chunks -Tsvg
 
  GVRENDER_Y_GOES_DOWN		device origin top left, y goes down, otherwise
   				device origin lower left, y goes up	
  GVRENDER_DOES_TRANSFORM	device uses scale, translate, rotate to do its own
  				coordinate transformations, otherwise coordinates 
   				are pre-transformed			
+ GVRENDER_CONCURRENT		renderer keeps no state across jobs, so several jobs for
+				one graph can be emitted at once -Tsvg, -Tcmapx
  GVRENDER_DOES_LABELS		basically, maps don't need labels	
  GVRENDER_DOES_MAPS		renderer encodes mapping information for mouse events -Tcmapx -Tsvg 
  GVRENDER_DOES_MAP_RECTANGLE	supports a 2 coord rectngle optimization 
@@ -93,6 +96,7 @@ extern "C" {
 #define GVDEVICE_NO_WRITER (1<<11)
 #define GVRENDER_Y_GOES_DOWN (1<<12)
 #define GVRENDER_DOES_TRANSFORM (1<<13)
+#define GVRENDER_CONCURRENT (1<<14)
 #define GVRENDER_DOES_LABELS (1<<15)
 #define GVRENDER_DOES_MAPS (1<<16)
 #define GVRENDER_DOES_MAP_RECTANGLE (1<<17)
@@ -106,6 +110,7 @@ extern "C" {
 #define GVRENDER_NO_WHITE_BG (1<<25)
 #define LAYOUT_NOT_REQUIRED (1<<26)
 #define OUTPUT_NOT_REQUIRED (1<<27)
+#define GVDEVICE_BUFFERED (1<<28)
 
     typedef struct {
 	int flags;
@@ -278,6 +283,7 @@ extern "C" {
 	char *output_data;
 	size_t output_data_allocated;
 	size_t output_data_position;
+	void *compression; ///< state of a compressed output format, see gvdevice.c
 
 	const char *output_langname;
 	int output_lang;
@@ -356,6 +362,15 @@ extern "C" {
 	gvevent_key_binding_t *keybindings;
 	size_t numkeys;
 	void *keycodes;
+
+	int *drawn;		/* view each node, by AGSEQ, was last drawn in */
+
+	char *output_buffer;	/* output not yet written, see GVDEVICE_BUFFERED */
+	size_t output_buffer_length;
+	/* receives the output of gvRenderChunks */
+	size_t (*output_chunk)(void *context, const char *data, size_t length);
+	void *output_chunk_context;
+	bool output_chunk_failed;	/* has output_chunk refused output? */
     };
 
 #ifdef __cplusplus
@@ -290,9 +290,9 @@ static int line_callback(struct dl_phdr_info *info, size_t size, void *line)
 
 char * gvconfig_libdir(GVC_t * gvc)
 {
-    static char line[BSZ];
-    static char *libdir;
-    static bool dirShown = false;
+    static _Thread_local char line[BSZ];
+    static _Thread_local char *libdir;
+    static _Thread_local bool dirShown = false;
 
     if (!libdir) {
         libdir=getenv("GVBINDIR");
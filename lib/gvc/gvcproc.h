@@ -63,6 +63,8 @@ gvplugin_available_t *gvplugin_load(GVC_t *gvc, api_t api, const char *type,
     point gvusershape_size_dpi(usershape_t *us, pointf dpi);
     point gvusershape_size(graph_t *g, char *name);
     usershape_t *gvusershape_find(const char *name);
+    Dict_t *gvusershape_images(void);
+    Dict_t *gvusershape_adopt_images(Dict_t *images);
 
 /* device */
     int gvdevice_initialize(GVJ_t * job);
@@ -15,16 +15,20 @@
 #include "config.h"
 
 #include <ctype.h>
+#include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <unistd.h>
 #include <util/gv_fopen.h>
+#include <util/parallel.h>
 #include <util/prisize_t.h>
 #include <util/xml.h>
 
@@ -33,6 +37,9 @@
 #include <io.h>
 #endif
 
+/// output gathered by `GVDEVICE_BUFFERED` devices before writing it
+enum { GVDEVICE_BUFFER_SIZE = 64 * 1024 };
+
 #ifdef HAVE_LIBZ
 #include <zlib.h>
 
@@ -42,10 +49,52 @@
 static const unsigned char z_file_header[] =
    {0x1f, 0x8b, /*magic*/ Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/, OS_CODE};
 
-static z_stream z_strm;
-static unsigned char *df;
-static unsigned int dfallocated;
-static uint64_t crc;
+/// input gathered before each call to `deflate`, and the size of the blocks
+/// compressed independently when compressing on several threads
+enum { DEFLATE_BLOCK = 128 * 1024 };
+
+/// blocks gathered per thread before compressing them together
+enum { DEFLATE_BATCH = 2 };
+
+/// how far back deflate looks for matches
+enum { DEFLATE_WINDOW = 1 << MAX_WBITS };
+
+/// a block of input compressed on its own
+typedef struct {
+    unsigned char *out; ///< deflated block
+    size_t size;        ///< bytes used in `out`
+    size_t length;      ///< bytes of input
+    uLong crc;          ///< CRC-32 of the input
+    bool ok;            ///< did deflating succeed?
+} gvdevice_zblock_t;
+
+/// deflate state of a job writing a compressed format
+///
+/// Input is gathered in `in` and deflated a buffer at a time. With one thread,
+/// it goes through a single deflate stream, `z_strm`. With more, `in` holds a
+/// batch of blocks that are deflated concurrently, like pigz does. Each block
+/// starts with the 32KiB of input before it as its dictionary and ends on a
+/// byte boundary, so the blocks concatenate into one valid deflate stream.
+typedef struct {
+    z_stream z_strm;
+    unsigned char *df; ///< buffer for deflated output
+    unsigned int dfallocated;
+    uint64_t crc;
+    uint64_t total_in;  ///< bytes of input deflated so far
+    int level;          ///< compression level, 0-9 or Z_DEFAULT_COMPRESSION
+    unsigned char *in;  ///< input not yet deflated
+    size_t in_len;
+    size_t in_cap;
+
+    size_t threads;             ///< threads to deflate with, 1 for serial
+    gv_pool_t *pool;            ///< workers deflating blocks
+    z_stream *streams;          ///< one stream per worker of `pool`
+    size_t n_streams;
+    gvdevice_zblock_t *blocks;  ///< results of the last batch
+    size_t block_bound;         ///< space to allocate for a deflated block
+    unsigned char window[DEFLATE_WINDOW]; ///< input preceding `in`
+    size_t window_len;
+} gvdevice_z_t;
 #endif /* HAVE_LIBZ */
 
 #include <assert.h>
@@ -57,16 +106,28 @@ static uint64_t crc;
 #include <common/utils.h>
 #include <gvc/gvio.h>
 #include <util/agxbuf.h>
+#include <util/alloc.h>
 #include <util/exit.h>
 #include <util/startswith.h>
 
 static size_t gvwrite_no_z(GVJ_t * job, const void *s, size_t len) {
     if (job->gvc->write_fn)   /* externally provided write discipline */
 	return job->gvc->write_fn(job, s, len);
+    if (job->output_chunk) {
+	/* once the caller refuses output, drop the rest for gvRenderChunks to
+	 * report, rather than exiting */
+	if (!job->output_chunk_failed
+	  && job->output_chunk(job->output_chunk_context, s, len) != len)
+	    job->output_chunk_failed = true;
+	return len;
+    }
     if (job->output_data) {
 	if (len > job->output_data_allocated - (job->output_data_position + 1)) {
-	    /* ensure enough allocation for string = null terminator */
+	    /* ensure enough allocation for string = null terminator, growing
+	     * geometrically so large outputs are not copied on every write */
 	    job->output_data_allocated = job->output_data_position + len + 1;
+	    if (job->output_data_allocated < job->output_data_position * 2)
+		job->output_data_allocated = job->output_data_position * 2;
 	    job->output_data = realloc(job->output_data, job->output_data_allocated);
 	    if (!job->output_data) {
                 job->common->errorfn("memory allocation failure\n");
@@ -84,7 +145,7 @@ static size_t gvwrite_no_z(GVJ_t * job, const void *s, size_t len) {
 
 static void auto_output_filename(GVJ_t *job)
 {
-    static agxbuf buf;
+    static _Thread_local agxbuf buf;
     char *fn;
 
     if (!(fn = job->input_filename))
@@ -112,6 +173,180 @@ static void auto_output_filename(GVJ_t *job)
     job->output_filename = agxbuse(&buf);
 }
 
+#ifdef HAVE_LIBZ
+/* zsettings:
+ * Read the compression level and number of threads to use from the
+ * "compresslevel" and "threads" attributes of the graph being rendered.
+ */
+static void zsettings(GVJ_t *job, gvdevice_z_t *state)
+{
+    graph_t *g = job->gvc->g;
+
+    state->level = Z_DEFAULT_COMPRESSION;
+    state->threads = 1;
+    if (!g)
+	return;
+    const int level = late_int(g, agfindgraphattr(g, "compresslevel"),
+                               Z_DEFAULT_COMPRESSION, 0);
+    if (level != Z_DEFAULT_COMPRESSION)
+	state->level = level > Z_BEST_COMPRESSION ? Z_BEST_COMPRESSION : level;
+    const int threads = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
+    state->threads = threads > 0 ? (size_t)threads : gv_processors();
+}
+
+static z_stream *zinit(GVJ_t *job, z_stream *z, int level)
+{
+    *z = (z_stream){0};
+    if (deflateInit2(z, level, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+	job->common->errorfn("Error initializing for deflation\n");
+	return NULL;
+    }
+    return z;
+}
+
+/* zserial:
+ * Deflate the gathered input through the single stream of the job.
+ */
+static void zserial(GVJ_t *job, gvdevice_z_t *state, int flush)
+{
+    z_streamp z = &state->z_strm;
+
+    state->crc = crc32(state->crc, state->in, (uInt)state->in_len);
+    state->total_in += state->in_len;
+
+    z->next_in = state->in;
+    z->avail_in = (uInt)state->in_len;
+    for (;;) {
+	z->next_out = state->df;
+	z->avail_out = state->dfallocated;
+	const int r = deflate(z, flush);
+	if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+	    job->common->errorfn("deflation problem %d\n", r);
+	    graphviz_exit(1);
+	}
+	const size_t olen = (size_t)(z->next_out - state->df);
+	if (olen && gvwrite_no_z(job, state->df, olen) != olen) {
+	    job->common->errorfn("gvwrite_no_z problem %" PRISIZE_T "\n", olen);
+	    graphviz_exit(1);
+	}
+	/* deflate only stops short of its input when the output is full */
+	if (flush == Z_FINISH ? r == Z_STREAM_END : z->avail_out != 0)
+	    break;
+    }
+    state->in_len = 0;
+}
+
+/// what the workers deflating a batch of blocks share
+typedef struct {
+    gvdevice_z_t *state;
+    size_t n;    ///< number of blocks
+    bool finish; ///< is the last block the end of the stream?
+} zbatch_t;
+
+static void zblocks(void *context, size_t start, size_t end, size_t worker)
+{
+    const zbatch_t *batch = context;
+    gvdevice_z_t *state = batch->state;
+    z_streamp z = &state->streams[worker];
+
+    for (size_t i = start; i < end; ++i) {
+	gvdevice_zblock_t *b = &state->blocks[i];
+	unsigned char *in = state->in + i * DEFLATE_BLOCK;
+	const size_t left = state->in_len - i * DEFLATE_BLOCK;
+	b->length = left < DEFLATE_BLOCK ? left : DEFLATE_BLOCK;
+	b->crc = crc32(crc32(0L, Z_NULL, 0), in, (uInt)b->length);
+
+	/* prime the block with the input before it, as a serial stream would
+	 * have it in its window */
+	b->ok = deflateReset(z) == Z_OK;
+	if (b->ok && i > 0)
+	    b->ok = deflateSetDictionary(z, in - DEFLATE_WINDOW, DEFLATE_WINDOW) == Z_OK;
+	else if (b->ok && state->window_len > 0)
+	    b->ok = deflateSetDictionary(z, state->window, (uInt)state->window_len) == Z_OK;
+	if (!b->ok)
+	    continue;
+
+	/* end every block but the last on a byte boundary, with an empty
+	 * stored block, so the next can be appended to it */
+	const bool last = batch->finish && i + 1 == batch->n;
+	z->next_in = in;
+	z->avail_in = (uInt)b->length;
+	z->next_out = b->out;
+	z->avail_out = (uInt)state->block_bound;
+	const int r = deflate(z, last ? Z_FINISH : Z_SYNC_FLUSH);
+	b->ok = last ? r == Z_STREAM_END : r == Z_OK && z->avail_out != 0;
+	b->size = (size_t)(z->next_out - b->out);
+    }
+}
+
+/* zbatch:
+ * Deflate the gathered input as blocks on several threads, and write them out
+ * in order.
+ */
+static void zbatch(GVJ_t *job, gvdevice_z_t *state, bool finish)
+{
+    size_t n = (state->in_len + DEFLATE_BLOCK - 1) / DEFLATE_BLOCK;
+    if (n == 0) /* nothing left but the end of the stream */
+	n = 1;
+
+    /* start the workers on the first batch, unless it is a single block */
+    if (!state->streams) {
+	if (n > 1)
+	    state->pool = gv_pool_new(state->threads < n ? state->threads : n);
+	state->n_streams = gv_pool_size(state->pool);
+	state->streams = gv_calloc(state->n_streams, sizeof(z_stream));
+	for (size_t i = 0; i < state->n_streams; ++i) {
+	    if (!zinit(job, &state->streams[i], state->level))
+		graphviz_exit(1);
+	}
+	state->block_bound = deflateBound(&state->streams[0], DEFLATE_BLOCK) + 16;
+	const size_t blocks = state->in_cap / DEFLATE_BLOCK;
+	state->blocks = gv_calloc(blocks, sizeof(gvdevice_zblock_t));
+	for (size_t i = 0; i < blocks; ++i)
+	    state->blocks[i].out = gv_alloc(state->block_bound);
+    }
+
+    zbatch_t batch = {.state = state, .n = n, .finish = finish};
+    gv_pool_for(state->pool, n, 1, zblocks, &batch);
+
+    for (size_t i = 0; i < n; ++i) {
+	const gvdevice_zblock_t *b = &state->blocks[i];
+	if (!b->ok) {
+	    job->common->errorfn("deflation problem in block %" PRISIZE_T "\n", i);
+	    graphviz_exit(1);
+	}
+	if (b->size && gvwrite_no_z(job, b->out, b->size) != b->size) {
+	    job->common->errorfn("gvwrite_no_z problem %" PRISIZE_T "\n", b->size);
+	    graphviz_exit(1);
+	}
+	state->crc = crc32_combine((uLong)state->crc, b->crc, (z_off_t)b->length);
+	state->total_in += b->length;
+    }
+
+    /* keep the end of the input as the dictionary of the next batch */
+    if (state->in_len >= DEFLATE_WINDOW) {
+	memcpy(state->window, state->in + state->in_len - DEFLATE_WINDOW, DEFLATE_WINDOW);
+	state->window_len = DEFLATE_WINDOW;
+    } else if (state->in_len > 0) {
+	const size_t keep = state->window_len + state->in_len > DEFLATE_WINDOW
+	                  ? DEFLATE_WINDOW - state->in_len : state->window_len;
+	memmove(state->window, state->window + state->window_len - keep, keep);
+	memcpy(state->window + keep, state->in, state->in_len);
+	state->window_len = keep + state->in_len;
+    }
+    state->in_len = 0;
+}
+
+/// deflate the gathered input
+static void zflush(GVJ_t *job, gvdevice_z_t *state, bool finish)
+{
+    if (state->threads > 1)
+	zbatch(job, state, finish);
+    else
+	zserial(job, state, finish ? Z_FINISH : Z_NO_FLUSH);
+}
+#endif /* HAVE_LIBZ */
+
 /* gvdevice_initialize:
  * Return 0 on success, non-zero on failure
  */
@@ -123,7 +358,7 @@ int gvdevice_initialize(GVJ_t * job)
     if (gvde && gvde->initialize) {
 	gvde->initialize(job);
     }
-    else if (job->output_data) {
+    else if (job->output_data || job->output_chunk) {
     }
     /* if the device has no initialization then it uses file output */
     else if (!job->output_file) {        /* if not yet opened */
@@ -155,21 +390,22 @@ int gvdevice_initialize(GVJ_t * job)
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_stream *z = &z_strm;
-
-	z->zalloc = 0;
-	z->zfree = 0;
-	z->opaque = 0;
-	z->next_in = NULL;
-	z->next_out = NULL;
-	z->avail_in = 0;
-
-	crc = crc32(0L, Z_NULL, 0);
-
-	if (deflateInit2(z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
-	    job->common->errorfn("Error initializing for deflation\n");
-	    return 1;
+	gvdevice_z_t *state = gv_alloc(sizeof(gvdevice_z_t));
+	job->compression = state;
+	zsettings(job, state);
+	state->crc = crc32(0L, Z_NULL, 0);
+
+	if (state->threads > 1) {
+	    state->in_cap = DEFLATE_BLOCK * DEFLATE_BATCH * state->threads;
+	} else {
+	    if (!zinit(job, &state->z_strm, state->level))
+		return 1;
+	    state->in_cap = DEFLATE_BLOCK;
+	    const uLong bound = deflateBound(&state->z_strm, DEFLATE_BLOCK);
+	    state->dfallocated = bound > UINT_MAX ? UINT_MAX : (unsigned)bound;
+	    state->df = gv_alloc(state->dfallocated);
 	}
+	state->in = gv_alloc(state->in_cap);
 	gvwrite_no_z(job, z_file_header, sizeof(z_file_header));
 #else
 	job->common->errorfn("No libz support.\n");
@@ -179,66 +415,29 @@ int gvdevice_initialize(GVJ_t * job)
     return 0;
 }
 
-size_t gvwrite (GVJ_t * job, const char *s, size_t len)
+/* gvwrite_unbuffered:
+ * Write to the output of the job, compressing it if the format asks for it.
+ */
+static size_t gvwrite_unbuffered(GVJ_t *job, const char *s, size_t len)
 {
-    size_t ret, olen;
-
-    if (!len || !s)
-	return 0;
+    size_t ret;
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
-
-	size_t dflen = deflateBound(z, len);
-	if (dfallocated < dflen) {
-	    dfallocated = dflen > UINT_MAX - 1 ? UINT_MAX : (unsigned)dflen + 1;
-	    df = realloc(df, dfallocated);
-	    if (! df) {
-                job->common->errorfn("memory allocation failure\n");
-		graphviz_exit(1);
-	    }
-	}
-
-#if ZLIB_VERNUM >= 0x1290
-	crc = crc32_z(crc, (const unsigned char*)s, len);
-#else
-	crc = crc32(crc, (const unsigned char*)s, len);
-#endif
+	gvdevice_z_t *state = job->compression;
 
+	/* gather the input, deflating it once there is a buffer full and more
+	 * to come, so the end of the stream is never left empty */
 	for (size_t offset = 0; offset < len; ) {
-// Suppress Clang/GCC -Wcast-qual warnings. `next_in` is morally const.
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-	    z->next_in = (unsigned char *)s + offset;
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
-	    const unsigned chunk = len - offset > UINT_MAX
-	                         ? UINT_MAX : (unsigned)(len - offset);
-	    z->avail_in = chunk;
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	    int r = deflate(z, Z_NO_FLUSH);
-	    if (r != Z_OK) {
-                job->common->errorfn("deflation problem %d\n", r);
-	        graphviz_exit(1);
-	    }
-
-	    if ((olen = (size_t)(z->next_out - df))) {
-		ret = gvwrite_no_z(job, df, olen);
-	        if (ret != olen) {
-                    job->common->errorfn("gvwrite_no_z problem %d\n", ret);
-	            graphviz_exit(1);
-	        }
-	    }
-	    offset += chunk - z->avail_in;
+	    if (state->in_len == state->in_cap)
+		zflush(job, state, false);
+	    const size_t room = state->in_cap - state->in_len;
+	    const size_t chunk = len - offset < room ? len - offset : room;
+	    memcpy(state->in + state->in_len, s + offset, chunk);
+	    state->in_len += chunk;
+	    offset += chunk;
 	}
-
 #else
-        (void)olen;
 	job->common->errorfn("No libz support.\n");
 	graphviz_exit(1);
 #endif
@@ -253,11 +452,41 @@ size_t gvwrite (GVJ_t * job, const char *s, size_t len)
     return len;
 }
 
+/// write out the output gathered for a `GVDEVICE_BUFFERED` device
+static void gvwrite_buffer(GVJ_t *job)
+{
+    if (job->output_buffer_length > 0) {
+	gvwrite_unbuffered(job, job->output_buffer, job->output_buffer_length);
+	job->output_buffer_length = 0;
+    }
+}
+
+size_t gvwrite (GVJ_t * job, const char *s, size_t len)
+{
+    if (!len || !s)
+	return 0;
+
+    /* gather small writes, passing on the buffer once it is full */
+    if (job->flags & GVDEVICE_BUFFERED) {
+	if (len > GVDEVICE_BUFFER_SIZE - job->output_buffer_length) {
+	    gvwrite_buffer(job);
+	    if (len >= GVDEVICE_BUFFER_SIZE)
+		return gvwrite_unbuffered(job, s, len);
+	}
+	if (!job->output_buffer)
+	    job->output_buffer = gv_alloc(GVDEVICE_BUFFER_SIZE);
+	memcpy(job->output_buffer + job->output_buffer_length, s, len);
+	job->output_buffer_length += len;
+	return len;
+    }
+    return gvwrite_unbuffered(job, s, len);
+}
+
 int gvferror (FILE* stream)
 {
     GVJ_t *job = (GVJ_t*)stream;
 
-    if (!job->gvc->write_fn && !job->output_data)
+    if (!job->gvc->write_fn && !job->output_data && !job->output_chunk)
 	return ferror(job->output_file);
 
     return 0;
@@ -307,6 +536,7 @@ int gvputc(GVJ_t * job, int c)
 
 int gvflush (GVJ_t * job)
 {
+    gvwrite_buffer(job);
     if (job->output_file
       && ! job->external_context
       && ! job->gvc->write_fn) {
@@ -333,6 +563,7 @@ void gvdevice_format(GVJ_t * job)
 {
     gvdevice_engine_t *gvde = job->device.engine;
 
+    gvwrite_buffer(job);
     if (gvde && gvde->format)
 	gvde->format(job);
     gvflush (job);
@@ -343,42 +574,48 @@ void gvdevice_finalize(GVJ_t * job)
     gvdevice_engine_t *gvde = job->device.engine;
     bool finalized_p = false;
 
+    gvwrite_buffer(job);
+    free(job->output_buffer);
+    job->output_buffer = NULL;
+
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
+	gvdevice_z_t *state = job->compression;
 	unsigned char out[8] = "";
-	int ret;
-	int cnt = 0;
-
-	z->next_in = out;
-	z->avail_in = 0;
-	z->next_out = df;
-	z->avail_out = dfallocated;
-	while ((ret = deflate (z, Z_FINISH)) == Z_OK && (cnt++ <= 100)) {
-	    gvwrite_no_z(job, df, (size_t)(z->next_out - df));
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	}
-	if (ret != Z_STREAM_END) {
-            job->common->errorfn("deflation finish problem %d cnt=%d\n", ret, cnt);
-	    graphviz_exit(1);
-	}
-	gvwrite_no_z(job, df, (size_t)(z->next_out - df));
 
-	ret = deflateEnd(z);
-	if (ret != Z_OK) {
-	    job->common->errorfn("deflation end problem %d\n", ret);
-	    graphviz_exit(1);
+	zflush(job, state, true);
+	if (state->threads > 1) {
+	    for (size_t i = 0; i < state->n_streams; ++i)
+		(void)deflateEnd(&state->streams[i]);
+	} else {
+	    const int ret = deflateEnd(&state->z_strm);
+	    if (ret != Z_OK) {
+		job->common->errorfn("deflation end problem %d\n", ret);
+		graphviz_exit(1);
+	    }
 	}
+	const uint64_t crc = state->crc;
+	const uint64_t total_in = state->total_in;
 	out[0] = (unsigned char)crc;
 	out[1] = (unsigned char)(crc >> 8);
 	out[2] = (unsigned char)(crc >> 16);
 	out[3] = (unsigned char)(crc >> 24);
-	out[4] = (unsigned char)z->total_in;
-	out[5] = (unsigned char)(z->total_in >> 8);
-	out[6] = (unsigned char)(z->total_in >> 16);
-	out[7] = (unsigned char)(z->total_in >> 24);
+	out[4] = (unsigned char)total_in;
+	out[5] = (unsigned char)(total_in >> 8);
+	out[6] = (unsigned char)(total_in >> 16);
+	out[7] = (unsigned char)(total_in >> 24);
 	gvwrite_no_z(job, out, sizeof(out));
+	gv_pool_free(state->pool);
+	free(state->streams);
+	if (state->blocks) {
+	    for (size_t i = 0; i < state->in_cap / DEFLATE_BLOCK; ++i)
+		free(state->blocks[i].out);
+	    free(state->blocks);
+	}
+	free(state->in);
+	free(state->df);
+	free(state);
+	job->compression = NULL;
 #else
 	job->common->errorfn("No libz support\n");
 	graphviz_exit(1);
@@ -401,22 +638,81 @@ void gvdevice_finalize(GVJ_t * job)
 
 void gvprintf(GVJ_t * job, const char *format, ...)
 {
-    agxbuf buf = {0};
+    char small[128];
     va_list argp;
 
+    /* most output fits on the stack, saving an allocation */
     va_start(argp, format);
-    int len = vagxbprint(&buf, format, argp);
+    int len = vsnprintf(small, sizeof(small), format, argp);
+    va_end(argp);
     if (len < 0) {
-	va_end(argp);
 	agerrorf("gvprintf: %s\n", strerror(errno));
 	return;
     }
+    if ((size_t)len < sizeof(small)) {
+	gvwrite(job, small, (size_t)len);
+	return;
+    }
+
+    agxbuf buf = {0};
+    va_start(argp, format);
+    len = vagxbprint(&buf, format, argp);
     va_end(argp);
+    if (len < 0) {
+	agerrorf("gvprintf: %s\n", strerror(errno));
+	return;
+    }
 
     gvwrite(job, agxbuse(&buf), (size_t)len);
     agxbfree(&buf);
 }
 
+/* gv_fixed:
+ * Write `num` to `buf` as `snprintf(buf, 50, "%.*f", precision, num)` would,
+ * for a precision of at most 3. The digits are formatted from an integer,
+ * which is much faster, leaving `snprintf` the values too close to a rounding
+ * boundary to tell from the scaled double.
+ * Returns the length of the string in `buf`.
+ */
+static size_t gv_fixed(char buf[static 50], double num, int precision)
+{
+    static const double scales[] = {1, 10, 100, 1000};
+    assert(precision >= 0 && precision <= 3);
+
+    const double a = fabs(num);
+    if (a < 1e12) { /* also excludes NaN and infinities */
+	const double x = a * scales[precision];
+	const double whole = floor(x);
+	const double frac = x - whole;
+	/* x is within half an ulp of the exact product, so only closer calls
+	 * than that are in doubt */
+	if (fabs(frac - 0.5) > x * DBL_EPSILON) {
+	    uint64_t r = (uint64_t)whole + (frac > 0.5);
+	    char digits[24];
+	    size_t n = 0;
+	    do {
+		digits[n++] = (char)('0' + r % 10);
+		r /= 10;
+	    } while (r > 0 || n <= (size_t)precision);
+
+	    size_t len = 0;
+	    if (signbit(num))
+		buf[len++] = '-';
+	    while (n > (size_t)precision)
+		buf[len++] = digits[--n];
+	    if (precision > 0) {
+		buf[len++] = '.';
+		while (n > 0)
+		    buf[len++] = digits[--n];
+	    }
+	    buf[len] = '\0';
+	    return len;
+	}
+    }
+
+    snprintf(buf, 50, "%.*f", precision, num);
+    return strlen(buf);
+}
 
 /* Test with:
  *	cc -DGVPRINTNUM_TEST gvprintnum.c -o gvprintnum
@@ -426,42 +722,49 @@ void gvprintf(GVJ_t * job, const char *format, ...)
 #define val_str(n, x) static double n = x; static char n##str[] = #x;
 val_str(maxnegnum, -999999999999999.99)
 
-static void gvprintnum(agxbuf *xb, double number) {
+/* gvprintnum:
+ * Write `number` to `buf`, returning its length.
+ */
+static size_t gvprintnum(char buf[static 50], double number) {
     /*
         number limited to a working range: maxnegnum >= n >= -maxnegnum
 	suppressing trailing "0" and "."
      */
 
     if (number < maxnegnum) {		/* -ve limit */
-	agxbput(xb, maxnegnumstr);
-	return;
+	strcpy(buf, maxnegnumstr);
+	return strlen(buf);
     }
     if (number > -maxnegnum) {		/* +ve limit */
-	agxbput(xb, maxnegnumstr + 1); // +1 to skip the '-' sign
-	return;
+	strcpy(buf, maxnegnumstr + 1); // +1 to skip the '-' sign
+	return strlen(buf);
     }
 
-    agxbprint(xb, "%.03f", number);
-    agxbuf_trim_zeros(xb);
+    size_t len = gv_fixed(buf, number, 3);
+    if (memchr(buf, '.', len)) {
+	while (buf[len - 1] == '0')
+	    --len;
+	if (buf[len - 1] == '.')
+	    --len;
+    }
+    buf[len] = '\0';
 
     // strip off unnecessary leading '0'
-    {
-        char *staging = agxbdisown(xb);
-        if (startswith(staging, "0.")) {
-            memmove(staging, &staging[1], strlen(staging));
-        } else if (startswith(staging, "-0.")) {
-            memmove(&staging[1], &staging[2], strlen(&staging[1]));
-        }
-        agxbput(xb, staging);
-        free(staging);
+    if (startswith(buf, "0.")) {
+	memmove(buf, &buf[1], len); // including the '\0'
+	--len;
+    } else if (startswith(buf, "-0.")) {
+	memmove(&buf[1], &buf[2], len - 1);
+	--len;
     }
+    return len;
 }
 
 
 #ifdef GVPRINTNUM_TEST
 int main (int argc, char *argv[])
 {
-    agxbuf xb = {0};
+    char buf[50];
 
     double test[] = {
 	-maxnegnum*1.1, -maxnegnum*.9,
@@ -475,13 +778,10 @@ int main (int argc, char *argv[])
     int i = sizeof(test) / sizeof(test[0]);
 
     while (i--) {
-	gvprintnum(&xb, test[i]);
-	const char *buf = agxbuse(&xb);
-	const size_t len = strlen(buf);
+	const size_t len = gvprintnum(buf, test[i]);
         printf("%g = %s %" PRISIZE_T "\n", test[i], buf, len);
     }
 
-    agxbfree(&xb);
     graphviz_exit(0);
 }
 #endif
@@ -521,7 +821,7 @@ void gvprintdouble(GVJ_t * job, double num)
 
     char buf[50];
 
-    snprintf(buf, 50, "%.02f", num);
+    (void)gv_fixed(buf, num, 2);
     size_t len = gv_trim_zeros(buf);
 
     gvwrite(job, buf, len);
@@ -529,16 +829,13 @@ void gvprintdouble(GVJ_t * job, double num)
 
 void gvprintpointf(GVJ_t * job, pointf p)
 {
-    agxbuf xb = {0};
-
-    gvprintnum(&xb, p.x);
-    const char *buf = agxbuse(&xb);
-    gvwrite(job, buf, strlen(buf));
-    gvwrite(job, " ", 1);
-    gvprintnum(&xb, p.y);
-    buf = agxbuse(&xb);
-    gvwrite(job, buf, strlen(buf));
-    agxbfree(&xb);
+    char buf[50];
+
+    size_t len = gvprintnum(buf, p.x);
+    buf[len++] = ' ';
+    gvwrite(job, buf, len);
+    len = gvprintnum(buf, p.y);
+    gvwrite(job, buf, len);
 } 
 
 void gvprintpointflist(GVJ_t *job, pointf *p, size_t n) {
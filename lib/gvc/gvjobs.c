@@ -19,9 +19,6 @@
 #include        <stddef.h>
 #include        <util/alloc.h>
 
-static GVJ_t *output_filename_job;
-static GVJ_t *output_langname_job;
-
 /*
  * -T and -o can be specified in any order relative to the other, e.g.
  *            -T -T -o -o
@@ -44,38 +41,38 @@ static GVJ_t *output_langname_job;
 void gvjobs_output_filename(GVC_t * gvc, const char *name)
 {
     if (!gvc->jobs) {
-	output_filename_job = gvc->job = gvc->jobs = gv_alloc(sizeof(GVJ_t));
+	gvc->output_filename_job = gvc->job = gvc->jobs = gv_alloc(sizeof(GVJ_t));
     } else {
-	if (!output_filename_job) {
-	    output_filename_job = gvc->jobs;
+	if (!gvc->output_filename_job) {
+	    gvc->output_filename_job = gvc->jobs;
 	} else {
-	    if (!output_filename_job->next) {
-		output_filename_job->next = gv_alloc(sizeof(GVJ_t));
+	    if (!gvc->output_filename_job->next) {
+		gvc->output_filename_job->next = gv_alloc(sizeof(GVJ_t));
 	    }
-	    output_filename_job = output_filename_job->next;
+	    gvc->output_filename_job = gvc->output_filename_job->next;
 	}
     }
-    output_filename_job->output_filename = name;
-    output_filename_job->gvc = gvc;
+    gvc->output_filename_job->output_filename = name;
+    gvc->output_filename_job->gvc = gvc;
 }
 
 /* -T switches */
 bool gvjobs_output_langname(GVC_t * gvc, const char *name)
 {
     if (!gvc->jobs) {
-	output_langname_job = gvc->job = gvc->jobs = gv_alloc(sizeof(GVJ_t));
+	gvc->output_langname_job = gvc->job = gvc->jobs = gv_alloc(sizeof(GVJ_t));
     } else {
-	if (!output_langname_job) {
-	    output_langname_job = gvc->jobs;
+	if (!gvc->output_langname_job) {
+	    gvc->output_langname_job = gvc->jobs;
 	} else {
-	    if (!output_langname_job->next) {
-		output_langname_job->next = gv_alloc(sizeof(GVJ_t));
+	    if (!gvc->output_langname_job->next) {
+		gvc->output_langname_job->next = gv_alloc(sizeof(GVJ_t));
 	    }
-	    output_langname_job = output_langname_job->next;
+	    gvc->output_langname_job = gvc->output_langname_job->next;
 	}
     }
-    output_langname_job->output_langname = name;
-    output_langname_job->gvc = gvc;
+    gvc->output_langname_job->output_langname = name;
+    gvc->output_langname_job->gvc = gvc;
 
     /* load it now to check that it exists */
     if (gvplugin_load(gvc, API_device, name, NULL))
@@ -110,9 +107,10 @@ void gvjobs_delete(GVC_t * gvc)
 	job = job->next;
 	free(j->active_tooltip);
 	free(j->selected_href);
+	free(j->output_buffer);
 	free(j);
     }
-    gvc->jobs = gvc->job = gvc->active_jobs = output_filename_job = output_langname_job =
-	NULL;
+    gvc->jobs = gvc->job = gvc->active_jobs = NULL;
+    gvc->output_filename_job = gvc->output_langname_job = NULL;
     gvc->common.viewNum = 0;
 }
@@ -22,6 +22,9 @@
 
 /* for agerr() */
 #include <cgraph/cgraph.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include <stdbool.h>
 #include <stddef.h>
 #include <util/agxbuf.h>
@@ -31,7 +34,15 @@ static int gvloadimage_select(GVJ_t * job, char *str)
     gvplugin_available_t *plugin;
     gvplugin_installed_t *typeptr;
 
+#ifdef HAVE_PTHREAD
+    // jobs for one context may be emitted at once, see gvRenderJobs
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&lock);
     plugin = gvplugin_load(job->gvc, API_loadimage, str, NULL);
+    pthread_mutex_unlock(&lock);
+#else
+    plugin = gvplugin_load(job->gvc, API_loadimage, str, NULL);
+#endif
     if (plugin) {
         typeptr = plugin->typeptr;
         job->loadimage.engine = typeptr->engine;
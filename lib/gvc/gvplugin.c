@@ -18,6 +18,9 @@
 
 #ifdef ENABLE_LTDL
 #include	<ltdl.h>
+#ifdef HAVE_PTHREAD
+#include	<pthread.h>
+#endif
 #endif
 
 #include        <common/types.h>
@@ -148,7 +151,7 @@ static void gvplugin_activate(GVC_t * gvc, api_t api, const char *typestr,
     }
 }
 
-gvplugin_library_t *gvplugin_library_load(GVC_t *gvc, const char *pathname) {
+static gvplugin_library_t *library_load(GVC_t *gvc, const char *pathname) {
 #ifdef ENABLE_LTDL
     lt_dlhandle hndl;
     lt_ptr ptr;
@@ -235,6 +238,19 @@ gvplugin_library_t *gvplugin_library_load(GVC_t *gvc, const char *pathname) {
 #endif
 }
 
+gvplugin_library_t *gvplugin_library_load(GVC_t *gvc, const char *pathname) {
+#if defined(ENABLE_LTDL) && defined(HAVE_PTHREAD)
+    // libltdl keeps global state, so contexts in different threads take turns
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&lock);
+    gvplugin_library_t *const library = library_load(gvc, pathname);
+    pthread_mutex_unlock(&lock);
+    return library;
+#else
+    return library_load(gvc, pathname);
+#endif
+}
+
 
 /* load a plugin of type=str
 	the str can optionally contain one or more ":dependencies" 
@@ -359,7 +375,7 @@ char *gvplugin_list(GVC_t * gvc, api_t api, const char *str)
     const gvplugin_available_t *pnext, *plugin;
     char *bp;
     bool new = true;
-    static agxbuf xb;
+    static _Thread_local agxbuf xb;
 
     /* check for valid str */
     if (!str)
@@ -34,7 +34,7 @@
 #include <util/streq.h>
 #include <util/strview.h>
 
-static Dict_t *ImageDict;
+static _Thread_local Dict_t *ImageDict;
 
 typedef struct {
   char *template;
@@ -679,9 +679,21 @@ usershape_t *gvusershape_find(const char *name) {
   return dtmatch(ImageDict, name);
 }
 
+/// the images loaded by this thread, to share with helpers emitting its graph
+Dict_t *gvusershape_images(void) { return ImageDict; }
+
+/// look up images in `images` from now on
+///
+/// @return The images this thread used until now, to restore afterwards
+Dict_t *gvusershape_adopt_images(Dict_t *images) {
+  Dict_t *const previous = ImageDict;
+  ImageDict = images;
+  return previous;
+}
+
 #define MAX_USERSHAPE_FILES_OPEN 50
 bool gvusershape_file_access(usershape_t *us) {
-  static int usershape_files_open_cnt;
+  static _Thread_local int usershape_files_open_cnt;
   const char *fn;
 
   assert(us);
@@ -812,7 +824,7 @@ point gvusershape_size_dpi(usershape_t *us, pointf dpi) {
  */
 point gvusershape_size(graph_t *g, char *name) {
   pointf dpi;
-  static char *oldpath;
+  static _Thread_local char *oldpath;
 
   /* no shape file, no shape size */
   if (!name || (*name == '\0')) {
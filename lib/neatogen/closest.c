@@ -20,6 +20,7 @@
 #include <util/alloc.h>
 #include <util/gv_math.h>
 #include <util/list.h>
+#include <util/random.h>
 #include <util/sort.h>
 
 /*****************************************
@@ -75,7 +76,7 @@ typedef struct {
 #define parent(i) ((i)/2)
 #define insideHeap(h,i) ((i)<h->heapSize)
 #define greaterPriority(h,i,j) \
-  (LT(h->data[i],h->data[j]) || ((EQ(h->data[i],h->data[j])) && (rand()%2)))
+  (LT(h->data[i],h->data[j]) || ((EQ(h->data[i],h->data[j])) && (gv_rand()%2)))
 
 static void heapify(PairHeap *h, size_t i) {
     size_t largest;
@@ -160,7 +160,7 @@ cleanup1:
 
 int
 conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
-			   double tol, int max_iterations)
+			   double tol, int max_iterations, gv_pool_t *pool)
 {
     /* Solves Ax=b using Conjugate-Gradients method */
     /* A is a packed symmetric matrix */
@@ -178,7 +178,7 @@ conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
     orthog1f(n, x);
     orthog1f(n, b);
 
-    right_mult_with_vector_ff(A, n, x, Ax);
+    right_mult_with_vector_ff_parallel(A, n, x, Ax, pool);
     /* centering Ax */
     orthog1f(n, Ax);
 
@@ -193,7 +193,7 @@ conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
 	orthog1f(n, x);
 	orthog1f(n, r);
 
-	right_mult_with_vector_ff(A, n, p, Ap);
+	right_mult_with_vector_ff_parallel(A, n, p, Ap, pool);
 	/* centering Ap */
 	orthog1f(n, Ap);
 
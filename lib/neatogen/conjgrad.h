@@ -11,6 +11,7 @@
 #pragma once
 
 #include <util/api.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,7 +35,7 @@ PRIVATE int conjugate_gradient_f(float **, double *, double *, int,
 				     double, int, bool);
 
 PRIVATE int conjugate_gradient_mkernel(float *, float *, float *, int,
-					   double, int);
+					   double, int, gv_pool_t *pool);
 
 #ifdef __cplusplus
 }
@@ -81,7 +81,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
     if (!directionalityExist) {
 	return stress_majorization_kD_mkernel(graph, n,
 					      d_coords, nodes, dim, opts,
-					      model, maxi);
+					      model, maxi, NULL);
     }
 
 	/******************************************************************
@@ -93,7 +93,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    /* the dim==2 case is handled below                      */
 	    if (stress_majorization_kD_mkernel(graph, n,
 					   d_coords + 1, nodes, dim - 1,
-					   opts, model, 15) < 0)
+					   opts, model, 15, NULL) < 0)
 		return -1;
 	    /* now copy the y-axis into the (dim-1)-axis */
 	    for (int i = 0; i < n; i++) {
@@ -117,7 +117,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    free(levels);
 	    return stress_majorization_kD_mkernel(graph, n,
 						  d_coords, nodes, dim,
-						  opts, model, maxi);
+						  opts, model, maxi, NULL);
 	}
 
 	if (levels_gap > 0) {
@@ -171,7 +171,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, NULL);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -183,12 +183,12 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, NULL);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, NULL);
     }
     if (Verbose) {
 	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
@@ -403,7 +403,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    } else {
 		/* use conjugate gradient for all dimensions except y */
 		if (conjugate_gradient_mkernel(lap2, coords[k], b[k], n,
-					   conj_tol, n)) {
+					   conj_tol, n, NULL)) {
 		    iterations = -1;
 		    goto finish;
 		}
@@ -127,7 +127,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, NULL);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -139,12 +139,12 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, NULL);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, NULL);
     }
     if (Verbose) {
 	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
@@ -406,7 +406,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	     * optimisation which should be considerably faster
 	     */
 	    if (conjugate_gradient_mkernel(lap2, coords[0], b[0], n,
-				       tolerance_cg, n) < 0) {
+				       tolerance_cg, n, NULL) < 0) {
 		iterations = -1;
 		goto finish;
 	    }
@@ -423,7 +423,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	    }
 	} else {
 	    conjugate_gradient_mkernel(lap2, coords[1], b[1], n,
-				       tolerance_cg, n);
+				       tolerance_cg, n, NULL);
 	}
     }
     if (Verbose) {
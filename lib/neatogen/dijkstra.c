@@ -336,3 +336,35 @@ int dijkstra_sgd(graph_sgd *graph, int source, term_sgd *terms) {
     free(dists);
     return offset;
 }
+
+// single source shortest path lengths over the same graph as dijkstra_sgd,
+// leaving FLT_MAX for nodes that cannot be reached
+void dijkstra_sgd_dist(const graph_sgd *graph, int source, float *dists) {
+    for (size_t i = 0; i < graph->n; i++) {
+        dists[i] = FLT_MAX;
+    }
+    dists[source] = 0;
+    for (size_t i = graph->sources[source]; i < graph->sources[source + 1];
+         i++) {
+        size_t target = graph->targets[i];
+        dists[target] = fminf(dists[target], graph->weights[i]);
+    }
+    assert(graph->n <= INT_MAX);
+    heap h = initHeap_f(source, dists, (int)graph->n);
+
+    int closest = 0;
+    while (extractMax_f(&h, &closest, dists)) {
+        float d = dists[closest];
+        if (d == FLT_MAX) {
+            break;
+        }
+        for (size_t i = graph->sources[closest]; i < graph->sources[closest + 1];
+             i++) {
+            size_t target = graph->targets[i];
+            float weight = graph->weights[i];
+            assert(target <= INT_MAX);
+            increaseKey_f(&h, (int)target, d+weight, dists);
+        }
+    }
+    freeHeap(&h);
+}
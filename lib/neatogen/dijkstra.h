@@ -22,6 +22,7 @@ extern "C" {
 PRIVATE void ngdijkstra(int, vtx_data *, int, DistType *);
 PRIVATE void dijkstra_f(int, vtx_data *, int, float *);
 PRIVATE int dijkstra_sgd(graph_sgd *, int, term_sgd *);
+PRIVATE void dijkstra_sgd_dist(const graph_sgd *, int, float *);
 
 #ifdef __cplusplus
 }
@@ -18,7 +18,7 @@
 #include <stddef.h>
 #include <util/arena.h>
 
-double pxmin, pxmax, pymin, pymax;	/* clipping window */
+_Thread_local double pxmin, pxmax, pymin, pymax;	/* clipping window */
 
 Edge *gvbisect(Site *s1, Site *s2, arena_t *allocator) {
     assert(allocator != NULL);
@@ -29,7 +29,7 @@ extern "C" {
 #define le 0
 #define re 1
 
-    extern double pxmin, pxmax, pymin, pymax;	/* clipping window */
+    extern _Thread_local double pxmin, pxmax, pymin, pymax;	/* clipping window */
 PRIVATE void endpoint(Edge *, int, Site *, arena_t *);
 PRIVATE void clip_line(Edge * e);
 PRIVATE Edge *gvbisect(Site *, Site *, arena_t *);
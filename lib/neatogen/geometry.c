@@ -14,11 +14,11 @@
 #include <math.h>
 #include <stddef.h>
 
-double xmin, xmax, ymin, ymax;	/* min and max x and y values of sites */
-double deltax; // xmax - xmin
+_Thread_local double xmin, xmax, ymin, ymax;	/* min and max x and y values of sites */
+_Thread_local double deltax; // xmax - xmin
 
-size_t nsites;
-int sqrt_nsites;
+_Thread_local size_t nsites;
+_Thread_local int sqrt_nsites;
 
 void geominit(void)
 {
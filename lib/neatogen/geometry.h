@@ -25,11 +25,11 @@ extern "C" {
     } Point;
 #endif
 
-    extern double xmin, xmax, ymin, ymax;	/* extreme x,y values of sites */
-    extern double deltax;	// xmax - xmin
+    extern _Thread_local double xmin, xmax, ymin, ymax;	/* extreme x,y values of sites */
+    extern _Thread_local double deltax;	// xmax - xmin
 
-    extern size_t nsites; // Number of sites
-    extern int sqrt_nsites;
+    extern _Thread_local size_t nsites; // Number of sites
+    extern _Thread_local int sqrt_nsites;
 
 PRIVATE void geominit(void);
 PRIVATE double dist_2(Point, Point); ///< distance squared between two points
@@ -32,7 +32,7 @@ typedef struct {
 } Info_t;
 
 /// array of node info
-extern Info_t *nodeInfo;
+extern _Thread_local Info_t *nodeInfo;
 
 /// insert vertex into sorted list
 PRIVATE void addVertex(Site *, double, double);
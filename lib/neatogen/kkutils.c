@@ -49,48 +49,69 @@ void empty_neighbors_vec(vtx_data * graph, int vtx, int *vtx_vec)
     }
 }
 
-/// assumes the graph has weights
-static DistType **compute_apsp_dijkstra(vtx_data * graph, int n)
-{
-    int i;
-
-    DistType *storage = gv_calloc((size_t)(n * n), sizeof(DistType));
-    DistType **dij = gv_calloc(n, sizeof(DistType*));
-    for (i = 0; i < n; i++)
-	dij[i] = storage + i * n;
+/// state shared by the workers of an all-pairs shortest path computation
+typedef struct {
+    vtx_data *graph;
+    int n;
+    DistType **dij;
+} apsp_t;
+
+/// fill rows `[start, end)` of a distance matrix using Dijkstra
+static void apsp_dijkstra_rows(void *context, size_t start, size_t end,
+                               size_t worker) {
+    (void)worker;
+    apsp_t *a = context;
+    for (size_t i = start; i < end; i++) {
+	ngdijkstra((int)i, a->graph, a->n, a->dij[i]);
+    }
+}
 
-    for (i = 0; i < n; i++) {
-	ngdijkstra(i, graph, n, dij[i]);
+/// fill rows `[start, end)` of a distance matrix using BFS
+static void apsp_simple_rows(void *context, size_t start, size_t end,
+                             size_t worker) {
+    (void)worker;
+    apsp_t *a = context;
+    for (size_t i = start; i < end; i++) {
+	bfs((int)i, a->graph, a->n, a->dij[i]);
     }
+}
+
+static DistType **new_distance_matrix(int n) {
+    DistType *storage = gv_calloc((size_t)n * (size_t)n, sizeof(DistType));
+    DistType **dij = gv_calloc(n, sizeof(DistType*));
+    for (int i = 0; i < n; i++)
+	dij[i] = storage + (size_t)i * (size_t)n;
     return dij;
 }
 
-static DistType **compute_apsp_simple(vtx_data * graph, int n)
+/// assumes the graph has weights
+static DistType **compute_apsp_dijkstra(vtx_data *graph, int n,
+                                        gv_pool_t *pool)
+{
+    apsp_t a = {.graph = graph, .n = n, .dij = new_distance_matrix(n)};
+    gv_pool_for(pool, (size_t)n, 1, apsp_dijkstra_rows, &a);
+    return a.dij;
+}
+
+static DistType **compute_apsp_simple(vtx_data *graph, int n, gv_pool_t *pool)
 {
     /* compute all pairs shortest path */
     /* for unweighted graph */
-    int i;
-    DistType *storage = gv_calloc((size_t)(n * n), sizeof(DistType));
-
-    DistType **dij = gv_calloc(n, sizeof(DistType*));
-    for (i = 0; i < n; i++) {
-	dij[i] = storage + i * n;
-    }
-    for (i = 0; i < n; i++) {
-	bfs(i, graph, n, dij[i]);
-    }
-    return dij;
+    apsp_t a = {.graph = graph, .n = n, .dij = new_distance_matrix(n)};
+    gv_pool_for(pool, (size_t)n, 1, apsp_simple_rows, &a);
+    return a.dij;
 }
 
-DistType **compute_apsp(vtx_data * graph, int n)
+DistType **compute_apsp(vtx_data *graph, int n, gv_pool_t *pool)
 {
     if (graph->ewgts)
-	return compute_apsp_dijkstra(graph, n);
+	return compute_apsp_dijkstra(graph, n, pool);
     else
-	return compute_apsp_simple(graph, n);
+	return compute_apsp_simple(graph, n, pool);
 }
 
-DistType **compute_apsp_artificial_weights(vtx_data *graph, int n) {
+DistType **compute_apsp_artificial_weights(vtx_data *graph, int n,
+                                           gv_pool_t *pool) {
     DistType **Dij;
     /* compute all-pairs-shortest-path-length while weighting the graph */
     /* so high-degree nodes are distantly located */
@@ -98,7 +119,7 @@ DistType **compute_apsp_artificial_weights(vtx_data *graph, int n) {
     float *old_weights = graph[0].ewgts;
 
     compute_new_weights(graph, n);
-    Dij = compute_apsp_dijkstra(graph, n);
+    Dij = compute_apsp_dijkstra(graph, n, pool);
     restore_old_weights(graph, n, old_weights);
     return Dij;
 }
@@ -12,6 +12,7 @@
 
 #include <stddef.h>
 #include <util/api.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,8 +25,9 @@ PRIVATE void fill_neighbors_vec_unweighted(vtx_data *, int vtx,
 PRIVATE size_t common_neighbors(vtx_data *, int u, int *);
 PRIVATE void empty_neighbors_vec(vtx_data * graph, int vtx,
 				    int *vtx_vec);
-PRIVATE DistType **compute_apsp(vtx_data *, int);
-PRIVATE DistType **compute_apsp_artificial_weights(vtx_data *, int);
+PRIVATE DistType **compute_apsp(vtx_data *, int, gv_pool_t *pool);
+PRIVATE DistType **compute_apsp_artificial_weights(vtx_data *, int,
+                                                   gv_pool_t *pool);
 PRIVATE double distance_kD(double **, int, int, int);
 PRIVATE void quicksort_place(double *, int *, int);
 PRIVATE void quicksort_placef(float *, int *, int, int);
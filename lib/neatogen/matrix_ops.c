@@ -16,6 +16,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <util/alloc.h>
+#include <util/gv_math.h>
+#include <util/random.h>
 
 static const double p_iteration_threshold = 1e-3;
 
@@ -41,7 +43,7 @@ bool power_iteration(double *const *square_mat, int n, int neigs, double **eigs)
 	/* guess the i-th eigen vector */
       choose:
         for (int j = 0; j < n; j++)
-            curr_vector[j] = rand() % 100;
+            curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (int j = 0; j < i; j++) {
 	    const double alpha = -vectors_inner_product(n, eigs[j], curr_vector);
@@ -88,7 +90,7 @@ bool power_iteration(double *const *square_mat, int n, int neigs, double **eigs)
 	double *const curr_vector = eigs[i];
 	/* guess the i-th eigen vector */
 	for (int j = 0; j < n; j++)
-	    curr_vector[j] = rand() % 100;
+	    curr_vector[j] = gv_rand() % 100;
 	/* orthogonalize against higher eigenvectors */
 	for (int j = 0; j < i; j++) {
 	    const double alpha = -vectors_inner_product(n, eigs[j], curr_vector);
@@ -253,7 +255,7 @@ void init_vec_orth1(int n, double *vec)
     int i;
 
     for (i = 0; i < n; i++)
-	vec[i] = rand() % RANGE;
+	vec[i] = gv_rand() % RANGE;
 
     orthog1(n, vec);
 }
@@ -422,6 +424,72 @@ void right_mult_with_vector_ff
     }
 }
 
+size_t packed_row(int n, int i) {
+    return (size_t)i * (2 * (size_t)n - (size_t)i + 1) / 2;
+}
+
+/// number of outputs computed together by `right_mult_with_vector_ff_parallel`
+enum { PACKED_BLOCK = 256 };
+
+typedef struct {
+    const float *packed_matrix;
+    int n;
+    const float *vector;
+    float *result;
+} packed_product_t;
+
+/// compute the outputs in column blocks `[start, end)` of a packed product
+///
+/// Each output is accumulated in the same order as `right_mult_with_vector_ff`
+/// does: the contributions of the rows above it in row order, then the dot
+/// product of its own row. Rows are read in contiguous segments, and the
+/// updates to a block of outputs are independent so can be vectorized.
+static void packed_product_blocks(void *context, size_t start, size_t end,
+                                  size_t worker) {
+    (void)worker;
+    const packed_product_t *p = context;
+    const int n = p->n;
+    const float *vector = p->vector;
+    float *result = p->result;
+
+    for (size_t block = start; block < end; block++) {
+	const int lo = (int)block * PACKED_BLOCK;
+	const int hi = imin(lo + PACKED_BLOCK, n);
+	for (int j = lo; j < hi; j++) {
+	    result[j] = 0;
+	}
+	for (int i = 0; i < hi; i++) {
+	    // offset so that `row[j]` is entry (i, j)
+	    const float *row = p->packed_matrix + packed_row(n, i) - i;
+	    const float vector_i = vector[i];
+	    if (i >= lo) {
+		float res = 0;
+		res += row[i] * vector_i;
+		for (int j = i + 1; j < n; j++) {
+		    res += row[j] * vector[j];
+		}
+		result[i] += res;
+	    }
+	    for (int j = imax(lo, i + 1); j < hi; j++) {
+		result[j] += row[j] * vector_i;
+	    }
+	}
+    }
+}
+
+void right_mult_with_vector_ff_parallel(float *packed_matrix, int n,
+                                        float *vector, float *result,
+                                        gv_pool_t *pool) {
+    if (gv_pool_size(pool) < 2) {
+	right_mult_with_vector_ff(packed_matrix, n, vector, result);
+	return;
+    }
+    packed_product_t p = {.packed_matrix = packed_matrix, .n = n,
+                          .vector = vector, .result = result};
+    const size_t blocks = ((size_t)n + PACKED_BLOCK - 1) / PACKED_BLOCK;
+    gv_pool_for(pool, blocks, 1, packed_product_blocks, &p);
+}
+
 void
 vectors_subtractionf(int n, float *vector1, float *vector2, float *result)
 {
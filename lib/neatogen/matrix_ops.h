@@ -11,7 +11,9 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <util/api.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -58,6 +60,17 @@ PRIVATE bool power_iteration(double *const *, int, int, double **);
 
 PRIVATE void orthog1f(int n, float *vec);
 PRIVATE void right_mult_with_vector_ff(float *, int, float *, float *);
+
+/// `right_mult_with_vector_ff` on the workers of `pool`
+///
+/// The result is identical to that of `right_mult_with_vector_ff`, which is
+/// called directly if `pool` has fewer than two workers.
+PRIVATE void right_mult_with_vector_ff_parallel(float *packed_matrix, int n,
+                                                float *vector, float *result,
+                                                gv_pool_t *pool);
+
+/// offset of row `i` in a packed upper triangular `n × n` matrix
+PRIVATE size_t packed_row(int n, int i);
 PRIVATE void vectors_subtractionf(int, float *, float *, float *);
 PRIVATE void vectors_additionf(int n, float *vector1, float *vector2,
 				  float *result);
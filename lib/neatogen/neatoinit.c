@@ -30,6 +30,7 @@
 #include <common/render.h>
 #include <common/utils.h>
 #include <neatogen/sgd.h>
+#include <neatogen/sparse_stress.h>
 #include <cgraph/cgraph.h>
 #include <float.h>
 #include <stdatomic.h>
@@ -42,17 +43,16 @@
 #include <util/gv_ctype.h>
 #include <util/gv_math.h>
 #include <util/itos.h>
+#include <util/parallel.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 #include <util/startswith.h>
 #include <util/strcasecmp.h>
 #include <util/streq.h>
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
 
-static attrsym_t *N_pos;
-static int Pack;		/* If >= 0, layout components separately and pack together
+static _Thread_local attrsym_t *N_pos;
+static _Thread_local int Pack;		/* If >= 0, layout components separately and pack together
 				 * The value of Pack gives margins around graphs.
 				 */
 static char *cc_pfx = "_neato_cc";
@@ -644,6 +644,8 @@ static int neatoMode(graph_t * g)
 	    mode = MODE_MAJOR;
 	else if (streq(str, "sgd"))
 		mode = MODE_SGD;
+	else if (streq(str, "sparse"))
+	    mode = MODE_SPARSE;
 #ifdef DIGCOLA
 	else if (streq(str, "hier"))
 	    mode = MODE_HIER;
@@ -748,7 +750,10 @@ acyclic (vtx_data* graph, int nv, int mode, node_t* nodes[])
  */
 static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int model, node_t*** nodedata)
 {
-    int ne = agnedges(g);	/* upper bound */
+    Agcsr_t *csr = agcsropen(g, NULL, 0);
+    assert(csr->n_nodes == (size_t)nv);
+    assert(csr->n_edges <= INT_MAX);
+    int ne = (int)csr->n_edges;	/* upper bound */
     float *ewgts = NULL;
     node_t *np;
     edge_t *ep;
@@ -781,11 +786,11 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 	edists = gv_calloc(edges_size, sizeof(int8_t));
 #endif
 
-    i = 0;
     ne = 0;
-    for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
+    for (i = 0; i < nv; i++) {
 	int j = 1;		/* index of neighbors */
 	clearPM(ps);
+	np = csr->nodes[i];
 	assert(ND_id(np) == i);
 	nodes[i] = np;
 	graph[i].edges = edges++;	/* reserve space for the self loop */
@@ -806,9 +811,15 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 #endif
 	size_t i_nedges = 1; // one for the self
 
-	for (ep = agfstedge(g, np); ep; ep = agnxtedge(g, ep, np)) {
-	    if (aghead(ep) == agtail(ep))
+	/* out-edges, then in-edges, in the order agfstedge visits them */
+	const size_t n_out = csr->out[i + 1] - csr->out[i];
+	const size_t n_in = csr->in[i + 1] - csr->in[i];
+	for (size_t k = 0; k < n_out + n_in; k++) {
+	    const size_t x = k < n_out ? csr->out[i] + k
+	                               : csr->in_edges[csr->in[i] + k - n_out];
+	    if (csr->tails[x] == csr->heads[x])
 		continue;	/* ignore loops */
+	    ep = csr->edges[x];
 	    idx = checkEdge(ps, ep, j);
 	    if (idx != j) {	/* seen before */
 		if (haveWt)
@@ -844,7 +855,6 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 
 	graph[i].nedges = i_nedges;
 	graph[i].edges[0] = i;
-	i++;
     }
 #ifdef DIGCOLA
     if (haveDir) {
@@ -856,7 +866,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     ne /= 2;			/* every edge is counted twice */
 
     /* If necessary, release extra memory. */
-    if (ne != agnedges(g)) {
+    if (ne != (int)csr->n_edges) {
 	edges = gv_recalloc(graph[0].edges, edges_size, 2 * ne + nv, sizeof(int));
 	if (haveLen)
 	    ewgts = gv_recalloc(graph[0].ewgts, edges_size, 2 * ne + nv, sizeof(float));
@@ -884,6 +894,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     else
         free (nodes);
     freePM(ps);
+    agcsrclose(csr);
     return graph;
 }
 
@@ -988,7 +999,7 @@ int checkStart(graph_t * G, int nG, int dflt)
 	agwarningf("node positions are ignored unless start=random\n");
     }
     if (init == INIT_REGULAR) initRegular(G, nG);
-    srand48(seed);
+    gv_srand48(seed);
     return init;
 }
 
@@ -1071,6 +1082,16 @@ void dumpOpts (ipsep_options* opp, int nv)
 }
 #endif
 
+/// workers requested by the `threads` attribute
+///
+/// @return A pool, or `NULL` to use the single threaded algorithms
+static gv_pool_t *layout_pool(graph_t *g) {
+    const int threads = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
+    if (threads == 1)
+	return NULL;
+    return gv_pool_new((size_t)threads);
+}
+
 /* Solve stress using majorization.
  * Old neato attributes to incorporate:
  *  weight
@@ -1186,7 +1207,12 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     }
     else
 #endif
-	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts, model, MaxIter);
+    {
+	gv_pool_t *pool = layout_pool(g);
+	rv = stress_majorization_kD_mkernel(gp, nv, coords, nodes, Ndim, opts,
+	                                    model, MaxIter, pool);
+	gv_pool_free(pool);
+    }
 
     if (rv < 0) {
 	agerr(AGPREV, "layout aborted\n");
@@ -1209,7 +1235,9 @@ static void subset_model(Agraph_t * G, int nG)
     vtx_data *gp;
 
     gp = makeGraphData(G, nG, &ne, MODE_KK, MODEL_SUBSET, NULL);
-    DistType **Dij = compute_apsp_artificial_weights(gp, nG);
+    gv_pool_t *pool = layout_pool(G);
+    DistType **Dij = compute_apsp_artificial_weights(gp, nG, pool);
+    gv_pool_free(pool);
     for (i = 0; i < nG; i++) {
 	for (j = 0; j < nG; j++) {
 	    GD_dist(G)[i][j] = Dij[i][j];
@@ -1282,7 +1310,7 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
 
     if ((str = agget(g, "maxiter")))
 	MaxIter = atoi(str);
-    else if (layoutMode == MODE_MAJOR)
+    else if (layoutMode == MODE_MAJOR || layoutMode == MODE_SPARSE)
 	MaxIter = DFLT_ITERATIONS;
     else if (layoutMode == MODE_SGD)
 	MaxIter = 30;
@@ -1294,9 +1322,19 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
 	return;
     if (layoutMode == MODE_KK)
 	kkNeato(g, nG, layoutModel);
-    else if (layoutMode == MODE_SGD)
-	sgd(g, layoutModel);
-    else
+    else if (layoutMode == MODE_SGD) {
+	gv_pool_t *pool = layout_pool(g);
+	sgd(g, layoutModel, late_int(g, agfindgraphattr(g, "pivots"), 0, 0),
+	    pool);
+	gv_pool_free(pool);
+    } else if (layoutMode == MODE_SPARSE) {
+	gv_pool_t *pool = layout_pool(g);
+	sparse_stress(g, layoutModel,
+	              late_int(g, agfindgraphattr(g, "pivots"),
+	                       SPARSE_STRESS_PIVOTS, 1),
+	              pool);
+	gv_pool_free(pool);
+    } else
 	majorization(mg, g, nG, layoutMode, layoutModel, Ndim, am);
 }
 
@@ -1,17 +1,23 @@
 #include "config.h"
 
 #include <assert.h>
+#include <float.h>
 #include <limits.h>
 #include <math.h>
 #include <neatogen/dijkstra.h>
+#include <neatogen/matrix_ops.h>
 #include <neatogen/neato.h>
 #include <neatogen/neatoprocs.h>
 #include <neatogen/randomkit.h>
 #include <neatogen/sgd.h>
+#include <neatogen/sparse_stress.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <util/alloc.h>
 #include <util/bitarray.h>
 #include <util/gv_math.h>
+#include <util/parallel.h>
 #include <util/unreachable.h>
 
 static double calculate_stress(double *pos, term_sgd *terms, int n_terms) {
@@ -36,15 +42,15 @@ static void fisheryates_shuffle(term_sgd *terms, int n_terms,
 }
 
 // graph_sgd data structure exists only to make dijkstras faster
-static graph_sgd *extract_adjacency(graph_t *G, int model) {
-  size_t n_nodes = 0, n_edges = 0;
-  for (node_t *np = agfstnode(G); np; np = agnxtnode(G, np)) {
-    assert(ND_id(np) == n_nodes);
-    n_nodes++;
-    for (edge_t *ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-      if (agtail(ep) != aghead(ep)) { // ignore self-loops and double edges
-        n_edges++;
-      }
+graph_sgd *extract_adjacency(graph_t *G, int model) {
+  Agcsr_t *const csr = agcsropen(G, NULL, 0);
+  const size_t n_nodes = csr->n_nodes;
+
+  // each edge other than a loop is a neighbor of both its ends
+  size_t n_edges = 0;
+  for (size_t x = 0; x < csr->n_edges; x++) {
+    if (csr->tails[x] != csr->heads[x]) { // ignore self-loops
+      n_edges += 2;
     }
   }
   graph_sgd *graph = gv_alloc(sizeof(graph_sgd));
@@ -57,29 +63,36 @@ static graph_sgd *extract_adjacency(graph_t *G, int model) {
   assert(n_edges <= INT_MAX);
   graph->sources[graph->n] = n_edges; // to make looping nice
 
-  n_nodes = 0, n_edges = 0;
-  for (node_t *np = agfstnode(G); np; np = agnxtnode(G, np)) {
-    assert(n_edges <= INT_MAX);
-    graph->sources[n_nodes] = n_edges;
-    bitarray_set(&graph->pinneds, n_nodes, isFixed(np));
-    for (edge_t *ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-      if (agtail(ep) == aghead(ep)) { // ignore self-loops and double edges
+  // visit each node’s out-edges and then its in-edges, as `agfstedge` does
+  n_edges = 0;
+  for (size_t i = 0; i < n_nodes; i++) {
+    node_t *const np = csr->nodes[i];
+    assert((size_t)ND_id(np) == i);
+    graph->sources[i] = n_edges;
+    bitarray_set(&graph->pinneds, i, isFixed(np));
+    for (size_t x = csr->out[i]; x < csr->out[i + 1]; x++) {
+      if (csr->heads[x] == i) { // ignore self-loops
+        continue;
+      }
+      graph->targets[n_edges] = csr->heads[x];
+      graph->weights[n_edges] = ED_dist(csr->edges[x]);
+      assert(graph->weights[n_edges] > 0);
+      n_edges++;
+    }
+    for (size_t y = csr->in[i]; y < csr->in[i + 1]; y++) {
+      const size_t x = csr->in_edges[y];
+      if (csr->tails[x] == i) { // ignore self-loops
         continue;
       }
-      node_t *target = (agtail(ep) == np)
-                           ? aghead(ep)
-                           : agtail(ep); // in case edge is reversed
-      graph->targets[n_edges] = (size_t)ND_id(target);
-      graph->weights[n_edges] = ED_dist(ep);
+      graph->targets[n_edges] = csr->tails[x];
+      graph->weights[n_edges] = ED_dist(csr->edges[x]);
       assert(graph->weights[n_edges] > 0);
       n_edges++;
     }
-    n_nodes++;
   }
-  assert(n_nodes == graph->n);
   assert(n_edges <= INT_MAX);
   assert(n_edges == graph->sources[graph->n]);
-  graph->sources[n_nodes] = n_edges;
+  agcsrclose(csr);
 
   if (model == MODEL_SHORTPATH) {
     // do nothing
@@ -131,7 +144,7 @@ static graph_sgd *extract_adjacency(graph_t *G, int model) {
   }
   return graph;
 }
-static void free_adjacency(graph_sgd *graph) {
+void free_adjacency(graph_sgd *graph) {
   free(graph->sources);
   bitarray_reset(&graph->pinneds);
   free(graph->targets);
@@ -139,18 +152,9 @@ static void free_adjacency(graph_sgd *graph) {
   free(graph);
 }
 
-void sgd(graph_t *G, /* input graph */
-         int model /* distance model */) {
-  if (model == MODEL_CIRCUIT) {
-    agwarningf("circuit model not yet supported in Gmode=sgd, reverting to "
-               "shortpath model\n");
-    model = MODEL_SHORTPATH;
-  }
-  if (model == MODEL_MDS) {
-    agwarningf("mds model not yet supported in Gmode=sgd, reverting to "
-               "shortpath model\n");
-    model = MODEL_SHORTPATH;
-  }
+/// lay out by SGD over all pairs of nodes, applying terms in shuffled order
+static void sgd_serial(graph_t *G, /* input graph */
+                       int model /* distance model */) {
   int n = agnnodes(G);
 
   if (Verbose) {
@@ -255,3 +259,271 @@ void sgd(graph_t *G, /* input graph */
   free(pos);
   free(unfixed);
 }
+
+/// state shared by the workers of a node-wise SGD layout
+///
+/// In each epoch, every node applies its own terms in a random order, moving
+/// only itself, against the positions the other nodes had at the start of the
+/// epoch. Nodes are thus independent within an epoch and can be updated
+/// concurrently, without locks and without the result depending on how they
+/// are divided among workers.
+typedef struct {
+  const graph_sgd *graph;
+  int n;
+  float *dist;       ///< all pairs: packed upper triangular distances
+  size_t *offsets;   ///< sampled: first term of each node, `n + 1` entries
+  term_sgd *terms;   ///< sampled: terms of each node, with `i` the node
+  float *row;        ///< per-worker Dijkstra output, `n` per worker
+  float *w_min;      ///< per-worker minimum term weight
+  float *w_max;      ///< per-worker maximum term weight
+  const double *prev; ///< positions at the start of the epoch
+  double *pos;       ///< positions being updated
+  double eta;        ///< step size of this epoch
+  int epoch;
+} nodewise_t;
+
+/// next number from a splitmix64 stream
+///
+/// This is cheap to seed, so each node can have its own stream per epoch.
+static uint64_t node_random(uint64_t *state) {
+  uint64_t h = *state += UINT64_C(0x9e3779b97f4a7c15);
+  h = (h ^ (h >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  h = (h ^ (h >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return h ^ (h >> 31);
+}
+
+static size_t gcd(size_t a, size_t b) {
+  while (b != 0) {
+    const size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/// fill in the distance rows of sources `[start, end)`
+static void nodewise_distances(void *context, size_t start, size_t end,
+                               size_t worker) {
+  const nodewise_t *s = context;
+  const size_t n = (size_t)s->n;
+  float *row = &s->row[worker * n];
+  for (size_t i = start; i < end; i++) {
+    dijkstra_sgd_dist(s->graph, (int)i, row);
+    memcpy(&s->dist[packed_row(s->n, (int)i)], &row[i],
+           (n - i) * sizeof(float));
+    for (size_t j = i + 1; j < n; j++) {
+      if (row[j] < FLT_MAX) {
+        const float w = 1 / (row[j] * row[j]);
+        s->w_min[worker] = fminf(s->w_min[worker], w);
+        s->w_max[worker] = fmaxf(s->w_max[worker], w);
+      }
+    }
+  }
+}
+
+/// move a node toward its ideal distance from another
+static void nodewise_step(double *x, const double *y, double d, double w,
+                          double eta) {
+  const double mu = fmin(eta * w, 1);
+  const double dx = x[0] - y[0];
+  const double dy = x[1] - y[1];
+  const double mag = sqrt(dx * dx + dy * dy);
+  if (mag > 0) {
+    const double r = (mu * (mag - d)) / (2 * mag);
+    x[0] -= r * dx;
+    x[1] -= r * dy;
+  }
+}
+
+/// apply the terms of nodes `[start, end)` for one epoch
+static void nodewise_epoch(void *context, size_t start, size_t end,
+                           size_t worker) {
+  (void)worker;
+  const nodewise_t *s = context;
+  const size_t n = (size_t)s->n;
+  for (size_t i = start; i < end; i++) {
+    if (bitarray_get(s->graph->pinneds, i)) {
+      continue;
+    }
+    double x[2] = {s->pos[2 * i], s->pos[2 * i + 1]};
+    uint64_t state = (uint64_t)(uint32_t)s->epoch << 32 | i;
+
+    if (s->terms != NULL) {
+      term_sgd *terms = &s->terms[s->offsets[i]];
+      const size_t count = s->offsets[i + 1] - s->offsets[i];
+      for (size_t t = count; t > 1; t--) {
+        const size_t u = node_random(&state) % t;
+        SWAP(&terms[t - 1], &terms[u]);
+      }
+      for (size_t t = 0; t < count; t++) {
+        nodewise_step(x, &s->prev[2 * terms[t].j], terms[t].d, terms[t].w,
+                      s->eta);
+      }
+    } else {
+      // visit the other nodes from a random start with a random stride
+      // coprime to their number, which reaches each exactly once
+      const float *row = &s->dist[i * (2 * n - i + 1) / 2];
+      const size_t m = n - 1;
+      size_t q = node_random(&state) % m;
+      size_t stride = 1;
+      if (m > 2) {
+        stride = 1 + node_random(&state) % (m - 1);
+        while (gcd(stride, m) != 1) {
+          stride++;
+        }
+      }
+      for (size_t t = 0; t < m; t++) {
+        const size_t j = q < i ? q : q + 1;
+        const float d = j < i ? s->dist[j * (2 * n - j + 1) / 2 + (i - j)]
+                              : row[j - i];
+        if (d < FLT_MAX) {
+          nodewise_step(x, &s->prev[2 * j], d, 1 / ((double)d * d), s->eta);
+        }
+        q += stride;
+        if (q >= m) {
+          q -= m;
+        }
+      }
+    }
+
+    s->pos[2 * i] = x[0];
+    s->pos[2 * i + 1] = x[1];
+  }
+}
+
+/// lay out by SGD with each node updated independently within an epoch
+///
+/// With `pivots` of 0, each node has a term for every other node, as in
+/// `sgd_serial`, with distances kept in a packed matrix of floats. Otherwise,
+/// each node only has terms for its neighbors and for `pivots` pivot nodes,
+/// as in `sparse_stress`.
+static void sgd_nodewise(graph_t *G, int model, int pivots, gv_pool_t *pool) {
+  const int n = agnnodes(G);
+  const size_t workers = gv_pool_size(pool);
+
+  if (Verbose) {
+    fprintf(stderr, "calculating shortest paths and setting up stress terms:");
+    start_timer();
+  }
+  graph_sgd *graph = extract_adjacency(G, model);
+  nodewise_t s = {.graph = graph, .n = n};
+  float w_min = FLT_MAX, w_max = 0;
+  if (pivots > 0) {
+    rk_state rstate;
+    rk_seed(0, &rstate);
+    pivot_terms_t pt = pivot_terms_new(graph, pivots, &rstate, pool);
+    const size_t k = (size_t)pt.k;
+
+    s.offsets = gv_calloc((size_t)n + 1, sizeof(size_t));
+    for (int i = 0; i < n; i++) {
+      size_t count = graph->sources[i + 1] - graph->sources[i];
+      for (size_t p = 0; p < k; p++) {
+        count += pt.weight[(size_t)i * k + p] > 0;
+      }
+      s.offsets[i + 1] = s.offsets[i] + count;
+    }
+    s.terms = gv_calloc(s.offsets[n], sizeof(term_sgd));
+    for (int i = 0; i < n; i++) {
+      term_sgd *t = &s.terms[s.offsets[i]];
+      for (size_t x = graph->sources[i]; x < graph->sources[i + 1]; x++) {
+        const float d = graph->weights[x];
+        *t++ = (term_sgd){.i = i, .j = (int)graph->targets[x], .d = d,
+                          .w = 1 / (d * d)};
+      }
+      for (size_t p = 0; p < k; p++) {
+        const float w = pt.weight[(size_t)i * k + p];
+        if (w > 0) {
+          *t++ = (term_sgd){.i = i, .j = pt.pivots[p],
+                            .d = pt.dist[(size_t)i * k + p], .w = w};
+        }
+      }
+    }
+    for (size_t t = 0; t < s.offsets[n]; t++) {
+      w_min = fminf(w_min, s.terms[t].w);
+      w_max = fmaxf(w_max, s.terms[t].w);
+    }
+    pivot_terms_free(&pt);
+  } else {
+    s.dist = gv_calloc(packed_row(n, n), sizeof(float));
+    s.row = gv_calloc(workers * (size_t)n, sizeof(float));
+    s.w_min = gv_calloc(workers, sizeof(float));
+    s.w_max = gv_calloc(workers, sizeof(float));
+    for (size_t w = 0; w < workers; w++) {
+      s.w_min[w] = FLT_MAX;
+    }
+    gv_pool_for(pool, (size_t)n, 1, nodewise_distances, &s);
+    for (size_t w = 0; w < workers; w++) {
+      w_min = fminf(w_min, s.w_min[w]);
+      w_max = fmaxf(w_max, s.w_max[w]);
+    }
+    free(s.w_max);
+    free(s.w_min);
+    free(s.row);
+  }
+  if (Verbose) {
+    fprintf(stderr, " %.2f sec\n", elapsed_sec());
+  }
+
+  // initialise annealing schedule as for sgd_serial
+  if (w_max == 0) { // no terms, e.g. all nodes are pinned
+    w_min = w_max = 1;
+  }
+  const double eta_max = 1.0 / w_min;
+  const double eta_min = Epsilon / w_max;
+  const double lambda = log(eta_max / eta_min) / (MaxIter - 1);
+
+  initial_positions(G, n);
+  double *pos = gv_calloc(2 * (size_t)n, sizeof(double));
+  double *prev = gv_calloc(2 * (size_t)n, sizeof(double));
+  for (int i = 0; i < n; i++) {
+    node_t *node = GD_neato_nlist(G)[i];
+    pos[2 * i] = ND_pos(node)[0];
+    pos[2 * i + 1] = ND_pos(node)[1];
+  }
+  s.pos = pos;
+  s.prev = prev;
+
+  if (Verbose) {
+    fprintf(stderr, "solving model:");
+    start_timer();
+  }
+  for (int t = 0; t < MaxIter; t++) {
+    memcpy(prev, pos, 2 * (size_t)n * sizeof(double));
+    s.epoch = t;
+    s.eta = eta_max * exp(-lambda * t);
+    gv_pool_for(pool, (size_t)n, 64, nodewise_epoch, &s);
+  }
+  if (Verbose) {
+    fprintf(stderr, " finished in %.2f sec\n", elapsed_sec());
+  }
+
+  for (int i = 0; i < n; i++) {
+    node_t *node = GD_neato_nlist(G)[i];
+    ND_pos(node)[0] = pos[2 * i];
+    ND_pos(node)[1] = pos[2 * i + 1];
+  }
+  free(prev);
+  free(pos);
+  free(s.terms);
+  free(s.offsets);
+  free(s.dist);
+  free_adjacency(graph);
+}
+
+void sgd(graph_t *G, int model, int pivots, gv_pool_t *pool) {
+  if (model == MODEL_CIRCUIT) {
+    agwarningf("circuit model not yet supported in Gmode=sgd, reverting to "
+               "shortpath model\n");
+    model = MODEL_SHORTPATH;
+  }
+  if (model == MODEL_MDS) {
+    agwarningf("mds model not yet supported in Gmode=sgd, reverting to "
+               "shortpath model\n");
+    model = MODEL_SHORTPATH;
+  }
+  if (pool == NULL && pivots == 0) {
+    sgd_serial(G, model);
+  } else {
+    sgd_nodewise(G, model, pivots, pool);
+  }
+}
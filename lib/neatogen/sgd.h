@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <util/api.h>
 #include <util/bitarray.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,7 +23,28 @@ typedef struct graph_sgd {
     float *weights; // weights of edges (length sources[n])
 } graph_sgd;
 
-PRIVATE void sgd(graph_t *, int);
+/// build the adjacency lists of a graph prepared by `scan_graph_mode`
+///
+/// @param G Graph
+/// @param model Distance model, `MODEL_SHORTPATH` or `MODEL_SUBSET`
+/// @return Adjacency to be later freed with `free_adjacency`
+PRIVATE graph_sgd *extract_adjacency(graph_t *G, int model);
+PRIVATE void free_adjacency(graph_sgd *graph);
+
+/// lay out a graph by stochastic gradient descent on its stress
+///
+/// Without a pool or pivots, every pair of nodes contributes a term and terms
+/// are applied in a random order. Otherwise, each epoch updates every node
+/// independently against the positions of the previous epoch, which lets
+/// nodes be updated concurrently and gives the same layout for any number of
+/// workers.
+///
+/// @param G Graph, prepared by `scan_graph_mode`
+/// @param model Distance model
+/// @param pivots If non-zero, sample terms from this many pivots instead of
+///   using all pairs of nodes, as in `sparse_stress`
+/// @param pool Optional workers to share the computation with
+PRIVATE void sgd(graph_t *G, int model, int pivots, gv_pool_t *pool);
 
 #ifdef __cplusplus
 }
@@ -13,7 +13,7 @@
 #include <neatogen/site.h>
 #include <math.h>
 
-Site *bottomsite;
+_Thread_local Site *bottomsite;
 
 double ngdist(Site * s, Site * t)
 {
@@ -25,7 +25,7 @@ typedef struct Site {
   size_t sitenbr;
 } Site;
 
-extern Site *bottomsite;
+extern _Thread_local Site *bottomsite;
 
 PRIVATE double ngdist(Site *, Site *); /* Distance between two sites */
 
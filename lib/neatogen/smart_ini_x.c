@@ -14,6 +14,7 @@
 #include <math.h>
 #include <neatogen/digcola.h>
 #include <util/alloc.h>
+#include <util/random.h>
 #ifdef DIGCOLA
 #include <neatogen/kkutils.h>
 #include <neatogen/matrix_ops.h>
@@ -92,7 +93,7 @@ power_iteration_orthog(float** square_mat, int n, int neigs,
 		/* guess the i-th eigen vector */
 choose:
 		for (j=0; j<n; j++) {
-			curr_vector[j] = rand()%100;
+			curr_vector[j] = gv_rand()%100;
 		}
 
 		assert(orthog != NULL);
@@ -145,7 +146,7 @@ exit:
 		curr_vector = eigs[i];
 		/* guess the i-th eigen vector */
 		for (j=0; j<n; j++)
-			curr_vector[j] = rand()%100;
+			curr_vector[j] = gv_rand()%100;
 		/* orthogonalize against higher eigenvectors */
 		for (j=0; j<i; j++) {
 			alpha = -vectors_inner_product(n, eigs[j], curr_vector);
@@ -266,7 +267,7 @@ int IMDS_given_dim(vtx_data* graph, int n, double* given_coords,
 	double b;
 	bool converged;
 
-	Dij = compute_apsp(graph, n);
+	Dij = compute_apsp(graph, n, NULL);
 	
 	/* scaling up the distances to enable an 'sqrt' operation later 
      * (in case distances are integers)
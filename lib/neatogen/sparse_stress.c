@@ -0,0 +1,488 @@
+/// @file
+/// @brief sparse stress layout, neato’s `mode=sparse`
+///
+/// This follows Ortmann, Klimenta and Brandes, “A Sparse Stress Model”, JGAA
+/// 21(5), 2017. Instead of a stress term for every pair of nodes, each node has
+/// a term for each of its neighbors and one for each of `k` pivots. The term
+/// for pivot p stands in for the nodes of p’s region (those nearer to p than
+/// to any other pivot) that are closer to p than to the node, and is weighted
+/// by their number. The starting layout is pivot MDS (Brandes and Pich,
+/// “Eigensolver Methods for Progressive Multidimensional Scaling of Large
+/// Data”, GD 2006), computed from the same pivot distances.
+
+#include "config.h"
+
+#include <assert.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <neatogen/dijkstra.h>
+#include <neatogen/matrix_ops.h>
+#include <neatogen/neato.h>
+#include <neatogen/neatoprocs.h>
+#include <neatogen/randomkit.h>
+#include <neatogen/sgd.h>
+#include <neatogen/sparse_stress.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+#include <util/bitarray.h>
+#include <util/gv_math.h>
+#include <util/parallel.h>
+
+/// state shared by the workers computing pivot terms
+typedef struct {
+  const graph_sgd *graph;
+  int n;               ///< number of nodes
+  pivot_terms_t terms; ///< output
+  int *region;         ///< pivot nearest to each node
+  float **region_dist; ///< sorted distances from each pivot to its region
+  int *region_size;    ///< number of nodes in each pivot’s region
+  int *marks;          ///< per-worker neighbor markers, `n` per worker
+} pivot_state_t;
+
+/// state shared by the workers of a sparse stress layout
+typedef struct {
+  const graph_sgd *graph;
+  int n;               ///< number of nodes
+  int dim;             ///< number of dimensions
+  pivot_terms_t terms;
+  double *C;           ///< double-centered squared pivot distances, `k` per node
+  double **M;          ///< k × k product CᵀC
+  double **eigs;       ///< `dim` eigenvectors of `M`
+  double *pos;         ///< current positions, `dim` per node
+  double *next;        ///< next positions, `dim` per node
+  double *moved;       ///< distance each node moved in the last iteration
+} sstress_t;
+
+static int cmp_float(const void *a, const void *b) {
+  const float x = *(const float *)a;
+  const float y = *(const float *)b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/// number of entries in sorted `xs[0 … n - 1]` that are `≤ x`
+static int count_le(const float *xs, int n, float x) {
+  int lo = 0, hi = n;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (xs[mid] <= x) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/// choose pivots by max/min selection, filling in the distances from each
+///
+/// Each pivot after the first is the node furthest from all pivots chosen so
+/// far, which spreads pivots evenly over the graph and puts at least one in
+/// each connected component.
+static void choose_pivots(pivot_state_t *s, rk_state *rstate) {
+  const int n = s->n;
+  const int k = s->terms.k;
+  float *mindist = gv_calloc((size_t)n, sizeof(float));
+  float *row = gv_calloc((size_t)n, sizeof(float));
+  for (int i = 0; i < n; i++) {
+    mindist[i] = FLT_MAX;
+  }
+
+  int pivot = (int)rk_interval((unsigned long)n - 1, rstate);
+  for (int p = 0; p < k; p++) {
+    s->terms.pivots[p] = pivot;
+    dijkstra_sgd_dist(s->graph, pivot, row);
+
+    // stand in for unreachable nodes like the other neato distance models do
+    float longest = 0;
+    for (int i = 0; i < n; i++) {
+      if (row[i] < FLT_MAX) {
+        longest = fmaxf(longest, row[i]);
+      }
+    }
+    for (int i = 0; i < n; i++) {
+      if (row[i] == FLT_MAX) {
+        row[i] = longest + 10;
+      }
+    }
+
+    int furthest = 0;
+    for (int i = 0; i < n; i++) {
+      s->terms.dist[(size_t)i * (size_t)k + (size_t)p] = row[i];
+      mindist[i] = fminf(mindist[i], row[i]);
+      if (mindist[i] > mindist[furthest]) {
+        furthest = i;
+      }
+    }
+    pivot = furthest;
+  }
+
+  free(row);
+  free(mindist);
+}
+
+/// partition nodes into the regions of their nearest pivots
+static void assign_regions(pivot_state_t *s) {
+  const int n = s->n;
+  const int k = s->terms.k;
+  const float *dist = s->terms.dist;
+  s->region = gv_calloc((size_t)n, sizeof(int));
+  s->region_size = gv_calloc((size_t)k, sizeof(int));
+  for (int i = 0; i < n; i++) {
+    const float *d = &dist[(size_t)i * (size_t)k];
+    int nearest = 0;
+    for (int p = 1; p < k; p++) {
+      if (d[p] < d[nearest]) {
+        nearest = p;
+      }
+    }
+    s->region[i] = nearest;
+    s->region_size[nearest]++;
+  }
+
+  s->region_dist = gv_calloc((size_t)k, sizeof(float *));
+  int *fill = gv_calloc((size_t)k, sizeof(int));
+  for (int p = 0; p < k; p++) {
+    s->region_dist[p] = gv_calloc((size_t)s->region_size[p], sizeof(float));
+  }
+  for (int i = 0; i < n; i++) {
+    const int p = s->region[i];
+    s->region_dist[p][fill[p]++] = dist[(size_t)i * (size_t)k + (size_t)p];
+  }
+  for (int p = 0; p < k; p++) {
+    qsort(s->region_dist[p], (size_t)s->region_size[p], sizeof(float),
+          cmp_float);
+  }
+  free(fill);
+}
+
+/// compute the pivot term weights of nodes `[start, end)`
+static void pivot_weights(void *context, size_t start, size_t end,
+                          size_t worker) {
+  const pivot_state_t *s = context;
+  const graph_sgd *graph = s->graph;
+  const int k = s->terms.k;
+  int *marks = &s->marks[worker * (size_t)s->n];
+
+  for (size_t i = start; i < end; i++) {
+    // neighbors already have a term for their edge
+    for (size_t x = graph->sources[i]; x < graph->sources[i + 1]; x++) {
+      marks[graph->targets[x]] = (int)i + 1;
+    }
+    const float *d = &s->terms.dist[i * (size_t)k];
+    float *w = &s->terms.weight[i * (size_t)k];
+    for (int p = 0; p < k; p++) {
+      const int pivot = s->terms.pivots[p];
+      if (pivot == (int)i || marks[pivot] == (int)i + 1 || d[p] <= 0) {
+        w[p] = 0;
+        continue;
+      }
+      const int nearer =
+          count_le(s->region_dist[p], s->region_size[p], d[p] / 2);
+      w[p] = (float)nearer / (d[p] * d[p]);
+    }
+  }
+}
+
+pivot_terms_t pivot_terms_new(const graph_sgd *graph, int k, rk_state *rstate,
+                              gv_pool_t *pool) {
+  assert(graph->n > 0 && graph->n <= INT_MAX);
+  const int n = (int)graph->n;
+  k = imax(1, imin(n, k));
+  pivot_state_t s = {.graph = graph, .n = n, .terms = {.k = k}};
+  s.terms.pivots = gv_calloc((size_t)k, sizeof(int));
+  s.terms.dist = gv_calloc((size_t)n * (size_t)k, sizeof(float));
+  s.terms.weight = gv_calloc((size_t)n * (size_t)k, sizeof(float));
+  s.marks = gv_calloc(gv_pool_size(pool) * (size_t)n, sizeof(int));
+
+  choose_pivots(&s, rstate);
+  assign_regions(&s);
+  gv_pool_for(pool, (size_t)n, 256, pivot_weights, &s);
+
+  free(s.marks);
+  for (int p = 0; p < k; p++) {
+    free(s.region_dist[p]);
+  }
+  free(s.region_dist);
+  free(s.region_size);
+  free(s.region);
+  return s.terms;
+}
+
+void pivot_terms_free(pivot_terms_t *terms) {
+  free(terms->weight);
+  free(terms->dist);
+  free(terms->pivots);
+  *terms = (pivot_terms_t){0};
+}
+
+/// compute rows `[start, end)` of M = CᵀC
+static void pivot_mds_product(void *context, size_t start, size_t end,
+                              size_t worker) {
+  (void)worker;
+  const sstress_t *s = context;
+  const size_t k = (size_t)s->terms.k;
+  for (size_t p = start; p < end; p++) {
+    double *row = s->M[p];
+    for (size_t q = 0; q < k; q++) {
+      row[q] = 0;
+    }
+    for (size_t i = 0; i < (size_t)s->n; i++) {
+      const double *c = &s->C[i * k];
+      for (size_t q = 0; q < k; q++) {
+        row[q] += c[p] * c[q];
+      }
+    }
+  }
+}
+
+/// project nodes `[start, end)` onto the eigenvectors of M
+static void pivot_mds_project(void *context, size_t start, size_t end,
+                              size_t worker) {
+  (void)worker;
+  const sstress_t *s = context;
+  const size_t k = (size_t)s->terms.k;
+  for (size_t i = start; i < end; i++) {
+    const double *c = &s->C[i * k];
+    for (int d = 0; d < s->dim; d++) {
+      double x = 0;
+      for (size_t p = 0; p < k; p++) {
+        x += c[p] * s->eigs[d][p];
+      }
+      s->pos[i * (size_t)s->dim + (size_t)d] = x;
+    }
+  }
+}
+
+/// initialize positions by pivot MDS
+static void pivot_mds(sstress_t *s, gv_pool_t *pool, rk_state *rstate) {
+  const int n = s->n;
+  const int k = s->terms.k;
+  const int dim = s->dim;
+
+  // double center the squared distances
+  s->C = gv_calloc((size_t)n * (size_t)k, sizeof(double));
+  double *col_mean = gv_calloc((size_t)k, sizeof(double));
+  double mean = 0;
+  for (int i = 0; i < n; i++) {
+    double *c = &s->C[(size_t)i * (size_t)k];
+    const float *d = &s->terms.dist[(size_t)i * (size_t)k];
+    double row_mean = 0;
+    for (int p = 0; p < k; p++) {
+      c[p] = (double)d[p] * d[p];
+      row_mean += c[p];
+      col_mean[p] += c[p];
+    }
+    row_mean /= k;
+    mean += row_mean;
+    for (int p = 0; p < k; p++) {
+      c[p] -= row_mean;
+    }
+  }
+  mean /= n;
+  for (int p = 0; p < k; p++) {
+    col_mean[p] /= n;
+  }
+  for (size_t i = 0; i < (size_t)n * (size_t)k; i++) {
+    const size_t p = i % (size_t)k;
+    s->C[i] = -0.5 * (s->C[i] - col_mean[p] + mean);
+  }
+  free(col_mean);
+
+  s->M = gv_calloc((size_t)k, sizeof(double *));
+  for (int p = 0; p < k; p++) {
+    s->M[p] = gv_calloc((size_t)k, sizeof(double));
+  }
+  gv_pool_for(pool, (size_t)k, 1, pivot_mds_product, s);
+
+  s->eigs = gv_calloc((size_t)dim, sizeof(double *));
+  for (int d = 0; d < dim; d++) {
+    s->eigs[d] = gv_calloc((size_t)k, sizeof(double));
+  }
+  power_iteration(s->M, k, dim, s->eigs);
+  gv_pool_for(pool, (size_t)n, 256, pivot_mds_project, s);
+
+  // scale to best fit the edge lengths
+  const graph_sgd *graph = s->graph;
+  double num = 0, den = 0;
+  for (int i = 0; i < n; i++) {
+    for (size_t x = graph->sources[i]; x < graph->sources[i + 1]; x++) {
+      const size_t j = graph->targets[x];
+      double r = 0;
+      for (int d = 0; d < dim; d++) {
+        const double delta = s->pos[(size_t)i * (size_t)dim + (size_t)d] -
+                             s->pos[j * (size_t)dim + (size_t)d];
+        r += delta * delta;
+      }
+      r = sqrt(r);
+      const double w = 1.0 / ((double)graph->weights[x] * graph->weights[x]);
+      num += w * graph->weights[x] * r;
+      den += w * r * r;
+    }
+  }
+  const double scale = den > 0 ? num / den : 1;
+
+  // nodes with identical pivot distances land on the same point, so nudge them
+  // apart to let the stress terms separate them
+  for (size_t i = 0; i < (size_t)n * (size_t)dim; i++) {
+    const double jitter = (double)rk_interval(1000, rstate) / 1000 - 0.5;
+    s->pos[i] = s->pos[i] * scale + 1e-3 * jitter;
+  }
+
+  for (int d = 0; d < dim; d++) {
+    free(s->eigs[d]);
+  }
+  free(s->eigs);
+  s->eigs = NULL;
+  for (int p = 0; p < k; p++) {
+    free(s->M[p]);
+  }
+  free(s->M);
+  s->M = NULL;
+  free(s->C);
+  s->C = NULL;
+}
+
+/// add the majorization of one stress term between `i` and `j` to `num`
+///
+/// @return The weight of the term
+static double add_term(const double *xi, const double *xj, int dim, double d,
+                       double w, double *num) {
+  double r = 0;
+  for (int k = 0; k < dim; k++) {
+    r += (xi[k] - xj[k]) * (xi[k] - xj[k]);
+  }
+  r = sqrt(r);
+  for (int k = 0; k < dim; k++) {
+    num[k] += w * (r > 0 ? xj[k] + d * (xi[k] - xj[k]) / r : xj[k]);
+  }
+  return w;
+}
+
+/// move nodes `[start, end)` to minimize their stress given the others
+static void update_nodes(void *context, size_t start, size_t end,
+                         size_t worker) {
+  (void)worker;
+  const sstress_t *s = context;
+  const graph_sgd *graph = s->graph;
+  const size_t dim = (size_t)s->dim;
+  const size_t k = (size_t)s->terms.k;
+
+  for (size_t i = start; i < end; i++) {
+    const double *xi = &s->pos[i * dim];
+    double *next = &s->next[i * dim];
+    if (bitarray_get(graph->pinneds, i)) {
+      memcpy(next, xi, dim * sizeof(double));
+      s->moved[i] = 0;
+      continue;
+    }
+
+    double num[MAXDIM] = {0};
+    double den = 0;
+    for (size_t x = graph->sources[i]; x < graph->sources[i + 1]; x++) {
+      const double d = graph->weights[x];
+      den += add_term(xi, &s->pos[graph->targets[x] * dim], s->dim, d,
+                      1 / (d * d), num);
+    }
+    const float *dist = &s->terms.dist[i * k];
+    const float *weight = &s->terms.weight[i * k];
+    for (size_t p = 0; p < k; p++) {
+      if (weight[p] > 0) {
+        den += add_term(xi, &s->pos[(size_t)s->terms.pivots[p] * dim], s->dim,
+                        dist[p], weight[p], num);
+      }
+    }
+
+    double moved = 0;
+    for (size_t d = 0; d < dim; d++) {
+      next[d] = den > 0 ? num[d] / den : xi[d];
+      moved += (next[d] - xi[d]) * (next[d] - xi[d]);
+    }
+    s->moved[i] = sqrt(moved);
+  }
+}
+
+void sparse_stress(graph_t *G, int model, int pivots, gv_pool_t *pool) {
+  if (model == MODEL_CIRCUIT || model == MODEL_MDS) {
+    agwarningf("%s model not supported in Gmode=sparse, reverting to "
+               "shortpath model\n",
+               model == MODEL_CIRCUIT ? "circuit" : "mds");
+    model = MODEL_SHORTPATH;
+  }
+  const int n = agnnodes(G);
+  const int dim = Ndim;
+
+  if (Verbose) {
+    fprintf(stderr, "calculating pivot distances and stress terms:");
+    start_timer();
+  }
+  rk_state rstate;
+  rk_seed(0, &rstate);
+
+  sstress_t s = {.graph = extract_adjacency(G, model), .n = n, .dim = dim};
+  s.terms = pivot_terms_new(s.graph, pivots, &rstate, pool);
+  s.pos = gv_calloc((size_t)n * (size_t)dim, sizeof(double));
+  s.next = gv_calloc((size_t)n * (size_t)dim, sizeof(double));
+  s.moved = gv_calloc((size_t)n, sizeof(double));
+  if (Verbose) {
+    fprintf(stderr, " %.2f sec\n", elapsed_sec());
+    start_timer();
+  }
+
+  // start from pivot MDS, unless the user has placed some nodes
+  bool user_pos = false;
+  for (int i = 0; i < n; i++) {
+    user_pos |= hasPos(GD_neato_nlist(G)[i]);
+  }
+  if (user_pos) {
+    initial_positions(G, n);
+    for (int i = 0; i < n; i++) {
+      const node_t *node = GD_neato_nlist(G)[i];
+      for (int d = 0; d < dim; d++) {
+        s.pos[(size_t)i * (size_t)dim + (size_t)d] = ND_pos(node)[d];
+      }
+    }
+  } else {
+    pivot_mds(&s, pool, &rstate);
+  }
+  if (Verbose) {
+    fprintf(stderr, "initial positions: %.2f sec\nsolving model:",
+            elapsed_sec());
+    start_timer();
+  }
+
+  int iterations;
+  for (iterations = 0; iterations < MaxIter; iterations++) {
+    gv_pool_for(pool, (size_t)n, 256, update_nodes, &s);
+    double moved = 0, size = 0;
+    for (int i = 0; i < n; i++) {
+      moved += s.moved[i];
+      for (int d = 0; d < dim; d++) {
+        size += fabs(s.next[(size_t)i * (size_t)dim + (size_t)d]);
+      }
+    }
+    SWAP(&s.pos, &s.next);
+    if (moved <= Epsilon * size) {
+      iterations++;
+      break;
+    }
+  }
+  if (Verbose) {
+    fprintf(stderr, " %d iterations %.2f sec\n", iterations, elapsed_sec());
+  }
+
+  for (int i = 0; i < n; i++) {
+    node_t *node = GD_neato_nlist(G)[i];
+    for (int d = 0; d < dim; d++) {
+      ND_pos(node)[d] = s.pos[(size_t)i * (size_t)dim + (size_t)d];
+    }
+  }
+
+  free(s.moved);
+  free(s.next);
+  free(s.pos);
+  pivot_terms_free(&s.terms);
+  free_adjacency((graph_sgd *)s.graph);
+}
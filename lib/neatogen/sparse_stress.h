@@ -0,0 +1,60 @@
+/// @file
+/// @brief sparse stress layout, neato’s `mode=sparse`
+
+#pragma once
+
+#include <common/types.h>
+#include <neatogen/randomkit.h>
+#include <neatogen/sgd.h>
+#include <util/api.h>
+#include <util/parallel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// default number of pivots used by `sparse_stress`
+enum { SPARSE_STRESS_PIVOTS = 100 };
+
+/// the pivot terms of a sparse stress model
+///
+/// Each node has a term for each pivot, standing in for the nodes in that
+/// pivot’s region that are closer to the pivot than to the node. The terms of
+/// node `i` are entries `i × k … i × k + k - 1` of `dist` and `weight`.
+typedef struct {
+  int k;         ///< number of pivots
+  int *pivots;   ///< node index of each pivot
+  float *dist;   ///< distance from each node to each pivot, `k` per node
+  float *weight; ///< weight of each term, 0 if the node has no such term
+} pivot_terms_t;
+
+/// choose pivots and compute the pivot terms of a graph
+///
+/// A node has no term for itself or its neighbors, as it already has one for
+/// each edge.
+///
+/// @param graph Adjacency, as from `extract_adjacency`
+/// @param k Number of pivots, reduced to the number of nodes if greater
+/// @param rstate Random state, used to choose the first pivot
+/// @param pool Optional workers to share the computation with
+/// @return Terms to be later freed with `pivot_terms_free`
+PRIVATE pivot_terms_t pivot_terms_new(const graph_sgd *graph, int k,
+                                      rk_state *rstate, gv_pool_t *pool);
+PRIVATE void pivot_terms_free(pivot_terms_t *terms);
+
+/// lay out a connected graph by minimizing sparse stress
+///
+/// Each node is placed relative to its neighbors and to a fixed set of pivot
+/// nodes, rather than to every other node. Memory use is proportional to the
+/// number of nodes times the number of pivots, instead of to the number of
+/// nodes squared as for `mode=major`.
+///
+/// @param G Graph, prepared by `scan_graph_mode`
+/// @param model Distance model, `MODEL_SHORTPATH` or `MODEL_SUBSET`
+/// @param pivots Number of pivots
+/// @param pool Optional workers to share the computation with
+PRIVATE void sparse_stress(graph_t *G, int model, int pivots, gv_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
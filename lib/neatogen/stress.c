@@ -25,6 +25,9 @@
 #include <stdlib.h>
 #include <time.h>
 #include <util/alloc.h>
+#include <util/gv_math.h>
+#include <util/parallel.h>
+#include <util/random.h>
 
 // the terms in the stress energy are normalized by dᵢⱼ¯²
 
@@ -151,11 +154,11 @@ int initLayout(int n, int dim, double **coords, node_t **nodes) {
 	    if (isFixed(np))
 		pinned = 1;
 	} else {
-	    *xp++ = drand48();
-	    *yp++ = drand48();
+	    *xp++ = gv_drand48();
+	    *yp++ = gv_drand48();
 	    if (dim > 2) {
 		for (d = 2; d < dim; d++)
-		    coords[d][i] = drand48();
+		    coords[d][i] = gv_drand48();
 	    }
 	}
     }
@@ -344,7 +347,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
     // select `num_centers` pivots that are uniformly spread over the graph
 
     /* the first pivots is selected randomly */
-    node = rand() % n;
+    node = gv_rand() % n;
     CenterIndex[node] = 0;
     invCenterIndex[0] = node;
 
@@ -376,7 +379,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	for (int j = 0; j < n; j++) {
 	    dist[j] = MIN(dist[j], Dij[i][j]);
 	    if (dist[j] > max_dist
-		|| (dist[j] == max_dist && rand() % (j + 1) == 0)) {
+		|| (dist[j] == max_dist && gv_rand() % (j + 1) == 0)) {
 		node = j;
 		max_dist = dist[j];
 	    }
@@ -531,7 +534,7 @@ static int sparse_stress_subspace_majorization_kD(vtx_data * graph,	/* Input gra
 	/* random initialization */
 	for (k = 0; k < dim; k++) {
 	    for (i = 0; i < subspace_dim; i++) {
-		directions[k][i] = (double) rand() / RAND_MAX;
+		directions[k][i] = (double) gv_rand() / GV_RAND_MAX;
 	    }
 	}
     }
@@ -639,30 +642,61 @@ finish0:
     return iterations;
 }
 
+/// state shared by the workers of an all-pairs shortest path computation
+typedef struct {
+    vtx_data *graph;
+    int n;
+    float *Dij;    ///< packed upper triangle, one row per source
+    void *scratch; ///< distances from the current source, `n` per worker
+} apsp_t;
+
+/// fill rows `[start, end)` of a packed distance matrix using Dijkstra
+static void weighted_apsp_rows(void *context, size_t start, size_t end,
+                               size_t worker) {
+    apsp_t *a = context;
+    float *Di = (float *)a->scratch + worker * (size_t)a->n;
+    for (size_t i = start; i < end; i++) {
+	dijkstra_f((int)i, a->graph, a->n, Di);
+	float *row = a->Dij + packed_row(a->n, (int)i);
+	for (int j = (int)i; j < a->n; j++) {
+	    *row++ = Di[j];
+	}
+    }
+}
+
+/// fill rows `[start, end)` of a packed distance matrix using BFS
+static void apsp_rows(void *context, size_t start, size_t end, size_t worker) {
+    apsp_t *a = context;
+    DistType *Di = (DistType *)a->scratch + worker * (size_t)a->n;
+    for (size_t i = start; i < end; i++) {
+	bfs((int)i, a->graph, a->n, Di);
+	float *row = a->Dij + packed_row(a->n, (int)i);
+	for (int j = (int)i; j < a->n; j++) {
+	    *row++ = (float)Di[j];
+	}
+    }
+}
+
 /* compute_weighted_apsp_packed:
  * Edge lengths can be any float > 0
  */
-static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
+static float *compute_weighted_apsp_packed(vtx_data *graph, int n,
+                                           gv_pool_t *pool)
 {
-    int i, j, count;
-    float *Dij = gv_calloc(n * (n + 1) / 2, sizeof(float));
+    apsp_t a = {.graph = graph, .n = n,
+                .Dij = gv_calloc(packed_row(n, n), sizeof(float))};
+    a.scratch = gv_calloc(gv_pool_size(pool) * (size_t)n, sizeof(float));
 
-    float *Di = gv_calloc(n, sizeof(float));
+    // each source is a whole traversal, so hand them out one at a time
+    gv_pool_for(pool, (size_t)n, 1, weighted_apsp_rows, &a);
 
-    count = 0;
-    for (i = 0; i < n; i++) {
-	dijkstra_f(i, graph, n, Di);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = Di[j];
-	}
-    }
-    free(Di);
-    return Dij;
+    free(a.scratch);
+    return a.Dij;
 }
 
 
 /// update matrix with actual edge lengths
-float *mdsModel(vtx_data * graph, int nG)
+float *mdsModel(vtx_data *graph, int nG, gv_pool_t *pool)
 {
     int i, j;
     float *Dij;
@@ -673,7 +707,7 @@ float *mdsModel(vtx_data * graph, int nG)
 	return 0;
 
     /* first, compute shortest paths to fill in non-edges */
-    Dij = compute_weighted_apsp_packed(graph, nG);
+    Dij = compute_weighted_apsp_packed(graph, nG, pool);
 
     /* then, replace edge entries will user-supplied len */
     for (i = 0; i < nG; i++) {
@@ -693,25 +727,20 @@ float *mdsModel(vtx_data * graph, int nG)
 }
 
 /// assumes integral weights > 0
-float *compute_apsp_packed(vtx_data * graph, int n)
+float *compute_apsp_packed(vtx_data *graph, int n, gv_pool_t *pool)
 {
-    int i, j, count;
-    float *Dij = gv_calloc(n * (n + 1) / 2, sizeof(float));
+    apsp_t a = {.graph = graph, .n = n,
+                .Dij = gv_calloc(packed_row(n, n), sizeof(float))};
+    a.scratch = gv_calloc(gv_pool_size(pool) * (size_t)n, sizeof(DistType));
 
-    DistType *Di = gv_calloc(n, sizeof(DistType));
+    gv_pool_for(pool, (size_t)n, 1, apsp_rows, &a);
 
-    count = 0;
-    for (i = 0; i < n; i++) {
-	bfs(i, graph, n, Di);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = (float)Di[j];
-	}
-    }
-    free(Di);
-    return Dij;
+    free(a.scratch);
+    return a.Dij;
 }
 
-float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
+float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n,
+                                              gv_pool_t *pool) {
     /* compute all-pairs-shortest-path-length while weighting the graph */
     /* so high-degree nodes are distantly located */
 
@@ -743,7 +772,7 @@ float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
 	    graph[i].ewgts = weights;
 	    weights += graph[i].nedges;
 	}
-	Dij = compute_weighted_apsp_packed(graph, n);
+	Dij = compute_weighted_apsp_packed(graph, n, pool);
     } else {
 	for (i = 0; i < n; i++) {
 	    graph[i].ewgts = weights;
@@ -758,7 +787,7 @@ float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n) {
 	    empty_neighbors_vec(graph, i, vtx_vec);
 	    weights += graph[i].nedges;
 	}
-	Dij = compute_apsp_packed(graph, n);
+	Dij = compute_apsp_packed(graph, n, pool);
     }
 
     free(vtx_vec);
@@ -791,6 +820,132 @@ static void dumpMatrix(float *Dij, int n)
  */
 #define DegType long double
 
+/// the Laplacian of 1 ÷ (dᵢⱼ × |pᵢ - pⱼ|) recomputed in each iteration
+typedef struct {
+    int n;
+    int dim;
+    int exp;
+    float **coords;
+    float *lap2;          ///< packed Laplacian of the weights
+    float *lap1;          ///< packed Laplacian being computed
+    DegType *degrees;     ///< negated diagonal being computed
+    DegType *row_degree;  ///< off-diagonal sum of each row
+    float *scratch;       ///< `n - 1` distances per worker
+} laplacian_t;
+
+/// compute the off-diagonal entries of row `i`, returning their sum
+static DegType laplacian_row(const laplacian_t *l, int i,
+                             float *dist_accumulator) {
+    const int n = l->n;
+    const int len = n - i - 1;
+    float *const row = l->lap1 + packed_row(n, i);
+
+    if (l->exp == 2) {
+	sqrt_vecf(len + 1, l->lap2 + packed_row(n, i), row);
+    }
+
+    /* init 'dist_accumulator' with zeros */
+    set_vector_valf(len, 0, dist_accumulator);
+
+    /* put into 'dist_accumulator' all squared distances between 'i' and 'i'+1,...,'n'-1 */
+    for (int k = 0; k < l->dim; k++) {
+	const float *const c = l->coords[k];
+	for (size_t x = 0; x < (size_t)len; ++x) {
+	    float tmp = c[i] + -1.0f * (c + i + 1)[x];
+	    dist_accumulator[x] += tmp * tmp;
+	}
+    }
+
+    /* convert to 1/d_{ij} */
+    invert_sqrt_vec(len, dist_accumulator);
+    /* detect overflows */
+    for (int j = 0; j < len; j++) {
+	if (dist_accumulator[j] >= FLT_MAX || dist_accumulator[j] < 0) {
+	    dist_accumulator[j] = 0;
+	}
+    }
+
+    float *const off_diag = row + 1; // skip the main diagonal entry
+    DegType degree = 0;
+    if (l->exp == 2) {
+	for (int j = 0; j < len; j++) {
+	    const float val = off_diag[j] *= dist_accumulator[j];
+	    degree += val;
+	}
+    } else {
+	for (int j = 0; j < len; j++) {
+	    const float val = off_diag[j] = dist_accumulator[j];
+	    degree += val;
+	}
+    }
+    return degree;
+}
+
+/// compute the off-diagonal entries of rows `[start, end)`
+static void laplacian_rows(void *context, size_t start, size_t end,
+                           size_t worker) {
+    const laplacian_t *l = context;
+    float *dist_accumulator = l->scratch + worker * (size_t)l->n;
+    for (size_t i = start; i < end; i++) {
+	l->row_degree[i] = laplacian_row(l, (int)i, dist_accumulator);
+    }
+}
+
+/// number of degrees computed together by `laplacian_degrees`
+enum { LAPLACIAN_BLOCK = 256 };
+
+/// sum the degrees of the nodes in blocks `[start, end)`
+///
+/// Each degree accumulates the column above it in row order, then its own
+/// row, exactly as the single threaded loop does.
+static void laplacian_degrees(void *context, size_t start, size_t end,
+                              size_t worker) {
+    (void)worker;
+    const laplacian_t *l = context;
+    const int n = l->n;
+    DegType *degrees = l->degrees;
+
+    for (size_t block = start; block < end; block++) {
+	const int lo = (int)block * LAPLACIAN_BLOCK;
+	const int hi = imin(lo + LAPLACIAN_BLOCK, n);
+	for (int j = lo; j < hi; j++) {
+	    degrees[j] = 0;
+	}
+	for (int i = 0; i < imin(hi, n - 1); i++) {
+	    // offset so that `row[j]` is entry (i, j)
+	    const float *row = l->lap1 + packed_row(n, i) - i;
+	    for (int j = imax(lo, i + 1); j < hi; j++) {
+		degrees[j] -= row[j];
+	    }
+	    if (i >= lo) {
+		degrees[i] -= l->row_degree[i];
+	    }
+	}
+    }
+}
+
+/// recompute the off-diagonal entries of `l->lap1` and the degrees
+static void update_laplacian(laplacian_t *l, gv_pool_t *pool) {
+    const int n = l->n;
+    if (gv_pool_size(pool) < 2) {
+	memset(l->degrees, 0, n * sizeof(DegType));
+	for (int i = 0; i < n - 1; i++) {
+	    const DegType degree = laplacian_row(l, i, l->scratch);
+	    const float *off_diag = l->lap1 + packed_row(n, i) + 1;
+	    for (int j = 0; j < n - i - 1; j++) {
+		l->degrees[i + j + 1] -= off_diag[j];
+	    }
+	    l->degrees[i] -= degree;
+	}
+	return;
+    }
+    if (n > 1) {
+	gv_pool_for(pool, (size_t)n - 1, 16, laplacian_rows, l);
+    }
+    const size_t blocks = ((size_t)n + LAPLACIAN_BLOCK - 1) / LAPLACIAN_BLOCK;
+    gv_pool_for(pool, blocks, 1, laplacian_degrees, l);
+}
+
 /// at present, if any nodes have pos set, smart_ini is false
 int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse representation */
 				   int n,	/* Number of nodes */
@@ -799,7 +954,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 				   int dim,	/* dimensionality of layout */
 				   int opts,    /* options */
 				   int model,	/* model */
-				   int maxi	/* max iterations */
+				   int maxi,	/* max iterations */
+				   gv_pool_t *pool /* optional workers */
     )
 {
     int iterations;		/* output: number of iteration of the process */
@@ -822,10 +978,10 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     float **b = NULL;
     float *tmp_coords = NULL;
     float *dist_accumulator = NULL;
+    DegType *row_degree = NULL;
     float *lap1 = NULL;
     int smart_ini = opts & opt_smart_init;
     int exp = opts & opt_exp_flag;
-    int len;
     int havePinned;		/* some node is pinned */
 
 	/*************************************************
@@ -848,7 +1004,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	/* and perform slower Dijkstra-based computation */
 	if (Verbose)
 	    fprintf(stderr, "Calculating subset model");
-	Dij = compute_apsp_artificial_weights_packed(graph, n);
+	Dij = compute_apsp_artificial_weights_packed(graph, n, pool);
     } else if (model == MODEL_CIRCUIT) {
 	Dij = circuitModel(graph, n);
 	if (!Dij) {
@@ -860,15 +1016,15 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     } else if (model == MODEL_MDS) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating MDS model");
-	Dij = mdsModel(graph, n);
+	Dij = mdsModel(graph, n, pool);
     }
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
 	if (graph->ewgts)
-	    Dij = compute_weighted_apsp_packed(graph, n);
+	    Dij = compute_weighted_apsp_packed(graph, n, pool);
 	else
-	    Dij = compute_apsp_packed(graph, n);
+	    Dij = compute_apsp_packed(graph, n, pool);
     }
 
     if (Verbose) {
@@ -907,7 +1063,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    }
 	    /* add small random noise */
 	    for (j = 0; j < n; j++) {
-		d_coords[i][j] += 1e-6 * (drand48() - 0.5);
+		d_coords[i][j] += 1e-6 * (gv_drand48() - 0.5);
 	    }
 	    orthog1(n, d_coords[i]);
 	}
@@ -980,8 +1136,12 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     }
 
     tmp_coords = gv_calloc(n, sizeof(float));
-    dist_accumulator = gv_calloc(n, sizeof(float));
+    dist_accumulator = gv_calloc(gv_pool_size(pool) * n, sizeof(float));
+    row_degree = gv_calloc(n, sizeof(DegType));
     lap1 = gv_calloc(lap_length, sizeof(float));
+    laplacian_t lap = {.n = n, .dim = dim, .exp = exp, .coords = coords,
+                       .lap2 = lap2, .lap1 = lap1, .degrees = degrees,
+                       .row_degree = row_degree, .scratch = dist_accumulator};
 
 
     old_stress = DBL_MAX; // at least one iteration
@@ -995,51 +1155,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	 iterations < maxi && !converged; iterations++) {
 
 	/* First, construct Laplacian of 1/(d_ij*|p_i-p_j|)  */
-	/* set_vector_val(n, 0, degrees); */
-	memset(degrees, 0, n * sizeof(DegType));
-	if (exp == 2) {
-	    sqrt_vecf(lap_length, lap2, lap1);
-	}
-	for (count = 0, i = 0; i < n - 1; i++) {
-	    len = n - i - 1;
-	    /* init 'dist_accumulator' with zeros */
-	    set_vector_valf(len, 0, dist_accumulator);
-
-	    /* put into 'dist_accumulator' all squared distances between 'i' and 'i'+1,...,'n'-1 */
-	    for (k = 0; k < dim; k++) {
-		size_t x;
-		for (x = 0; x < (size_t)len; ++x) {
-		    float tmp = coords[k][i] + -1.0f * (coords[k] + i + 1)[x];
-		    dist_accumulator[x] += tmp * tmp;
-		}
-	    }
-
-	    /* convert to 1/d_{ij} */
-	    invert_sqrt_vec(len, dist_accumulator);
-	    /* detect overflows */
-	    for (j = 0; j < len; j++) {
-		if (dist_accumulator[j] >= FLT_MAX || dist_accumulator[j] < 0) {
-		    dist_accumulator[j] = 0;
-		}
-	    }
-
-	    count++;		/* save place for the main diagonal entry */
-	    degree = 0;
-	    if (exp == 2) {
-		for (j = 0; j < len; j++, count++) {
-		    val = lap1[count] *= dist_accumulator[j];
-		    degree += val;
-		    degrees[i + j + 1] -= val;
-		}
-	    } else {
-		for (j = 0; j < len; j++, count++) {
-		    val = lap1[count] = dist_accumulator[j];
-		    degree += val;
-		    degrees[i + j + 1] -= val;
-		}
-	    }
-	    degrees[i] -= degree;
-	}
+	update_laplacian(&lap, pool);
 	for (step = n, count = 0, i = 0; i < n; i++, count += step, step--) {
 	    lap1[count] = degrees[i];
 	}
@@ -1047,7 +1163,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	/* Now compute b[] */
 	for (k = 0; k < dim; k++) {
 	    /* b[k] := lap1*coords[k] */
-	    right_mult_with_vector_ff(lap1, n, coords[k], b[k]);
+	    right_mult_with_vector_ff_parallel(lap1, n, coords[k], b[k], pool);
 	}
 
 
@@ -1060,7 +1176,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	new_stress *= 2;
 	new_stress += constant_term;	/* only after mult by 2 */
 	for (k = 0; k < dim; k++) {
-	    right_mult_with_vector_ff(lap2, n, coords[k], tmp_coords);
+	    right_mult_with_vector_ff_parallel(lap2, n, coords[k], tmp_coords,
+	                                       pool);
 	    new_stress -= vectors_inner_productf(n, coords[k], tmp_coords);
 	}
 	/* Invariant: old_stress > 0. In theory, old_stress >= new_stress
@@ -1078,7 +1195,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    if (havePinned) {
 		copy_vectorf(n, coords[k], tmp_coords);
 		if (conjugate_gradient_mkernel(lap2, tmp_coords, b[k], n,
-					   conj_tol, n) < 0) {
+					   conj_tol, n, pool) < 0) {
 		    iterations = -1;
 		    goto finish1;
 		}
@@ -1089,7 +1206,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 		}
 	    } else {
 		if (conjugate_gradient_mkernel(lap2, coords[k], b[k], n,
-					   conj_tol, n) < 0) {
+					   conj_tol, n, pool) < 0) {
 		    iterations = -1;
 		    goto finish1;
 		}
@@ -1123,6 +1240,7 @@ finish1:
     }
     free(tmp_coords);
     free(dist_accumulator);
+    free(row_degree);
     free(degrees);
     free(lap1);
     return iterations;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <util/api.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,13 +40,15 @@ PRIVATE int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in s
 					      int dim,	/* dimensionality of layout */
 					      int opts,	/* option flags */
 					      int model,	/* model */
-					      int maxi	/* max iterations */
+					      int maxi,	/* max iterations */
+					      gv_pool_t *pool /* optional workers */
 	);
 
-PRIVATE float *compute_apsp_packed(vtx_data * graph, int n);
-PRIVATE float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n);
+PRIVATE float *compute_apsp_packed(vtx_data *graph, int n, gv_pool_t *pool);
+PRIVATE float *compute_apsp_artificial_weights_packed(vtx_data *graph, int n,
+                                                      gv_pool_t *pool);
 PRIVATE float* circuitModel(vtx_data * graph, int nG);
-PRIVATE float* mdsModel (vtx_data * graph, int nG);
+PRIVATE float* mdsModel (vtx_data * graph, int nG, gv_pool_t *pool);
 PRIVATE int initLayout(int n, int dim, double **coords, node_t **nodes);
 
 #ifdef __cplusplus
@@ -10,6 +10,7 @@
 
 
 #include "config.h"
+#include <util/random.h>
 #include	<math.h>
 #include	<neatogen/neato.h>
 #include	<neatogen/stress.h>
@@ -18,7 +19,7 @@
 #include	<time.h>
 #include	<util/alloc.h>
 
-static double Epsilon2;
+static _Thread_local double Epsilon2;
 static Agnode_t *choose_node(graph_t *, int);
 static void make_spring(graph_t *, Agnode_t *, Agnode_t *, double);
 static void move_node(graph_t *, int, Agnode_t *);
@@ -244,8 +245,8 @@ int scan_graph_mode(graph_t * G, int mode)
 	    ND_heapindex(np) = -1;
 	    total_len += setEdgeLen(G, np, lenx, dfltlen);
 	}
-    } else if (mode == MODE_SGD) {
-	Epsilon = .01;
+    } else if (mode == MODE_SGD || mode == MODE_SPARSE) {
+	Epsilon = mode == MODE_SGD ? .01 : DFLT_TOLERANCE;
 	getdouble(G, "epsilon", &Epsilon);
 	GD_neato_nlist(G) = gv_calloc(nV + 1, sizeof(node_t *));
 	for (i = 0, np = agfstnode(G); np; np = agnxtnode(G, np)) {
@@ -299,7 +300,7 @@ void jitter_d(node_t * np, int nG, int n)
 {
     int k;
     for (k = n; k < Ndim; k++)
-	ND_pos(np)[k] = nG * drand48();
+	ND_pos(np)[k] = nG * gv_drand48();
 }
 
 void jitter3d(node_t * np, int nG)
@@ -309,8 +310,8 @@ void jitter3d(node_t * np, int nG)
 
 void randompos(node_t * np, int nG)
 {
-    ND_pos(np)[0] = nG * drand48();
-    ND_pos(np)[1] = nG * drand48();
+    ND_pos(np)[0] = nG * gv_drand48();
+    ND_pos(np)[1] = nG * gv_drand48();
     if (Ndim > 2)
 	jitter3d(np, nG);
 }
@@ -497,7 +498,7 @@ node_t *choose_node(graph_t * G, int nG)
     int i, k;
     double m, max;
     node_t *choice, *np;
-    static int cnt = 0;
+    static _Thread_local int cnt = 0;
 
     cnt++;
     if (GD_move(G) >= MaxIter)
@@ -541,7 +542,7 @@ void move_node(graph_t * G, int nG, node_t * n)
 	c[i] = -GD_sum_t(G)[m][i];
     solve(a, b, c, Ndim);
     for (i = 0; i < Ndim; i++) {
-	b[i] = (Damping + 2 * (1 - Damping) * drand48()) * b[i];
+	b[i] = (Damping + 2 * (1 - Damping) * gv_drand48()) * b[i];
 	ND_pos(n)[i] += b[i];
     }
     GD_move(G)++;
@@ -557,9 +558,9 @@ void move_node(graph_t * G, int nG, node_t * n)
     free(a);
 }
 
-static node_t **Heap;
-static int Heapsize;
-static node_t *Src;
+static _Thread_local node_t **Heap;
+static _Thread_local int Heapsize;
+static _Thread_local node_t *Src;
 
 static void heapup(node_t * v)
 {
@@ -25,6 +25,7 @@
 #include <util/gv_math.h>
 #include <util/list.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 
 #ifndef DEBUG
   #define DEBUG 0
@@ -48,12 +49,6 @@
 #define CROSS_SINE(v0, v1) ((v0).x * (v1).y - (v1).x * (v0).y)
 #define LENGTH(v0) hypot((v0).x, (v0).y)
 
-#ifndef HAVE_SRAND48
-#define srand48 srand
-#endif
-#ifdef _WIN32
-extern double drand48(void);
-#endif
 
 typedef struct {
   int vnum;
@@ -110,18 +105,18 @@ typedef struct {
   int nextfree;
 } vertexchain_t;
 
-static int chain_idx;
-static size_t mon_idx;
+static _Thread_local int chain_idx;
+static _Thread_local size_t mon_idx;
 	/* chain init. information. This */
 	/* is used to decide which */
 	/* monotone polygon to split if */
 	/* there are several other */
 	/* polygons touching at the same */
 	/* vertex  */
-static vertexchain_t* vert;
+static _Thread_local vertexchain_t* vert;
 	/* contains position of any vertex in */
 	/* the monotone chain for the polygon */
-static int* mon;
+static _Thread_local int* mon;
 
 /* return a new mon structure from the table */
 #define newmon() (++mon_idx)
@@ -199,7 +194,7 @@ static void generateRandomOrdering(size_t n, int *permute) {
     }
 
     for (size_t i = 0; i < n; i++) {
-	const size_t j = (size_t)((double)i + drand48() * (double)(n - i));
+	const size_t j = (size_t)((double)i + gv_drand48() * (double)(n - i));
 	if (j != i) {
 	    SWAP(&permute[i], &permute[j]);
 	}
@@ -734,7 +729,7 @@ boxf *partition(cell *cells, size_t ncells, size_t *nrects, boxf bb) {
 	    if (i%4 == 0) fprintf(stderr, "\n");
 	}
     }
-    srand48(173);
+    gv_srand48(173);
     generateRandomOrdering(nsegs, permute);
     assert(nsegs <= INT_MAX);
     traps_t hor_traps = construct_trapezoids((int)nsegs, segs, permute);
@@ -32,8 +32,8 @@ typedef struct tna_t {
 
 #define POINTSIZE sizeof (Ppoint_t)
 
-static Ppoint_t *ops;
-static size_t opn, opl;
+static _Thread_local Ppoint_t *ops;
+static _Thread_local size_t opn, opl;
 
 static int reallyroutespline(Pedge_t *, size_t,
 			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
@@ -52,10 +52,10 @@ typedef struct deque_t {
     size_t pnlpn, fpnlpi, lpnlpi, apex;
 } deque_t;
 
-static LIST(triangle_t) tris;
+static _Thread_local LIST(triangle_t) tris;
 
-static Ppoint_t *ops;
-static size_t opn;
+static _Thread_local Ppoint_t *ops;
+static _Thread_local size_t opn;
 
 static int triangulate(pointnlink_t **, size_t);
 static int loadtriangle(pointnlink_t *, pointnlink_t *, pointnlink_t *);
@@ -42,7 +42,7 @@ int Ppolybarriers(Ppoly_t **polys, int npolys, Pedge_t **barriers,
 }
 
 void make_polyline(Ppolyline_t line, Ppolyline_t *sline) {
-  static LIST(Ppoint_t) ispline;
+  static _Thread_local LIST(Ppoint_t) ispline;
   LIST_CLEAR(&ispline);
 
   size_t i = 0;
@@ -15,12 +15,17 @@
 #include <common/arith.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <util/alloc.h>
+#include <util/parallel.h>
 #include <util/random.h>
 
 static const int minsize = 4;
 static const double min_coarsen_factor = 0.75;
 
+/// nodes per chunk of work handed to a thread during coarsening
+enum { COARSEN_GRAIN = 1024 };
+
 static Multilevel Multilevel_init(SparseMatrix A) {
   if (!A) return NULL;
   assert(A->m == A->n);
@@ -53,19 +58,69 @@ void Multilevel_delete(Multilevel grid){
   free(grid);
 }
 
+enum {MATCHED = -1};
+
+/// start a clustering with groups of nodes that have identical neighbors
+///
+/// @param A Symmetric adjacency matrix
+/// @param matched [in,out] Entries of clustered nodes are set to `MATCHED`
+/// @param cluster [out] Nodes of each cluster
+/// @param clusterp [out] Start of each cluster in `cluster`
+/// @param ncluster [out] Number of clusters
+/// @return Number of nodes clustered
+static int cluster_supervariables(SparseMatrix A, int *matched, int *cluster,
+                                  int *clusterp, int *ncluster) {
+  int nsuper, *super = NULL, *superp = NULL;
+  int nz = 0, nz0;
+
+  SparseMatrix_decompose_to_supervariables(A, &nsuper, &super, &superp);
+
+  *ncluster = 0;
+  clusterp[0] = 0;
+
+  for (int i = 0; i < nsuper; i++){
+    if (superp[i+1] - superp[i] <= 1) continue;
+    nz0 = clusterp[*ncluster];
+    for (int j = superp[i]; j < superp[i+1]; j++){
+      matched[super[j]] = MATCHED;
+      cluster[nz++] = super[j];
+      if (nz - nz0 >= MAX_CLUSTER_SIZE){
+	clusterp[++(*ncluster)] = nz;
+	nz0 = nz;
+      }
+    }
+    if (nz > nz0) clusterp[++(*ncluster)] = nz;
+  }
+
+  free(super);
+  free(superp);
+  return nz;
+}
+
+/// the heaviest unmatched neighbor of node `i`, the first of them if several
+/// are equally heavy, or -1 if it has none
+static int heaviest_unmatched(SparseMatrix A, const int *matched, int i) {
+  const int *ia = A->ia, *ja = A->ja;
+  const double *a = A->a;
+  int best = -1;
+  double amax = 0;
+  for (int j = ia[i]; j < ia[i+1]; j++) {
+    if (ja[j] == i || matched[ja[j]] == MATCHED) continue;
+    if (best < 0 || a[j] > amax) {
+      best = ja[j];
+      amax = a[j];
+    }
+  }
+  return best;
+}
+
 static void maximal_independent_edge_set_heavest_edge_pernode_supernodes_first(SparseMatrix A, int **cluster, int **clusterp, int *ncluster){
-  int i, ii, j, *ia, *ja, m, n;
+  int i, ii, m, n;
   (void)n;
-  double *a, amax = 0;
-  int jamax = 0;
-  int *matched, nz, nz0;
-  enum {MATCHED = -1};
-  int  nsuper, *super = NULL, *superp = NULL;
+  int *matched, nz;
 
   assert(A);
   assert(A->is_pattern_symmetric);
-  ia = A->ia;
-  ja = A->ja;
   m = A->m;
   n = A->n;
   assert(n == m);
@@ -78,48 +133,14 @@ static void maximal_independent_edge_set_heavest_edge_pernode_supernodes_first(S
   assert(SparseMatrix_is_symmetric(A, false));
   assert(A->type == MATRIX_TYPE_REAL);
 
-  SparseMatrix_decompose_to_supervariables(A, &nsuper, &super, &superp);
-
-  *ncluster = 0;
-  (*clusterp)[0] = 0;
-  nz = 0;
-  a = A->a;
-
-  for (i = 0; i < nsuper; i++){
-    if (superp[i+1] - superp[i] <= 1) continue;
-    nz0 = (*clusterp)[*ncluster];
-    for (j = superp[i]; j < superp[i+1]; j++){
-      matched[super[j]] = MATCHED;
-      (*cluster)[nz++] = super[j];
-      if (nz - nz0 >= MAX_CLUSTER_SIZE){
-	(*clusterp)[++(*ncluster)] = nz;
-	nz0 = nz;
-      }
-    }
-    if (nz > nz0) (*clusterp)[++(*ncluster)] = nz;
-  }
+  nz = cluster_supervariables(A, matched, *cluster, *clusterp, ncluster);
 
   int *const p = gv_permutation(m);
   for (ii = 0; ii < m; ii++){
     i = p[ii];
-    bool first = true;
     if (matched[i] == MATCHED) continue;
-    for (j = ia[i]; j < ia[i+1]; j++){
-      if (i == ja[j]) continue;
-      if (matched[ja[j]] != MATCHED && matched[i] != MATCHED){
-        if (first) {
-          amax = a[j];
-          jamax = ja[j];
-          first = false;
-        } else {
-          if (a[j] > amax){
-            amax = a[j];
-            jamax = ja[j];
-          }
-        }
-      }
-    }
-    if (!first){
+    const int jamax = heaviest_unmatched(A, matched, i);
+    if (jamax >= 0){
         matched[jamax] = MATCHED;
         matched[i] = MATCHED;
         (*cluster)[nz++] = i;
@@ -136,15 +157,273 @@ static void maximal_independent_edge_set_heavest_edge_pernode_supernodes_first(S
   }
   free(p);
 
-  free(super);
+  free(matched);
+}
 
-  free(superp);
+/// a pseudo random priority for the edge {i, j}, for breaking ties
+static uint64_t edge_priority(int i, int j) {
+  // splitmix64 finalizer, a bijection, so distinct edges never tie
+  uint64_t h = i < j ? (uint64_t)i << 32 | (uint32_t)j
+                     : (uint64_t)j << 32 | (uint32_t)i;
+  h = (h ^ (h >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  h = (h ^ (h >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return h ^ (h >> 31);
+}
 
-  free(matched);
+/// shared state for `choose_partners` and `accept_partners`
+typedef struct {
+  const int *ia;
+  const int *ja;
+  const double *a;
+  int *matched; ///< `MATCHED` or the node’s own index
+  int *choice;  ///< heaviest unmatched neighbor of each node, or -1
+  int *mate;    ///< partner of each node, or -1
+  bool first_round; ///< are there no choices from a previous round?
+  bool *active; ///< per-worker flag, does any unmatched node have a choice?
+} handshake_t;
+
+/// for each unmatched node in `[start, end)`, pick its heaviest unmatched edge
+///
+/// Nodes only ever become matched, so a choice that is still unmatched remains
+/// the best and a node that found no candidate never will. Only choices that
+/// were matched in the previous round need to be revisited.
+static void choose_partners(void *context, size_t start, size_t end,
+                            size_t worker) {
+  handshake_t *h = context;
+  for (int i = (int)start; i < (int)end; i++) {
+    if (h->matched[i] == MATCHED) continue;
+    const bool stale = h->choice[i] >= 0 && h->matched[h->choice[i]] == MATCHED;
+    if (h->first_round || stale) {
+      h->choice[i] = -1;
+      double amax = 0;
+      uint64_t pmax = 0;
+      for (int j = h->ia[i]; j < h->ia[i+1]; j++) {
+        const int k = h->ja[j];
+        if (k == i || h->matched[k] == MATCHED) continue;
+        const uint64_t pri = edge_priority(i, k);
+        if (h->choice[i] < 0 || h->a[j] > amax ||
+            (h->a[j] == amax && pri > pmax)) {
+          h->choice[i] = k;
+          amax = h->a[j];
+          pmax = pri;
+        }
+      }
+    }
+    if (h->choice[i] >= 0) h->active[worker] = true;
+  }
+}
+
+/// match nodes in `[start, end)` whose choice chose them in return
+static void accept_partners(void *context, size_t start, size_t end,
+                            size_t worker) {
+  (void)worker;
+  handshake_t *h = context;
+  for (int i = (int)start; i < (int)end; i++) {
+    const int k = h->choice[i];
+    if (k >= 0 && h->choice[k] == i) {
+      h->mate[i] = k;
+      h->matched[i] = MATCHED;
+    }
+  }
+}
+
+/// rounds of handshaking before any remaining nodes are matched serially
+///
+/// Most nodes are matched within the first few rounds. But a round can match as
+/// few as one pair, such as along a path whose edge weights increase
+/// monotonically, and each round visits every node. Bounding the rounds keeps
+/// the work linear in the size of the graph.
+enum { HANDSHAKE_ROUNDS = 16 };
+
+/// a parallel equivalent of
+/// `maximal_independent_edge_set_heavest_edge_pernode_supernodes_first`
+///
+/// Rather than visiting nodes in a random order, every unmatched node
+/// simultaneously proposes to its heaviest unmatched neighbor, and nodes that
+/// propose to each other are matched. This repeats until no proposals can be
+/// made. Ties between equal weight edges are broken by a hash of the edge, so
+/// the heaviest remaining edge is always mutually chosen and each round makes
+/// progress. No round depends on how nodes are distributed among threads, so
+/// the result is the same for any number of threads. After
+/// `HANDSHAKE_ROUNDS` rounds, any nodes that could still be matched are
+/// matched as by the serial algorithm.
+static void maximal_independent_edge_set_handshake(SparseMatrix A,
+                                                   gv_pool_t *pool,
+                                                   int **cluster,
+                                                   int **clusterp,
+                                                   int *ncluster) {
+  const int m = A->m;
+
+  assert(A->is_pattern_symmetric);
+  assert(A->m == A->n);
+  assert(A->type == MATRIX_TYPE_REAL);
+
+  *cluster = gv_calloc(m, sizeof(int));
+  *clusterp = gv_calloc(m + 1, sizeof(int));
+
+  handshake_t h = {.ia = A->ia, .ja = A->ja, .a = A->a, .first_round = true};
+  h.matched = gv_calloc(m, sizeof(int));
+  h.choice = gv_calloc(m, sizeof(int));
+  h.mate = gv_calloc(m, sizeof(int));
+  h.active = gv_calloc(gv_pool_size(pool), sizeof(bool));
+  for (int i = 0; i < m; i++) {
+    h.matched[i] = i;
+    h.mate[i] = -1;
+  }
+
+  int nz = cluster_supervariables(A, h.matched, *cluster, *clusterp, ncluster);
+
+  bool active = true;
+  for (int round = 0; active && round < HANDSHAKE_ROUNDS; round++) {
+    for (size_t w = 0; w < gv_pool_size(pool); w++) h.active[w] = false;
+    gv_pool_for(pool, (size_t)m, COARSEN_GRAIN, choose_partners, &h);
+    gv_pool_for(pool, (size_t)m, COARSEN_GRAIN, accept_partners, &h);
+    h.first_round = false;
+    active = false;
+    for (size_t w = 0; w < gv_pool_size(pool); w++) active |= h.active[w];
+  }
+
+  if (active) {
+    int *const p = gv_permutation(m);
+    for (int ii = 0; ii < m; ii++) {
+      const int i = p[ii];
+      if (h.matched[i] == MATCHED) continue;
+      const int k = heaviest_unmatched(A, h.matched, i);
+      if (k < 0) continue;
+      h.mate[i] = k;
+      h.mate[k] = i;
+      h.matched[i] = MATCHED;
+      h.matched[k] = MATCHED;
+    }
+    free(p);
+  }
+
+  for (int i = 0; i < m; i++) {
+    if (h.mate[i] > i) {
+      (*cluster)[nz++] = i;
+      (*cluster)[nz++] = h.mate[i];
+      (*clusterp)[++(*ncluster)] = nz;
+    }
+  }
+  for (int i = 0; i < m; i++) {
+    if (h.matched[i] == i) {
+      (*cluster)[nz++] = i;
+      (*clusterp)[++(*ncluster)] = nz;
+    }
+  }
+  assert(nz == m);
+
+  free(h.active);
+  free(h.mate);
+  free(h.choice);
+  free(h.matched);
+}
+
+/// shared state for `count_coarse_row` and `fill_coarse_row`
+typedef struct {
+  SparseMatrix A;
+  const int *cluster;
+  const int *clusterp;
+  const int *aggregate; ///< coarse node each fine node belongs to
+  int nc;               ///< number of coarse nodes
+  int *marker;          ///< `nc` entries of scratch per worker
+  SparseMatrix cA;
+} galerkin_t;
+
+/// count the off-diagonal entries of coarse rows `[start, end)`
+static void count_coarse_row(void *context, size_t start, size_t end,
+                             size_t worker) {
+  galerkin_t *g = context;
+  const int *ia = g->A->ia, *ja = g->A->ja;
+  int *marker = &g->marker[worker * (size_t)g->nc];
+  for (int ci = (int)start; ci < (int)end; ci++) {
+    int count = 0;
+    for (int k = g->clusterp[ci]; k < g->clusterp[ci+1]; k++) {
+      const int i = g->cluster[k];
+      for (int j = ia[i]; j < ia[i+1]; j++) {
+        const int cj = g->aggregate[ja[j]];
+        if (cj == ci || marker[cj] == ci) continue;
+        marker[cj] = ci;
+        count++;
+      }
+    }
+    g->cA->ia[ci + 1] = count;
+  }
+}
+
+/// write the off-diagonal entries of coarse rows `[start, end)`
+static void fill_coarse_row(void *context, size_t start, size_t end,
+                            size_t worker) {
+  galerkin_t *g = context;
+  const int *ia = g->A->ia, *ja = g->A->ja;
+  const double *a = g->A->a;
+  int *cia = g->cA->ia, *cja = g->cA->ja;
+  double *ca = g->cA->a;
+  int *marker = &g->marker[worker * (size_t)g->nc];
+  for (int ci = (int)start; ci < (int)end; ci++) {
+    int nz = cia[ci];
+    for (int k = g->clusterp[ci]; k < g->clusterp[ci+1]; k++) {
+      const int i = g->cluster[k];
+      for (int j = ia[i]; j < ia[i+1]; j++) {
+        const int cj = g->aggregate[ja[j]];
+        if (cj == ci) continue;
+        // positions recorded for other rows lie outside `[cia[ci], nz)`
+        if (marker[cj] >= cia[ci] && marker[cj] < nz) {
+          ca[marker[cj]] += a[j];
+        } else {
+          marker[cj] = nz;
+          cja[nz] = cj;
+          ca[nz++] = a[j];
+        }
+      }
+    }
+    assert(nz == cia[ci + 1]);
+  }
+}
+
+/// compute RAP without its diagonal, where P is the prolongation of a
+/// clustering and R is its transpose
+///
+/// This is `SparseMatrix_multiply3(R, A, P)` followed by
+/// `SparseMatrix_remove_diagonal`, but with each coarse row computed
+/// independently.
+static SparseMatrix galerkin_product(SparseMatrix A, gv_pool_t *pool,
+                                     const int *cluster, const int *clusterp,
+                                     int ncluster) {
+  galerkin_t g = {.A = A, .cluster = cluster, .clusterp = clusterp,
+                  .nc = ncluster};
+
+  int *aggregate = gv_calloc(A->m, sizeof(int));
+  for (int ci = 0; ci < ncluster; ci++) {
+    for (int k = clusterp[ci]; k < clusterp[ci+1]; k++) {
+      aggregate[cluster[k]] = ci;
+    }
+  }
+  g.aggregate = aggregate;
+
+  const size_t markers = gv_pool_size(pool) * (size_t)ncluster;
+  g.marker = gv_calloc(markers, sizeof(int));
+  for (size_t i = 0; i < markers; i++) g.marker[i] = -1;
+
+  g.cA = SparseMatrix_new(ncluster, ncluster, 0, MATRIX_TYPE_REAL, FORMAT_CSR);
+  gv_pool_for(pool, (size_t)ncluster, COARSEN_GRAIN, count_coarse_row, &g);
+  for (int ci = 0; ci < ncluster; ci++) g.cA->ia[ci + 1] += g.cA->ia[ci];
+
+  const size_t nz = (size_t)g.cA->ia[ncluster];
+  g.cA->ja = gv_calloc(nz, sizeof(int));
+  g.cA->a = gv_calloc(nz, sizeof(double));
+  g.cA->nz = g.cA->nzmax = nz;
+  for (size_t i = 0; i < markers; i++) g.marker[i] = -1;
+  gv_pool_for(pool, (size_t)ncluster, COARSEN_GRAIN, fill_coarse_row, &g);
+
+  free(g.marker);
+  free(aggregate);
+  return g.cA;
 }
 
 static void Multilevel_coarsen_internal(SparseMatrix A, SparseMatrix *cA,
-                                        SparseMatrix *P, SparseMatrix *R) {
+                                        SparseMatrix *P, SparseMatrix *R,
+                                        gv_pool_t *pool) {
   int nc, n, i;
   int *irn = NULL, *jcn = NULL;
   double *val = NULL;
@@ -157,7 +436,12 @@ static void Multilevel_coarsen_internal(SparseMatrix A, SparseMatrix *cA,
   *R = NULL;
   n = A->m;
 
-  maximal_independent_edge_set_heavest_edge_pernode_supernodes_first(A, &cluster, &clusterp, &ncluster);
+  if (pool != NULL) {
+    maximal_independent_edge_set_handshake(A, pool, &cluster, &clusterp,
+                                           &ncluster);
+  } else {
+    maximal_independent_edge_set_heavest_edge_pernode_supernodes_first(A, &cluster, &clusterp, &ncluster);
+  }
   assert(ncluster <= n);
   nc = ncluster;
   if (nc == n || nc < minsize) {
@@ -182,15 +466,21 @@ static void Multilevel_coarsen_internal(SparseMatrix A, SparseMatrix *cA,
   assert(nzc == (size_t)n);
   *P = SparseMatrix_from_coordinate_arrays(nzc, n, nc, irn, jcn, val,
                                            MATRIX_TYPE_REAL, sizeof(double));
-  *R = SparseMatrix_transpose(*P);
+  *R = SparseMatrix_transpose_parallel(*P, pool);
 
-  *cA = SparseMatrix_multiply3(*R, A, *P); 
+  if (pool != NULL) {
+    *cA = galerkin_product(A, pool, cluster, clusterp, ncluster);
+  } else {
+    *cA = SparseMatrix_multiply3(*R, A, *P); 
+  }
   if (!*cA) goto RETURN;
 
   *R = SparseMatrix_divide_row_by_degree(*R);
   (*cA)->is_symmetric = true;
   (*cA)->is_pattern_symmetric = true;
-  *cA = SparseMatrix_remove_diagonal(*cA);
+  if (pool == NULL) {
+    *cA = SparseMatrix_remove_diagonal(*cA);
+  }
 
  RETURN:
   free(irn);
@@ -202,7 +492,8 @@ static void Multilevel_coarsen_internal(SparseMatrix A, SparseMatrix *cA,
 }
 
 static void Multilevel_coarsen(SparseMatrix A, SparseMatrix *cA,
-                               SparseMatrix *P, SparseMatrix *R) {
+                               SparseMatrix *P, SparseMatrix *R,
+                               gv_pool_t *pool) {
   SparseMatrix cA0 = A, P0 = NULL, R0 = NULL, M;
   int nc = 0, n;
   
@@ -211,7 +502,7 @@ static void Multilevel_coarsen(SparseMatrix A, SparseMatrix *cA,
   n = A->n;
 
   do {/* this loop force a sufficient reduction */
-    Multilevel_coarsen_internal(A, &cA0, &P0, &R0);
+    Multilevel_coarsen_internal(A, &cA0, &P0, &R0, pool);
     if (!cA0) return;
     nc = cA0->n;
 #ifdef DEBUG_PRINT
@@ -219,11 +510,11 @@ static void Multilevel_coarsen(SparseMatrix A, SparseMatrix *cA,
 #endif
     if (*P){
       assert(*R);
-      M = SparseMatrix_multiply(*P, P0);
+      M = SparseMatrix_multiply_parallel(*P, P0, pool);
       SparseMatrix_delete(*P);
       SparseMatrix_delete(P0);
       *P = M;
-      M = SparseMatrix_multiply(R0, *R);
+      M = SparseMatrix_multiply_parallel(R0, *R, pool);
       SparseMatrix_delete(*R);
       SparseMatrix_delete(R0);
       *R = M;
@@ -246,7 +537,8 @@ void print_padding(int n){
 }
 
 static void Multilevel_establish(Multilevel grid,
-                                 const Multilevel_control ctrl) {
+                                 const Multilevel_control ctrl,
+                                 gv_pool_t *pool) {
   Multilevel cgrid;
   SparseMatrix P, R, A, cA;
 
@@ -266,7 +558,7 @@ static void Multilevel_establish(Multilevel grid,
 #endif
     return;
   }
-  Multilevel_coarsen(A, &cA, &P, &R);
+  Multilevel_coarsen(A, &cA, &P, &R, pool);
   if (!cA) return;
 
   cgrid = Multilevel_init(cA);
@@ -276,7 +568,7 @@ static void Multilevel_establish(Multilevel grid,
   cgrid->P = P;
   grid->R = R;
   cgrid->prev = grid;
-  Multilevel_establish(cgrid, ctrl);
+  Multilevel_establish(cgrid, ctrl, pool);
 }
 
 Multilevel Multilevel_new(SparseMatrix A0,
@@ -289,7 +581,12 @@ Multilevel Multilevel_new(SparseMatrix A0,
     A = SparseMatrix_get_real_adjacency_matrix_symmetrized(A);
   }
   grid = Multilevel_init(A);
-  Multilevel_establish(grid, ctrl);
+  gv_pool_t *pool = NULL;
+  if (ctrl.threads != 1) {
+    pool = gv_pool_new(ctrl.threads > 0 ? (size_t)ctrl.threads : 0);
+  }
+  Multilevel_establish(grid, ctrl, pool);
+  gv_pool_free(pool);
   if (A != A0) grid->delete_top_level_A = true; // be sure to clean up later
   return grid;
 }
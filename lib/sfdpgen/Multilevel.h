@@ -30,6 +30,8 @@ enum { MAX_CLUSTER_SIZE = 4 };
 
 typedef struct {
   int maxlevel;
+  int threads; ///< worker threads for coarsening. 1 uses the sequential
+               ///< algorithm, 0 uses one thread per processor
 } Multilevel_control;
 
 void Multilevel_delete(Multilevel grid);
@@ -605,7 +605,7 @@ double StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim,
     }
     /* solve (Lw+lambda*I) x = Lwdd y + lambda x0 */
 
-    SparseMatrix_multiply_dense(Lwdd, x, y, dim);
+    SparseMatrix_multiply_dense_parallel(Lwdd, x, y, dim, sm->pool);
 
     if (lambda){/* is there a penalty term? */
       for (i = 0; i < m; i++){
@@ -635,7 +635,7 @@ double StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim,
     }
 #endif
 
-    SparseMatrix_solve(Lw, dim, x, y,  sm->tol_cg, sm->maxit_cg);
+    SparseMatrix_solve(Lw, dim, x, y,  sm->tol_cg, sm->maxit_cg, sm->pool);
 
 #ifdef DEBUG_PRINT
     if (Verbose) fprintf(stderr, "stress2 = %g\n",get_stress(m, dim, iw, jw, w, d, y, sm->scaling));
@@ -949,7 +949,11 @@ void post_process_smoothing(int dim, SparseMatrix A, spring_electrical_control c
       }
 
       sm = StressMajorizationSmoother2_new(A, dim, 0.05, x, dist_scheme);
+      if (ctrl.threads != 1) {
+        sm->pool = gv_pool_new(ctrl.threads > 0 ? (size_t)ctrl.threads : 0);
+      }
       StressMajorizationSmoother_smooth(sm, dim, x, 50);
+      gv_pool_free(sm->pool);
       StressMajorizationSmoother_delete(sm);
       break;
     }
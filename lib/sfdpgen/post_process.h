@@ -28,6 +28,7 @@ struct StressMajorizationSmoother_struct {
 		 typically the Laplacian only needs to be solved very crudely as it is part of an
 		 outer iteration.*/
   double maxit_cg;
+  gv_pool_t *pool; ///< optional workers for the linear algebra, not owned
 };
 
 typedef struct StressMajorizationSmoother_struct *StressMajorizationSmoother;
@@ -221,6 +221,7 @@ static void tuneControl(graph_t *g, spring_electrical_control *ctrl) {
 	agwarningf("label_scheme = %d > 4 : ignoring\n", ctrl->edge_labeling_scheme);
 	ctrl->edge_labeling_scheme = 0;
     }
+    ctrl->threads = late_int(g, agfindgraphattr(g, "threads"), 1, 0);
 }
 
 void sfdp_layout(graph_t * g)
@@ -55,7 +55,7 @@ static double *diag_precon_new(SparseMatrix A) {
 
 static double conjugate_gradient(SparseMatrix A, const double *precon, int n,
                                  double *x, double *rhs, double tol,
-                                 double maxit) {
+                                 double maxit, gv_pool_t *pool) {
   double res, alpha;
   double rho, rho_old = 1, res0, beta;
   int iter = 0;
@@ -65,7 +65,7 @@ static double conjugate_gradient(SparseMatrix A, const double *precon, int n,
   double *p = gv_calloc(n, sizeof(double));
   double *q = gv_calloc(n, sizeof(double));
 
-  SparseMatrix_multiply_vector(A, x, &r);
+  SparseMatrix_multiply_vector_parallel(A, x, &r, pool);
   r = vector_subtract_to(n, rhs, r);
 
   res0 = res = sqrt(vector_product(n, r, r))/n;
@@ -88,7 +88,7 @@ static double conjugate_gradient(SparseMatrix A, const double *precon, int n,
       memcpy(p, z, sizeof(double)*n);
     }
 
-    SparseMatrix_multiply_vector(A, p, &q);
+    SparseMatrix_multiply_vector_parallel(A, p, &q, pool);
 
     alpha = rho/vector_product(n, p, q);
 
@@ -113,7 +113,8 @@ static double conjugate_gradient(SparseMatrix A, const double *precon, int n,
 }
 
 static double cg(SparseMatrix A, const double *precond, int n, int dim,
-                 double *x0, double *rhs, double tol, double maxit) {
+                 double *x0, double *rhs, double tol, double maxit,
+                 gv_pool_t *pool) {
   double res = 0;
   int k, i;
   double *x = gv_calloc(n, sizeof(double));
@@ -124,7 +125,7 @@ static double cg(SparseMatrix A, const double *precond, int n, int dim,
       b[i] = rhs[i*dim+k];
     }
     
-    res += conjugate_gradient(A, precond, n, x, b, tol, maxit);
+    res += conjugate_gradient(A, precond, n, x, b, tol, maxit, pool);
     for (i = 0; i < n; i++) {
       rhs[i*dim+k] = x[i];
     }
@@ -135,11 +136,11 @@ static double cg(SparseMatrix A, const double *precond, int n, int dim,
 }
 
 double SparseMatrix_solve(SparseMatrix A, int dim, double *x0, double *rhs,
-                          double tol, double maxit) {
+                          double tol, double maxit, gv_pool_t *pool) {
   int n = A->m;
 
   double *precond = diag_precon_new(A);
-  double res = cg(A, precond, n, dim, x0, rhs, tol, maxit);
+  double res = cg(A, precond, n, dim, x0, rhs, tol, maxit, pool);
   free(precond);
   return res;
 }
@@ -12,5 +12,8 @@
 
 #include <sparse/SparseMatrix.h>
 
+/// solve `A x = rhs` for `dim` right hand sides by preconditioned CG
+///
+/// @param pool Optional workers for the matrix-vector products
 double SparseMatrix_solve(SparseMatrix A, int dim, double *x0, double *rhs,
-                          double tol, double maxit);
+                          double tol, double maxit, gv_pool_t *pool);
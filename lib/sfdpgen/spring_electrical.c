@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <sparse/SparseMatrix.h>
 #include <sfdpgen/spring_electrical.h>
+#include <sparse/FlatQuadTree.h>
 #include <sparse/QuadTree.h>
 #include <sfdpgen/Multilevel.h>
 #include <sfdpgen/post_process.h>
@@ -29,7 +30,9 @@
 #include <util/alloc.h>
 #include <util/bitarray.h>
 #include <util/list.h>
+#include <util/parallel.h>
 #include <util/prisize_t.h>
+#include <util/random.h>
 
 /// another parameter
 /// fₐ(i, j) = C × dist(i , j)² ÷ K × dᵢⱼ, fᵣ(i, j) = K³⁻ᵖ ÷ dist(i, j)⁻ᵖ
@@ -68,6 +71,7 @@ spring_electrical_control spring_electrical_control_new(void){
   ctrl.initial_scaling = -4;
   ctrl.rotation = 0.;
   ctrl.edge_labeling_scheme = 0;
+  ctrl.threads = 1;
   return ctrl;
 }
 
@@ -96,6 +100,7 @@ void spring_electrical_control_print(spring_electrical_control ctrl){
     smoothings[ctrl.smoothing], ctrl.overlap, ctrl.initial_scaling, (int)ctrl.do_shrinking);
   fprintf (stderr, "  octree scheme %s\n", tschemes[ctrl.tscheme]);
   fprintf (stderr, "  edge_labeling_scheme %d\n", ctrl.edge_labeling_scheme);
+  fprintf (stderr, "  threads %d\n", ctrl.threads);
 }
 
 enum { MAX_I = 20, OPT_UP = 1, OPT_DOWN = -1, OPT_INIT = 0 };
@@ -239,6 +244,64 @@ static void beautify_leaves(int dim, SparseMatrix A, double *x){
   bitarray_reset(&checked);
 }
 
+/// nodes per chunk of work handed to a thread by the parallel fast scheme
+enum { FORCE_GRAIN = 256 };
+
+/// per-thread state for `fast_forces`
+typedef struct {
+  double nsuper;          ///< number of supernodes seen this iteration
+  double counts;          ///< number of quadtree cells visited this iteration
+} force_scratch_t;
+
+/// shared state for `fast_forces`
+typedef struct {
+  int dim;
+  int *ia;
+  int *ja;
+  double *x;
+  double *force;
+  FlatQuadTree qt;
+  double p;
+  double KP;
+  double CRK;
+  force_scratch_t *scratch; ///< one entry per thread
+} force_job_t;
+
+/// compute the total force on nodes `[start, end)`
+///
+/// Unlike `QuadTree_get_repulsive_force`, this considers one node at a time
+/// against the supernodes of the quadtree. Each node’s force depends only on
+/// the positions and the quadtree, neither of which is modified here, and is
+/// written only to that node’s slot in `force`. So nodes can be processed
+/// concurrently and the result does not depend on how they were scheduled.
+static void fast_forces(void *context, size_t start, size_t end,
+                        size_t worker) {
+  const force_job_t *job = context;
+  force_scratch_t *scratch = &job->scratch[worker];
+  const int dim = job->dim;
+  const int *ia = job->ia, *ja = job->ja;
+  double *x = job->x;
+
+  for (int i = (int)start; i < (int)end; i++) {
+    double *f = &job->force[i * dim];
+    for (int k = 0; k < dim; k++) f[k] = 0;
+
+    /* attractive force   C^((2-p)/3) ||x_i-x_j||/K * (x_j - x_i) */
+    for (int j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] == i) continue;
+      const double dist = distance(x, dim, i, ja[j]);
+      for (int k = 0; k < dim; k++){
+	f[k] -= job->CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
+      }
+    }
+
+    /* repulsive force K^(1 - p)/||x_i-x_j||^(1 - p) (x_i - x_j) */
+    FlatQuadTree_add_repulsive_force(job->qt, i, &x[dim*i], bh, job->p,
+                                     job->KP, f, &scratch->nsuper,
+                                     &scratch->counts);
+  }
+}
+
 void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
                                       spring_electrical_control *ctrl,
                                       double *x, int *flag) {
@@ -252,6 +315,8 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
   int iter = 0;
   const bool adaptive_cooling = ctrl->adaptive_cooling;
   double counts[4], *force = NULL;
+  gv_pool_t *pool = NULL;
+  force_scratch_t *scratch = NULL;
 #ifdef TIME
   clock_t start, end, start0;
   double qtree_cpu = 0, qtree_new_cpu = 0;
@@ -278,7 +343,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -290,6 +355,16 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
 
   force = gv_calloc(dim * n, sizeof(double));
 
+  /* with threads, trade the cell-cell interactions of the serial scheme for
+     independent per-node supernode queries */
+  force_job_t job = {.dim = dim, .ia = ia, .ja = ja, .x = x, .force = force,
+                     .p = p, .KP = KP, .CRK = CRK};
+  if (ctrl->threads != 1) {
+    pool = gv_pool_new(ctrl->threads > 0 ? (size_t)ctrl->threads : 0);
+    scratch = gv_calloc(gv_pool_size(pool), sizeof(force_scratch_t));
+    job.scratch = scratch;
+  }
+
   do {
     iter++;
     Fnorm0 = Fnorm;
@@ -300,7 +375,15 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
 #ifdef TIME
     start = clock();
 #endif
-    QuadTree qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x);
+    // the serial scheme keeps the pointer-based tree, so its layouts are
+    // unchanged
+    QuadTree qt = NULL;
+    FlatQuadTree flat = NULL;
+    if (pool != NULL) {
+      flat = FlatQuadTree_new(dim, n, max_qtree_level, x, pool);
+    } else {
+      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x);
+    }
 
 #ifdef TIME
     qtree_new_cpu += (double)(clock() - start) / CLOCKS_PER_SEC;
@@ -311,7 +394,29 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
     start = clock();
 #endif
 
-    QuadTree_get_repulsive_force(qt, force, x, bh, p, KP, counts);
+    double work;
+    if (pool != NULL) {
+      for (size_t w = 0; w < gv_pool_size(pool); w++) {
+        scratch[w].nsuper = 0;
+        scratch[w].counts = 0;
+      }
+      job.qt = flat;
+      gv_pool_for(pool, (size_t)n, FORCE_GRAIN, fast_forces, &job);
+
+      /* these are integer valued, so the sum does not depend on how nodes were
+         distributed among threads */
+      double nsuper_avg = 0, counts_avg = 0;
+      for (size_t w = 0; w < gv_pool_size(pool); w++) {
+        nsuper_avg += scratch[w].nsuper;
+        counts_avg += scratch[w].counts;
+      }
+      nsuper_avg /= n;
+      counts_avg /= n;
+      work = 5 * nsuper_avg + counts_avg;
+    } else {
+      QuadTree_get_repulsive_force(qt, force, x, bh, p, KP, counts);
+      work = counts[0] + 0.85 * counts[1] + 3.3 * counts[2];
+    }
 
 #ifdef TIME
     end = clock();
@@ -319,14 +424,16 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
 #endif
 
     /* attractive force   C^((2-p)/3) ||x_i-x_j||/K * (x_j - x_i) */
-    for (i = 0; i < n; i++){
-      f = &(force[i*dim]);
-      for (j = ia[i]; j < ia[i+1]; j++){
-	if (ja[j] == i) continue;
-	dist = distance(x, dim, i, ja[j]);
-	for (k = 0; k < dim; k++){
-	  f[k] -= CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
-	}
+    if (pool == NULL) {
+      for (i = 0; i < n; i++){
+        f = &(force[i*dim]);
+        for (j = ia[i]; j < ia[i+1]; j++){
+	  if (ja[j] == i) continue;
+	  dist = distance(x, dim, i, ja[j]);
+	  for (k = 0; k < dim; k++){
+	    f[k] -= CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
+	  }
+        }
       }
     }
 
@@ -344,18 +451,18 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
 
 
 
-    if (qt) {
+    if (qt || flat) {
 #ifdef TIME
       start = clock();
 #endif
       QuadTree_delete(qt);
+      FlatQuadTree_delete(flat);
 #ifdef TIME
       end = clock();
       qtree_new_cpu += (double)(end - start) / CLOCKS_PER_SEC;
 #endif
 
-      oned_optimizer_train(&qtree_level_optimizer,
-                           counts[0] + 0.85 * counts[1] + 3.3 * counts[2]);
+      oned_optimizer_train(&qtree_level_optimizer, work);
     } else {
       if (Verbose) {
         fprintf(stderr,
@@ -388,6 +495,8 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0,
 
   if (A != A0) SparseMatrix_delete(A);
   free(force);
+  free(scratch);
+  gv_pool_free(pool);
 }
 
 static void spring_electrical_embedding_slow(int dim, SparseMatrix A0,
@@ -428,7 +537,7 @@ static void spring_electrical_embedding_slow(int dim, SparseMatrix A0,
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -565,7 +674,7 @@ void spring_electrical_embedding(int dim, SparseMatrix A0,
   ja = A->ja;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -733,7 +842,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
   d = D->a;
 
   if (ctrl->random_start){
-    srand(ctrl->random_seed);
+    gv_srand(ctrl->random_seed);
     for (i = 0; i < dim*n; i++) x[i] = drand();
   }
   if (K < 0){
@@ -1121,7 +1230,8 @@ void multilevel_spring_electrical_embedding(int dim, SparseMatrix A0,
     return;
   }
 
-  Multilevel_control mctrl = {.maxlevel = ctrl->multilevels};
+  Multilevel_control mctrl = {.maxlevel = ctrl->multilevels,
+                              .threads = ctrl->threads};
   grid0 = Multilevel_new(A, mctrl);
 
   grid = Multilevel_get_coarsest(grid0);
@@ -48,6 +48,9 @@ typedef struct {
 			       0 (no action, default), 1 (penalty based method to make that kind of node close to the center of its neighbor), 
 			       1 (penalty based method to make that kind of node close to the old center of its neighbor),
 			       3 (two step process of overlap removal and straightening) */
+  int threads; ///< worker threads for coarsening and the fast quadtree scheme.
+               ///< 1 (default) uses the serial algorithms, 0 uses one thread
+               ///< per processor
 } spring_electrical_control;
 
 spring_electrical_control spring_electrical_control_new(void);
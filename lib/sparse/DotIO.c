@@ -15,6 +15,7 @@
 #include <sparse/general.h>
 #include <sparse/DotIO.h>
 #include <sparse/clustering.h>
+#include <limits.h>
 #include <math.h>
 #include <sparse/mq.h>
 #include <sparse/color_palette.h>
@@ -86,33 +87,35 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim,
                                      double **x, int format) {
   SparseMatrix A = 0;
   Agnode_t* n;
-  Agedge_t* e;
   Agsym_t *sym;
   Agsym_t *psym;
   int nnodes;
   int nedges;
-  int i, row;
+  int i;
   int* I;
   int* J;
   double *val;
-  double v;
   int type = MATRIX_TYPE_REAL;
 
   if (!g) return NULL;
-  nnodes = agnnodes (g);
-  nedges = agnedges (g);
   if (format != FORMAT_CSR && format != FORMAT_COORD) {
     fprintf (stderr, "Format %d not supported\n", format);
     graphviz_exit(1);
   }
 
+  /* a flat copy of the edges, with weights defaulting to 1 */
+  sym = agattr_text(g, AGEDGE, "weight", NULL);
+  Agcsr_t *csr = agcsropen(g, sym, 1);
+  assert(csr->n_nodes <= INT_MAX && csr->n_edges <= INT_MAX);
+  nnodes = (int)csr->n_nodes;
+  nedges = (int)csr->n_edges;
+
   /* Assign node ids */
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n))
-    ND_id(n) = i++;
+  for (i = 0; i < nnodes; i++)
+    ND_id(csr->nodes[i]) = i;
 
   if (format == FORMAT_COORD){
-    A = SparseMatrix_new(i, i, (size_t)nedges, MATRIX_TYPE_REAL, format);
+    A = SparseMatrix_new(nnodes, nnodes, (size_t)nedges, MATRIX_TYPE_REAL, format);
     A->nz = (size_t)nedges;
     I = A->ia;
     J = A->ja;
@@ -123,25 +126,12 @@ SparseMatrix SparseMatrix_import_dot(Agraph_t *g, int dim,
     val = gv_calloc(nedges, sizeof(double));
   }
 
-  sym = agattr_text(g, AGEDGE, "weight", NULL);
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
-      I[i] = row;
-      J[i] = ND_id(aghead(e));
-
-      /* edge weight */
-      if (sym) {
-        if (sscanf (agxget(e,sym), "%lf", &v) != 1) v = 1;
-      } else {
-        v = 1;
-      }
-      val[i] = v;
-
-      i++;
-    }
+  for (i = 0; i < nedges; i++) {
+    I[i] = (int)csr->tails[i];
+    J[i] = (int)csr->heads[i];
+    val[i] = csr->weights ? csr->weights[i] : 1;
   }
+  agcsrclose(csr);
   
   if (x && (psym = agattr_text(g, AGNODE, "pos", NULL))) {
     bool has_positions = true;
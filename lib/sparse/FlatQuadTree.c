@@ -0,0 +1,374 @@
+/// @file
+/// @brief Implementation of the FlatQuadTree.h API
+
+#include "config.h"
+
+#include <assert.h>
+#include <math.h>
+#include <sparse/FlatQuadTree.h>
+#include <sparse/general.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/alloc.h>
+#include <util/parallel.h>
+
+/// points per chunk of work handed to a thread during construction
+enum { BUILD_GRAIN = 4096 };
+
+/// state shared by workers during construction
+typedef struct {
+  int dim;
+  int levels;          ///< depth of the tree
+  const double *coord; ///< input coordinates
+  const double *lo;    ///< lower corner of the root cell
+  double side;         ///< side length of the root cell
+  uint64_t *code;      ///< Morton code of each point
+  int *id;             ///< point indices, to be sorted
+  double *sorted;      ///< coordinates in sorted order
+} build_t;
+
+/// compute Morton codes of points `[start, end)`
+///
+/// Coordinates are quantized to `levels` bits each, then interleaved so that
+/// the group of `dim` bits for the top level are most significant and, within
+/// a group, dimension `k` is bit `k`. This makes the children of a cell sort in
+/// the same order as the quadrant numbering of `QuadTree`.
+static void compute_codes(void *context, size_t start, size_t end,
+                          size_t worker) {
+  (void)worker;
+  const build_t *b = context;
+  const int dim = b->dim;
+  const double scale = ldexp(1.0, b->levels) / b->side;
+  const uint64_t cells = (uint64_t)1 << b->levels;
+
+  for (size_t i = start; i < end; ++i) {
+    uint64_t code = 0;
+    for (int k = 0; k < dim; ++k) {
+      const double q = floor((b->coord[i * (size_t)dim + (size_t)k] - b->lo[k]) *
+                             scale);
+      uint64_t qk = q <= 0 ? 0 : q >= (double)cells ? cells - 1 : (uint64_t)q;
+      for (int bit = 0; bit < b->levels; ++bit) {
+        code |= ((qk >> bit) & 1) << (bit * dim + k);
+      }
+    }
+    b->code[i] = code;
+    b->id[i] = (int)i;
+  }
+}
+
+/// copy coordinates of sorted points `[start, end)` into place
+static void gather_coords(void *context, size_t start, size_t end,
+                          size_t worker) {
+  (void)worker;
+  const build_t *b = context;
+  const size_t dim = (size_t)b->dim;
+  for (size_t i = start; i < end; ++i) {
+    memcpy(&b->sorted[i * dim], &b->coord[(size_t)b->id[i] * dim],
+           dim * sizeof(double));
+  }
+}
+
+/// stable radix sort of `id` by `code`, considering only the low `bits` bits
+static void sort_by_code(size_t n, uint64_t *code, int *id, int bits) {
+  enum { RADIX_BITS = 8, RADIX = 1 << RADIX_BITS };
+  uint64_t *code2 = gv_calloc(n, sizeof(uint64_t));
+  int *id2 = gv_calloc(n, sizeof(int));
+
+  for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+    size_t bucket[RADIX + 1] = {0};
+    for (size_t i = 0; i < n; ++i) {
+      ++bucket[((code[i] >> shift) & (RADIX - 1)) + 1];
+    }
+    for (size_t r = 0; r < RADIX; ++r) {
+      bucket[r + 1] += bucket[r];
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const size_t dst = bucket[(code[i] >> shift) & (RADIX - 1)]++;
+      code2[dst] = code[i];
+      id2[dst] = id[i];
+    }
+    memcpy(code, code2, n * sizeof(uint64_t));
+    memcpy(id, id2, n * sizeof(int));
+  }
+
+  free(id2);
+  free(code2);
+}
+
+/// cell arrays under construction
+typedef struct {
+  FlatQuadTree qt;
+  int capacity;         ///< allocated number of cells
+  const uint64_t *code; ///< sorted Morton codes
+  int levels;
+  const double *lo; ///< lower corner of the root cell
+  double side;      ///< side length of the root cell
+} cells_t;
+
+static int append_cell(cells_t *c, int start, int end) {
+  FlatQuadTree qt = c->qt;
+  if (qt->ncells == c->capacity) {
+    const int capacity = c->capacity == 0 ? 64 : 2 * c->capacity;
+    const size_t dim = (size_t)qt->dim;
+    qt->start = gv_recalloc(qt->start, c->capacity, capacity, sizeof(int));
+    qt->end = gv_recalloc(qt->end, c->capacity, capacity, sizeof(int));
+    qt->size = gv_recalloc(qt->size, c->capacity, capacity, sizeof(int));
+    qt->width = gv_recalloc(qt->width, c->capacity, capacity, sizeof(double));
+    qt->center = gv_recalloc(qt->center, dim * c->capacity, dim * capacity,
+                             sizeof(double));
+    c->capacity = capacity;
+  }
+  const int cell = qt->ncells++;
+  qt->start[cell] = start;
+  qt->end[cell] = end;
+  return cell;
+}
+
+/// append a cell covering sorted points `[start, end)`, then its descendants
+///
+/// @param c Cells under construction
+/// @param start First sorted point in the cell
+/// @param end One past the last sorted point in the cell
+/// @param level Depth of the cell, with the root at 0
+/// @param parent Index of the parent cell, or -1 for the root
+/// @param quadrant Which quadrant of the parent this cell occupies
+static void build_cells(cells_t *c, int start, int end, int level, int parent,
+                        uint64_t quadrant) {
+  const int cell = append_cell(c, start, end);
+  FlatQuadTree qt = c->qt;
+  const int dim = qt->dim;
+
+  if (parent < 0) {
+    qt->width[cell] = c->side / 2;
+    for (int k = 0; k < dim; ++k) {
+      qt->center[cell * dim + k] = c->lo[k] + c->side / 2;
+    }
+  } else {
+    const double w = qt->width[parent] / 2;
+    qt->width[cell] = w;
+    for (int k = 0; k < dim; ++k) {
+      qt->center[cell * dim + k] = qt->center[parent * dim + k] +
+                                   ((quadrant >> k) & 1 ? w : -w);
+    }
+  }
+
+  if (end - start > 1 && level < c->levels) {
+    // points in the same child share the code bits above `shift`
+    const int shift = (c->levels - 1 - level) * dim;
+    const uint64_t mask = ((uint64_t)1 << dim) - 1;
+    for (int lo = start; lo < end;) {
+      const uint64_t prefix = c->code[lo] >> shift;
+      int hi = end;
+      for (int l = lo + 1; l < hi;) { // binary search for the end of the child
+        const int mid = l + (hi - l) / 2;
+        if (c->code[mid] >> shift == prefix) {
+          l = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      build_cells(c, lo, hi, level + 1, cell, prefix & mask);
+      lo = hi;
+    }
+  }
+
+  qt->size[cell] = qt->ncells - cell;
+}
+
+FlatQuadTree FlatQuadTree_new(int dim, int n, int max_level,
+                              const double *coord, gv_pool_t *pool) {
+  assert(dim > 0);
+  assert(n > 0);
+
+  FlatQuadTree qt = gv_alloc(sizeof(struct FlatQuadTree_struct));
+  qt->dim = dim;
+  qt->n = n;
+
+  // bounding box, padded as `QuadTree_new_from_point_list` does
+  double *lo = gv_calloc((size_t)dim, sizeof(double));
+  double side = 0;
+  for (int k = 0; k < dim; ++k) {
+    double xmin = coord[k], xmax = coord[k];
+    for (int i = 1; i < n; ++i) {
+      xmin = fmin(xmin, coord[i * dim + k]);
+      xmax = fmax(xmax, coord[i * dim + k]);
+    }
+    lo[k] = (xmin + xmax) * 0.5;
+    side = fmax(side, xmax - xmin);
+  }
+  side = fmax(side, 0.00001) * 0.52; // half width of the root
+  for (int k = 0; k < dim; ++k) {
+    lo[k] -= side;
+  }
+  side *= 2;
+
+  const int levels = max_level < 64 / dim ? (max_level > 0 ? max_level : 0)
+                                          : 64 / dim;
+
+  build_t b = {.dim = dim, .levels = levels, .coord = coord, .lo = lo,
+               .side = side};
+  b.code = gv_calloc((size_t)n, sizeof(uint64_t));
+  qt->id = b.id = gv_calloc((size_t)n, sizeof(int));
+  gv_pool_for(pool, (size_t)n, BUILD_GRAIN, compute_codes, &b);
+
+  sort_by_code((size_t)n, b.code, qt->id, levels * dim);
+
+  qt->coord = b.sorted = gv_calloc((size_t)n * (size_t)dim, sizeof(double));
+  gv_pool_for(pool, (size_t)n, BUILD_GRAIN, gather_coords, &b);
+
+  cells_t cells = {.qt = qt, .code = b.code, .levels = levels, .lo = lo,
+                   .side = side};
+  build_cells(&cells, 0, n, 0, -1, 0);
+
+  // Averages, by first summing the coordinates in each cell. Walking in reverse
+  // visits children before parents, so a parent can add up its children.
+  qt->average = gv_calloc((size_t)qt->ncells * (size_t)dim, sizeof(double));
+  for (int c = qt->ncells - 1; c >= 0; --c) {
+    double *sum = &qt->average[c * dim];
+    if (qt->size[c] == 1) {
+      for (int i = qt->start[c]; i < qt->end[c]; ++i) {
+        for (int k = 0; k < dim; ++k) {
+          sum[k] += qt->coord[i * dim + k];
+        }
+      }
+    } else {
+      const int last = c + qt->size[c];
+      for (int d = c + 1; d < last; d += qt->size[d]) {
+        for (int k = 0; k < dim; ++k) {
+          sum[k] += qt->average[d * dim + k];
+        }
+      }
+    }
+  }
+  for (int c = 0; c < qt->ncells; ++c) {
+    const double w = qt->end[c] - qt->start[c];
+    for (int k = 0; k < dim; ++k) {
+      qt->average[c * dim + k] /= w;
+    }
+  }
+
+  free(b.code);
+  free(lo);
+  return qt;
+}
+
+void FlatQuadTree_delete(FlatQuadTree qt) {
+  if (!qt) return;
+  free(qt->id);
+  free(qt->coord);
+  free(qt->start);
+  free(qt->end);
+  free(qt->size);
+  free(qt->width);
+  free(qt->center);
+  free(qt->average);
+  free(qt);
+}
+
+/// the total weight of a cell, being the number of unit weight points within
+static double weight(const FlatQuadTree qt, int c) {
+  return qt->end[c] - qt->start[c];
+}
+
+static bool is_leaf(const FlatQuadTree qt, int c) { return qt->size[c] == 1; }
+
+/// magnitude scaling of the repulsive force at a given distance
+static double repulsion(double dist, double p) {
+  return p == -1 ? dist * dist : pow(dist, 1. - p);
+}
+
+void FlatQuadTree_add_repulsive_force(FlatQuadTree qt, int id, const double *pt,
+                                      double bh, double p, double KP,
+                                      double *force, double *nsuper,
+                                      double *counts) {
+  const int dim = qt->dim;
+
+  // The depth-first layout lets us walk the tree without a stack: descending
+  // into a cell is moving to the next cell, and skipping a cell’s subtree is
+  // moving forward by its size.
+  for (int c = 0; c < qt->ncells;) {
+    (*counts)++;
+    if (is_leaf(qt, c)) {
+      for (int i = qt->start[c]; i < qt->end[c]; i++) {
+        if (qt->id[i] == id) continue;
+        const double *x = &qt->coord[i * dim];
+        const double dist = fmax(point_distance(pt, x, dim), MINDIST);
+        const double scale = KP / repulsion(dist, p);
+        for (int k = 0; k < dim; k++) force[k] += scale * (pt[k] - x[k]);
+        (*nsuper)++;
+      }
+      c++;
+      continue;
+    }
+    const double dist = point_distance(&qt->center[c * dim], pt, dim);
+    if (qt->width[c] < bh * dist) {
+      const double *x = &qt->average[c * dim];
+      const double d = fmax(point_distance(pt, x, dim), MINDIST);
+      const double scale = weight(qt, c) * KP / repulsion(d, p);
+      for (int k = 0; k < dim; k++) force[k] += scale * (pt[k] - x[k]);
+      (*nsuper)++;
+      c += qt->size[c];
+    } else {
+      c++;
+    }
+  }
+}
+
+/// consider the points of a leaf as candidates for the nearest
+static void nearest_in_leaf(const FlatQuadTree qt, int c, const double *x,
+                            double *ymin, int *imin, double *min) {
+  const int dim = qt->dim;
+  for (int i = qt->start[c]; i < qt->end[c]; i++) {
+    const double *coord = &qt->coord[i * dim];
+    const double dist = point_distance(x, coord, dim);
+    if (*min < 0 || dist < *min) {
+      *min = dist;
+      *imin = qt->id[i];
+      memcpy(ymin, coord, sizeof(double) * (size_t)dim);
+    }
+  }
+}
+
+void FlatQuadTree_get_nearest(FlatQuadTree qt, const double *x, double *ymin,
+                              int *imin, double *min) {
+  const int dim = qt->dim;
+
+  *min = -1;
+
+  /* quick first approximation, following the closest child downwards */
+  int c = 0;
+  while (!is_leaf(qt, c)) {
+    const int last = c + qt->size[c];
+    int closest = -1;
+    double qmin = -1;
+    for (int d = c + 1; d < last; d += qt->size[d]) {
+      const double dist = point_distance(&qt->average[d * dim], x, dim);
+      if (qmin < 0 || dist < qmin) {
+        qmin = dist;
+        closest = d;
+      }
+    }
+    assert(closest >= 0);
+    c = closest;
+  }
+  nearest_in_leaf(qt, c, x, ymin, imin, min);
+
+  /* exhaustive search, skipping cells that cannot contain anything closer */
+  const double diagonal = sqrt((double)dim);
+  for (c = 0; c < qt->ncells;) {
+    if (is_leaf(qt, c)) {
+      nearest_in_leaf(qt, c, x, ymin, imin, min);
+      c++;
+      continue;
+    }
+    const double dist = point_distance(&qt->center[c * dim], x, dim);
+    if (dist - diagonal * qt->width[c] > *min) {
+      c += qt->size[c];
+    } else {
+      c++;
+    }
+  }
+}
@@ -0,0 +1,81 @@
+/// @file
+/// @brief immutable, array-backed quadtree for bulk queries
+
+#pragma once
+
+#include <util/parallel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// a quadtree (or octree, …) over a fixed list of points, stored in flat arrays
+///
+/// This answers some of the same queries as `QuadTree` but is built in one pass
+/// from a complete list of unit weight points and cannot be modified
+/// afterwards. It is intended for callers that rebuild a tree from scratch on
+/// every use, like the multithreaded force computation in sfdp.
+///
+/// Points are sorted along a Morton (Z-order) curve, so the points within any
+/// cell form a contiguous range. Cells are stored depth-first, so the first
+/// child of cell `c` is `c + 1`, the sibling following a child `d` is
+/// `d + size[d]`, and a cell is a leaf if `size[c] == 1`. Per-cell data lives in
+/// parallel arrays indexed by cell.
+typedef struct FlatQuadTree_struct *FlatQuadTree;
+
+struct FlatQuadTree_struct {
+  int dim;
+  int n;          ///< number of points
+  int ncells;     ///< number of cells
+  int *id;        ///< index into the input point list of each sorted point
+  double *coord;  ///< point coordinates in sorted order, `dim` per point
+  int *start;     ///< first sorted point in each cell
+  int *end;       ///< one past the last sorted point in each cell
+  int *size;      ///< number of cells in the subtree rooted at each cell
+  double *width;  ///< half the side length of each cell
+  double *center; ///< geometric center of each cell, `dim` per cell
+  double *average; ///< mean of the points in each cell, `dim` per cell
+};
+
+/// build a tree over the points `coord[i × dim … i × dim + dim - 1]`
+///
+/// @param dim Number of dimensions
+/// @param n Number of points
+/// @param max_level Maximum depth of the tree. Depth is also limited to the
+///   resolution of 64-bit Morton codes, ⌊64 ÷ dim⌋.
+/// @param coord Point coordinates
+/// @param pool Optional workers to share the construction with
+/// @return A new tree the caller should later pass to `FlatQuadTree_delete`
+FlatQuadTree FlatQuadTree_new(int dim, int n, int max_level,
+                              const double *coord, gv_pool_t *pool);
+
+void FlatQuadTree_delete(FlatQuadTree qt);
+
+/// add the repulsive force on a single point to `force`
+///
+/// This is the per-point equivalent of `QuadTree_get_supernodes` followed by
+/// summing the supernode forces. It only reads the tree, so may be called
+/// concurrently for different points.
+///
+/// @param qt Tree to query
+/// @param id Index of the point in the original list, to exclude from the sum
+/// @param pt Coordinates of the point
+/// @param bh Barnes-Hut coefficient. A cell is treated as a supernode when
+///   `width < bh × distance`.
+/// @param p The repulsive force power
+/// @param KP pow(K, 1 - p)
+/// @param force [in,out] Force on the point, `dim` entries
+/// @param nsuper [in,out] Incremented by the number of supernodes considered
+/// @param counts [in,out] Incremented by the number of cells visited
+void FlatQuadTree_add_repulsive_force(FlatQuadTree qt, int id, const double *pt,
+                                      double bh, double p, double KP,
+                                      double *force, double *nsuper,
+                                      double *counts);
+
+/// find the nearest point and put in ymin, index in imin and distance in min
+void FlatQuadTree_get_nearest(FlatQuadTree qt, const double *x, double *ymin,
+                              int *imin, double *min);
+
+#ifdef __cplusplus
+}
+#endif
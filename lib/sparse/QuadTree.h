@@ -57,7 +57,7 @@ void QuadTree_print(FILE *fp, QuadTree q);
 
 QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coord);
 
-double point_distance(double *p1, double *p2, int dim);
+double point_distance(const double *p1, const double *p2, int dim);
 
 void QuadTree_get_supernodes(QuadTree qt, double bh, double *pt, int nodeid, int *nsuper, 
 			     int *nsupermax, double **center, double **supernode_wgts, double **distances, double *counts);
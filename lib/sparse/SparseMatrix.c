@@ -928,6 +928,442 @@ SparseMatrix SparseMatrix_multiply3(SparseMatrix A, SparseMatrix B, SparseMatrix
   return D;
 }
 
+/// rows per chunk of work handed to a thread by the `_parallel` kernels
+enum { ROW_GRAIN = 512 };
+
+/// shared state for the row-partitioned transpose
+typedef struct {
+  SparseMatrix A;
+  SparseMatrix B;
+  size_t nblocks;
+  int *offset; ///< `A->n` counters per block, first counts then positions
+} transpose_t;
+
+/// rows of `A` assigned to a block
+static void block_rows(const transpose_t *t, size_t block, int *lo, int *hi) {
+  const size_t m = (size_t)t->A->m;
+  *lo = (int)(m * block / t->nblocks);
+  *hi = (int)(m * (block + 1) / t->nblocks);
+}
+
+/// count the entries in each column for blocks `[start, end)`
+static void transpose_count(void *context, size_t start, size_t end,
+                            size_t worker) {
+  (void)worker;
+  const transpose_t *t = context;
+  const int *ia = t->A->ia, *ja = t->A->ja;
+  for (size_t b = start; b < end; b++) {
+    int *count = &t->offset[b * (size_t)t->A->n];
+    int lo, hi;
+    block_rows(t, b, &lo, &hi);
+    for (int j = ia[lo]; j < ia[hi]; j++) count[ja[j]]++;
+  }
+}
+
+/// turn per-block counts of columns `[start, end)` into starting positions
+static void transpose_offsets(void *context, size_t start, size_t end,
+                              size_t worker) {
+  (void)worker;
+  const transpose_t *t = context;
+  const size_t n = (size_t)t->A->n;
+  for (size_t c = start; c < end; c++) {
+    int position = t->B->ia[c];
+    for (size_t b = 0; b < t->nblocks; b++) {
+      const int count = t->offset[b * n + c];
+      t->offset[b * n + c] = position;
+      position += count;
+    }
+  }
+}
+
+/// scatter the entries of blocks `[start, end)` into the transpose
+///
+/// Blocks cover increasing ranges of rows and each block’s entries in a column
+/// start after those of the blocks before it, so every column of the result
+/// lists rows in increasing order as `SparseMatrix_transpose` does.
+static void transpose_scatter(void *context, size_t start, size_t end,
+                              size_t worker) {
+  (void)worker;
+  const transpose_t *t = context;
+  const int *ia = t->A->ia, *ja = t->A->ja;
+  int *jb = t->B->ja;
+  for (size_t b = start; b < end; b++) {
+    int *offset = &t->offset[b * (size_t)t->A->n];
+    int lo, hi;
+    block_rows(t, b, &lo, &hi);
+    switch (t->A->type) {
+    case MATRIX_TYPE_REAL: {
+      const double *a = t->A->a;
+      double *bv = t->B->a;
+      for (int i = lo; i < hi; i++) {
+        for (int j = ia[i]; j < ia[i+1]; j++) {
+          jb[offset[ja[j]]] = i;
+          bv[offset[ja[j]]++] = a[j];
+        }
+      }
+      break;
+    }
+    case MATRIX_TYPE_INTEGER: {
+      const int *a = t->A->a;
+      int *bv = t->B->a;
+      for (int i = lo; i < hi; i++) {
+        for (int j = ia[i]; j < ia[i+1]; j++) {
+          jb[offset[ja[j]]] = i;
+          bv[offset[ja[j]]++] = a[j];
+        }
+      }
+      break;
+    }
+    case MATRIX_TYPE_PATTERN:
+      for (int i = lo; i < hi; i++) {
+        for (int j = ia[i]; j < ia[i+1]; j++) {
+          jb[offset[ja[j]]++] = i;
+        }
+      }
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+}
+
+SparseMatrix SparseMatrix_transpose_parallel(SparseMatrix A, gv_pool_t *pool) {
+  if (!A) return NULL;
+  if (gv_pool_size(pool) == 1) return SparseMatrix_transpose(A);
+
+  assert(A->format == FORMAT_CSR);/* only implemented for CSR right now */
+
+  const int n = A->n;
+  SparseMatrix B = SparseMatrix_new(n, A->m, A->nz, A->type, A->format);
+  B->nz = A->nz;
+
+  // One block per worker keeps the counters small. The result does not depend
+  // on the number of blocks.
+  transpose_t t = {.A = A, .B = B, .nblocks = gv_pool_size(pool)};
+  t.offset = gv_calloc(t.nblocks * (size_t)n, sizeof(int));
+
+  gv_pool_for(pool, t.nblocks, 1, transpose_count, &t);
+  for (int c = 0; c < n; c++) {
+    int count = 0;
+    for (size_t b = 0; b < t.nblocks; b++) count += t.offset[b * (size_t)n + (size_t)c];
+    B->ia[c + 1] = B->ia[c] + count;
+  }
+  gv_pool_for(pool, (size_t)n, ROW_GRAIN, transpose_offsets, &t);
+  gv_pool_for(pool, t.nblocks, 1, transpose_scatter, &t);
+
+  free(t.offset);
+  return B;
+}
+
+/// shared state for row-partitioned products with dense vectors
+typedef struct {
+  SparseMatrix A;
+  const double *v;
+  double *res;
+  int dim;
+} dense_product_t;
+
+/// `SparseMatrix_multiply_vector` for rows `[start, end)`
+static void multiply_vector_rows(void *context, size_t start, size_t end,
+                                 size_t worker) {
+  (void)worker;
+  const dense_product_t *p = context;
+  const int *ia = p->A->ia, *ja = p->A->ja;
+  const double *v = p->v;
+  double *u = p->res;
+  switch (p->A->type) {
+  case MATRIX_TYPE_REAL: {
+    const double *a = p->A->a;
+    for (int i = (int)start; i < (int)end; i++) {
+      double sum = 0.;
+      if (v) {
+        for (int j = ia[i]; j < ia[i+1]; j++) sum += a[j] * v[ja[j]];
+      } else {
+        for (int j = ia[i]; j < ia[i+1]; j++) sum += a[j];
+      }
+      u[i] = sum;
+    }
+    break;
+  }
+  case MATRIX_TYPE_INTEGER: {
+    const int *a = p->A->a;
+    for (int i = (int)start; i < (int)end; i++) {
+      double sum = 0.;
+      if (v) {
+        for (int j = ia[i]; j < ia[i+1]; j++) sum += a[j] * v[ja[j]];
+      } else {
+        for (int j = ia[i]; j < ia[i+1]; j++) sum += a[j];
+      }
+      u[i] = sum;
+    }
+    break;
+  }
+  default:
+    UNREACHABLE();
+  }
+}
+
+void SparseMatrix_multiply_vector_parallel(SparseMatrix A, double *v,
+                                           double **res, gv_pool_t *pool) {
+  if (gv_pool_size(pool) == 1) {
+    SparseMatrix_multiply_vector(A, v, res);
+    return;
+  }
+
+  assert(A->format == FORMAT_CSR);
+  assert(A->type == MATRIX_TYPE_REAL || A->type == MATRIX_TYPE_INTEGER);
+
+  if (!*res) *res = gv_calloc((size_t)A->m, sizeof(double));
+  dense_product_t p = {.A = A, .v = v, .res = *res};
+  gv_pool_for(pool, (size_t)A->m, ROW_GRAIN, multiply_vector_rows, &p);
+}
+
+/// `SparseMatrix_multiply_dense` for rows `[start, end)`
+static void multiply_dense_rows(void *context, size_t start, size_t end,
+                                size_t worker) {
+  (void)worker;
+  const dense_product_t *p = context;
+  const int *ia = p->A->ia, *ja = p->A->ja;
+  const double *a = p->A->a;
+  const int dim = p->dim;
+  for (int i = (int)start; i < (int)end; i++) {
+    double *r = &p->res[i * dim];
+    for (int k = 0; k < dim; k++) r[k] = 0;
+    for (int j = ia[i]; j < ia[i+1]; j++) {
+      const double *x = &p->v[ja[j] * dim];
+      for (int k = 0; k < dim; k++) r[k] += a[j] * x[k];
+    }
+  }
+}
+
+void SparseMatrix_multiply_dense_parallel(SparseMatrix A, const double *v,
+                                          double *res, int dim,
+                                          gv_pool_t *pool) {
+  if (gv_pool_size(pool) == 1) {
+    SparseMatrix_multiply_dense(A, v, res, dim);
+    return;
+  }
+
+  assert(A->format == FORMAT_CSR);
+  assert(A->type == MATRIX_TYPE_REAL);
+
+  dense_product_t p = {.A = A, .v = v, .res = res, .dim = dim};
+  gv_pool_for(pool, (size_t)A->m, ROW_GRAIN, multiply_dense_rows, &p);
+}
+
+/// shared state for row-partitioned sparse products
+///
+/// The product is of two or three matrices. Each row of the result is computed
+/// in two passes, first counting its entries and then filling them in, using
+/// a per-worker array of markers indexed by column.
+typedef struct {
+  SparseMatrix A;
+  SparseMatrix B;
+  SparseMatrix C; ///< third factor, or `NULL`
+  SparseMatrix D; ///< the result
+  int n;          ///< column dimension of the result
+  int *counts;    ///< entries in each row of the result
+  int *mask;      ///< `n` markers per worker
+} product_t;
+
+/// count the entries of rows `[start, end)` of the product
+static void product_count(void *context, size_t start, size_t end,
+                          size_t worker) {
+  const product_t *p = context;
+  const int *ia = p->A->ia, *ja = p->A->ja, *ib = p->B->ia, *jb = p->B->ja;
+  int *mask = &p->mask[worker * (size_t)p->n];
+  for (int i = (int)start; i < (int)end; i++) {
+    int count = 0;
+    for (int j = ia[i]; j < ia[i+1]; j++) {
+      for (int l = ib[ja[j]]; l < ib[ja[j]+1]; l++) {
+        if (p->C == NULL) {
+          if (mask[jb[l]] != i) {
+            mask[jb[l]] = i;
+            count++;
+          }
+          continue;
+        }
+        const int *ic = p->C->ia, *jc = p->C->ja;
+        for (int k = ic[jb[l]]; k < ic[jb[l]+1]; k++) {
+          if (mask[jc[k]] != i) {
+            mask[jc[k]] = i;
+            count++;
+          }
+        }
+      }
+    }
+    p->counts[i] = count;
+  }
+}
+
+/// has a column already been given a position in the row being filled?
+///
+/// @param mask Position of each column’s entry in the row that last had it
+/// @param col Column to look up
+/// @param row_start Position of the first entry of the current row
+/// @param nz Position of the next entry of the current row
+static bool in_row(const int *mask, int col, int row_start, int nz) {
+  // markers left by other rows point outside `[row_start, nz)`
+  return mask[col] >= row_start && mask[col] < nz;
+}
+
+/// fill in rows `[start, end)` of the product of two matrices
+///
+/// Entries of a row appear in the order they are first reached, and are summed
+/// in the order they are reached, as in `SparseMatrix_multiply`.
+static void product2_fill(void *context, size_t start, size_t end,
+                          size_t worker) {
+  const product_t *p = context;
+  const int *ia = p->A->ia, *ja = p->A->ja, *ib = p->B->ia, *jb = p->B->ja;
+  const int *id = p->D->ia;
+  int *jd = p->D->ja;
+  int *mask = &p->mask[worker * (size_t)p->n];
+  for (int i = (int)start; i < (int)end; i++) {
+    int nz = id[i];
+    switch (p->D->type) {
+    case MATRIX_TYPE_REAL: {
+      const double *a = p->A->a, *b = p->B->a;
+      double *d = p->D->a;
+      for (int j = ia[i]; j < ia[i+1]; j++) {
+        for (int k = ib[ja[j]]; k < ib[ja[j]+1]; k++) {
+          if (!in_row(mask, jb[k], id[i], nz)) {
+            mask[jb[k]] = nz;
+            jd[nz] = jb[k];
+            d[nz++] = a[j] * b[k];
+          } else {
+            d[mask[jb[k]]] += a[j] * b[k];
+          }
+        }
+      }
+      break;
+    }
+    case MATRIX_TYPE_INTEGER: {
+      const int *a = p->A->a, *b = p->B->a;
+      int *d = p->D->a;
+      for (int j = ia[i]; j < ia[i+1]; j++) {
+        for (int k = ib[ja[j]]; k < ib[ja[j]+1]; k++) {
+          if (!in_row(mask, jb[k], id[i], nz)) {
+            mask[jb[k]] = nz;
+            jd[nz] = jb[k];
+            d[nz++] = a[j] * b[k];
+          } else {
+            d[mask[jb[k]]] += a[j] * b[k];
+          }
+        }
+      }
+      break;
+    }
+    case MATRIX_TYPE_PATTERN:
+      for (int j = ia[i]; j < ia[i+1]; j++) {
+        for (int k = ib[ja[j]]; k < ib[ja[j]+1]; k++) {
+          if (!in_row(mask, jb[k], id[i], nz)) {
+            mask[jb[k]] = nz;
+            jd[nz++] = jb[k];
+          }
+        }
+      }
+      break;
+    default:
+      UNREACHABLE();
+    }
+    assert(nz == id[i + 1]);
+  }
+}
+
+/// fill in rows `[start, end)` of the product of three real matrices
+static void product3_fill(void *context, size_t start, size_t end,
+                          size_t worker) {
+  const product_t *p = context;
+  const int *ia = p->A->ia, *ja = p->A->ja, *ib = p->B->ia, *jb = p->B->ja;
+  const int *ic = p->C->ia, *jc = p->C->ja;
+  const double *a = p->A->a, *b = p->B->a, *c = p->C->a;
+  const int *id = p->D->ia;
+  int *jd = p->D->ja;
+  double *d = p->D->a;
+  int *mask = &p->mask[worker * (size_t)p->n];
+  for (int i = (int)start; i < (int)end; i++) {
+    int nz = id[i];
+    for (int j = ia[i]; j < ia[i+1]; j++) {
+      for (int l = ib[ja[j]]; l < ib[ja[j]+1]; l++) {
+        for (int k = ic[jb[l]]; k < ic[jb[l]+1]; k++) {
+          if (!in_row(mask, jc[k], id[i], nz)) {
+            mask[jc[k]] = nz;
+            jd[nz] = jc[k];
+            d[nz++] = a[j] * b[l] * c[k];
+          } else {
+            d[mask[jc[k]]] += a[j] * b[l] * c[k];
+          }
+        }
+      }
+    }
+    assert(nz == id[i + 1]);
+  }
+}
+
+/// run both passes of a row-partitioned product
+///
+/// @return The product, or `NULL` if it has too many entries to represent
+static SparseMatrix product(SparseMatrix A, SparseMatrix B, SparseMatrix C,
+                            gv_pool_t *pool) {
+  const int m = A->m;
+  const int n = C == NULL ? B->n : C->n;
+  const size_t workers = gv_pool_size(pool);
+
+  product_t p = {.A = A, .B = B, .C = C, .n = n};
+  p.counts = gv_calloc((size_t)m, sizeof(int));
+  p.mask = gv_calloc(workers * (size_t)n, sizeof(int));
+  for (size_t i = 0; i < workers * (size_t)n; i++) p.mask[i] = -1;
+
+  gv_pool_for(pool, (size_t)m, ROW_GRAIN, product_count, &p);
+
+  size_t nz = 0;
+  for (int i = 0; i < m; i++) {
+    if (size_overflow(nz, (size_t)p.counts[i], &nz) || nz > INT_MAX) {
+      goto done;
+    }
+  }
+
+  p.D = SparseMatrix_new(m, n, nz, A->type, FORMAT_CSR);
+  p.D->nz = nz;
+  for (int i = 0; i < m; i++) p.D->ia[i + 1] = p.D->ia[i] + p.counts[i];
+
+  for (size_t i = 0; i < workers * (size_t)n; i++) p.mask[i] = -1;
+  gv_pool_for(pool, (size_t)m, ROW_GRAIN, C == NULL ? product2_fill
+                                                    : product3_fill, &p);
+
+done:
+  free(p.mask);
+  free(p.counts);
+  return p.D;
+}
+
+SparseMatrix SparseMatrix_multiply_parallel(SparseMatrix A, SparseMatrix B,
+                                            gv_pool_t *pool) {
+  if (gv_pool_size(pool) == 1) return SparseMatrix_multiply(A, B);
+
+  assert(A->format == B->format && A->format == FORMAT_CSR);/* other format not yet supported */
+
+  if (A->n != B->m) return NULL;
+  if (A->type != B->type) return NULL;
+
+  return product(A, B, NULL, pool);
+}
+
+SparseMatrix SparseMatrix_multiply3_parallel(SparseMatrix A, SparseMatrix B,
+                                             SparseMatrix C, gv_pool_t *pool) {
+  if (gv_pool_size(pool) == 1) return SparseMatrix_multiply3(A, B, C);
+
+  assert(A->format == B->format && A->format == FORMAT_CSR);/* other format not yet supported */
+
+  if (A->n != B->m) return NULL;
+  if (B->n != C->m) return NULL;
+  if (A->type != B->type || B->type != C->type) return NULL;
+
+  assert(A->type == MATRIX_TYPE_REAL);
+
+  return product(A, B, C, pool);
+}
+
 SparseMatrix SparseMatrix_sum_repeat_entries(SparseMatrix A){
   /* sum repeated entries in the same row, i.e., {1,1}->1, {1,1}->2 becomes {1,1}->3 */
   int *ia = A->ia, *ja = A->ja, type = A->type, n = A->n;
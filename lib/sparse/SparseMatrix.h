@@ -14,6 +14,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <util/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -128,6 +129,27 @@ SparseMatrix SparseMatrix_set_entries_to_real_one(SparseMatrix A);
 /// @return An n×n matrix, (i,j)-th entry gives the distance of node i to j
 SparseMatrix SparseMatrix_distance_matrix(SparseMatrix D0);
 
+/// \name Multithreaded kernels
+///
+/// These split work by rows across the workers of `pool` and return exactly
+/// what their single threaded namesakes return, regardless of the number of
+/// workers. A `NULL` pool, or one with a single worker, calls the single
+/// threaded version.
+/// @{
+
+SparseMatrix SparseMatrix_transpose_parallel(SparseMatrix A, gv_pool_t *pool);
+void SparseMatrix_multiply_vector_parallel(SparseMatrix A, double *v,
+                                           double **res, gv_pool_t *pool);
+void SparseMatrix_multiply_dense_parallel(SparseMatrix A, const double *v,
+                                          double *res, int dim,
+                                          gv_pool_t *pool);
+SparseMatrix SparseMatrix_multiply_parallel(SparseMatrix A, SparseMatrix B,
+                                            gv_pool_t *pool);
+SparseMatrix SparseMatrix_multiply3_parallel(SparseMatrix A, SparseMatrix B,
+                                             SparseMatrix C, gv_pool_t *pool);
+
+/// @}
+
 #ifdef __cplusplus
 }
 
@@ -16,13 +16,14 @@
 #include <sparse/general.h>
 #include <errno.h>
 #include <util/alloc.h>
+#include <util/random.h>
 
 #ifdef DEBUG
 double _statistics[10];
 #endif
 
 double drand(void){
-  return rand()/(double) RAND_MAX;
+  return gv_rand()/(double) GV_RAND_MAX;
 }
 
 double* vector_subtract_to(int n, double *x, double *y){
@@ -128,7 +129,7 @@ double distance(double *x, int dim, int i, int j){
   return dist;
 }
 
-double point_distance(double *p1, double *p2, int dim){
+double point_distance(const double *p1, const double *p2, int dim){
   int i;
   double dist;
   dist = 0;
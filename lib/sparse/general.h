@@ -80,7 +80,7 @@ enum {UNMATCHED = -1};
 double distance(double *x, int dim, int i, int j);
 double distance_cropped(double *x, int dim, int i, int j);
 
-double point_distance(double *p1, double *p2, int dim);
+double point_distance(const double *p1, const double *p2, int dim);
 
 char *strip_dir(char *s);
 
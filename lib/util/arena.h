@@ -28,7 +28,7 @@ typedef struct arena_chunk arena_chunk_t;
 ///   arena_t new_arena = {0};
 ///
 /// All fields are considered private and should not be used outside of arena.c.
-typedef struct {
+typedef struct graphviz_arena {
   arena_chunk_t *source; ///< current chunk being allocated out of
   size_t remaining;      ///< number of free bytes remaining in `source`
 } arena_t;
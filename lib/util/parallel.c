@@ -0,0 +1,210 @@
+/// @file
+/// @brief Implementation of the parallel.h API
+
+#ifndef NO_CONFIG // defined by test_parallel.c
+#include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+#include <util/parallel.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_PTHREAD
+/// a thread started by a pool
+typedef struct {
+  gv_pool_t *pool;
+  size_t worker; ///< index passed to loop bodies run by this thread
+  pthread_t thread;
+} helper_t;
+#endif
+
+struct gv_pool {
+  size_t size; ///< number of workers, including the calling thread
+#ifdef HAVE_PTHREAD
+  helper_t *helpers; ///< `size - 1` started threads
+
+  pthread_mutex_t lock; ///< protects all fields below except `next`
+  pthread_cond_t posted;   ///< signalled when a new loop is available
+  pthread_cond_t finished; ///< signalled when the last helper finishes a loop
+  unsigned long generation; ///< sequence number of the current loop
+  size_t running;           ///< helpers yet to finish the current loop
+  bool stop;                ///< should helpers exit?
+
+  // the current loop
+  gv_pool_fn fn;
+  void *context;
+  size_t n;
+  size_t grain;
+  atomic_size_t next; ///< first iteration not yet claimed by a worker
+#endif
+};
+
+size_t gv_processors(void) {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+/// claim and run chunks of the current loop until there are none left
+static void run_chunks(gv_pool_t *pool, size_t worker) {
+  for (;;) {
+    const size_t start = atomic_fetch_add(&pool->next, pool->grain);
+    if (start >= pool->n) {
+      return;
+    }
+    const size_t end =
+        pool->n - start > pool->grain ? start + pool->grain : pool->n;
+    pool->fn(pool->context, start, end, worker);
+  }
+}
+
+static void *helper_main(void *arg) {
+  helper_t *self = arg;
+  gv_pool_t *pool = self->pool;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (!pool->stop && pool->generation == seen) {
+      pthread_cond_wait(&pool->posted, &pool->lock);
+    }
+    if (pool->stop) {
+      break;
+    }
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool, self->worker);
+
+    pthread_mutex_lock(&pool->lock);
+    assert(pool->running > 0);
+    --pool->running;
+    if (pool->running == 0) {
+      pthread_cond_signal(&pool->finished);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+#endif
+
+gv_pool_t *gv_pool_new(size_t threads) {
+  if (threads == 0) {
+    threads = gv_processors();
+  }
+
+  gv_pool_t *pool = gv_alloc(sizeof(gv_pool_t));
+  pool->size = 1;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->posted, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+  atomic_init(&pool->next, 0);
+
+  if (threads > 1) {
+    pool->helpers = gv_calloc(threads - 1, sizeof(helper_t));
+    for (size_t i = 0; i < threads - 1; ++i) {
+      helper_t *h = &pool->helpers[i];
+      h->pool = pool;
+      h->worker = i + 1;
+      if (pthread_create(&h->thread, NULL, helper_main, h) != 0) {
+        break;
+      }
+      ++pool->size;
+    }
+  }
+#else
+  (void)threads;
+#endif
+
+  return pool;
+}
+
+size_t gv_pool_size(const gv_pool_t *pool) {
+  return pool == NULL ? 1 : pool->size;
+}
+
+void gv_pool_for(gv_pool_t *pool, size_t n, size_t grain, gv_pool_fn fn,
+                 void *context) {
+  assert(fn != NULL);
+
+  if (n == 0) {
+    return;
+  }
+  if (grain == 0) {
+    grain = 1;
+  }
+
+  // run inline if there is nobody to share the work with
+  if (gv_pool_size(pool) == 1 || n <= grain) {
+    fn(context, 0, n, 0);
+    return;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&pool->lock);
+  pool->fn = fn;
+  pool->context = context;
+  pool->n = n;
+  pool->grain = grain;
+  atomic_store(&pool->next, 0);
+  pool->running = pool->size - 1;
+  ++pool->generation;
+  pthread_cond_broadcast(&pool->posted);
+  pthread_mutex_unlock(&pool->lock);
+
+  run_chunks(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->running > 0) {
+    pthread_cond_wait(&pool->finished, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+void gv_pool_free(gv_pool_t *pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->posted);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i + 1 < pool->size; ++i) {
+    pthread_join(pool->helpers[i].thread, NULL);
+  }
+  free(pool->helpers);
+
+  pthread_cond_destroy(&pool->finished);
+  pthread_cond_destroy(&pool->posted);
+  pthread_mutex_destroy(&pool->lock);
+#endif
+
+  free(pool);
+}
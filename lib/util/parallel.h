@@ -0,0 +1,81 @@
+/// @file
+/// @brief fork-join loops over a persistent set of worker threads
+///
+/// A pool splits the iterations of a loop whose iterations are independent
+/// across a fixed set of threads. The calling thread participates as worker 0,
+/// so a pool of size N starts N − 1 additional threads.
+///
+/// Iterations are handed out in chunks of a caller-chosen grain size on a
+/// first-come first-served basis, so loops whose iterations have uneven cost
+/// are still balanced across workers. Which worker runs which chunk is not
+/// deterministic. Callers wanting reproducible output should write results into
+/// per-iteration slots and combine them afterwards in index order.
+///
+/// When Graphviz is built without thread support, every pool has a single
+/// worker and loops run inline on the calling thread.
+
+#pragma once
+
+#include <stddef.h>
+#include <util/api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// a set of worker threads
+typedef struct gv_pool gv_pool_t;
+
+/// loop body run by a worker
+///
+/// @param context Caller state passed through from `gv_pool_for`
+/// @param start First iteration of this chunk
+/// @param end One past the last iteration of this chunk
+/// @param worker Index of the running worker, in `[0, gv_pool_size(pool))`
+typedef void (*gv_pool_fn)(void *context, size_t start, size_t end,
+                           size_t worker);
+
+/// number of processors available to this process
+///
+/// @return Number of online processors, or 1 if this cannot be determined
+UTIL_API size_t gv_processors(void);
+
+/// create a pool of workers
+///
+/// This function calls `exit` on memory allocation failure. If the system
+/// cannot start as many threads as requested, the pool is silently smaller.
+///
+/// @param threads Number of workers to use, or 0 for one per processor
+/// @return A new pool the caller should later pass to `gv_pool_free`
+UTIL_API gv_pool_t *gv_pool_new(size_t threads);
+
+/// number of workers in a pool
+///
+/// This is the upper bound on the `worker` index seen by loop bodies, and so
+/// is the number of per-worker scratch areas a caller needs.
+///
+/// @param pool Pool to inspect, or `NULL` for a serial pseudo-pool
+/// @return Number of workers, including the calling thread
+UTIL_API size_t gv_pool_size(const gv_pool_t *pool);
+
+/// run `fn` over `[0, n)` on the workers of a pool, returning when all are done
+///
+/// This is not reentrant. A loop body must not itself call `gv_pool_for` on the
+/// same pool.
+///
+/// @param pool Pool to run on, or `NULL` to run serially on the calling thread
+/// @param n Number of iterations
+/// @param grain Maximum number of iterations per chunk handed to `fn`
+/// @param fn Loop body
+/// @param context Opaque state to pass through to `fn`
+UTIL_API void gv_pool_for(gv_pool_t *pool, size_t n, size_t grain,
+                          gv_pool_fn fn, void *context);
+
+/// stop the workers of a pool and deallocate it
+///
+/// @param pool Pool to free, or `NULL` for a no-op
+UTIL_API void gv_pool_free(gv_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
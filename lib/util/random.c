@@ -5,6 +5,8 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,78 @@
 #include <util/gv_math.h>
 #include <util/random.h>
 
+enum { RAND_DEGREE = 31, RAND_SEP = 3 };
+
+/// state of the generator behind `gv_rand`
+///
+/// This is the additive feedback generator the GNU C library uses for `rand`,
+/// so sequences match those of earlier Graphviz releases on Linux.
+typedef struct {
+  bool seeded;
+  uint32_t ring[RAND_DEGREE];
+  int front; ///< index of the next value to update
+  int rear;  ///< index of the value `RAND_SEP` behind `front`
+} rand_state_t;
+
+static _Thread_local rand_state_t rand_state;
+
+/// advance the generator behind `gv_rand`
+static int rand_next(rand_state_t *st) {
+  const uint32_t v = st->ring[st->front] + st->ring[st->rear];
+  st->ring[st->front] = v;
+  st->front = (st->front + 1) % RAND_DEGREE;
+  st->rear = (st->rear + 1) % RAND_DEGREE;
+  return (int)(v >> 1);
+}
+
+void gv_srand(unsigned seed) {
+  rand_state_t *const st = &rand_state;
+  if (seed == 0) {
+    seed = 1;
+  }
+
+  // fill the ring using a multiplicative congruential generator
+  st->ring[0] = seed;
+  int64_t word = (int32_t)seed;
+  for (int i = 1; i < RAND_DEGREE; ++i) {
+    const int64_t hi = word / 127773;
+    const int64_t lo = word % 127773;
+    word = 16807 * lo - 2836 * hi;
+    if (word < 0) {
+      word += 2147483647;
+    }
+    st->ring[i] = (uint32_t)word;
+  }
+  st->front = RAND_SEP;
+  st->rear = 0;
+  st->seeded = true;
+
+  // discard the initial values, which are poorly mixed
+  for (int i = 0; i < 10 * RAND_DEGREE; ++i) {
+    (void)rand_next(st);
+  }
+}
+
+int gv_rand(void) {
+  if (!rand_state.seeded) {
+    gv_srand(1);
+  }
+  return rand_next(&rand_state);
+}
+
+/// state of the generator behind `gv_drand48`, POSIX’s default until seeded
+static _Thread_local uint64_t drand48_state = UINT64_C(0x1234ABCD330E);
+
+void gv_srand48(long seed) {
+  drand48_state = ((uint64_t)(uint32_t)seed << 16) | 0x330E;
+}
+
+double gv_drand48(void) {
+  const uint64_t mask = (UINT64_C(1) << 48) - 1;
+  drand48_state = (drand48_state * UINT64_C(0x5DEECE66D) + 0xB) & mask;
+  return ldexp((double)drand48_state, -48);
+}
+
 int *gv_permutation(int bound) {
   if (bound <= 0) {
     return NULL;
@@ -32,13 +106,13 @@ int *gv_permutation(int bound) {
   return p;
 }
 
-/// handle random number generation, `bound ≤ RAND_MAX`
+/// handle random number generation, `bound ≤ GV_RAND_MAX`
 static int random_small(int bound) {
   assert(bound > 0);
-  assert(bound <= RAND_MAX);
+  assert(bound <= GV_RAND_MAX);
 
-  // The interval `[0, RAND_MAX]` is not necessarily neatly divided into
-  // `bound`-sized chunks. E.g. using a bound of 3 with a `RAND_MAX` of 7:
+  // The interval `[0, GV_RAND_MAX]` is not necessarily neatly divided into
+  // `bound`-sized chunks. E.g. using a bound of 3 with a `GV_RAND_MAX` of 7:
   //   ┌───┬───┬───┬───┬───┬───┬───┬───┐
   //   │ 0 │ 1 │ 2 │ 3 │ 4 │ 5 │ 6 │ 7 │
   //   └───┴───┴───┴───┴───┴───┴───┴───┘
@@ -48,11 +122,11 @@ static int random_small(int bound) {
   // complete chunk (5 in the example above), above which we discard and
   // resample to avoid pulling from the partial trailing chunk.
   const int discard_threshold =
-      RAND_MAX - (int)(((unsigned)RAND_MAX + 1) % (unsigned)bound);
+      GV_RAND_MAX - (int)(((unsigned)GV_RAND_MAX + 1) % (unsigned)bound);
 
   int r;
   do {
-    r = rand();
+    r = gv_rand();
   } while (r > discard_threshold);
 
   return r % bound;
@@ -62,8 +136,8 @@ uint64_t gv_random_u64(uint64_t bound) {
   assert(bound > 0);
 
   // See comment in `random_small`, but note that our maximum generated value
-  // here will be `UINT64_MAX` instead of `RAND_MAX`. Note that we need to do a
-  // slightly different calculation to avoid the integer overflow that would
+  // here will be `UINT64_MAX` instead of `GV_RAND_MAX`. Note that we need to do
+  // a slightly different calculation to avoid the integer overflow that would
   // otherwise result from `UINT64_MAX + 1`.
   const uint64_t discard_threshold =
       UINT64_MAX - (UINT64_MAX - bound + 1) % bound;
@@ -73,7 +147,7 @@ uint64_t gv_random_u64(uint64_t bound) {
     // generate a random `uint64_t` value
     r = 0;
     for (size_t i = 0; i < sizeof(uint64_t); ++i) {
-      // `RAND_MAX ≥ 32767` is guaranteed, so `random_small(256)` is safe
+      // `GV_RAND_MAX ≥ 255`, so `random_small(256)` is safe
       const uint8_t byte = (uint8_t)random_small((int)UINT8_MAX + 1);
       memcpy((char *)&r + i, &byte, sizeof(byte));
     }
@@ -85,7 +159,7 @@ uint64_t gv_random_u64(uint64_t bound) {
 int gv_random(int bound) {
   assert(bound > 0);
 
-  if (bound > RAND_MAX) {
+  if (bound > GV_RAND_MAX) {
     _Static_assert(INT_MAX <= UINT64_MAX,
                    "the `int` type includes non-negative values that do not "
                    "fit in a `uint64_t`, hence some `int` values can never be "
@@ -10,6 +10,41 @@
 extern "C" {
 #endif
 
+/// largest value returned by @ref gv_rand
+#define GV_RAND_MAX 2147483647
+
+/// seed the generator behind @ref gv_rand
+///
+/// Each thread has its own generator, so layouts running in separate threads
+/// neither disturb each other’s sequences nor race. Until seeded, a thread’s
+/// generator behaves as if seeded with 1.
+///
+/// @param seed Starting point of the sequence
+UTIL_API void gv_srand(unsigned seed);
+
+/// generate a random number in the range `[0, GV_RAND_MAX]`
+///
+/// This is a thread-local replacement for `rand`. For a given seed, it produces
+/// the same sequence as the GNU C library’s `rand` on every platform.
+///
+/// @return A random number drawn from a uniform distribution
+UTIL_API int gv_rand(void);
+
+/// seed the generator behind @ref gv_drand48
+///
+/// Like @ref gv_srand, the generator is per thread.
+///
+/// @param seed Starting point of the sequence
+UTIL_API void gv_srand48(long seed);
+
+/// generate a random number in the range `[0, 1)`
+///
+/// This is a thread-local replacement for the POSIX `drand48`, producing the
+/// same sequence.
+///
+/// @return A random number drawn from a uniform distribution
+UTIL_API double gv_drand48(void);
+
 /// generate a random permutation of the numbers `[0, bound - 1]`
 ///
 /// The caller is responsible for `free`ing the returned array. This function
@@ -21,8 +56,8 @@ UTIL_API int *gv_permutation(int bound);
 
 /// generate a random number in the range `[0, bound - 1]`
 ///
-/// This function assumes the caller has previously seeded the `rand` random
-/// number generator.
+/// This function assumes the caller has previously seeded the calling thread’s
+/// generator with @ref gv_srand.
 ///
 /// @param bound Exclusive upper bound on random number generation
 /// @return A random number drawn from a uniform distribution
@@ -30,8 +65,8 @@ UTIL_API int gv_random(int bound);
 
 /// generate a random 64-bit unsigned number in the range `[0, bound - 1]`
 ///
-/// This function assumes the caller has previously seeded the `rand` random
-/// number generator.
+/// This function assumes the caller has previously seeded the calling thread’s
+/// generator with @ref gv_srand.
 ///
 /// @param bound Exclusive upper bound on random number generation
 /// @return A random number drawn from a uniform distribution
@@ -0,0 +1,143 @@
+/// @file
+/// @brief Basic unit tester for parallel.c
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#define NO_CONFIG // suppress include of config.h in parallel.c
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/alloc.h>
+#include <util/parallel.c>
+
+/// a loop body that marks each iteration it was given
+static void mark(void *context, size_t start, size_t end, size_t worker) {
+  unsigned char *seen = context;
+  (void)worker;
+  for (size_t i = start; i < end; ++i) {
+    ++seen[i];
+  }
+}
+
+/// a loop body that should never be called
+static void fail(void *context, size_t start, size_t end, size_t worker) {
+  (void)context;
+  (void)start;
+  (void)end;
+  (void)worker;
+  assert(0 && "loop body called for an empty loop");
+}
+
+/// state for `sum_per_worker`
+typedef struct {
+  size_t pool_size;
+  size_t *sums; ///< one accumulator per worker
+} sums_t;
+
+/// a loop body accumulating into per-worker slots
+static void sum_per_worker(void *context, size_t start, size_t end,
+                           size_t worker) {
+  sums_t *s = context;
+  assert(worker < s->pool_size);
+  for (size_t i = start; i < end; ++i) {
+    s->sums[worker] += i;
+  }
+}
+
+/// processor count should always be something usable
+static void test_processors(void) { assert(gv_processors() >= 1); }
+
+/// a `NULL` pool runs loops inline
+static void test_null_pool(void) {
+  assert(gv_pool_size(NULL) == 1);
+
+  unsigned char seen[100] = {0};
+  gv_pool_for(NULL, sizeof(seen), 7, mark, seen);
+  for (size_t i = 0; i < sizeof(seen); ++i) {
+    assert(seen[i] == 1);
+  }
+
+  gv_pool_for(NULL, 0, 7, fail, NULL);
+
+  // freeing nothing should be fine
+  gv_pool_free(NULL);
+}
+
+/// create and destroy pools without using them
+static void test_lifecycle(void) {
+  for (size_t threads = 0; threads < 5; ++threads) {
+    gv_pool_t *pool = gv_pool_new(threads);
+    assert(gv_pool_size(pool) >= 1);
+    gv_pool_free(pool);
+  }
+}
+
+/// every iteration should be run exactly once, across repeated loops
+static void test_coverage(void) {
+  static const size_t grains[] = {0, 1, 3, 64, 1000, 5000};
+  enum { N = 4321 };
+
+  gv_pool_t *pool = gv_pool_new(4);
+
+  for (size_t g = 0; g < sizeof(grains) / sizeof(grains[0]); ++g) {
+    unsigned char *seen = gv_calloc(N, sizeof(seen[0]));
+    gv_pool_for(pool, N, grains[g], mark, seen);
+    for (size_t i = 0; i < N; ++i) {
+      assert(seen[i] == 1);
+    }
+    free(seen);
+  }
+
+  gv_pool_for(pool, 0, 1, fail, NULL);
+
+  gv_pool_free(pool);
+}
+
+/// per-worker accumulation should combine to the serial result
+static void test_worker_index(void) {
+  enum { N = 100000 };
+
+  gv_pool_t *pool = gv_pool_new(0);
+  sums_t s = {.pool_size = gv_pool_size(pool)};
+  s.sums = gv_calloc(s.pool_size, sizeof(s.sums[0]));
+
+  for (int round = 0; round < 10; ++round) {
+    for (size_t i = 0; i < s.pool_size; ++i) {
+      s.sums[i] = 0;
+    }
+    gv_pool_for(pool, N, 16, sum_per_worker, &s);
+    size_t total = 0;
+    for (size_t i = 0; i < s.pool_size; ++i) {
+      total += s.sums[i];
+    }
+    assert(total == (size_t)N * (N - 1) / 2);
+  }
+
+  free(s.sums);
+  gv_pool_free(pool);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  RUN(processors);
+  RUN(null_pool);
+  RUN(lifecycle);
+  RUN(coverage);
+  RUN(worker_index);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
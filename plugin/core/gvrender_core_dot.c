@@ -41,6 +41,7 @@ typedef enum {
 	FORMAT_XDOT,
 	FORMAT_XDOT12,
 	FORMAT_XDOT14,
+	FORMAT_GVB,
 } format_type;
 
 #define XDOTVERSION "1.7"
@@ -50,18 +51,22 @@ typedef enum {
  * However, only the first NUMXBUFS are distinct. Nodes, clusters, and
  * edges are drawn atomically, so they share the DRAW and LABEL buffers
  */
-static agxbuf xbuf[NUMXBUFS];
-static agxbuf* xbufs[] = {
-    xbuf+EMIT_GDRAW, xbuf+EMIT_CDRAW, xbuf+EMIT_TDRAW, xbuf+EMIT_HDRAW, 
-    xbuf+EMIT_GLABEL, xbuf+EMIT_CLABEL, xbuf+EMIT_TLABEL, xbuf+EMIT_HLABEL, 
-    xbuf+EMIT_CDRAW, xbuf+EMIT_CDRAW, xbuf+EMIT_CLABEL, xbuf+EMIT_CLABEL, 
+static _Thread_local agxbuf xbuf[NUMXBUFS];
+static const emit_state_t xbuf_index[] = {
+    EMIT_GDRAW, EMIT_CDRAW, EMIT_TDRAW, EMIT_HDRAW,
+    EMIT_GLABEL, EMIT_CLABEL, EMIT_TLABEL, EMIT_HLABEL,
+    EMIT_CDRAW, EMIT_CDRAW, EMIT_CLABEL, EMIT_CLABEL,
 };
-static double penwidth [] = {
+
+static agxbuf *xbufs(emit_state_t emit_state) {
+    return &xbuf[xbuf_index[emit_state]];
+}
+static _Thread_local double penwidth [] = {
     1, 1, 1, 1,
     1, 1, 1, 1,
     1, 1, 1, 1,
 };
-static unsigned int textflags[EMIT_ELABEL+1];
+static _Thread_local unsigned int textflags[EMIT_ELABEL+1];
 
 typedef struct {
     attrsym_t *g_draw;
@@ -78,7 +83,7 @@ typedef struct {
     char* version_s;
     double yOff; ///< ymin + ymax
 } xdot_state_t;
-static xdot_state_t* xd;
+static _Thread_local xdot_state_t* xd;
 
 static void xdot_str_xbuf (agxbuf* xb, char* pfx, const char* s)
 {
@@ -88,7 +93,7 @@ static void xdot_str_xbuf (agxbuf* xb, char* pfx, const char* s)
 static void xdot_str (GVJ_t *job, char* pfx, const char* s)
 {   
     emit_state_t emit_state = job->obj->emit_state;
-    xdot_str_xbuf (xbufs[emit_state], pfx, s);
+    xdot_str_xbuf (xbufs(emit_state), pfx, s);
 }
 
 /// output a color
@@ -115,7 +120,7 @@ static void xdot_str_color_xbuf(agxbuf *xb, const char *prefix,
 static void xdot_str_color(GVJ_t *job, const char *prefix,
                            const unsigned char rgba[4]) {
   emit_state_t emit_state = job->obj->emit_state;
-  agxbuf *xb = xbufs[emit_state];
+  agxbuf *xb = xbufs(emit_state);
   xdot_str_color_xbuf(xb, prefix, rgba);
 }
 
@@ -143,9 +148,9 @@ static void xdot_num(agxbuf *xb, double v)
 
 static void xdot_points(GVJ_t *job, char c, pointf *A, size_t n) {
     emit_state_t emit_state = job->obj->emit_state;
-    agxbprint(xbufs[emit_state], "%c %" PRISIZE_T " ", c, n);
+    agxbprint(xbufs(emit_state), "%c %" PRISIZE_T " ", c, n);
     for (size_t i = 0; i < n; i++)
-        xdot_point(xbufs[emit_state], A[i]);
+        xdot_point(xbufs(emit_state), A[i]);
 }
 
 static void xdot_pencolor (GVJ_t *job)
@@ -237,10 +242,10 @@ static void put_escaping_backslashes(Agobj_t* n, Agsym_t *sym, const char *value
 static void xdot_end_node(GVJ_t* job)
 {
     Agnode_t* n = job->obj->u.n; 
-    if (agxblen(xbufs[EMIT_NDRAW]))
-	agxset(n, xd->n_draw, agxbuse(xbufs[EMIT_NDRAW]));
-    if (agxblen(xbufs[EMIT_NLABEL]))
-	put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs[EMIT_NLABEL]));
+    if (agxblen(xbufs(EMIT_NDRAW)))
+	agxset(n, xd->n_draw, agxbuse(xbufs(EMIT_NDRAW)));
+    if (agxblen(xbufs(EMIT_NLABEL)))
+	put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs(EMIT_NLABEL)));
     penwidth[EMIT_NDRAW] = 1;
     penwidth[EMIT_NLABEL] = 1;
     textflags[EMIT_NDRAW] = 0;
@@ -251,18 +256,18 @@ static void xdot_end_edge(GVJ_t* job)
 {
     Agedge_t* e = job->obj->u.e; 
 
-    if (agxblen(xbufs[EMIT_EDRAW]))
-	agxset(e, xd->e_draw, agxbuse(xbufs[EMIT_EDRAW]));
-    if (agxblen(xbufs[EMIT_TDRAW]))
-	agxset(e, xd->t_draw, agxbuse(xbufs[EMIT_TDRAW]));
-    if (agxblen(xbufs[EMIT_HDRAW]))
-	agxset(e, xd->h_draw, agxbuse(xbufs[EMIT_HDRAW]));
-    if (agxblen(xbufs[EMIT_ELABEL]))
-	put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs[EMIT_ELABEL]));
-    if (agxblen(xbufs[EMIT_TLABEL]))
-	agxset(e, xd->tl_draw, agxbuse(xbufs[EMIT_TLABEL]));
-    if (agxblen(xbufs[EMIT_HLABEL]))
-	agxset(e, xd->hl_draw, agxbuse(xbufs[EMIT_HLABEL]));
+    if (agxblen(xbufs(EMIT_EDRAW)))
+	agxset(e, xd->e_draw, agxbuse(xbufs(EMIT_EDRAW)));
+    if (agxblen(xbufs(EMIT_TDRAW)))
+	agxset(e, xd->t_draw, agxbuse(xbufs(EMIT_TDRAW)));
+    if (agxblen(xbufs(EMIT_HDRAW)))
+	agxset(e, xd->h_draw, agxbuse(xbufs(EMIT_HDRAW)));
+    if (agxblen(xbufs(EMIT_ELABEL)))
+	put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs(EMIT_ELABEL)));
+    if (agxblen(xbufs(EMIT_TLABEL)))
+	agxset(e, xd->tl_draw, agxbuse(xbufs(EMIT_TLABEL)));
+    if (agxblen(xbufs(EMIT_HLABEL)))
+	agxset(e, xd->hl_draw, agxbuse(xbufs(EMIT_HLABEL)));
     penwidth[EMIT_EDRAW] = 1;
     penwidth[EMIT_ELABEL] = 1;
     penwidth[EMIT_TDRAW] = 1;
@@ -281,9 +286,9 @@ static void xdot_end_cluster(GVJ_t * job)
 {
     Agraph_t* cluster_g = job->obj->u.sg;
 
-    agxset(cluster_g, xd->g_draw, agxbuse(xbufs[EMIT_CDRAW]));
+    agxset(cluster_g, xd->g_draw, agxbuse(xbufs(EMIT_CDRAW)));
     if (GD_label(cluster_g))
-	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs[EMIT_CLABEL]));
+	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs(EMIT_CLABEL)));
     penwidth[EMIT_CDRAW] = 1;
     penwidth[EMIT_CLABEL] = 1;
     textflags[EMIT_CDRAW] = 0;
@@ -401,6 +406,7 @@ static void dot_begin_graph(GVJ_t *job)
 
     switch (job->render.id) {
 	case FORMAT_DOT:
+	case FORMAT_GVB:
 	    attach_attrs(g);
 	    break;
 	case FORMAT_CANON:
@@ -428,13 +434,13 @@ static void xdot_end_graph(graph_t* g)
 {
     int i;
 
-    if (agxblen(xbufs[EMIT_GDRAW])) {
+    if (agxblen(xbufs(EMIT_GDRAW))) {
 	if (!xd->g_draw)
 	    xd->g_draw = safe_dcl(g, AGRAPH, "_draw_", "");
-	agxset(g, xd->g_draw, agxbuse(xbufs[EMIT_GDRAW]));
+	agxset(g, xd->g_draw, agxbuse(xbufs(EMIT_GDRAW)));
     }
     if (GD_label(g))
-	put_escaping_backslashes(&g->base, xd->g_l_draw, agxbuse(xbufs[EMIT_GLABEL]));
+	put_escaping_backslashes(&g->base, xd->g_l_draw, agxbuse(xbufs(EMIT_GLABEL)));
     agsafeset (g, "xdotversion", xd->version_s, "");
 
     for (i = 0; i < NUMXBUFS; i++)
@@ -446,13 +452,19 @@ static void xdot_end_graph(graph_t* g)
     textflags[EMIT_GLABEL] = 0;
 }
 
+/// write callback for @ref agwritebin
+static size_t gvb_write(void *chan, const void *buf, size_t len)
+{
+    return gvwrite(chan, buf, len);
+}
+
 typedef int (*putstrfn) (void *chan, const char *str);
 typedef int (*flushfn) (void *chan);
 static void dot_end_graph(GVJ_t *job)
 {
     graph_t *g = job->obj->u.g;
     Agiodisc_t* io_save;
-    static Agiodisc_t io;
+    static _Thread_local Agiodisc_t io;
 
     if (io.afread == NULL) {
 	io.afread = AgIoDisc.afread;
@@ -481,6 +493,10 @@ static void dot_end_graph(GVJ_t *job)
 	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
 		agwrite(g, job);
 	    break;
+	case FORMAT_GVB:
+	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
+		agwritebin(g, job, gvb_write);
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -495,8 +511,8 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
     unsigned flags;
     int j;
     
-    agxbput(xbufs[emit_state], "F ");
-    xdot_fmt_num(xbufs[emit_state], span->font->size);
+    agxbput(xbufs(emit_state), "F ");
+    xdot_fmt_num(xbufs(emit_state), span->font->size);
     xdot_str (job, "", span->font->name);
     xdot_pencolor(job);
 
@@ -521,16 +537,16 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	unsigned int mask = flag_masks[xd->version-15];
 	unsigned int bits = flags & mask;
 	if (textflags[emit_state] != bits) {
-	    agxbprint(xbufs[emit_state], "t %u ", bits);
+	    agxbprint(xbufs(emit_state), "t %u ", bits);
 	    textflags[emit_state] = bits;
 	}
     }
 
     p.y += span->yoffset_centerline;
-    agxbput(xbufs[emit_state], "T ");
-    xdot_point(xbufs[emit_state], p);
-    agxbprint(xbufs[emit_state], "%d ", j);
-    xdot_fmt_num(xbufs[emit_state], span->size.x);
+    agxbput(xbufs(emit_state), "T ");
+    xdot_point(xbufs(emit_state), p);
+    agxbprint(xbufs(emit_state), "%d ", j);
+    xdot_fmt_num(xbufs(emit_state), span->size.x);
     xdot_str (job, "", span->str);
 }
 
@@ -611,13 +627,13 @@ static void xdot_ellipse(GVJ_t * job, pointf * A, int filled)
 	}
         else 
 	    xdot_fillcolor (job);
-        agxbput(xbufs[emit_state], "E ");
+        agxbput(xbufs(emit_state), "E ");
     }
     else
-        agxbput(xbufs[emit_state], "e ");
-    xdot_point(xbufs[emit_state], A[0]);
-    xdot_fmt_num(xbufs[emit_state], A[1].x - A[0].x);
-    xdot_fmt_num(xbufs[emit_state], A[1].y - A[0].y);
+        agxbput(xbufs(emit_state), "e ");
+    xdot_point(xbufs(emit_state), A[0]);
+    xdot_fmt_num(xbufs(emit_state), A[1].x - A[0].x);
+    xdot_fmt_num(xbufs(emit_state), A[1].y - A[0].y);
 }
 
 static void xdot_bezier(GVJ_t *job, pointf *A, size_t n, int filled) {
@@ -662,10 +678,10 @@ void core_loadimage_xdot(GVJ_t * job, usershape_t *us, boxf b, bool filled)
 
     emit_state_t emit_state = job->obj->emit_state;
     
-    agxbput(xbufs[emit_state], "I ");
-    xdot_point(xbufs[emit_state], b.LL);
-    xdot_fmt_num(xbufs[emit_state], b.UR.x - b.LL.x);
-    xdot_fmt_num(xbufs[emit_state], b.UR.y - b.LL.y);
+    agxbput(xbufs(emit_state), "I ");
+    xdot_point(xbufs(emit_state), b.LL);
+    xdot_fmt_num(xbufs(emit_state), b.UR.x - b.LL.x);
+    xdot_fmt_num(xbufs(emit_state), b.UR.y - b.LL.y);
     xdot_str (job, "", us->name);
 }
 
@@ -768,6 +784,13 @@ static gvdevice_features_t device_features_dot = {
     {72.,72.},			/* default dpi */
 };
 
+static gvdevice_features_t device_features_gvb = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_dot_types[] = {
     {FORMAT_DOT, "dot", 1, &dot_engine, &render_features_dot},
     {FORMAT_XDOT, "xdot", 1, &xdot_engine, &render_features_xdot},
@@ -783,5 +806,6 @@ gvplugin_installed_t gvdevice_dot_types[] = {
     {FORMAT_XDOT, "xdot:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT12, "xdot1.2:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT14, "xdot1.4:xdot", 1, NULL, &device_features_dot},
+    {FORMAT_GVB, "gvb:dot", 1, NULL, &device_features_gvb},
     {0, NULL, 0, NULL, NULL}
 };
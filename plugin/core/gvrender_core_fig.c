@@ -33,7 +33,7 @@
 
 enum { FORMAT_FIG, };
 
-static int Depth;
+static _Thread_local int Depth;
 
 static void figptarray(GVJ_t *job, pointf *A, size_t n, int close) {
     for (size_t i = 0; i < n; i++) {
@@ -49,8 +49,8 @@ static int figColorResolve(bool *new, unsigned char r, unsigned char g,
   unsigned char b)
 {
 #define maxColors 512
-    static int top = 0;
-    static short red[maxColors], green[maxColors], blue[maxColors];
+    static _Thread_local int top = 0;
+    static _Thread_local short red[maxColors], green[maxColors], blue[maxColors];
     int c;
     int ct = -1;
     long rd, gd, bd, dist;
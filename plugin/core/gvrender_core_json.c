@@ -703,7 +703,7 @@ static void json_end_graph(GVJ_t *job)
 {
     graph_t *g = job->obj->u.g;
     state_t sp;
-    static Agiodisc_t io;
+    static _Thread_local Agiodisc_t io;
 
     if (io.afread == NULL) {
 	io.afread = AgIoDisc.afread;
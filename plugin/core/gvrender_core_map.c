@@ -240,7 +240,8 @@ static gvrender_features_t render_features_map = {
 	| GVRENDER_DOES_LABELS
 	| GVRENDER_DOES_TOOLTIPS
 	| GVRENDER_DOES_TARGETS
-	| GVRENDER_DOES_MAP_RECTANGLE, /* flags */
+	| GVRENDER_DOES_MAP_RECTANGLE
+	| GVRENDER_CONCURRENT, /* flags */
     4.,                         /* default pad - graph units */
     NULL,			/* knowncolors */
     0,				/* sizeof knowncolors */
@@ -33,8 +33,8 @@
 
 enum {FORMAT_PIC};
 
-static bool onetime = true;
-static double Fontscale;
+static _Thread_local bool onetime = true;
+static _Thread_local double Fontscale;
 
 /* There are a couple of ways to generate output: 
     1. generate for whatever size is given by the bounding box
@@ -290,8 +290,8 @@ static void pic_end_page(GVJ_t * job)
 
 static void pic_textspan(GVJ_t * job, pointf p, textspan_t * span)
 {
-    static char *lastname;
-    static double lastsize;
+    static _Thread_local char *lastname;
+    static _Thread_local double lastsize;
 
     switch (span->just) {
     case 'l': 
@@ -312,8 +312,8 @@ enum { FORMAT_POV, };
 
 static char *pov_knowncolors[] = { POV_COLORS };
 
-static int layerz = 0;
-static int z = 0;
+static _Thread_local int layerz = 0;
+static _Thread_local int z = 0;
 
 static char *pov_color_as_str(GVJ_t * job, gvcolor_t color, float transparency)
 {
@@ -740,7 +740,8 @@ static gvrender_features_t render_features_pov = {
 	    | GVRENDER_DOES_MAP_BSPLINE
 	    | GVRENDER_NO_WHITE_BG
 	    | GVRENDER_DOES_TRANSFORM
-	    | GVRENDER_DOES_Z,
+	    | GVRENDER_DOES_Z
+	    | GVRENDER_CONCURRENT,
 	4.0,			/* default pad - graph units */
 	pov_knowncolors,	/* knowncolors */
 	sizeof(pov_knowncolors) / sizeof(char *),	/* strings in knowncolors */
@@ -37,8 +37,8 @@
 
 enum { FORMAT_PS, FORMAT_PS2, FORMAT_EPS };
 
-static int isLatin1;
-static bool setupLatin1;
+static _Thread_local int isLatin1;
+static _Thread_local bool setupLatin1;
 
 static void psgen_begin_job(GVJ_t * job)
 {
@@ -574,7 +574,7 @@ static void svg_print_stop(GVJ_t * job, double offset, gvcolor_t color)
  */
 static int svg_gradstyle(GVJ_t *job, pointf *A, size_t n) {
     pointf G[2];
-    static int gradId;
+    static _Thread_local int gradId;
     int id = gradId++;
 
     obj_state_t *obj = job->obj;
@@ -611,7 +611,7 @@ static int svg_gradstyle(GVJ_t *job, pointf *A, size_t n) {
 static int svg_rgradstyle(GVJ_t * job)
 {
     double ifx, ify;
-    static int rgradId;
+    static _Thread_local int rgradId;
     int id = rgradId++;
 
     obj_state_t *obj = job->obj;
@@ -800,7 +800,7 @@ static gvrender_engine_t svg_engine = {
 };
 
 static gvrender_features_t render_features_svg = {
-    GVRENDER_Y_GOES_DOWN | GVRENDER_DOES_TRANSFORM | GVRENDER_DOES_LABELS | GVRENDER_DOES_MAPS | GVRENDER_DOES_TARGETS | GVRENDER_DOES_TOOLTIPS,	/* flags */
+    GVRENDER_Y_GOES_DOWN | GVRENDER_DOES_TRANSFORM | GVRENDER_DOES_LABELS | GVRENDER_DOES_MAPS | GVRENDER_DOES_TARGETS | GVRENDER_DOES_TOOLTIPS | GVRENDER_CONCURRENT,	/* flags */
     4.,				/* default pad - graph units */
     svg_knowncolors,		/* knowncolors */
     sizeof(svg_knowncolors) / sizeof(char *),	/* sizeof knowncolors */
@@ -808,7 +808,7 @@ static gvrender_features_t render_features_svg = {
 };
 
 static gvdevice_features_t device_features_svg = {
-    GVDEVICE_DOES_TRUECOLOR|GVDEVICE_DOES_LAYERS,  /* flags */
+    GVDEVICE_DOES_TRUECOLOR|GVDEVICE_DOES_LAYERS|GVDEVICE_BUFFERED,  /* flags */
     {0., 0.},			/* default margin - points */
     {0., 0.},			/* default page width, height - points */
     {72., 72.},			/* default dpi */
@@ -122,7 +122,7 @@ static void tkgen_begin_job(GVJ_t * job)
            job->common->info[1], job->common->info[2]);
 }
 
-static int first_periphery;
+static _Thread_local int first_periphery;
 
 static void tkgen_begin_graph(GVJ_t * job)
 {
@@ -346,7 +346,8 @@ static gvrender_engine_t tkgen_engine = {
 
 static gvrender_features_t render_features_tk = {
     GVRENDER_Y_GOES_DOWN
-	| GVRENDER_NO_WHITE_BG, /* flags */
+	| GVRENDER_NO_WHITE_BG
+	| GVRENDER_CONCURRENT, /* flags */
     4.,                         /* default pad - graph units */
     NULL, 			/* knowncolors */
     0,				/* sizeof knowncolors */
@@ -1 +1,9 @@
+#pragma once
+
 #define FONT_DPI 96.
+
+#include <common/types.h>
+#include <stdbool.h>
+
+/// lay out a span with Pango, attaching the layout to it
+bool pango_textlayout(textspan_t *span, char **fontpath);
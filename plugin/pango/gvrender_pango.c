@@ -313,6 +313,18 @@ static void cairogen_textspan(GVJ_t * job, pointf p, textspan_t * span)
     }
     p.y += span->yoffset_centerline + span->yoffset_layout;
 
+    /* spans measured from the text measurement cache have no layout yet */
+    if (!span->layout) {
+	const pointf size = span->size;
+	const double yoffset_layout = span->yoffset_layout;
+	const double yoffset_centerline = span->yoffset_centerline;
+	if (!pango_textlayout(span, NULL))
+	    return;
+	span->size = size;
+	span->yoffset_layout = yoffset_layout;
+	span->yoffset_centerline = yoffset_centerline;
+    }
+
     cairo_move_to (cr, p.x, -p.y);
     cairo_save(cr);
     cairo_scale(cr, POINTS_PER_INCH / FONT_DPI, POINTS_PER_INCH / FONT_DPI);
@@ -503,6 +515,13 @@ static gvrender_engine_t cairogen_engine = {
     0,				/* cairogen_library_shape */
 };
 
+/* Not GVRENDER_CONCURRENT: jobs for the same graph draw the same text spans,
+ * and cairogen_textspan fills in a span's PangoLayout on first use, through
+ * pango_textlayout and its static font path buffer, and then draws that one
+ * layout object, which pango does not allow from several threads at once.
+ * cairo_loadimage likewise caches the decoded surface of an image in its
+ * shared usershape_t without locking.
+ */
 static gvrender_features_t render_features_cairo = {
     GVRENDER_Y_GOES_DOWN
 	| GVRENDER_DOES_TRANSFORM, /* flags */
@@ -25,6 +25,7 @@
 
 #include <pango/pangocairo.h>
 #include "gvgetfontlist.h"
+#include "gvplugin_pango.h"
 #ifdef HAVE_PANGO_FC_FONT_LOCK_FACE
 #include <pango/pangofc-font.h>
 #endif
@@ -50,8 +51,6 @@ static char* pango_psfontResolve (PostscriptAlias* pa)
     return agxbdisown(&buf);
 }
 
-#define FONT_DPI 96.
-
 #define ENABLE_PANGO_MARKUP
 
 // wrapper to handle difference in calling conventions between `agxbput` and
@@ -62,15 +61,15 @@ static int agxbput_int(void *buffer, const char *s) {
   return (int)len;
 }
 
-static bool pango_textlayout(textspan_t * span, char **fontpath)
+bool pango_textlayout(textspan_t * span, char **fontpath)
 {
     static agxbuf buf; // returned in fontpath, only good until next call
-    static PangoFontMap *fontmap;
-    static PangoContext *context;
-    static PangoFontDescription *desc;
-    static char *fontname;
-    static double fontsize;
-    static gv_font_map* gv_fmap;
+    static _Thread_local PangoFontMap *fontmap;
+    static _Thread_local PangoContext *context;
+    static _Thread_local PangoFontDescription *desc;
+    static _Thread_local char *fontname;
+    static _Thread_local double fontsize;
+    static _Thread_local gv_font_map* gv_fmap;
     char *fnt, *psfnt = NULL;
     PangoFont *font;
 #ifdef ENABLE_PANGO_MARKUP
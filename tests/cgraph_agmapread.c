@@ -0,0 +1,43 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_agmapread
+///
+/// Maps the file named by the last argument into memory and writes each graph
+/// read from it to stdout. Files that cannot be mapped are read through stdio,
+/// as callers of `agmapopen` are expected to do. A leading `-p` argument reads
+/// the mapped graphs with `AG_PARALLEL_READ`.
+
+#include <assert.h>
+#include <errno.h>
+#include <graphviz/cgraph.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+
+  assert(argc == 2 || (argc == 3 && strcmp(argv[1], "-p") == 0));
+  const char *const path = argv[argc - 1];
+  const unsigned flags = argc == 3 ? AG_PARALLEL_READ : 0;
+
+  struct graphviz_mapped_input *const input = agmapopen(path);
+  if (input == NULL) {
+    assert(errno == EINVAL);
+    FILE *const f = fopen(path, "r");
+    assert(f != NULL);
+    for (Agraph_t *g; (g = agread(f, NULL)) != NULL;) {
+      agwrite(g, stdout);
+      agclose(g);
+    }
+    fclose(f);
+    return 0;
+  }
+
+  for (Agraph_t *g; (g = agmapread_flags(input, NULL, flags)) != NULL;) {
+    agwrite(g, stdout);
+    agclose(g);
+  }
+
+  agmapclose(input);
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_agstrtod
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+int main(void) {
+
+  Agraph_t *const g = agopen("foo", Agdirected, NULL);
+  assert(g != NULL);
+
+  // a number should parse the same way repeatedly
+  const char *const number = agstrdup_text(g, "1.5in");
+  assert(number != NULL);
+  for (int i = 0; i < 2; ++i) {
+    double d = 0;
+    assert(agstrtod(number, &d));
+    assert(d == 1.5);
+  }
+
+  // parsing as an integer after parsing as a double should give strtol’s answer
+  {
+    long l = 0;
+    assert(agstrtol(number, &l));
+    assert(l == 1);
+    double d = 0;
+    assert(agstrtod(number, &d));
+    assert(d == 1.5);
+  }
+
+  // text that is not a number should be rejected
+  {
+    const char *const text = agstrdup_text(g, "bar");
+    assert(text != NULL);
+    double d = 42;
+    assert(!agstrtod(text, &d));
+    assert(!agstrtod(text, &d));
+    assert(d == 42);
+    long l = 42;
+    assert(!agstrtol(text, &l));
+    assert(l == 42);
+  }
+
+  // an attribute value set on one object should not affect another
+  {
+    Agsym_t *const width = agattr_text(g, AGNODE, "width", "0.75");
+    assert(width != NULL);
+    Agnode_t *const a = agnode(g, "a", 1);
+    Agnode_t *const b = agnode(g, "b", 1);
+    double d = 0;
+    assert(agstrtod(agxget(a, width), &d));
+    assert(d == 0.75);
+    agxset(b, width, "2");
+    assert(agstrtod(agxget(b, width), &d));
+    assert(d == 2);
+    assert(agstrtod(agxget(a, width), &d));
+    assert(d == 0.75);
+  }
+
+  (void)agclose(g);
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_arena
+///
+/// Reads a graph from stdin, edits it, and writes it to stdout. Passing `arena`
+/// as the only argument allocates the graph’s objects from a region.
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+
+  // options the library does not know should be refused
+  assert(agopen_flags("unknown", Agdirected, NULL, 1u << 31) == NULL);
+
+  const unsigned flags = argc > 1 && strcmp(argv[1], "arena") == 0 ? AG_ARENA
+                                                                   : 0;
+
+  Agraph_t *const g = agread_flags(stdin, NULL, flags);
+  assert(g != NULL);
+
+  // declare attributes after objects exist, growing their value arrays
+  Agsym_t *const weight = agattr_text(g, AGEDGE, "weight", "1");
+  assert(weight != NULL);
+  Agsym_t *const color = agattr_text(g, AGNODE, "color", "black");
+  assert(color != NULL);
+
+  // delete every third node and every other remaining edge
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g), *next; n != NULL; n = next) {
+    next = agnxtnode(g, n);
+    if (i++ % 3 == 0) {
+      agdelnode(g, n);
+    }
+  }
+  i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    for (Agedge_t *e = agfstout(g, n), *next; e != NULL; e = next) {
+      next = agnxtout(g, e);
+      if (i++ % 2 == 0) {
+        agdeledge(g, e);
+      } else {
+        agxset(e, weight, "2");
+      }
+    }
+  }
+
+  // add a subgraph holding the remaining nodes, then delete the first one
+  Agraph_t *const sg = agsubg(g, "remaining", 1);
+  assert(sg != NULL);
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    Agnode_t *const sn = agsubnode(sg, n, 1);
+    assert(sn != NULL);
+    agxset(sn, color, "red");
+  }
+  Agraph_t *const first = agfstsubg(g);
+  assert(first != NULL);
+  if (first != sg) {
+    agdelsubg(g, first);
+  }
+
+  // attach and detach a record
+  agbindrec(g, "test", sizeof(Agrec_t), false);
+  agdelrec(g, "test");
+
+  agwrite(g, stdout);
+  agclose(g);
+
+  return 0;
+}
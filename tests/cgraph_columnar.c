@@ -0,0 +1,72 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_columnar
+///
+/// Reads a graph from stdin, edits its attributes, and writes it to stdout.
+/// Passing `columnar` as the only argument stores node and edge attribute
+/// values by column.
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+
+  const unsigned flags =
+      argc > 1 && strcmp(argv[1], "columnar") == 0 ? AG_COLUMNAR : 0;
+
+  Agraph_t *const g = agread_flags(stdin, NULL, flags);
+  assert(g != NULL);
+
+  // declare an attribute after nodes exist, then change its default so
+  // existing nodes keep the old one and new nodes take the new one
+  Agsym_t *const color = agattr_text(g, AGNODE, "color", "black");
+  assert(color != NULL);
+  agattr_text(g, AGNODE, "color", "blue");
+  Agnode_t *const added = agnode(g, "added", 1);
+  assert(added != NULL);
+  assert(strcmp(agxget(added, color), "blue") == 0);
+
+  // a node created in a subgraph takes the defaults of that subgraph
+  Agraph_t *const sg = agsubg(g, "cluster_columnar", 1);
+  assert(sg != NULL);
+  agattr_text(sg, AGNODE, "color", "green");
+  agattr_html(sg, AGNODE, "label", "<b>html</b>");
+  Agnode_t *const local = agnode(sg, "local", 1);
+  assert(local != NULL);
+  assert(strcmp(agxget(local, color), "green") == 0);
+  assert(aghtmlstr(agget(local, "label")));
+
+  // set values on a sparse selection of edges, and delete some objects
+  Agsym_t *const weight = agattr_text(g, AGEDGE, "weight", "1");
+  assert(weight != NULL);
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g), *next; n != NULL; n = next) {
+    next = agnxtnode(g, n);
+    for (Agedge_t *e = agfstout(g, n), *next_e; e != NULL; e = next_e) {
+      next_e = agnxtout(g, e);
+      if (i % 5 == 0) {
+        agxset(e, weight, "3");
+      } else if (i % 7 == 0) {
+        agdeledge(g, e);
+      }
+      ++i;
+    }
+    if (n != added && n != local && i % 4 == 0) {
+      agdelnode(g, n);
+    }
+  }
+
+  // copy attributes between nodes
+  Agnode_t *const copy = agnode(g, "copy", 1);
+  assert(copy != NULL);
+  agcopyattr(local, copy);
+  assert(strcmp(agxget(copy, color), "green") == 0);
+
+  agwrite(g, stdout);
+  agclose(g);
+
+  return 0;
+}
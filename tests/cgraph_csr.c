@@ -0,0 +1,114 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_csr
+///
+/// Reads a graph from stdin, takes adjacency snapshots of it and each of its
+/// subgraphs, and checks them against cgraph’s own iterators.
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// check a snapshot of the given graph
+static void check(Agraph_t *g) {
+  Agsym_t *const weight = agattr_text(g, AGEDGE, "weight", NULL);
+  Agcsr_t *const csr = agcsropen(g, weight, 1);
+  assert(csr != NULL);
+
+  // nodes appear in iteration order
+  size_t i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n), ++i) {
+    assert(i < csr->n_nodes);
+    assert(csr->nodes[i] == n);
+    assert(agcsrindex(csr, n) == i);
+  }
+  assert(i == csr->n_nodes);
+  assert(csr->n_nodes == (size_t)agnnodes(g));
+
+  // nodes of the root graph not in this one are not found
+  Agraph_t *const root = agroot(g);
+  for (Agnode_t *n = agfstnode(root); n != NULL; n = agnxtnode(root, n)) {
+    if (agsubnode(g, n, 0) == NULL) {
+      assert(agcsrindex(csr, n) == SIZE_MAX);
+    }
+  }
+
+  for (i = 0; i < csr->n_nodes; ++i) {
+    Agnode_t *const n = csr->nodes[i];
+
+    // out-edges appear in the order of `agfstout`
+    size_t x = csr->out[i];
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e), ++x) {
+      assert(x < csr->out[i + 1]);
+      assert(ageqedge(csr->edges[x], e));
+      assert(csr->tails[x] == i);
+      assert(csr->nodes[csr->heads[x]] == aghead(e));
+
+      char *end;
+      const double w = strtod(agxget(e, weight), &end);
+      assert(csr->weights[x] == (end == agxget(e, weight) ? 1 : w));
+    }
+    assert(x == csr->out[i + 1]);
+
+    // in-edges appear in the order of `agfstin`
+    x = csr->in[i];
+    for (Agedge_t *e = agfstin(g, n); e != NULL; e = agnxtin(g, e), ++x) {
+      assert(x < csr->in[i + 1]);
+      const size_t id = csr->in_edges[x];
+      assert(ageqedge(csr->edges[id], e));
+      assert(csr->heads[id] == i);
+      assert(csr->nodes[csr->tails[id]] == agtail(e));
+    }
+    assert(x == csr->in[i + 1]);
+  }
+
+  printf("%s: %zu nodes, %zu edges\n", agnameof(g), csr->n_nodes,
+         csr->n_edges);
+  agcsrclose(csr);
+
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    check(sg);
+  }
+}
+
+int main(void) {
+
+  Agraph_t *const g = agread(stdin, NULL);
+  assert(g != NULL);
+
+  // give every other edge a weight, some of them unparseable
+  Agsym_t *const weight = agattr_text(g, AGEDGE, "weight", "");
+  int i = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e), ++i) {
+      if (i % 4 == 1) {
+        agxset(e, weight, "2.5");
+      } else if (i % 4 == 3) {
+        agxset(e, weight, "heavy");
+      }
+    }
+  }
+
+  // add a loop and parallel edges
+  Agnode_t *const a = agnode(g, "csr_a", 1);
+  Agnode_t *const b = agnode(g, "csr_b", 1);
+  assert(agedge(g, a, a, "loop", 1) != NULL);
+  assert(agedge(g, a, b, "first", 1) != NULL);
+  assert(agedge(g, a, b, "second", 1) != NULL);
+  assert(agedge(g, b, a, "third", 1) != NULL);
+
+  check(g);
+
+  // a snapshot of a graph without edges
+  Agraph_t *const empty = agsubg(g, "csr_empty", 1);
+  Agcsr_t *const csr = agcsropen(empty, NULL, 0);
+  assert(csr->n_nodes == 0 && csr->n_edges == 0);
+  assert(csr->weights == NULL);
+  assert(agcsrindex(csr, a) == SIZE_MAX);
+  agcsrclose(csr);
+
+  agclose(g);
+  return 0;
+}
@@ -0,0 +1,154 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_edge_index
+///
+/// Builds and edits graphs with many parallel and duplicate edges, looking up
+/// edges along the way, and writes the results to stdout. Passing `index` as
+/// the only argument indexes the graphs’ edges by their endpoints.
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/// number of nodes around the hub
+enum { SPOKES = 2000 };
+
+static unsigned flags;
+
+/// a hub node with an edge to and from each of many others, in a strict graph
+static void hub(void) {
+  Agraph_t *const g = agopen_flags("hub", Agstrictdirected, NULL, flags);
+  assert(g != NULL);
+
+  Agnode_t *const centre = agnode(g, "centre", 1);
+  for (int i = 0; i < SPOKES; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%d", i);
+    Agnode_t *const n = agnode(g, name, 1);
+    Agedge_t *const out = agedge(g, centre, n, NULL, 1);
+    assert(out != NULL);
+    Agedge_t *const in = agedge(g, n, centre, NULL, 1);
+    assert(in != NULL);
+
+    // duplicates are merged
+    assert(ageqedge(agedge(g, centre, n, NULL, 1), out));
+    assert(ageqedge(agedge(g, n, centre, NULL, 1), in));
+  }
+  printf("hub: %d nodes, %d edges\n", agnnodes(g), agnedges(g));
+
+  // put every third spoke in a subgraph and look the edges up there
+  Agraph_t *const sg = agsubg(g, "third", 1);
+  int i = 0;
+  for (Agedge_t *e = agfstout(g, centre); e != NULL; e = agnxtout(g, e)) {
+    if (i++ % 3 == 0) {
+      assert(agsubedge(sg, e, 1) != NULL);
+    }
+  }
+  int found = 0;
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    if (agedge(sg, centre, n, NULL, 0) != NULL) {
+      ++found;
+    }
+    assert(agedge(sg, n, centre, NULL, 0) == NULL);
+  }
+  printf("hub: %d edges in subgraph, %d found\n", agnedges(sg), found);
+
+  // delete every other out-edge and check it is gone
+  i = 0;
+  for (Agedge_t *e = agfstout(g, centre), *next; e != NULL; e = next) {
+    next = agnxtout(g, e);
+    if (i++ % 2 == 0) {
+      Agnode_t *const h = aghead(e);
+      agdeledge(g, e);
+      assert(agedge(g, centre, h, NULL, 0) == NULL);
+      assert(agedge(sg, centre, h, NULL, 0) == NULL);
+      assert(agedge(g, h, centre, NULL, 0) != NULL);
+    }
+  }
+  printf("hub: %d edges after deletion, %d in subgraph\n", agnedges(g),
+         agnedges(sg));
+
+  // and recreate them
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    if (n != centre) {
+      assert(agedge(g, centre, n, NULL, 1) != NULL);
+    }
+  }
+  printf("hub: %d edges after recreation\n", agnedges(g));
+
+  agclose(g);
+}
+
+/// many parallel edges with keys, in an undirected graph
+static void parallel(void) {
+  Agraph_t *const g = agopen_flags("parallel", Agundirected, NULL, flags);
+  assert(g != NULL);
+
+  Agnode_t *const a = agnode(g, "a", 1);
+  Agnode_t *const b = agnode(g, "b", 1);
+  for (int i = 0; i < 100; ++i) {
+    char key[32];
+    snprintf(key, sizeof(key), "k%d", i);
+    Agedge_t *const e = agedge(g, i % 2 ? a : b, i % 2 ? b : a, key, 1);
+    assert(e != NULL);
+    assert(strcmp(agnameof(e), key) == 0);
+  }
+  printf("parallel: %d edges\n", agnedges(g));
+
+  // each key is found in either direction
+  for (int i = 0; i < 100; ++i) {
+    char key[32];
+    snprintf(key, sizeof(key), "k%d", i);
+    Agedge_t *const ab = agedge(g, a, b, key, 0);
+    Agedge_t *const ba = agedge(g, b, a, key, 0);
+    assert(ab != NULL && ba != NULL);
+    assert(ageqedge(ab, ba));
+    assert(strcmp(agnameof(ab), key) == 0);
+  }
+  assert(agedge(g, a, b, "missing", 0) == NULL);
+
+  // delete the even keys and look again
+  for (int i = 0; i < 100; i += 2) {
+    char key[32];
+    snprintf(key, sizeof(key), "k%d", i);
+    Agedge_t *const e = agedge(g, a, b, key, 0);
+    assert(e != NULL);
+    agdeledge(g, e);
+  }
+  for (int i = 0; i < 100; ++i) {
+    char key[32];
+    snprintf(key, sizeof(key), "k%d", i);
+    assert((agedge(g, a, b, key, 0) == NULL) == (i % 2 == 0));
+  }
+  printf("parallel: %d edges after deletion\n", agnedges(g));
+
+  // an edge between the nodes can be found without a key
+  Agedge_t *const any = agedge(g, a, b, NULL, 0);
+  assert(any != NULL);
+  assert(ageqedge(agedge(g, a, b, agnameof(any), 0), any));
+
+  agclose(g);
+}
+
+int main(int argc, char **argv) {
+
+  flags = argc > 1 && strcmp(argv[1], "index") == 0 ? AG_EDGE_INDEX : 0;
+
+  hub();
+  parallel();
+
+  // read and write a graph with clusters
+  Agraph_t *const g = agread_flags(stdin, NULL, flags);
+  assert(g != NULL);
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      assert(agedge(g, agtail(e), aghead(e), NULL, 0) != NULL);
+    }
+  }
+  agwrite(g, stdout);
+  agclose(g);
+
+  return 0;
+}
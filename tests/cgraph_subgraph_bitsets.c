@@ -0,0 +1,152 @@
+/// @file
+/// @brief Accompanying test code for test_cgraph_subgraph_bitsets
+///
+/// Builds and edits graphs with nested subgraphs, walking them along the way,
+/// and writes the results to stdout. Passing `bitsets` as the only argument
+/// keeps the subgraphs’ members in bitsets.
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static unsigned flags;
+
+/// print the nodes and edges of a graph, forwards and backwards
+static void walk(Agraph_t *g) {
+  printf("%s: %d nodes, %d edges\n", agnameof(g), agnnodes(g), agnedges(g));
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    printf(" %s(%d,%d,%d)", agnameof(n), agdegree(g, n, 1, 0),
+           agdegree(g, n, 0, 1), agcountuniqedges(g, n, 1, 1));
+    for (Agedge_t *e = agfstedge(g, n); e != NULL; e = agnxtedge(g, e, n)) {
+      printf(" %s-%s", agnameof(agtail(e)), agnameof(aghead(e)));
+    }
+    printf("\n");
+  }
+  printf(" backwards:");
+  for (Agnode_t *n = aglstnode(g); n != NULL; n = agprvnode(g, n)) {
+    printf(" %s", agnameof(n));
+  }
+  printf("\n");
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    walk(sg);
+  }
+}
+
+/// a chain of nested subgraphs with nodes added at each depth
+static void nested(void) {
+  Agraph_t *const g = agopen_flags("nested", Agdirected, NULL, flags);
+  assert(g != NULL);
+
+  enum { DEPTH = 50 };
+  Agraph_t *sg[DEPTH];
+  Agraph_t *parent = g;
+  for (int i = 0; i < DEPTH; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "cluster_%d", i);
+    sg[i] = parent = agsubg(parent, name, 1);
+  }
+
+  // nodes created in the innermost subgraph, and edges between them
+  Agnode_t *prev = NULL;
+  for (int i = 0; i < 600; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "n%d", i);
+    Agnode_t *const n = agnode(sg[i % DEPTH], name, 1);
+    assert(n != NULL);
+    if (prev != NULL) {
+      assert(agedge(sg[i % DEPTH], prev, n, NULL, 1) != NULL);
+    }
+    prev = n;
+  }
+  // an existing node added to a subgraph, and parallel edges and a loop
+  Agnode_t *const first = agnode(g, "n0", 0);
+  assert(agsubnode(sg[DEPTH - 1], first, 1) == first);
+  assert(agedge(sg[DEPTH - 1], first, prev, "p1", 1) != NULL);
+  assert(agedge(sg[DEPTH - 1], first, prev, "p2", 1) != NULL);
+  assert(agedge(sg[3], first, first, "loop", 1) != NULL);
+
+  printf("nested: %d nodes in the innermost subgraph\n",
+         agnnodes(sg[DEPTH - 1]));
+  for (int i = 0; i < DEPTH; i += 7) {
+    printf("nested: depth %d has %d nodes, %d edges\n", i, agnnodes(sg[i]),
+           agnedges(sg[i]));
+  }
+
+  // lookups, with and without keys
+  assert(agedge(sg[DEPTH - 1], first, prev, "p2", 0) != NULL);
+  assert(agedge(sg[DEPTH - 1], first, prev, NULL, 0) != NULL);
+  assert(agedge(sg[DEPTH - 1], prev, first, NULL, 0) == NULL);
+  assert(agedge(sg[4], first, first, NULL, 0) == NULL);
+  assert(agedge(sg[3], first, first, NULL, 0) != NULL);
+  assert(agnode(sg[DEPTH - 1], "n1", 0) == NULL);
+  assert(agnode(sg[1], "n1", 0) != NULL);
+
+  // delete a node from a subgraph, an edge and a node from the root graph
+  Agnode_t *const n7 = agnode(g, "n7", 0);
+  assert(agdelnode(sg[2], n7) == 0);
+  assert(agnode(sg[2], "n7", 0) == NULL);
+  assert(agnode(sg[1], "n7", 0) == n7);
+  Agedge_t *const p1 = agedge(g, first, prev, "p1", 0);
+  assert(p1 != NULL);
+  assert(agdeledge(g, p1) == 0);
+  assert(agedge(sg[DEPTH - 1], first, prev, "p1", 0) == NULL);
+  assert(agdelnode(g, agnode(g, "n8", 0)) == 0);
+
+  // renumber nodes, and rename one that is only in the root graph
+  assert(agnodebefore(agnode(g, "n20", 0), agnode(g, "n5", 0)) == 0);
+  assert(agrelabel_node(agnode(g, "lone", 1), "alone") == 0);
+
+  walk(g);
+
+  // close an inner subgraph
+  assert(agclose(sg[10]) == 0);
+  printf("nested: %d nodes in the outermost subgraph after closing\n",
+         agnnodes(sg[0]));
+
+  agclose(g);
+}
+
+/// an undirected strict graph with a subgraph holding a few of its edges
+static void strict(void) {
+  Agraph_t *const g = agopen_flags("strict", Agstrictundirected, NULL, flags);
+  assert(g != NULL);
+  Agraph_t *const sg = agsubg(g, "sub", 1);
+
+  Agnode_t *nodes[40];
+  for (int i = 0; i < 40; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "s%d", i);
+    nodes[i] = agnode(i % 3 ? g : sg, name, 1);
+  }
+  for (int i = 0; i < 40; ++i) {
+    for (int j = 0; j < 40; j += 3) {
+      (void)agedge(i % 2 ? g : sg, nodes[i], nodes[j], NULL, 1);
+      // duplicates and reversed duplicates are merged
+      Agnode_t *const t = agsubnode(sg, nodes[j], 1);
+      Agnode_t *const h = agsubnode(sg, nodes[i], 1);
+      (void)agedge(sg, t, h, NULL, 1);
+    }
+  }
+  walk(g);
+  agclose(g);
+}
+
+int main(int argc, char **argv) {
+
+  flags = argc > 1 && strcmp(argv[1], "bitsets") == 0 ? AG_SUBGRAPH_BITSETS : 0;
+
+  nested();
+  strict();
+
+  // read and write a graph with clusters
+  Agraph_t *const g = agread_flags(stdin, NULL, flags);
+  assert(g != NULL);
+  walk(g);
+  agwrite(g, stdout);
+  agclose(g);
+
+  return 0;
+}
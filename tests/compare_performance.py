@@ -85,17 +85,16 @@ implicit `-o /dev/null` added to them when executed.
 """
 
 
-def run(args: list[Union[str, Path]], root: Union[str, Path]):
+def environment(root: Path) -> tuple[dict[str, str], str]:
     """
-    run a command, pre-echoing it like Bash’s `set -x`
+    construct an environment for running programs from a Graphviz installation
 
     Args:
-        args: Command line to run
-        root: Root directory of the Graphviz installation under test
-    """
-    assert len(args) > 0
+        root: Root directory of the Graphviz installation
 
-    exe = root / "bin"
+    Returns:
+        The environment and a shell prefix equivalent to it, for display
+    """
     lib = root / "lib"
 
     env = os.environ.copy()
@@ -114,6 +113,22 @@ def run(args: list[Union[str, Path]], root: Union[str, Path]):
             env["LD_LIBRARY_PATH"] = str(lib)
             prefix = f'LD_LIBRARY_PATH="{lib}"'
 
+    return env, prefix
+
+
+def run(args: list[Union[str, Path]], root: Union[str, Path]):
+    """
+    run a command, pre-echoing it like Bash’s `set -x`
+
+    Args:
+        args: Command line to run
+        root: Root directory of the Graphviz installation under test
+    """
+    assert len(args) > 0
+
+    exe = root / "bin"
+    env, prefix = environment(root)
+
     arg0 = shutil.which(args[0], path=exe)
     assert arg0 is not None, "{args[0]} not found in installation {root}"
     argv = [arg0] + args[1:] + ["-o", os.devnull]
@@ -0,0 +1,94 @@
+/// @file
+/// @brief Accompanying test code for test_gvc_chunks
+///
+/// Renders the graph named on the command line with `gvRenderChunks` and
+/// checks the chunks join up to what `gvRenderData` produces. SVG output
+/// should arrive in a few large chunks, and a callback refusing output should
+/// make rendering fail rather than exit.
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// output received by `collect`
+typedef struct {
+  char *data;
+  size_t length;
+  size_t chunks;
+  size_t refuse_after; ///< chunks to take before refusing more, or 0
+} output_t;
+
+static size_t collect(void *context, const char *data, size_t length) {
+  output_t *const out = context;
+  assert(length > 0 && "empty chunk");
+  ++out->chunks;
+  if (out->refuse_after != 0 && out->chunks > out->refuse_after) {
+    return 0;
+  }
+  out->data = realloc(out->data, out->length + length);
+  assert(out->data != NULL);
+  memcpy(out->data + out->length, data, length);
+  out->length += length;
+  return length;
+}
+
+int main(int argc, char **argv) {
+  assert(argc == 2 && "usage: gvc_chunks graph");
+
+  FILE *const f = fopen(argv[1], "r");
+  assert(f != NULL && "could not open input");
+  Agraph_t *const g = agread(f, NULL);
+  fclose(f);
+  assert(g != NULL);
+
+  GVC_t *const gvc = gvContext();
+  assert(gvc != NULL);
+  int rc = gvLayout(gvc, g, "dot");
+  assert(rc == 0 && "layout failed");
+
+  const char *const formats[] = {"svg", "svgz", "dot", "cmapx"};
+  for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+    char *expected = NULL;
+    size_t length = 0;
+    rc = gvRenderData(gvc, g, formats[i], &expected, &length);
+    assert(rc == 0 && "rendering to memory failed");
+
+    output_t out = {0};
+    rc = gvRenderChunks(gvc, g, formats[i], collect, &out);
+    assert(rc == 0 && "rendering in chunks failed");
+    if (out.length != length || memcmp(out.data, expected, length) != 0) {
+      fprintf(stderr, "%s output in chunks differs\n", formats[i]);
+      return EXIT_FAILURE;
+    }
+    // SVG gathers its output, in chunks of 64KiB
+    if (strcmp(formats[i], "svg") == 0 &&
+        out.chunks > length / (64 * 1024) + 1) {
+      fprintf(stderr, "%zu bytes of SVG came in %zu chunks\n", length,
+              out.chunks);
+      return EXIT_FAILURE;
+    }
+    printf("%s: %zu bytes in %zu chunks\n", formats[i], length, out.chunks);
+
+    // a callback refusing output should fail the rendering
+    if (out.chunks > 1) {
+      output_t refuse = {.refuse_after = 1};
+      rc = gvRenderChunks(gvc, g, formats[i], collect, &refuse);
+      assert(rc != 0 && "refused output went unreported");
+      free(refuse.data);
+    }
+
+    free(out.data);
+    gvFreeRenderData(expected);
+  }
+
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  return gvFreeContext(gvc);
+}
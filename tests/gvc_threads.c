@@ -0,0 +1,227 @@
+/// @file
+/// @brief Accompanying test code for test_gvc_threads
+///
+/// Lays out and renders the graphs named on the command line with several
+/// engines and formats, first serially and then from several threads at once,
+/// each thread using its own context. The threads also render all formats in
+/// one call to `gvRenderDataFormats`, letting it emit some of them at once.
+/// Every concurrent result must match the serial one. Built with
+/// `-fsanitize=thread`, this also checks for data races.
+
+#ifdef NDEBUG
+#error "this program is not intended to be compiled with assertions disabled"
+#endif
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <graphviz/gvc.h>
+#include <graphviz/gvcext.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern gvplugin_library_t gvplugin_core_LTX_library;
+extern gvplugin_library_t gvplugin_dot_layout_LTX_library;
+extern gvplugin_library_t gvplugin_neato_layout_LTX_library;
+
+static lt_symlist_t builtins[4];
+
+enum { THREADS = 4, ROUNDS = 2 };
+
+static const char *const engines[] = {"dot", "neato", "fdp", "circo", "twopi"};
+static const char *const formats[] = {"svg", "xdot", "ps", "svgz", "cmapx"};
+/// `formats` in the order to render them all at once, putting those that can
+/// be emitted concurrently next to each other
+static const size_t batch[] = {0, 3, 4, 2, 1};
+enum {
+  N_ENGINES = sizeof(engines) / sizeof(engines[0]),
+  N_FORMATS = sizeof(formats) / sizeof(formats[0]),
+};
+
+/// a graph to process
+typedef struct {
+  const char *filename;
+  char *source;
+  /// serial output for each engine and format, `NULL` if unsupported
+  char *expected[N_ENGINES][N_FORMATS];
+  size_t lengths[N_ENGINES][N_FORMATS];
+} input_t;
+
+static input_t *inputs;
+static size_t n_inputs;
+
+/// read a whole file into memory
+static char *slurp(const char *filename) {
+  FILE *const f = fopen(filename, "rb");
+  assert(f != NULL && "could not open input");
+  char *buf = NULL;
+  size_t size = 0;
+  for (;;) {
+    buf = realloc(buf, size + 4097);
+    assert(buf != NULL);
+    const size_t got = fread(buf + size, 1, 4096, f);
+    size += got;
+    if (got < 4096) {
+      break;
+    }
+  }
+  buf[size] = '\0';
+  fclose(f);
+  return buf;
+}
+
+/// render a laid out graph in every format at once
+///
+/// @return Number of results differing from the saved ones
+static size_t run_batch(const input_t *in, size_t e, Agraph_t *g,
+                        GVC_t *gvc) {
+  const char *names[N_FORMATS];
+  size_t indices[N_FORMATS];
+  size_t n = 0;
+  for (size_t i = 0; i < N_FORMATS; ++i) {
+    if (in->expected[e][batch[i]] != NULL) {
+      indices[n] = batch[i];
+      names[n++] = formats[batch[i]];
+    }
+  }
+
+  // ask for concurrent emission, which only applies once a layout exists
+  agattr_text(g, AGRAPH, "threads", "2");
+  char *results[N_FORMATS];
+  size_t lengths[N_FORMATS];
+  const int rc = gvRenderDataFormats(gvc, g, names, n, results, lengths);
+  assert(rc == 0 && "rendering several formats failed");
+
+  size_t failures = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const size_t f = indices[i];
+    // xdot also writes the attribute set above
+    if (strcmp(formats[f], "xdot") != 0 &&
+        (lengths[i] != in->lengths[e][f] ||
+         memcmp(results[i], in->expected[e][f], lengths[i]) != 0)) {
+      fprintf(stderr, "%s with %s as %s among other formats differs\n",
+              in->filename, engines[e], formats[f]);
+      ++failures;
+    }
+    gvFreeRenderData(results[i]);
+  }
+  return failures;
+}
+
+/// lay out and render every graph with every engine and format
+///
+/// @param gvc Context to use
+/// @param record Save the results, rather than compare against them?
+/// @return Number of results differing from the saved ones
+static size_t run(GVC_t *gvc, bool record) {
+  size_t failures = 0;
+  for (size_t i = 0; i < n_inputs; ++i) {
+    input_t *const in = &inputs[i];
+    for (size_t e = 0; e < N_ENGINES; ++e) {
+      Agraph_t *const g = agmemread(in->source);
+      assert(g != NULL);
+      const int rc = gvLayout(gvc, g, engines[e]);
+      assert(rc == 0 && "layout failed");
+
+      for (size_t f = 0; f < N_FORMATS; ++f) {
+        if (!record && in->expected[e][f] == NULL) {
+          continue;
+        }
+        char *result = NULL;
+        size_t length = 0;
+        if (gvRenderData(gvc, g, formats[f], &result, &length) != 0) {
+          gvFreeRenderData(result);
+          assert(record && "format went missing");
+          continue;
+        }
+        if (record) {
+          in->expected[e][f] = result;
+          in->lengths[e][f] = length;
+          continue;
+        }
+        if (length != in->lengths[e][f] ||
+            memcmp(result, in->expected[e][f], length) != 0) {
+          fprintf(stderr, "%s with %s as %s differs from serial output\n",
+                  in->filename, engines[e], formats[f]);
+          ++failures;
+        }
+        gvFreeRenderData(result);
+      }
+
+      if (!record) {
+        failures += run_batch(in, e, g, gvc);
+      }
+
+      gvFreeLayout(gvc, g);
+      agclose(g);
+    }
+  }
+  return failures;
+}
+
+/// a thread doing every job in its own context
+static void *worker(void *arg) {
+  size_t *const failures = arg;
+  GVC_t *const gvc = gvContextPlugins(builtins, 0);
+  assert(gvc != NULL);
+  for (int round = 0; round < ROUNDS; ++round) {
+    *failures += run(gvc, false);
+  }
+  gvFreeContext(gvc);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+
+  // link the plugins in, rather than loading them
+  builtins[0] = (lt_symlist_t){.name = "gvplugin_core_LTX_library",
+                               .address = &gvplugin_core_LTX_library};
+  builtins[1] = (lt_symlist_t){.name = "gvplugin_dot_layout_LTX_library",
+                               .address = &gvplugin_dot_layout_LTX_library};
+  builtins[2] = (lt_symlist_t){.name = "gvplugin_neato_layout_LTX_library",
+                               .address = &gvplugin_neato_layout_LTX_library};
+
+  assert(argc > 1 && "usage: gvc_threads graph...");
+  n_inputs = (size_t)argc - 1;
+  inputs = calloc(n_inputs, sizeof(inputs[0]));
+  assert(inputs != NULL);
+  for (size_t i = 0; i < n_inputs; ++i) {
+    inputs[i].filename = argv[i + 1];
+    inputs[i].source = slurp(argv[i + 1]);
+  }
+
+  // the expected results, produced serially
+  GVC_t *const gvc = gvContextPlugins(builtins, 0);
+  assert(gvc != NULL);
+  (void)run(gvc, true);
+  gvFreeContext(gvc);
+
+  pthread_t threads[THREADS];
+  size_t failures[THREADS] = {0};
+  for (size_t i = 0; i < THREADS; ++i) {
+    const int rc = pthread_create(&threads[i], NULL, worker, &failures[i]);
+    assert(rc == 0);
+  }
+  size_t total = 0;
+  for (size_t i = 0; i < THREADS; ++i) {
+    const int rc = pthread_join(threads[i], NULL);
+    assert(rc == 0);
+    total += failures[i];
+  }
+
+  for (size_t i = 0; i < n_inputs; ++i) {
+    for (size_t e = 0; e < N_ENGINES; ++e) {
+      for (size_t f = 0; f < N_FORMATS; ++f) {
+        gvFreeRenderData(inputs[i].expected[e][f]);
+      }
+    }
+    free(inputs[i].source);
+  }
+  free(inputs);
+
+  printf("%zu differing results\n", total);
+  return total == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+
+"""
+compare the crossing minimization performance of different versions of Graphviz
+
+This is a narrower companion to compare_performance.py that times only dot’s
+crossing minimization phase, as reported by `dot -v`, on inputs where that phase
+dominates:
+
+  python3 mincross_performance.py \
+    /path/to/install/before/bin/dot /path/to/install/after/bin/dot
+
+Layout stops after crossing minimization, so each run takes minutes rather than
+hours. The number of crossings found is reported alongside the time, so a change
+that was meant to only speed things up can be checked to not alter the result.
+"""
+
+import argparse
+import os
+import re
+import statistics
+import subprocess
+import sys
+from pathlib import Path
+
+import tabulate
+from compare_performance import MY_DIR, environment
+
+TESTS: dict[str, list[str]] = {
+    "#2095": ["2095_1.dot"],
+    "#2108": ["2108.dot"],
+    "#2222": ["2222.dot"],
+}
+"""
+relevant workloads to evaluate
+
+Entries are a test name mapped to input files in this directory.
+"""
+
+
+def mincross(dot: Path, inputs: list[str]) -> tuple[int, float]:
+    """
+    run dot up to and including crossing minimization
+
+    Args:
+        dot: dot binary to run
+        inputs: Graphs to lay out, relative to this directory
+
+    Returns:
+        The number of crossings and seconds spent minimizing them, summed over
+        all graphs laid out
+    """
+    env, _ = environment(dot.parents[1])
+    argv = [dot, "-v", "-Gphase=2", "-Tcanon", "-o", os.devnull]
+    argv += [MY_DIR / i for i in inputs]
+    p = subprocess.run(argv, stderr=subprocess.PIPE, check=True, env=env, text=True)
+
+    crossings = 0
+    seconds = 0.0
+    for m in re.finditer(
+        r"^mincross .*: (\d+) crossings, ([\d.]+) secs\.$", p.stderr, flags=re.M
+    ):
+        crossings += int(m.group(1))
+        seconds += float(m.group(2))
+    return crossings, seconds
+
+
+def main(args: list[str]) -> int:
+    """entry point"""
+
+    # parse command line options
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument(
+        "--repeat",
+        type=int,
+        default=3,
+        help="how many times to run each test case, reporting the median",
+    )
+    parser.add_argument(
+        "candidate",
+        type=argparse.FileType("rb"),
+        nargs="+",
+        help="dot binaries to compare",
+    )
+    options = parser.parse_args(args[1:])
+
+    dots = [Path(d.name).resolve() for d in options.candidate]
+    headers = ["test case"] + [str(d) for d in dots]
+
+    rows: list[list[str]] = []
+    ret = 0
+    for name, cmd in TESTS.items():
+        row = [name]
+        baseline = None
+        for dot in dots:
+            runs = [mincross(dot, cmd) for _ in range(options.repeat)]
+            crossings = runs[0][0]
+            seconds = statistics.median(s for _, s in runs)
+            cell = f"{seconds:.2f}s, {crossings} crossings"
+            if baseline is None:
+                baseline = (crossings, seconds)
+            else:
+                if baseline[1] > 0:
+                    cell += f" ({int((seconds - baseline[1]) / baseline[1] * 100)}%)"
+                if crossings != baseline[0]:
+                    cell += " DIFFERS"
+                    ret = 1
+            row += [cell]
+            print(f"{name}: {dot}: {cell}", flush=True)
+        rows += [row]
+
+    print(tabulate.tabulate(rows, headers=headers, tablefmt="simple_outline"))
+    return ret
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -57,6 +57,39 @@ def test_overflow_h(builtins: bool):
     run_c(src, cflags=cflags)
 
 
+@pytest.mark.parametrize(
+    "threads",
+    (
+        False,
+        pytest.param(
+            True,
+            marks=pytest.mark.skipif(
+                platform.system() == "Windows" and not is_mingw(),
+                reason="POSIX threads are not available with MSVC",
+            ),
+        ),
+    ),
+)
+def test_parallel(threads: bool):
+    """test ../lib/util/parallel.c"""
+
+    # locate the unit test
+    src = Path(__file__).parent.resolve() / "../lib/util/test_parallel.c"
+    assert src.exists()
+
+    # locate lib directory that needs to be in the include path
+    lib = Path(__file__).parent.resolve() / "../lib"
+
+    # extra C flags this compilation needs
+    cflags = ["-I", lib]
+    if threads:
+        cflags += ["-DHAVE_PTHREAD", "-pthread"]
+    if platform.system() != "Windows":
+        cflags += ["-std=gnu17"]
+
+    run_c(src, cflags=cflags)
+
+
 @pytest.mark.parametrize(
     "bad_test",
     (
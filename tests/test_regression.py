@@ -6,6 +6,7 @@ of these indicates that a past bug has been reintroduced.
 """
 
 import dataclasses
+import gzip
 import hashlib
 import io
 import json
@@ -18,6 +19,7 @@ import shutil
 import signal
 import stat
 import statistics
+import struct
 import subprocess
 import sys
 import tempfile
@@ -6104,7 +6106,7 @@ def test_2722():
 
     # The SHA1 digest of ../lib/cdt/cdt.h. This should be updated whenever you update
     # ../lib/cdt/cdt.h.
-    reference = "43c41531381ed1cec4259a08a80dd69b53189100"
+    reference = "2f470c3ccfda433eac89862d5809d1c9a89b099c"
 
     # read in the current cdt.h, accounting for Windows vs Unix line ending differences
     cdt_h = Path(__file__).absolute().parents[1] / "lib/cdt/cdt.h"
@@ -7381,3 +7383,910 @@ def test_negative_dpi():
     assert src.exists(), "unexpectedly missing test case"
 
     run(["dot", "-Tpng", "-o", os.devnull, src], timeout=10)
+
+
+@pytest.mark.parametrize("quadtree", ("normal", "fast"))
+@pytest.mark.skipif(which("sfdp") is None, reason="sfdp not available")
+def test_sfdp_threads(quadtree: str):
+    """
+    multithreaded sfdp layout should not depend on the number of threads used
+    """
+
+    # locate an input large enough to use the quadtree
+    input = Path(__file__).parent / "graphs/b100.gv"
+    assert input.exists(), "unexpectedly missing test case"
+
+    # lay it out with a range of thread counts, comparing only positions because
+    # `-Tdot` output would echo the differing `threads` attribute
+    sfdp = which("sfdp")
+    layouts = []
+    for threads in (2, 3, 8):
+        p = subprocess.run(
+            [sfdp, f"-Gquadtree={quadtree}", f"-Gthreads={threads}", "-Tplain", input],
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=False,
+            text=True,
+        )
+
+        # if sfdp was built without libgts, it will not handle anything non-trivial
+        no_gts_error = "remove_overlap: Graphviz not built with triangulation library"
+        if no_gts_error in p.stderr:
+            assert p.returncode != 0, "sfdp returned success after an error message"
+            return
+        p.check_returncode()
+        layouts.append(p.stdout)
+
+    assert all(
+        l == layouts[0] for l in layouts
+    ), "sfdp layout varied with the number of threads"
+
+
+@pytest.mark.parametrize("model", ("shortpath", "subset", "mds"))
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_neato_threads(model: str):
+    """
+    multithreaded neato layout should be identical to single threaded layout
+    """
+
+    input = Path(__file__).parent / "graphs/b100.gv"
+    assert input.exists(), "unexpectedly missing test case"
+
+    # compare only positions, as `-Tdot` output would echo the differing
+    # `threads` attribute
+    neato = which("neato")
+    layouts = []
+    for threads in (1, 2, 3, 8):
+        layouts.append(
+            run([neato, f"-Gmodel={model}", f"-Gthreads={threads}", "-Tplain", input])
+        )
+
+    assert all(
+        l == layouts[0] for l in layouts
+    ), "neato layout varied with the number of threads"
+
+
+@pytest.mark.parametrize("pivots", (0, 20))
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_neato_sgd_threads(pivots: int):
+    """
+    multithreaded SGD layout should not depend on the number of threads
+    """
+
+    input = Path(__file__).parent / "graphs/b100.gv"
+    assert input.exists(), "unexpectedly missing test case"
+
+    # compare only positions, as `-Tdot` output would echo the differing
+    # `threads` attribute
+    neato = which("neato")
+    layouts = []
+    for threads in (2, 3, 8):
+        layouts.append(
+            run(
+                [
+                    neato,
+                    "-Gmode=sgd",
+                    f"-Gpivots={pivots}",
+                    f"-Gthreads={threads}",
+                    "-Tplain",
+                    input,
+                ]
+            )
+        )
+
+    assert all(
+        l == layouts[0] for l in layouts
+    ), "neato layout varied with the number of threads"
+
+
+@pytest.mark.parametrize("model", ("shortpath", "subset"))
+@pytest.mark.skipif(which("neato") is None, reason="neato not available")
+def test_neato_sparse(model: str):
+    """
+    neato’s sparse stress mode should lay out a graph independently of the
+    number of threads
+    """
+
+    input = Path(__file__).parent / "graphs/b100.gv"
+    assert input.exists(), "unexpectedly missing test case"
+
+    # compare only positions, as `-Tdot` output would echo the differing
+    # `threads` attribute
+    neato = which("neato")
+    layouts = []
+    for threads in (1, 2, 3, 8):
+        layouts.append(
+            run(
+                [
+                    neato,
+                    "-Gmode=sparse",
+                    f"-Gmodel={model}",
+                    f"-Gthreads={threads}",
+                    "-Tplain",
+                    input,
+                ]
+            )
+        )
+
+    assert all(
+        l == layouts[0] for l in layouts
+    ), "neato layout varied with the number of threads"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_dot_threads():
+    """
+    multithreaded dot crossing minimization should give the same layout as
+    single threaded
+    """
+
+    # many small components, each with crossings for mincross to remove
+    edges = []
+    for c in range(50):
+        for i in range(4):
+            for j in range(4):
+                if (i * 7 + j * 3 + c) % 3 != 0:
+                    edges.append(f"a{c}_{i} -> b{c}_{(i + j + c) % 4}")
+                    edges.append(f"b{c}_{j} -> c{c}_{(i * j + c) % 4}")
+    input = "digraph { " + "; ".join(edges) + " }"
+
+    dot = which("dot")
+    layouts = []
+    for threads in (1, 2, 3, 8):
+        layouts.append(run([dot, f"-Gthreads={threads}", "-Tplain"], input=input))
+
+    assert all(
+        l == layouts[0] for l in layouts
+    ), "dot layout varied with the number of threads"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_render_threads(tmp_path: Path):
+    """
+    emitting several formats at once should write the same files as emitting
+    them one after another
+    """
+
+    input = Path(__file__).parent / "graphs/clust4.gv"
+    formats = ("svg", "cmapx", "ps", "imap", "svg_inline", "pov")
+
+    dot = which("dot")
+    outputs = []
+    for threads in (1, 2, 0):
+        shutil.copy(input, tmp_path / "input.gv")
+        args = [dot, f"-Gthreads={threads}", "-O"] + [f"-T{f}" for f in formats]
+        subprocess.run(args + ["input.gv"], cwd=tmp_path, check=True)
+        outputs.append(
+            {f: (tmp_path / f"input.gv.{f}").read_bytes() for f in formats}
+        )
+
+    for f in formats:
+        assert all(
+            o[f] == outputs[0][f] for o in outputs
+        ), f"{f} output varied with the number of threads"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_render_threads_clusters(tmp_path: Path):
+    """
+    emitting many nested clusters in several formats at once should write the
+    same files as emitting them one after another
+    """
+
+    # nested clusters whose attribute values are first parsed or quoted while
+    # emitting, when the graph is frozen and read from several threads
+    lines = ["digraph G {", 'node [shape=box, penwidth="1.5"];']
+    for i in range(20):
+        lines += [
+            f"subgraph cluster_{i} {{",
+            f'label="outer {i}"; penwidth="{i % 3 + 1}.5"; fontsize="{8 + i % 5}";',
+            f'style=filled; fillcolor="#{i * 12:02x}e0e0";',
+        ]
+        for j in range(3):
+            lines += [
+                f"subgraph cluster_{i}_{j} {{",
+                f'label="inner {i}.{j}"; peripheries="{j % 2 + 1}";',
+                f'n{i}_{j}_a [label="a {i}.{j}", fontsize="{10 + j}"];',
+                f'n{i}_{j}_b [label="b-{i}-{j}"];',
+                f'n{i}_{j}_a -> n{i}_{j}_b [penwidth="{j + 1}.25"];',
+                "}",
+            ]
+        lines += ["}"]
+        if i > 0:
+            lines += [f'n{i - 1}_0_b -> n{i}_2_a [arrowsize="0.{i % 9 + 1}"];']
+    lines += ["}"]
+
+    formats = ("svg", "cmapx", "imap", "svg_inline", "pov", "dot", "xdot")
+
+    dot = which("dot")
+    outputs = []
+    for threads in (1, 2, 4):
+        (tmp_path / "input.gv").write_text("\n".join(lines), encoding="utf-8")
+        args = [dot, f"-Gthreads={threads}", "-O"] + [f"-T{f}" for f in formats]
+        subprocess.run(args + ["input.gv"], cwd=tmp_path, check=True)
+        # the DOT writers echo the differing `threads` attribute
+        outputs.append(
+            {
+                f: re.sub(
+                    rb"\bthreads=\d+,?\s*", b"", (tmp_path / f"input.gv.{f}").read_bytes()
+                )
+                for f in formats
+            }
+        )
+
+    for f in formats:
+        assert all(
+            o[f] == outputs[0][f] for o in outputs
+        ), f"{f} output varied with the number of threads"
+
+
+def test_svgz_threads():
+    """
+    compressed output written on several threads or at another compression
+    level should be a valid gzip stream of the same SVG
+    """
+
+    # a laid out graph whose SVG spans several compressed blocks
+    source = io.StringIO()
+    source.write("graph {\n")
+    for i in range(4000):
+        source.write(f'n{i} [pos="{i % 64 * 72},{i // 64 * 72}" label="{i}"];\n')
+    source.write("}\n")
+    source = source.getvalue()
+
+    def render(fmt: str, *args: str) -> bytes:
+        return subprocess.check_output(
+            [which("dot"), "-Knop2", f"-T{fmt}", *args], input=source.encode("utf-8")
+        )
+
+    svg = render("svg")
+    assert len(svg) > 1024 * 1024, "graph is too small to exercise blocks"
+
+    parallel = {}
+    for threads in (1, 2, 3, 0):
+        for level in (None, 0, 1, 9):
+            args = [f"-Gthreads={threads}"]
+            if level is not None:
+                args += [f"-Gcompresslevel={level}"]
+            svgz = render("svgz", *args)
+            assert (
+                gzip.decompress(svgz) == svg
+            ), f"threads={threads} compresslevel={level} output differs"
+            if threads in (2, 3):
+                parallel.setdefault(level, set()).add(svgz)
+
+    # blocks are cut at the same places whatever the number of threads
+    assert all(
+        len(p) == 1 for p in parallel.values()
+    ), "parallel output varied with the number of threads"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_gvc_chunks():
+    """
+    rendering in chunks should give the same output as rendering to memory
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvc_chunks.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a graph whose SVG spans several chunks
+    input = Path(__file__).parent / "graphs/root.gv"
+
+    run_c(c_src, [str(input)], link=["cgraph", "gvc"])
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_arena():
+    """
+    a graph allocated from a region should behave the same as one allocated from
+    the heap
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_arena.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find a graph with clusters and attributes
+    input = (Path(__file__).parent / "graphs/clust4.gv").read_text(encoding="utf-8")
+
+    heap, _ = run_c(c_src, input=input, link=["cgraph"])
+    arena, _ = run_c(c_src, ["arena"], input=input, link=["cgraph"])
+
+    assert heap == arena, "region allocated graph differed from heap allocated"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_columnar():
+    """
+    a graph storing attribute values by column should behave the same as one
+    storing them by object
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_columnar.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find a graph with clusters and attributes
+    input = (Path(__file__).parent / "graphs/clust4.gv").read_text(encoding="utf-8")
+
+    by_object, _ = run_c(c_src, input=input, link=["cgraph"])
+    by_column, _ = run_c(c_src, ["columnar"], input=input, link=["cgraph"])
+
+    assert by_object == by_column, "columnar attributes differed from per-object"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_edge_index():
+    """
+    a graph indexing its edges by endpoints should behave the same as one that
+    does not
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_edge_index.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find a graph with clusters and attributes
+    input = (Path(__file__).parent / "graphs/clust4.gv").read_text(encoding="utf-8")
+
+    unindexed, _ = run_c(c_src, input=input, link=["cgraph"])
+    indexed, _ = run_c(c_src, ["index"], input=input, link=["cgraph"])
+
+    assert unindexed == indexed, "edge index changed graph behavior"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_subgraph_bitsets():
+    """
+    a graph keeping subgraph members in bitsets should behave the same as one
+    that does not
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_subgraph_bitsets.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find a graph with clusters and attributes
+    input = (Path(__file__).parent / "graphs/clust4.gv").read_text(encoding="utf-8")
+
+    by_dict, _ = run_c(c_src, input=input, link=["cgraph"])
+    by_bits, _ = run_c(c_src, ["bitsets"], input=input, link=["cgraph"])
+
+    assert by_dict == by_bits, "subgraph bitsets changed graph behavior"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_csr():
+    """
+    an adjacency snapshot of a graph should list its nodes and edges in the
+    same order as cgraph’s iterators
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_csr.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find a graph with clusters
+    input = (Path(__file__).parent / "graphs/clust4.gv").read_text(encoding="utf-8")
+
+    stdout, _ = run_c(c_src, input=input, link=["cgraph"])
+
+    assert stdout.startswith("G: "), "unexpected output"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+def test_cgraph_agstrtod():
+    """
+    `agstrtod` and `agstrtol` should give the same results as `strtod` and
+    `strtol` when asked repeatedly
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_agstrtod.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # run it
+    run_c(c_src, link=["cgraph"])
+
+
+def _input_file_cases() -> dict[str, tuple[str, int]]:
+    """inputs for testing the reading of files of DOT graphs, with the number of
+    graphs in each"""
+    return {
+        "several": (
+            "\n".join(
+                [
+                    'digraph { a -> b; "c d" [label=<<b>c</b>>] }',
+                    (Path(__file__).parent / "graphs/clust4.gv").read_text(
+                        encoding="utf-8"
+                    ),
+                    "graph { x -- y }",
+                ]
+            )
+            + "\n",
+            3,
+        ),
+        "empty": ("", 0),
+        "no_trailing_newline": ("digraph { a -> b }\ngraph { x -- y }", 2),
+        # graphs of growing length, so that the scanner's blocks of input end
+        # inside each kind of token, and a string spanning several blocks
+        "block_boundaries": (
+            "".join(
+                f'digraph g{i} {{ n{i} -> "{"q" * i}" '
+                f'[label=<<i>{"h" * i}</i>>, len={i}.5]; /* {"c" * i} */ }}\n'
+                for i in range(1, 200)
+            )
+            + f'graph long {{ a [label="{"x" * 40000}"] }}\n',
+            200,
+        ),
+    }
+
+
+@pytest.mark.parametrize("case", _input_file_cases().keys())
+@pytest.mark.skipif(which("nop") is None, reason="nop not available")
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+@pytest.mark.skipif(platform.system() == "Windows", reason="no mmap on Windows")
+def test_cgraph_agmapread(tmp_path: Path, case: str):
+    """
+    graphs read from a file mapped into memory should be the same as those read
+    through stdio
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_agmapread.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    source = tmp_path / "input.gv"
+    source.write_text(_input_file_cases()[case][0], encoding="utf-8")
+
+    mapped, _ = run_c(c_src, [source], link=["cgraph"])
+    nopped = run([which("nop"), source])
+
+    assert mapped == nopped, "mapped graphs differed from those read through stdio"
+
+
+def _parallel_read_cases() -> dict[str, str]:
+    """inputs for testing `AG_PARALLEL_READ`, in addition to those of
+    `_input_file_cases`"""
+
+    # a flat graph of more than a megabyte, using each kind of statement and
+    # token the parallel reader replays itself, with tokens long enough to
+    # straddle the boundaries of the chunks its input is cut into
+    lines = [
+        "/* a flat graph */",
+        "DiGraph flat {",
+        '  graph [rankdir=LR, label="flat"]; fontsize=9',
+        '  node [shape=box, style="filled,rounded"]',
+        "  EDGE [color=blue]",
+    ]
+    for i in range(12000):
+        lines.append(
+            f"  n{i} -> n{i + 1} -> m{i % 97} [key=k{i % 3}, weight={i % 7}]"
+            f" // chain {i}"
+        )
+        if i % 10 == 0:
+            lines.append(f'  n{i}, "quoted \\"{i}\\"" [width=.{i % 9}]')
+            lines.append(f"# {i}")
+            lines.append(f"  h{i} [label=<<b>{i}</b> &amp; <i>x</i>>]")
+            lines.append(f'  "esc\\\\{i}" -> "split\\\n{i}"; -{i}.5')
+        if i == 3000:
+            lines.append("/* " + "comment\n" * 40000 + " */")
+        if i == 6000:
+            lines.append(f'  long [label="{"label " * 50000}"]')
+        if i == 9000:
+            lines.append(f"  html [label=<{'<br/>' * 60000}>]")
+    lines.append("}")
+    flat = "\n".join(lines) + "\n"
+
+    return {
+        "flat": flat,
+        "strict": "strict graph { a -- b; b -- a; a -- b [color=red] }\n",
+        "late_subgraph": flat[:-2] + "  subgraph cluster_x { late }\n}\n",
+        "late_port": flat[:-2] + "  n1:e -> n2:w\n}\n",
+        "concatenated": 'digraph { a [label="x" + "y"] }\n',
+        "flat_then_nested": flat + "graph { a -- { b c } }\n" + flat,
+        "syntax_error": flat[:-2] + "  a -> -> b\n}\n",
+    }
+
+
+@pytest.mark.parametrize(
+    "case", list(_input_file_cases().keys()) + list(_parallel_read_cases().keys())
+)
+@pytest.mark.skipif(which("nop") is None, reason="nop not available")
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+@pytest.mark.skipif(platform.system() == "Windows", reason="no mmap on Windows")
+def test_cgraph_parallel_read(tmp_path: Path, case: str):
+    """
+    graphs read with `AG_PARALLEL_READ` should be the same as those read by the
+    serial parser
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "cgraph_agmapread.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    cases = _parallel_read_cases()
+    contents = cases[case] if case in cases else _input_file_cases()[case][0]
+    source = tmp_path / "input.gv"
+    source.write_text(contents, encoding="utf-8")
+
+    serial, serial_errors = run_c(c_src, [source], link=["cgraph"])
+    parallel, parallel_errors = run_c(c_src, ["-p", source], link=["cgraph"])
+
+    assert parallel == serial, "graphs read in parallel differed from serial ones"
+    assert parallel_errors == serial_errors, "parallel read reported other errors"
+
+    if case != "syntax_error":
+        nopped = run([which("nop"), source])
+        assert parallel == nopped, "graphs read in parallel differed from nop"
+
+
+@pytest.mark.parametrize("case", _input_file_cases().keys())
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_input_file(tmp_path: Path, case: str):
+    """
+    a file named on the command line should give the same graphs as the same
+    input on stdin
+    """
+
+    contents, count = _input_file_cases()[case]
+    source = tmp_path / "input.gv"
+    source.write_text(contents, encoding="utf-8")
+
+    dot = which("dot")
+    named = run([dot, "-Tcanon", source])
+    piped = run([dot, "-Tcanon"], input=contents)
+
+    assert named == piped, "graphs read from a file differed from those on stdin"
+    assert (
+        len(re.findall(r"^(di)?graph\b", named, flags=re.MULTILINE)) == count
+    ), "graphs were lost"
+
+
+@pytest.mark.skipif(which("gvbin") is None, reason="gvbin not available")
+@pytest.mark.skipif(which("nop") is None, reason="nop not available")
+@pytest.mark.parametrize(
+    "testcase", ("clust4.gv", "html2.gv", "b100.gv", "multi.gv", "ports.gv")
+)
+def test_gvbin_roundtrip(testcase: str):
+    """
+    a graph converted to the binary format and back should be the same as one
+    that was never converted
+    """
+
+    source = Path(__file__).parent / "graphs" / testcase
+    assert source.exists(), "missing test case"
+
+    binary = run_raw([which("gvbin"), "-b", source])
+    assert binary.startswith(b"\x89GVB\r\n\x1a\n"), "binary format not written"
+    assert run_raw([which("gvbin"), "-b"], input=binary) == binary
+
+    converted = run_raw([which("gvbin")], input=binary)
+    nopped = run_raw([which("nop"), source])
+    assert converted == nopped, "graph changed by conversion to binary and back"
+
+
+@pytest.mark.parametrize("malformation", ("huge_count", "deep_nesting"))
+@pytest.mark.skipif(which("gvbin") is None, reason="gvbin not available")
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+@pytest.mark.skipif(platform.system() == "Windows", reason="no mmap on Windows")
+def test_gvbin_malformed(tmp_path: Path, malformation: str):
+    """
+    a binary graph claiming too many nodes or nesting subgraphs too deeply
+    should be rejected, rather than exhausting memory or the stack
+    """
+
+    # a directed graph without a name or attribute declarations
+    header = b"\x89GVB\r\n\x1a\n" + b"\x01" + b"\x01" + b"\x00" + b"\x00\x00\x00"
+
+    if malformation == "huge_count":
+        # 2³¹ - 2 nodes, and then nothing
+        binary = header + b"\xfe\xff\xff\xff\x07"
+    else:
+        # no nodes or edges and a chain of anonymous subgraphs, each with no
+        # declarations, nodes or edges
+        depth = 100000
+        binary = header + b"\x00\x00" + b"\x01\x00\x00\x00\x00\x00\x00" * depth
+        binary += b"\x00"
+
+    # through a stream
+    p = subprocess.run(
+        [which("gvbin")], input=binary, stdout=subprocess.PIPE, check=False
+    )
+    assert p.returncode == 1, "malformed binary graph was not rejected"
+    assert p.stdout == b"", "malformed binary graph was partly read"
+
+    # from memory
+    c_src = (Path(__file__).parent / "cgraph_agmapread.c").resolve()
+    assert c_src.exists(), "missing test case"
+    source = tmp_path / "input.gvb"
+    source.write_bytes(binary)
+    mapped, _ = run_c(c_src, [source], link=["cgraph"])
+    assert mapped == "", "malformed binary graph was partly read"
+
+
+def test_gvb_format(tmp_path: Path):
+    """
+    `-Tgvb` output should carry the same layout as `-Tdot` and be readable as
+    input, from stdin and from files, including several graphs in one file
+    """
+
+    source = Path(__file__).parent / "graphs/clust4.gv"
+    assert source.exists(), "missing test case"
+
+    binary = run_raw(["dot", "-Tgvb", source])
+    laid_out = tmp_path / "clust4.gvb"
+    laid_out.write_bytes(binary)
+
+    if which("gvbin") is not None:
+        assert run([which("gvbin"), "-d", laid_out]) == dot("dot", source)
+
+    # files and stdin should be read to the same effect
+    assert run_raw(["dot", "-Tcanon", laid_out]) == run_raw(
+        ["dot", "-Tcanon"], input=binary
+    )
+
+    twice = tmp_path / "twice.gvb"
+    twice.write_bytes(binary + b"\n" + binary)
+    canon = run(["dot", "-Tcanon", twice])
+    assert canon.count("digraph G {") == 2, "both graphs should be read"
+
+
+@pytest.mark.skipif(which("nop") is None, reason="nop not available")
+@pytest.mark.parametrize("linelength", (None, 0, 60))
+def test_write_repeated_strings(linelength: Optional[int]):
+    """
+    strings written more than once should be quoted the same way each time
+    """
+
+    long = "x," * 100
+    setting = "" if linelength is None else f"linelength={linelength};"
+    source = (
+        f"digraph {{ {setting} "
+        'a [label="a b"]; b [label="a b"]; "node"; "graph"; '
+        "c [label=plain]; d [label=plain]; e [label=<<b>x</b>>]; "
+        f'f [label=<<b>x</b>>]; g [label="{long}"]; h [label="{long}"]; '
+        'a -> b [key="k 1"]; b -> a [key="k 1" color=red]; }'
+    )
+    output = run(["nop"], input=source)
+
+    assert output.count('[label="a b"]') == 2, "quoted value written differently"
+    assert '\t"node";' in output, "keyword not quoted"
+    assert '\t"graph";' in output, "keyword not quoted"
+    assert output.count("[label=plain]") == 2, "plain value written differently"
+    assert output.count("[label=<<b>x</b>>]") == 2, "HTML-like value mangled"
+    assert output.count('key="k 1"') == 2, "edge key written differently"
+
+    g = re.search(r"\tg\t\[label=(.*?)\];\n", output, flags=re.DOTALL)
+    h = re.search(r"\th\t\[label=(.*?)\];\n", output, flags=re.DOTALL)
+    assert g is not None and h is not None, "long labels missing"
+    assert g.group(1) == h.group(1), "long value written differently"
+    if linelength == 0:
+        assert g.group(1) == f'"{long}"', "long value split despite linelength=0"
+    else:
+        assert "\\\n" in g.group(1), "long value not split"
+
+
+@pytest.mark.skipif(which("dot") is None, reason="dot not available")
+def test_text_measurement_cache(tmp_path: Path):
+    """
+    text measurements remembered in `$GV_TEXT_CACHE` should be reused by later
+    runs without changing their output
+    """
+
+    labels = ("true", "false", "int")
+    source = "digraph { node [shape=box]; " + " ".join(
+        f'n{i} [label="{labels[i % 3]}"]; n{i} -> n{(i * 7) % 30} [label="x{i % 5}"];'
+        for i in range(30)
+    )
+    source += ' h [label=<<b>bold</b> and <i>true</i>>]; label="the end"; }'
+
+    # repeated labels are measured once
+    proc = subprocess.run(
+        ["dot", "-v", "-Tsvg"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    reference = proc.stdout
+    m = re.search(r"text measurement cache: (\d+) hits, (\d+) misses", proc.stderr)
+    assert m is not None, "cache hit rate not reported"
+    assert int(m.group(1)) > int(m.group(2)), "repeated labels were remeasured"
+    uncached_misses = int(m.group(2))
+
+    # a missing or unusable cache file is replaced
+    cache = tmp_path / "text-cache"
+    env = os.environ.copy()
+    env["GV_TEXT_CACHE"] = str(cache)
+    for content in (None, b"not a cache"):
+        if content is not None:
+            cache.write_bytes(content)
+        output = run(["dot", "-Tsvg"], input=source, env=env)
+        assert output == reference, "cache file changed output"
+        assert cache.exists(), "cache file not written"
+
+    # a later run measures nothing new
+    proc = subprocess.run(
+        ["dot", "-v", "-Tsvg"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+        env=env,
+    )
+    assert proc.stdout == reference, "cached measurements changed output"
+    m = re.search(r"text measurement cache: (\d+) hits, (\d+) misses", proc.stderr)
+    assert m is not None, "cache hit rate not reported"
+    assert int(m.group(2)) <= 1, "measurements were not reused"
+
+    # a truncated cache file is used as far as it goes
+    cache.write_bytes(cache.read_bytes()[:-3])
+    output = run(["dot", "-Tsvg"], input=source, env=env)
+    assert output == reference, "truncated cache file changed output"
+
+    # a record whose strings would run past the end of the file is rejected,
+    # along with the rest of the file
+    content = cache.read_bytes()
+    start = content.index(b"\n") + 1 + 8
+    fields = struct.Struct("=5dI2I")
+    *_, name_len, str_len = fields.unpack_from(content, start)
+    good = content[: start + fields.size + name_len + str_len]
+    bad = fields.pack(1, 1, 0, 0, 14, 0, 0xFFFFFFF0, 0)
+    cache.write_bytes(good + bad)
+    proc = subprocess.run(
+        ["dot", "-v", "-Tsvg"],
+        input=source,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True,
+        universal_newlines=True,
+        env=env,
+    )
+    assert proc.stdout == reference, "malformed cache file changed output"
+    m = re.search(r"text measurement cache: (\d+) hits, (\d+) misses", proc.stderr)
+    assert m is not None, "cache hit rate not reported"
+    assert int(m.group(2)) == uncached_misses, "malformed cache file was used"
+
+    # the file is replaced without leaving temporary files behind
+    assert [f.name for f in tmp_path.iterdir()] == [cache.name]
+
+
+def test_label_empty_first_line():
+    """
+    freeing a label whose first line is empty should not crash
+    """
+
+    # two graphs, so the first is freed before `dot` exits
+    source = 'digraph { a [label="\\nsecond"] }\ndigraph { b }\n'
+
+    # have glibc fill new allocations with garbage, so that reading any of them
+    # before they are initialized reliably crashes
+    env = os.environ.copy()
+    env["MALLOC_PERTURB_"] = "165"
+
+    run(["dot", "-Tsvg", "-o", os.devnull], input=source, env=env)
+
+
+@pytest.mark.skipif(which("fdp") is None, reason="fdp not available")
+def test_fdp_earlier_graphs():
+    """
+    an fdp layout should not depend on the graphs laid out before it in the same
+    process
+    """
+
+    graphs = Path(__file__).parent / "graphs"
+    first = (graphs / "clust.gv").read_text(encoding="utf-8")
+    second = (graphs / "clust4.gv").read_text(encoding="utf-8")
+
+    alone = run(["fdp", "-Tplain"], input=second)
+    both = run(["fdp", "-Tplain"], input=first + second)
+
+    assert both.endswith(alone), "fdp layout varied with the graph before it"
+
+
+@pytest.mark.skipif(
+    is_static_build(),
+    reason="dynamic libraries are unavailable to link against in static builds",
+)
+@pytest.mark.skipif(
+    platform.system() == "Windows", reason="test case uses POSIX threads"
+)
+def test_gvc_threads(tmp_path: Path):
+    """
+    separate contexts should be able to lay out and render graphs concurrently,
+    giving the same results as when run one after another
+    """
+
+    # find co-located test source
+    c_src = (Path(__file__).parent / "gvc_threads.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # find the plugins we need to link against
+    plugins = []
+    for plugin in ("core", "dot_layout", "neato_layout"):
+        so = _find_plugin_so(plugin)
+        assert so is not None, f"{plugin} plugin library not found"
+        plugins += [so]
+
+    # compile the test code, which links against the plugins like test_2648
+    exe = tmp_path / "a.exe"
+    compile_c(c_src, cflags=["-pthread"], link=["cgraph", "gvc"] + plugins, dst=exe)
+
+    # teach the runtime linker how to find the plugins
+    env = os.environ.copy()
+    var = "DYLD_LIBRARY_PATH" if is_macos() else "LD_LIBRARY_PATH"
+    search = ":".join(str(p.parent) for p in plugins)
+    env[var] = f"{search}:{env[var]}" if var in env else search
+
+    graphs = Path(__file__).parent / "graphs"
+    inputs = [graphs / "clust4.gv", graphs / "html.gv", graphs / "abstract.gv"]
+    subprocess.run([exe] + inputs, env=env, check=True)
+
+
+@pytest.mark.skipif(which("sfdp") is None, reason="sfdp not available")
+def test_sfdp_fast_serial():
+    """
+    single threaded sfdp with `quadtree=fast` should give the same layout every
+    time, whether or not `threads=1` is given explicitly
+    """
+
+    # locate an input large enough to use the quadtree
+    input = Path(__file__).parent / "graphs/b100.gv"
+    assert input.exists(), "unexpectedly missing test case"
+
+    sfdp = which("sfdp")
+    layouts = []
+    for extra in ([], [], ["-Gthreads=1"]):
+        p = subprocess.run(
+            [sfdp, "-Gquadtree=fast"] + extra + ["-Tplain", input],
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=False,
+            text=True,
+        )
+
+        # if sfdp was built without libgts, it will not handle anything non-trivial
+        no_gts_error = "remove_overlap: Graphviz not built with triangulation library"
+        if no_gts_error in p.stderr:
+            assert p.returncode != 0, "sfdp returned success after an error message"
+            return
+        p.check_returncode()
+        layouts.append(p.stdout)
+
+    assert layouts[0] == layouts[1], "single threaded sfdp layout was not repeatable"
+    assert layouts[0] == layouts[2], "sfdp layout varied with an explicit threads=1"